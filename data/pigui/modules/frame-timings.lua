@@ -0,0 +1,40 @@
+-- Copyright © 2008-2018 Pioneer Developers. See AUTHORS.txt for details
+-- Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+local Engine = import('Engine')
+local ui = import('pigui/pigui.lua')
+local Vector = import('Vector')
+
+-- CPU and GPU milliseconds per frame of the major rendering passes, toggled
+-- with Ctrl+T. Ctrl+Shift+T saves the last frames for chrome://tracing
+
+local function ms(t)
+	return t and string.format("%.2f", t) or "-"
+end
+
+local function displayFrameTimings()
+	if not Engine.GetDisplayFrameTimings() then return end
+	local timings = Engine.GetFrameTimings(30)
+
+	ui.setNextWindowPos(Vector(ui.screenWidth - 320, 10), "Always")
+	ui.window("Frame timings", {"NoTitleBar", "NoResize", "NoSavedSettings", "NoFocusOnAppearing", "AlwaysAutoResize"}, function()
+		ui.columns(3, "frametimings", false)
+		ui.text("pass") ui.nextColumn()
+		ui.text("cpu ms") ui.nextColumn()
+		ui.text("gpu ms") ui.nextColumn()
+		ui.separator()
+		ui.text("frame") ui.nextColumn()
+		ui.text(ms(timings.cpu)) ui.nextColumn()
+		ui.text(ms(timings.gpu)) ui.nextColumn()
+		for _,pass in ipairs(timings.passes) do
+			ui.text(string.rep("  ", pass.depth) .. pass.name) ui.nextColumn()
+			ui.text(ms(pass.cpu)) ui.nextColumn()
+			ui.text(ms(pass.gpu)) ui.nextColumn()
+		end
+		ui.columns(1, "", false)
+	end)
+end
+
+ui.registerModule("game", displayFrameTimings)
+
+return {}
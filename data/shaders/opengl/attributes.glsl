@@ -37,4 +37,33 @@ layout (location = 6) in mat4 a_transform;
 // a_transform @ 6 shadows (uses) 7, 8, and 9
 // next available is layout (location = 10) 
 
+// model vertices may be compact: positions relative to the mesh, normals
+// and tangents octahedron encoded in x and y. See VertexBufferDesc
+uniform vec3 uPositionScale;
+uniform vec3 uPositionOffset;
+uniform bool uOctNormals;
+
+vec4 vertexPosition()
+{
+	return vec4(a_vertex.xyz * uPositionScale + uPositionOffset, 1.0);
+}
+
+vec3 octDecode(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (n.z < 0.0)
+		n.xy = (1.0 - abs(e.yx)) * vec2(e.x >= 0.0 ? 1.0 : -1.0, e.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(n);
+}
+
+vec3 vertexNormal()
+{
+	return uOctNormals ? octDecode(a_normal.xy) : a_normal;
+}
+
+vec3 vertexTangent()
+{
+	return uOctNormals ? octDecode(a_tangent.xy) : a_tangent;
+}
+
 #endif // VERTEX_SHADER
\ No newline at end of file
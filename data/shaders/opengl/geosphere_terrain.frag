@@ -25,6 +25,9 @@ in vec2 texCoord0;
 in float dist;
 uniform float detailScaleHi;
 uniform float detailScaleLo;
+#ifdef PATCH_BATCHING
+in float detailFrequency;
+#endif
 
 uniform Material material;
 uniform Scene scene;
@@ -42,8 +45,13 @@ out vec4 frag_color;
 void main(void)
 {
 #ifdef DETAIL_MAPS
+#ifdef PATCH_BATCHING
+	vec4 hidetail = texture(texture0, texCoord0 * (detailScaleHi * detailFrequency));
+	vec4 lodetail = texture(texture1, texCoord0 * (detailScaleLo * detailFrequency));
+#else
 	vec4 hidetail = texture(texture0, texCoord0 * detailScaleHi);
 	vec4 lodetail = texture(texture1, texCoord0 * detailScaleLo);
+#endif
 #endif // DETAIL_MAPS
 	vec3 eyepos = varyingEyepos;
 	vec3 eyenorm = normalize(eyepos);
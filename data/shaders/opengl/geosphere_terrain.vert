@@ -12,6 +12,14 @@ out vec4 vertexColor;
 uniform vec3 geosphereCenter;
 uniform float geosphereRadius;
 
+#ifdef PATCH_BATCHING
+// camera relative offset (xyz) and detail texture frequency (w) of each patch
+// in the vertex buffer, patchVertices vertices apiece
+uniform samplerBuffer patchData;
+uniform int patchVertices;
+out float detailFrequency;
+#endif
+
 #ifdef DETAIL_MAPS
 out vec2 texCoord0;
 out float dist;
@@ -24,9 +32,17 @@ uniform Material material;
 
 void main(void)
 {
-	gl_Position = logarithmicTransform();
+#ifdef PATCH_BATCHING
+	// gl_VertexID includes the draw's base vertex, so it tells the patch apart
+	vec4 patchInfo = texelFetch(patchData, gl_VertexID / patchVertices);
+	vec4 vertex = vec4(a_vertex.xyz + patchInfo.xyz, 1.0);
+	detailFrequency = patchInfo.w;
+#else
+	vec4 vertex = a_vertex;
+#endif
+	gl_Position = logarithmicTransform(vertex);
 	vertexColor = a_color;
-	varyingEyepos = vec3(uViewMatrix * a_vertex);
+	varyingEyepos = vec3(uViewMatrix * vertex);
 	varyingNormal = normalize(uNormalMatrix * a_normal);
 	
 #ifdef DETAIL_MAPS
@@ -10,17 +10,22 @@ out float varLogDepth;
 #endif
 
 #ifdef VERTEX_SHADER
-vec4 logarithmicTransform()
+vec4 logarithmicTransform(vec4 position)
 {
 #ifdef USE_INSTANCING
-	//vec4 vertexPosClip = uProjectionMatrix * uViewMatrix * a_transform * a_vertex;
-	vec4 vertexPosClip = uViewProjectionMatrix * a_transform * a_vertex;
+	//vec4 vertexPosClip = uProjectionMatrix * uViewMatrix * a_transform * position;
+	vec4 vertexPosClip = uViewProjectionMatrix * a_transform * position;
 #else
-	vec4 vertexPosClip = uViewProjectionMatrix * a_vertex;
+	vec4 vertexPosClip = uViewProjectionMatrix * position;
 #endif
 	varLogDepth = vertexPosClip.z;
 	return vertexPosClip;
 }
+
+vec4 logarithmicTransform()
+{
+	return logarithmicTransform(a_vertex);
+}
 #elif defined(FRAGMENT_SHADER)
 void SetFragDepth()
 {
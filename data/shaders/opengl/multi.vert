@@ -29,7 +29,8 @@ out vec3 normal;
 
 void main(void)
 {
-	gl_Position = logarithmicTransform();
+	vec4 position = vertexPosition();
+	gl_Position = logarithmicTransform(position);
 #ifdef VERTEXCOLOR
 	vertexColor = a_color;
 #endif
@@ -37,19 +38,23 @@ void main(void)
 	texCoord0 = a_uv0.xy;
 #endif
 #if (NUM_LIGHTS > 0)
+	vec3 vnormal = vertexNormal();
+#ifdef MAP_NORMAL
+	vec3 vtangent = vertexTangent();
+#endif
 #ifdef USE_INSTANCING
-	eyePos = vec3(uViewMatrix * (a_transform * a_vertex));
-	normal = normalize(uNormalMatrix * (mat3(a_transform) * a_normal));
+	eyePos = vec3(uViewMatrix * (a_transform * position));
+	normal = normalize(uNormalMatrix * (mat3(a_transform) * vnormal));
 	#ifdef MAP_NORMAL
-		tangent = uNormalMatrix * (mat3(a_transform) * a_tangent);
-		bitangent = uNormalMatrix * (mat3(a_transform) * cross(a_normal, a_tangent));
+		tangent = uNormalMatrix * (mat3(a_transform) * vtangent);
+		bitangent = uNormalMatrix * (mat3(a_transform) * cross(vnormal, vtangent));
 	#endif
 #else
-	eyePos = vec3(uViewMatrix * a_vertex);
-	normal = normalize(uNormalMatrix * a_normal);
+	eyePos = vec3(uViewMatrix * position);
+	normal = normalize(uNormalMatrix * vnormal);
 	#ifdef MAP_NORMAL
-		tangent = uNormalMatrix * a_tangent;
-		bitangent = uNormalMatrix * cross(a_normal, a_tangent);
+		tangent = uNormalMatrix * vtangent;
+		bitangent = uNormalMatrix * cross(vnormal, vtangent);
 	#endif
 #endif
 
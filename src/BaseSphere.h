@@ -47,6 +47,11 @@ public:
 		std::vector<Camera::Shadow> shadows;
 		Sint32 patchDepth;
 		Sint32 maxPatchDepth;
+
+		// set by GeoPatchPool while it draws, 4 floats for each slot
+		const float *patchData = nullptr;
+		Uint32 numPatchData = 0;
+		Uint32 patchVertices = 0;
 	};
 
 	virtual void Reset()=0;
@@ -0,0 +1,73 @@
+// Copyright © 2008-2018 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "Bench.h"
+
+namespace Bench {
+
+bool enabled = false;
+
+static const char *s_sectionNames[SECTION_MAX] = {
+	"space_timestep",
+	"lua",
+	"camera_draw",
+	"geosphere_lod",
+	"jobs",
+};
+
+static Uint64 s_ticks[SECTION_MAX];
+static Uint32 s_calls[SECTION_MAX];
+
+void Start()
+{
+	std::fill(s_ticks, s_ticks + SECTION_MAX, 0);
+	std::fill(s_calls, s_calls + SECTION_MAX, 0);
+	enabled = true;
+}
+
+void Stop()
+{
+	enabled = false;
+}
+
+void Add(Section section, Uint64 ticks)
+{
+	s_ticks[section] += ticks;
+	s_calls[section]++;
+}
+
+static std::string json_escape(const std::string &s)
+{
+	std::string out;
+	for (char c : s) {
+		if (c == '"' || c == '\\')
+			out += '\\';
+		if (Uint8(c) >= 0x20)
+			out += c;
+	}
+	return out;
+}
+
+void Write(FILE *f, const std::string &source, Uint32 frames, double timeStep, Uint64 totalTicks)
+{
+	const double msPerTick = 1000.0 / double(SDL_GetPerformanceFrequency());
+	const double totalMs = totalTicks * msPerTick;
+	const double perFrame = frames > 0 ? 1.0 / frames : 0.0;
+
+	fprintf(f, "{\n");
+	fprintf(f, "\t\"source\": \"%s\",\n", json_escape(source).c_str());
+	fprintf(f, "\t\"frames\": %u,\n", frames);
+	fprintf(f, "\t\"time_step\": %g,\n", timeStep);
+	fprintf(f, "\t\"total_ms\": %.3f,\n", totalMs);
+	fprintf(f, "\t\"frame_ms\": %.4f,\n", totalMs * perFrame);
+	fprintf(f, "\t\"sections\": {\n");
+	for (int i = 0; i < SECTION_MAX; i++) {
+		const double ms = s_ticks[i] * msPerTick;
+		fprintf(f, "\t\t\"%s\": { \"total_ms\": %.3f, \"frame_ms\": %.4f, \"calls\": %u }%s\n",
+			s_sectionNames[i], ms, ms * perFrame, s_calls[i], i + 1 < SECTION_MAX ? "," : "");
+	}
+	fprintf(f, "\t}\n");
+	fprintf(f, "}\n");
+}
+
+}
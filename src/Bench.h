@@ -0,0 +1,47 @@
+// Copyright © 2008-2018 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include "libs.h"
+
+// CPU time spent in the main subsystems, gathered while running -bench.
+// Sections are timed inclusively, so anything nested inside another (Lua
+// inside Space::TimeStep, for one) is counted in both. Timing costs a branch
+// when no benchmark is running.
+namespace Bench {
+
+	enum Section {
+		SECTION_SPACE,          // Space::TimeStep
+		SECTION_LUA,            // event queue and timers, during the time step
+		SECTION_CAMERA_DRAW,    // Camera::Draw, the scene traversal
+		SECTION_GEOSPHERE_LOD,  // patch splits and merges
+		SECTION_JOBS,           // running and finishing the job queues
+		SECTION_MAX
+	};
+
+	extern bool enabled;
+
+	// clears the totals and starts timing
+	void Start();
+	void Stop();
+	void Add(Section section, Uint64 ticks);
+
+	// a JSON object with the totals for each section
+	void Write(FILE *f, const std::string &source, Uint32 frames, double timeStep, Uint64 totalTicks);
+
+	class ScopedTimer {
+	public:
+		ScopedTimer(Section section) : m_section(section), m_start(enabled ? SDL_GetPerformanceCounter() : 0) {}
+		~ScopedTimer() { if (enabled) Add(m_section, SDL_GetPerformanceCounter() - m_start); }
+	private:
+		Section m_section;
+		Uint64 m_start;
+	};
+
+}
+
+#define BENCH_SCOPED(section) Bench::ScopedTimer bench_timer_##section(Bench::section);
+
+#endif
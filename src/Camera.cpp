@@ -2,6 +2,7 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "Camera.h"
+#include "Bench.h"
 #include "Frame.h"
 #include "galaxy/StarSystem.h"
 #include "Space.h"
@@ -10,6 +11,8 @@
 #include "Sfx.h"
 #include "Game.h"
 #include "Planet.h"
+#include "NavLights.h"
+#include "scenegraph/Thruster.h"
 #include "graphics/Graphics.h"
 #include "graphics/Renderer.h"
 #include "graphics/VertexArray.h"
@@ -191,6 +194,7 @@ void Camera::Update()
 void Camera::Draw(const Body *excludeBody, ShipCockpit* cockpit)
 {
 	PROFILE_SCOPED()
+	BENCH_SCOPED(SECTION_CAMERA_DRAW)
 
 	Frame *camFrame = m_context->GetCamFrame();
 
@@ -242,8 +246,11 @@ void Camera::Draw(const Body *excludeBody, ShipCockpit* cockpit)
 		}
 	}
 
-	Pi::game->GetSpace()->GetBackground()->SetIntensity(bgIntensity);
-	Pi::game->GetSpace()->GetBackground()->Draw(trans2bg);
+	{
+		TIMING_SCOPED(m_renderer, "background")
+		Pi::game->GetSpace()->GetBackground()->SetIntensity(bgIntensity);
+		Pi::game->GetSpace()->GetBackground()->Draw(trans2bg);
+	}
 
 	{
 		std::vector<Graphics::Light> rendererLights;
@@ -253,6 +260,13 @@ void Camera::Draw(const Body *excludeBody, ShipCockpit* cockpit)
 		m_renderer->SetLights(rendererLights.size(), &rendererLights[0]);
 	}
 
+	// thrusters and navlights of all the bodies are drawn together after them.
+	// they don't write depth and blend additively, so the only difference from
+	// drawing them with each body is over the alpha blended parts of nearer
+	// bodies, which they now show through
+	SceneGraph::Thruster::BeginBatch();
+	NavLights::BeginBatch();
+
 	for (std::list<BodyAttrs>::iterator i = m_sortedBodies.begin(); i != m_sortedBodies.end(); ++i) {
 		BodyAttrs *attrs = &(*i);
 
@@ -260,6 +274,8 @@ void Camera::Draw(const Body *excludeBody, ShipCockpit* cockpit)
 		if (attrs->body == excludeBody)
 			continue;
 
+		TIMING_SCOPED(m_renderer, attrs->body->IsType(Object::TERRAINBODY) ? "geospheres" : "models")
+
 		// draw something!
 		if (attrs->billboard) {
 			Graphics::Renderer::MatrixTicket mt(m_renderer, Graphics::MatrixMode::MODELVIEW);
@@ -271,7 +287,16 @@ void Camera::Draw(const Body *excludeBody, ShipCockpit* cockpit)
 			attrs->body->Render(m_renderer, this, attrs->viewCoords, attrs->viewTransform);
 	}
 
-	SfxManager::RenderAll(m_renderer, Pi::game->GetSpace()->GetRootFrame(), camFrame);
+	{
+		TIMING_SCOPED(m_renderer, "lights")
+		SceneGraph::Thruster::EndBatch(m_renderer);
+		NavLights::EndBatch(m_renderer);
+	}
+
+	{
+		TIMING_SCOPED(m_renderer, "sfx")
+		SfxManager::RenderAll(m_renderer, Pi::game->GetSpace()->GetRootFrame(), camFrame);
+	}
 
 	// NB: Do any screen space rendering after here:
 	// Things like the cockpit and AR features like hudtrails, space dust etc.
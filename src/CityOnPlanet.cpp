@@ -33,13 +33,6 @@ CityOnPlanet::cityflavourdef_t CityOnPlanet::cityflavour[CITYFLAVOURS];
 
 void CityOnPlanet::AddStaticGeomsToCollisionSpace()
 {
-	// reset data structures
-	m_enabledBuildings.clear();
-	m_buildingCounts.resize(s_buildingList.numBuildings);
-	for(Uint32 i=0; i<s_buildingList.numBuildings; i++) {
-		m_buildingCounts[i] = 0;
-	}
-
 	// Generate the new building list
 	int skipMask;
 	switch (Pi::detail.cities) {
@@ -50,32 +43,55 @@ void CityOnPlanet::AddStaticGeomsToCollisionSpace()
 		default:
 			skipMask = 0; break;
 	}
-	Uint32 numVisibleBuildings = 0;
+
+	// count each model's buildings first, so they can go in grouped by model
+	const Uint32 numModels = s_buildingList.numBuildings;
+	std::vector<Uint32> &modelStart = m_enabled.modelStart;
+	modelStart.assign(numModels + 1, 0);
 	for (unsigned int i=0; i<m_buildings.size(); i++) {
 		if (!(i&skipMask)) {
-			++numVisibleBuildings;
+			++modelStart[m_buildings[i].instIndex + 1];
 		}
 	}
+	for (Uint32 i=0; i<numModels; i++) {
+		modelStart[i + 1] += modelStart[i];
+	}
 
-	// we know how many building we'll be adding, reserve space up front
-	m_enabledBuildings.reserve(numVisibleBuildings);
+	const Uint32 numEnabled = modelStart[numModels];
+	m_enabled.x.resize(numEnabled);
+	m_enabled.y.resize(numEnabled);
+	m_enabled.z.resize(numEnabled);
+	m_enabled.clipRadius.resize(numEnabled);
+	m_enabled.rotation.resize(numEnabled);
+	m_enabled.visible.assign(numEnabled, 0);
+
+	std::vector<Uint32> next(modelStart.begin(), modelStart.end() - 1);
 	for (unsigned int i=0; i<m_buildings.size(); i++) {
 		if (i & skipMask) {
 		} else {
-			m_frame->AddStaticGeom(m_buildings[i].geom);
-			m_enabledBuildings.push_back(m_buildings[i]);
-			// Update building types
-			++(m_buildingCounts[m_buildings[i].instIndex]);
+			const BuildingDef &def = m_buildings[i];
+			m_frame->AddStaticGeom(def.geom);
+			const Uint32 j = next[def.instIndex]++;
+			const vector3d pos = def.pos - m_centre;
+			m_enabled.x[j] = float(pos.x);
+			m_enabled.y[j] = float(pos.y);
+			m_enabled.z[j] = float(pos.z);
+			m_enabled.clipRadius[j] = def.clipRadius;
+			m_enabled.rotation[j] = Uint8(def.rotation);
 		}
 	}
 
+	m_transforms.resize(numModels);
+	m_transformsValid = false;
+
 	// reset the reset flag
 	m_detailLevel = Pi::detail.cities;
 }
 
 void CityOnPlanet::RemoveStaticGeomsFromCollisionSpace()
 {
-	m_enabledBuildings.clear();
+	m_enabled.modelStart.clear();
+	m_transformsValid = false;
 	for (unsigned int i=0; i<m_buildings.size(); i++) {
 		m_frame->RemoveStaticGeom(m_buildings[i].geom);
 	}
@@ -125,7 +141,10 @@ void CityOnPlanet::LookupBuildingListModels(citybuildinglist_t *list)
 		list->buildings[i].instIndex = i;
 		list->buildings[i].resolvedModel = *m;
 		list->buildings[i].idle = (*m)->FindAnimation("idle");
-		list->buildings[i].collMesh = (*m)->CreateCollisionMesh();
+		// the model's own collision mesh, which its instances share, rather than building another
+		list->buildings[i].collMesh = (*m)->GetCollisionMesh();
+		if (!list->buildings[i].collMesh)
+			list->buildings[i].collMesh = (*m)->CreateCollisionMesh();
 		const Aabb &aabb = list->buildings[i].collMesh->GetAabb();
 		const double maxx = std::max(fabs(aabb.max.x), fabs(aabb.min.x));
 		const double maxy = std::max(fabs(aabb.max.z), fabs(aabb.min.z));
@@ -137,13 +156,26 @@ void CityOnPlanet::LookupBuildingListModels(citybuildinglist_t *list)
 
 void CityOnPlanet::Init()
 {
-	/* Resolve city model numbers since it is a bit expensive */
-	LookupBuildingListModels(&s_buildingList);
+	// the models load on the job threads until the first city needs them
+	std::set<std::string> filenames;
+	EnumerateNewBuildings(filenames);
+	for (const std::string &name : filenames)
+		Pi::modelCache->RequestModel(name);
 }
 
 void CityOnPlanet::Uninit()
 {
 	delete[] s_buildingList.buildings;
+	s_buildingList.buildings = nullptr;
+	s_buildingList.numBuildings = 0;
+}
+
+//static
+void CityOnPlanet::ResolveBuildingList()
+{
+	/* Resolve city model numbers since it is a bit expensive */
+	if (!s_buildingList.buildings)
+		LookupBuildingListModels(&s_buildingList);
 }
 
 // Need a reliable way to sort the models rather than using their address in memory we use their name which should be unique.
@@ -159,6 +191,8 @@ struct ModelNameComparator {
 //static
 void CityOnPlanet::SetCityModelPatterns(const SystemPath &path)
 {
+	ResolveBuildingList();
+
 	Uint32 _init[5] = { path.systemIndex, Uint32(path.sectorX), Uint32(path.sectorY), Uint32(path.sectorZ), UNIVERSE_SEED };
 	Random rand(_init, 5);
 
@@ -194,6 +228,8 @@ CityOnPlanet::~CityOnPlanet()
 
 CityOnPlanet::CityOnPlanet(Planet *planet, SpaceStation *station, const Uint32 seed)
 {
+	ResolveBuildingList();
+
 	// beware, these are not used in this function, but are used in subroutines!
 	m_planet = planet;
 	m_frame = planet->GetFrame();
@@ -313,9 +349,42 @@ CityOnPlanet::CityOnPlanet(Planet *planet, SpaceStation *station, const Uint32 s
 	}
 	m_realCentre = buildAABB.min + ((buildAABB.max - buildAABB.min)*0.5);
 	m_clipRadius = buildAABB.GetRadius();
+	m_centre = p + m_realCentre;
+	m_transformsValid = false;
+	m_numVisible = 0;
 	AddStaticGeomsToCollisionSpace();
 }
 
+void CityOnPlanet::CullBuildings(const Graphics::Frustum &frustum, const matrix4x4d &viewTransform)
+{
+	PROFILE_SCOPED()
+	const Uint32 numEnabled = m_enabled.visible.size();
+	if (!numEnabled)
+		return;
+
+	const float *x = &m_enabled.x[0];
+	const float *y = &m_enabled.y[0];
+	const float *z = &m_enabled.z[0];
+	const float *radius = &m_enabled.clipRadius[0];
+	Uint8 *visible = &m_enabled.visible[0];
+	memset(visible, 1, numEnabled);
+
+	// bring the planes into the city's space rather than every building into
+	// view space: n.(Rp + c) + d == (R'n).p + (n.c + d)
+	const matrix4x4d invRot = viewTransform.Transpose();
+	const vector3d centre = viewTransform * m_centre;
+	for (int p=0; p<6; p++) {
+		const SPlane &plane = frustum.GetPlane(p);
+		const vector3d n(plane.a, plane.b, plane.c);
+		const vector3f ln(invRot.ApplyRotationOnly(n));
+		const float ld = float(n.Dot(centre) + plane.d);
+		// no branches, so the compiler can vectorise it
+		for (Uint32 i=0; i<numEnabled; i++) {
+			visible[i] &= Uint8(ln.x * x[i] + ln.y * y[i] + ln.z * z[i] + ld + radius[i] >= 0.0f);
+		}
+	}
+}
+
 void CityOnPlanet::Render(Graphics::Renderer *r, const Graphics::Frustum &frustum, const SpaceStation *station, const vector3d &viewCoords, const matrix4x4d &viewTransform)
 {
 	// Early frustum test of whole city.
@@ -324,10 +393,6 @@ void CityOnPlanet::Render(Graphics::Renderer *r, const Graphics::Frustum &frustu
 	if (!frustum.TestPoint(stationPos, m_clipRadius))
 		return;
 
-	matrix4x4d rot[4];
-	matrix4x4f rotf[4];
-	rot[0] = station->GetOrient();
-
 	// change detail level if necessary
 	const bool bDetailChanged = m_detailLevel != Pi::detail.cities;
 	if (bDetailChanged) {
@@ -335,16 +400,6 @@ void CityOnPlanet::Render(Graphics::Renderer *r, const Graphics::Frustum &frustu
 		AddStaticGeomsToCollisionSpace();
 	}
 
-	rot[0] = viewTransform * rot[0];
-	for (int i=1; i<4; i++) {
-		rot[i] = rot[0] * matrix4x4d::RotateYMatrix(M_PI*0.5*double(i));
-	}
-	for (int i=0; i<4; i++) {
-		for (int e=0; e<16; e++) {
-			rotf[i][e] = float(rot[i][e]);
-		}
-	}
-
 	// update any idle animations
 	for(Uint32 i=0; i<s_buildingList.numBuildings; i++) {
 		SceneGraph::Animation *pAnim = s_buildingList.buildings[i].idle;
@@ -354,51 +409,68 @@ void CityOnPlanet::Render(Graphics::Renderer *r, const Graphics::Frustum &frustu
 		}
 	}
 
-	Uint32 uCount = 0;
-	std::vector<Uint32> instCount;
-	std::vector< std::vector<matrix4x4f> > transform;
-	instCount.resize(s_buildingList.numBuildings);
-	transform.resize(s_buildingList.numBuildings);
-	memset(&instCount[0], 0, sizeof(Uint32) * s_buildingList.numBuildings);
-	for(Uint32 i=0; i<s_buildingList.numBuildings; i++) {
-		transform[i].reserve(m_buildingCounts[i]);
+	// the transforms only change when the view does, and a ship sitting on the
+	// pad has the same one frame after frame
+	bool viewChanged = !m_transformsValid || memcmp(&viewTransform, &m_lastViewTransform, sizeof(matrix4x4d)) != 0;
+	for (int p=0; p<6 && !viewChanged; p++) {
+		viewChanged = memcmp(&frustum.GetPlane(p), &m_lastPlanes[p], sizeof(SPlane)) != 0;
 	}
 
-	for (std::vector<BuildingDef>::const_iterator iter=m_enabledBuildings.begin(), itEND=m_enabledBuildings.end(); iter != itEND; ++iter)
-	{
-		const vector3d pos = viewTransform * (*iter).pos;
-		const vector3f posf(pos);
-		if (!frustum.TestPoint(pos, (*iter).clipRadius))
-			continue;
+	if (viewChanged) {
+		CullBuildings(frustum, viewTransform);
 
-		matrix4x4f _rot(rotf[(*iter).rotation]);
-		_rot.SetTranslate(posf);
+		matrix4x4d rot[4];
+		matrix4x4f rotf[4];
+		rot[0] = viewTransform * station->GetOrient();
+		for (int i=1; i<4; i++) {
+			rot[i] = rot[0] * matrix4x4d::RotateYMatrix(M_PI*0.5*double(i));
+		}
+		for (int i=0; i<4; i++) {
+			for (int e=0; e<16; e++) {
+				rotf[i][e] = float(rot[i][e]);
+			}
+		}
 
-		// increment the instance count and store the transform
-		instCount[(*iter).instIndex]++;
-		transform[(*iter).instIndex].push_back( _rot );
+		const vector3d centre = viewTransform * m_centre;
+		m_numVisible = 0;
+		for(Uint32 m=0; m<s_buildingList.numBuildings; m++) {
+			std::vector<matrix4x4f> &transform = m_transforms[m];
+			transform.clear();
+			for (Uint32 i=m_enabled.modelStart[m], end=m_enabled.modelStart[m + 1]; i<end; i++) {
+				if (!m_enabled.visible[i])
+					continue;
+				const vector3d pos = centre + viewTransform.ApplyRotationOnly(vector3d(m_enabled.x[i], m_enabled.y[i], m_enabled.z[i]));
+				transform.push_back(rotf[m_enabled.rotation[i]]);
+				transform.back().SetTranslate(vector3f(pos));
+			}
+			m_numVisible += transform.size();
+		}
 
-		++uCount;
+		m_lastViewTransform = viewTransform;
+		for (int p=0; p<6; p++) {
+			m_lastPlanes[p] = frustum.GetPlane(p);
+		}
+		m_transformsValid = true;
 	}
 
 	if(r->SupportsInstancing())
 	{
 		// render the building models using instancing
 		for(Uint32 i=0; i<s_buildingList.numBuildings; i++) {
-			if(!transform[i].empty())
-				s_buildingList.buildings[i].resolvedModel->Render(transform[i]);
+			if(!m_transforms[i].empty())
+				s_buildingList.buildings[i].resolvedModel->Render(m_transforms[i]);
 		}
 	}
 	else
 	{
 		// render the buildings individually
 		for(Uint32 i=0; i<s_buildingList.numBuildings; i++) {
-			for(auto t : transform[i]) {
+			for(const matrix4x4f &t : m_transforms[i]) {
 				s_buildingList.buildings[i].resolvedModel->Render(t);
 			}
 		}
 	}
 
-	r->GetStats().AddToStatCount(Graphics::Stats::STAT_BUILDINGS, uCount);
+	r->GetStats().AddToStatCount(Graphics::Stats::STAT_BUILDINGS, m_numVisible);
 	r->GetStats().AddToStatCount(Graphics::Stats::STAT_CITIES, 1);
 }
@@ -9,6 +9,7 @@
 #include "Object.h"
 #include "CollMesh.h"
 #include "collider/Geom.h"
+#include "Plane.h"
 #include "galaxy/StarSystem.h"
 
 class Planet;
@@ -42,15 +43,36 @@ private:
 		Geom *geom;
 	};
 
+	// the buildings enabled at the current detail level, grouped by model and
+	// stored a field at a time so culling runs straight down the arrays.
+	// Positions are relative to m_centre, small enough for floats
+	struct EnabledBuildings {
+		std::vector<float> x, y, z;
+		std::vector<float> clipRadius;
+		std::vector<Uint8> rotation;
+		std::vector<Uint8> visible;
+		std::vector<Uint32> modelStart; // first building of each model, then the total
+	};
+
+	void CullBuildings(const Graphics::Frustum &frustum, const matrix4x4d &viewTransform);
+
 	Planet *m_planet;
 	Frame *m_frame;
 	std::vector<BuildingDef> m_buildings;
-	std::vector<BuildingDef> m_enabledBuildings;
-	std::vector<Uint32> m_buildingCounts;
+	EnabledBuildings m_enabled;
 	int m_detailLevel;
+	vector3d m_centre;
 	vector3d m_realCentre;
 	float m_clipRadius;
 
+	// the visible buildings' transforms for each model, kept from frame to
+	// frame and only worked out again when the view moves
+	std::vector< std::vector<matrix4x4f> > m_transforms;
+	matrix4x4d m_lastViewTransform;
+	SPlane m_lastPlanes[6];
+	bool m_transformsValid;
+	Uint32 m_numVisible;
+
 	// --------------------------------------------------------
 	// statics
 	static const unsigned int CITYFLAVOURS = 5;
@@ -83,6 +105,7 @@ private:
 
 	static void EnumerateNewBuildings(std::set<std::string> &filenames);
 	static void LookupBuildingListModels(citybuildinglist_t *list);
+	static void ResolveBuildingList();
 };
 
 #endif /* _CITYONPLANET_H */
@@ -26,6 +26,7 @@ void CollMesh::Save(Serializer::Writer &wr) const
 void CollMesh::Load(Serializer::Reader &rd)
 {
 	PROFILE_SCOPED()
+	const Uint64 start = SDL_GetPerformanceCounter();
 	m_aabb.max = rd.Vector3d();
 	m_aabb.min = rd.Vector3d();
 	m_aabb.radius = rd.Double();
@@ -39,4 +40,5 @@ void CollMesh::Load(Serializer::Reader &rd)
 	}
 
 	m_totalTris = rd.Int32();
+	m_buildTime = double(SDL_GetPerformanceCounter() - start) * 1000.0 / double(SDL_GetPerformanceFrequency());
 }
@@ -15,6 +15,7 @@ public:
 	CollMesh()
 	: m_geomTree(0)
 	, m_totalTris(0)
+	, m_buildTime(0.0)
 	{ }
 	virtual ~CollMesh() {
 		for (auto it = m_dynGeomTrees.begin(); it != m_dynGeomTrees.end(); ++it)
@@ -44,6 +45,9 @@ public:
 	//for statistics
 	inline unsigned int GetNumTriangles() const { return m_totalTris; }
 	inline void SetNumTriangles(unsigned int i) { m_totalTris = i; }
+	//milliseconds taken to build the trees, or to load them
+	inline double GetBuildTime() const { return m_buildTime; }
+	inline void SetBuildTime(double ms) { m_buildTime = ms; }
 
 	void Save(Serializer::Writer &wr) const;
 	void Load(Serializer::Reader &rd);
@@ -53,6 +57,7 @@ protected:
 	GeomTree *m_geomTree;
 	std::vector<GeomTree*> m_dynGeomTrees;
 	unsigned int m_totalTris;
+	double m_buildTime;
 };
 
 #endif
@@ -489,8 +489,15 @@ void FactionsDatabase::SetHomeSectors()
 {
 	m_may_assign_factions = false;
 	for (auto it = m_factions.begin(); it != m_factions.end(); ++it)
-		if ((*it)->hasHomeworld)
+		if ((*it)->hasHomeworld) {
 			(*it)->m_homesector = m_galaxy->GetSector((*it)->homeworld);
+			// positions never change, so keep them around even when the sector cache gets flushed
+			if ((*it)->homeworld.systemIndex < (*it)->m_homesector->m_systems.size()) {
+				(*it)->m_homePos = (*it)->m_homesector->m_systems[(*it)->homeworld.systemIndex].GetPosition();
+				(*it)->m_hasHomePos = true;
+			}
+		}
+	m_spatial_index.Build(m_factions);
 	m_may_assign_factions = true;
 }
 
@@ -564,15 +571,42 @@ const Faction* FactionsDatabase::GetNearestClaimant(const Sector::System* sys) c
 	// if it didn't, or it wasn't a custom StarStystem, then we go ahead and assign it a faction allegiance like normal below...
 	const Faction* result = &m_no_faction;
 	double closestFactionDist = HUGE_VAL;
-	ConstFactionList& candidates = m_spatial_index.CandidateFactions(sys);
 
-	for (ConstFactionIterator it = candidates.begin(); it != candidates.end(); ++it)
-	{
-		if ((*it)->IsClaimed(sys->GetPath()))
-			return *it; // this is a very specific claim, no further checks for distance from another factions homeworld is needed.
-		if ((*it)->IsCloserAndContains(closestFactionDist, sys))
-			result = *it;
+	// during faction generation there's no index yet, so check every faction in index order
+	if (!m_spatial_index.IsBuilt()) {
+		for (const Faction* faction : m_factions)
+		{
+			if (!m_spatial_index.InCell(faction, sys))
+				continue;
+			if (faction->IsClaimed(sys->GetPath()))
+				return faction; // this is a very specific claim, no further checks for distance from another factions homeworld is needed.
+			if (faction->IsCloserAndContains(closestFactionDist, sys))
+				result = faction;
+		}
+		return result;
 	}
+
+	// a very specific claim, no further checks for distance from another factions homeworld are needed.
+	if (const Faction* claimant = m_spatial_index.FindClaimant(sys))
+		return claimant;
+
+	/* The index hands out candidates in no particular order, so pick the same faction the
+	   in-order search above would: the closest one, and of equally close ones the last.
+	*/
+	auto consider = [&](const Faction* faction) {
+		float distance;
+		if (!m_spatial_index.InCell(faction, sys) || !faction->Contains(sys, distance))
+			return;
+		if (distance < closestFactionDist ||
+			(distance == closestFactionDist && (result == &m_no_faction || faction->idx > result->idx))) {
+			closestFactionDist = distance;
+			result = faction;
+		}
+	};
+	for (const Faction* faction : m_spatial_index.GetUnbounded())
+		consider(faction);
+	m_spatial_index.VisitContaining(sys->GetFullPosition(), consider);
+
 	return result;
 }
 
@@ -607,13 +641,32 @@ bool Faction::IsClaimed(SystemPath path) const
 const bool Faction::IsCloserAndContains(double& closestFactionDist, const Sector::System* sys) const
 {
 	PROFILE_SCOPED()
+	float distance;
+	bool  inside = Contains(sys, distance);
+
+	/*	if the faction contains the world, and its homeworld is closer, then this faction
+		wins, and we update the closestFactionDist */
+	if (inside && (distance <= closestFactionDist)) {
+		closestFactionDist = distance;
+		return true;
+
+	/* otherwise this isn't the faction we were looking for */
+	} else {
+		return false;
+	}
+}
+
+/*	Answer whether the faction contains the system, and set distance to how far the
+	system is from the factions homeworld.
+*/
+const bool Faction::Contains(const Sector::System* sys, float& distance) const
+{
 	/*	Treat factions without homeworlds as if they are of effectively infinite radius,
 		so every world is potentially within their borders, but also treat them as if
 		they had a homeworld that was infinitely far away, so every other faction has
 		a better claim.
 	*/
-	float distance = HUGE_VAL;
-	bool  inside   = true;
+	distance = HUGE_VAL;
 
 	/*	Factions that have a homeworld... */
 	if (hasHomeworld)
@@ -624,23 +677,21 @@ const bool Faction::IsCloserAndContains(double& closestFactionDist, const Sector
 		/* ...otherwise we need to calculate whether the world is inside the
 		   the faction border, and how far away it is. */
 		else {
-			RefCountedPtr<const Sector> homeSec = GetHomeSector();
-			const Sector::System* homeSys = &homeSec->m_systems[homeworld.systemIndex];
-			distance = Sector::System::DistanceBetween(homeSys, sys);
-			inside   = distance < Radius();
+			vector3f homePos;
+			if (m_hasHomePos) {
+				homePos = m_homePos;
+			} else {
+				RefCountedPtr<const Sector> homeSec = GetHomeSector();
+				homePos = homeSec->m_systems[homeworld.systemIndex].GetPosition();
+			}
+			// same arithmetic as Sector::System::DistanceBetween
+			vector3f dv = homePos - sys->GetPosition();
+			dv += Sector::SIZE*vector3f(float(homeworld.sectorX - sys->sx), float(homeworld.sectorY - sys->sy), float(homeworld.sectorZ - sys->sz));
+			distance = dv.Length();
+			return distance < Radius();
 		}
 	}
-
-	/*	if the faction contains the world, and its homeworld is closer, then this faction
-		wins, and we update the closestFactionDist */
-	if (inside && (distance <= closestFactionDist)) {
-		closestFactionDist = distance;
-		return true;
-
-	/* otherwise this isn't the faction we were looking for */
-	} else {
-		return false;
-	}
+	return true;
 }
 
 const Color Faction::AdjustedColour(fixed population, bool inRange) const
@@ -748,7 +799,8 @@ Faction::Faction(Galaxy* galaxy) :
 	expansionRate(0.0),
 	colour(BAD_FACTION_COLOUR),
 	m_galaxy(galaxy),
-	m_homesector(0)
+	m_homesector(0),
+	m_hasHomePos(false)
 {
 	PROFILE_SCOPED()
 	govtype_weights_total = 0;
@@ -756,95 +808,170 @@ Faction::Faction(Galaxy* galaxy) :
 
 // ------ Factions Spatial Indexing ------
 
-void FactionsDatabase::Octsapling::Add(const Faction* faction)
+void FactionsDatabase::SpatialIndex::Add(const Faction* faction)
 {
 	PROFILE_SCOPED()
-	/*  The general principle here is to put the faction in every octbox cell that a system
-	    that is a member of that faction could be in. This should let us cut the number
-		of factions that have to be checked by GetNearestFaction, by eliminating right off
-		all the those Factions that aren't in the same cell.
-
-		As I'm just going for the quick performance win, I'm being very sloppy and
-		treating a Faction as if it was a cube rather than a sphere. I'm also not even
-		attempting to work out real faction boundaries for this.
-
-		Obviously this all could be improved even without this Octsapling growing into
-		a full Octree.
-
-		This part happens at faction generation time so shouldn't be too performance
-		critical
+	/*  Factions are only ever considered for systems in the octants around the origin
+	    that they were put in here, at faction generation time. This treats a Faction
+		as if it was a cube rather than a sphere, and is kept exactly as it always was
+		because it decides the allegiance of systems close to the axes.
 	*/
 	RefCountedPtr<const Sector> sec = faction->GetHomeSector();
 
 	/* only factions with homeworlds that are available at faction generation time can
-	   be added to specific cells...
+	   be restricted to specific cells...
 	*/
+	Uint8 mask = 0xff;
 	if (faction->hasHomeworld && (faction->homeworld.systemIndex < sec->m_systems.size())) {
-		/* calculate potential indexes for the octbox cells the faction needs to go into
-		*/
-		Sector::System sys = sec->m_systems[faction->homeworld.systemIndex];
+		const Sector::System& sys = sec->m_systems[faction->homeworld.systemIndex];
+		const vector3f pos = sys.GetFullPosition();
+		const float radius = float(faction->Radius());
+
+		const Sint32 xs[2] = { Sint32(pos.x - radius), Sint32(pos.x + radius) };
+		const Sint32 ys[2] = { Sint32(pos.y - radius), Sint32(pos.y + radius) };
+		const Sint32 zs[2] = { Sint32(pos.z - radius), Sint32(pos.z + radius) };
+
+		mask = 0;
+		for (int x = 0; x < 2; x++)
+			for (int y = 0; y < 2; y++)
+				for (int z = 0; z < 2; z++)
+					mask |= CellBit(xs[x], ys[y], zs[z]);
+	}
+	/* ...other factions, such as ones with no homeworlds, and more annoyingly ones
+	   whose homeworlds don't exist yet because they're custom systems have to go in
+	   *every* cell
+	*/
+	m_cellMasks.push_back(mask);
+}
 
-		int xmin = BoxIndex(Sint32(sys.GetFullPosition().x - float((faction->Radius()))));
-		int xmax = BoxIndex(Sint32(sys.GetFullPosition().x + float((faction->Radius()))));
-		int ymin = BoxIndex(Sint32(sys.GetFullPosition().y - float((faction->Radius()))));
-		int ymax = BoxIndex(Sint32(sys.GetFullPosition().y + float((faction->Radius()))));
-		int zmin = BoxIndex(Sint32(sys.GetFullPosition().z - float((faction->Radius()))));
-		int zmax = BoxIndex(Sint32(sys.GetFullPosition().z + float((faction->Radius()))));
+void FactionsDatabase::SpatialIndex::Build(const FactionList& factions)
+{
+	PROFILE_SCOPED()
+	m_nodes.clear();
+	m_items.clear();
+	m_unbounded.clear();
+	m_claims.clear();
+
+	// fudge factor so float rounding in system positions can't push a system out of a box
+	static const double PADDING = 1.0;
+
+	for (const Faction* faction : factions) {
+		for (const SystemPath& claim : faction->m_ownedsystemlist) {
+			std::vector<const Faction*>& claimants = m_claims[claim];
+			if (claimants.empty() || claimants.back() != faction)
+				claimants.push_back(faction);
+		}
 
-		/* put the faction in all the octbox cells needed in a hideously inexact way that
-		   will generate duplicates in each cell in many cases
-		*/
-		octbox[xmin][ymin][zmin].push_back(faction);  // 0,0,0
-		octbox[xmax][ymin][zmin].push_back(faction);  // 1,0,0
-		octbox[xmax][ymax][zmin].push_back(faction);  // 1,1,0
-		octbox[xmax][ymax][zmax].push_back(faction);  // 1,1,1
+		if (!faction->hasHomeworld || !faction->m_hasHomePos) {
+			m_unbounded.push_back(faction);
+			continue;
+		}
 
-		octbox[xmin][ymax][zmin].push_back(faction);  // 0,1,0
-		octbox[xmin][ymax][zmax].push_back(faction);  // 0,1,1
-		octbox[xmin][ymin][zmax].push_back(faction);  // 0,0,1
-		octbox[xmax][ymin][zmax].push_back(faction);  // 1,0,1
+		// the faction sphere, plus its home sector which it always owns
+		const vector3d sectorMin = double(Sector::SIZE) * vector3d(faction->homeworld.sectorX, faction->homeworld.sectorY, faction->homeworld.sectorZ);
+		const vector3d sectorMax = sectorMin + vector3d(Sector::SIZE);
+		const vector3d home = sectorMin + vector3d(faction->m_homePos);
+		const double radius = std::max(faction->Radius(), 0.0) + PADDING;
+
+		Item item;
+		item.bounds.Update(home - vector3d(radius));
+		item.bounds.Update(home + vector3d(radius));
+		item.bounds.Update(sectorMin - vector3d(PADDING));
+		item.bounds.Update(sectorMax + vector3d(PADDING));
+		item.centre = (item.bounds.min + item.bounds.max) * 0.5;
+		item.faction = faction;
+		m_items.push_back(item);
+	}
 
-		/* prune any duplicates from the octbox cells making things slightly saner
-		*/
-		PruneDuplicates(0,0,0);
-		PruneDuplicates(1,0,0);
-		PruneDuplicates(1,1,0);
-		PruneDuplicates(1,1,1);
+	if (!m_items.empty())
+		BuildNode(0, m_items.size(), 0);
+	m_built = true;
+}
 
-		PruneDuplicates(0,1,0);
-		PruneDuplicates(0,1,1);
-		PruneDuplicates(0,0,1);
-		PruneDuplicates(1,0,1);
+Uint32 FactionsDatabase::SpatialIndex::BuildNode(Uint32 begin, Uint32 end, int depth)
+{
+	const Uint32 index = m_nodes.size();
+	m_nodes.push_back(Node());
 
-	} else {
-	/* ...other factions, such as ones with no homeworlds, and more annoyingly ones
-	   whose homeworlds don't exist yet because they're custom systems have to go in
-	   *every* octbox cell
-	*/
-		octbox[0][0][0].push_back(faction);
-		octbox[1][0][0].push_back(faction);
-		octbox[1][1][0].push_back(faction);
-		octbox[1][1][1].push_back(faction);
-
-		octbox[0][1][0].push_back(faction);
-		octbox[0][1][1].push_back(faction);
-		octbox[0][0][1].push_back(faction);
-		octbox[1][0][1].push_back(faction);
+	Aabb bounds;
+	Aabb centres;
+	for (Uint32 i = begin; i < end; i++) {
+		bounds.Update(m_items[i].bounds.min);
+		bounds.Update(m_items[i].bounds.max);
+		centres.Update(m_items[i].centre);
 	}
+	m_nodes[index].bounds = bounds;
+
+	if (end - begin <= MAX_LEAF_ITEMS || depth + 1 >= MAX_DEPTH) {
+		m_nodes[index].first = begin;
+		m_nodes[index].count = end - begin;
+		return index;
+	}
+
+	// split at the median along the widest axis of the item centres
+	const vector3d extent = centres.max - centres.min;
+	const int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+	const Uint32 mid = begin + (end - begin) / 2;
+	std::nth_element(m_items.begin() + begin, m_items.begin() + mid, m_items.begin() + end,
+		[axis](const Item& a, const Item& b) { return a.centre[axis] < b.centre[axis]; });
+
+	// the left child always directly follows its parent
+	BuildNode(begin, mid, depth + 1);
+	m_nodes[index].first = BuildNode(mid, end, depth + 1);
+	m_nodes[index].count = 0;
+	return index;
 }
 
-void FactionsDatabase::Octsapling::PruneDuplicates(const int bx, const int by, const int bz)
+template <typename Visitor>
+void FactionsDatabase::SpatialIndex::VisitContaining(const vector3f& pos, Visitor visit) const
 {
 	PROFILE_SCOPED()
-	octbox[bx][by][bz].erase(std::unique( octbox[bx][by][bz].begin(), octbox[bx][by][bz].end() ), octbox[bx][by][bz].end() );
+	if (m_nodes.empty())
+		return;
+
+	Uint32 stack[MAX_DEPTH + 1];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		const Uint32 index = stack[--top];
+		const Node& node = m_nodes[index];
+		if (!node.bounds.IsIn(pos))
+			continue;
+		if (node.count) {
+			for (Uint32 i = node.first; i < node.first + node.count; i++)
+				if (m_items[i].bounds.IsIn(pos))
+					visit(m_items[i].faction);
+		} else {
+			stack[top++] = index + 1;
+			stack[top++] = node.first;
+		}
+	}
 }
 
-const std::vector<const Faction*>& FactionsDatabase::Octsapling::CandidateFactions(const Sector::System* sys) const
+const Faction* FactionsDatabase::SpatialIndex::FindClaimant(const Sector::System* sys) const
 {
 	PROFILE_SCOPED()
-	/* answer the factions that we've put in the same octobox cell as the one the
-	   system would go in. This part happens every time we do GetNearest faction
-	   so *is* performance criticale.e
-	*/
-	return octbox[BoxIndex(sys->sx)][BoxIndex(sys->sy)][BoxIndex(sys->sz)];
+	if (m_claims.empty())
+		return nullptr;
+
+	// systems can be claimed on their own, or as part of a whole sector
+	SystemPath sector = sys->GetPath();
+	sector.systemIndex = -99;
+	const SystemPath paths[2] = { sector, sys->GetPath() };
+
+	// of several claimants, the first faction added wins
+	const Faction* result = nullptr;
+	for (const SystemPath& path : paths) {
+		auto it = m_claims.find(path);
+		if (it == m_claims.end())
+			continue;
+		for (const Faction* faction : it->second) {
+			if (!InCell(faction, sys))
+				continue;
+			if (!result || faction->idx < result->idx)
+				result = faction;
+			break;
+		}
+	}
+	return result;
 }
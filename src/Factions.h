@@ -12,6 +12,7 @@
 #include "fixed.h"
 #include "DeleteEmitter.h"
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <utility>
 
@@ -75,14 +76,12 @@ private:
 
 	Galaxy* const m_galaxy;							// galaxy we are part of
 	mutable RefCountedPtr<const Sector> m_homesector;	// cache of home sector to use in distance calculations
+	bool          m_hasHomePos;						// true once m_homePos has been filled in by FactionsDatabase::PostInit
+	vector3f      m_homePos;						// position of the homeworld system within its sector
 	const bool IsCloserAndContains(double& closestFactionDist, const Sector::System* sys) const;
+	const bool Contains(const Sector::System* sys, float& distance) const;
 };
 
-/* One day it might grow up to become a full tree, on the  other hand it might be
-   cut down before it's full growth to be replaced by
-   a proper spatial data structure.
-*/
-
 class FactionsDatabase {
 public:
 	FactionsDatabase(Galaxy* galaxy, const std::string& factionDir) : m_galaxy(galaxy), m_factionDirectory(factionDir), m_no_faction(galaxy), m_may_assign_factions(false), m_initialized(false) { }
@@ -106,18 +105,60 @@ public:
 	bool MayAssignFactions() const;
 
 private:
-	class Octsapling {
+	typedef std::vector<Faction*> FactionList;
+
+	/* Bounding volume hierarchy over the faction homeworld spheres, plus a hash
+	   table of explicit claims. Built once the galaxy is initialised; until then
+	   GetNearestClaimant falls back to checking every faction.
+	*/
+	class SpatialIndex {
 	public:
+		SpatialIndex() : m_built(false) {}
+
 		void Add(const Faction* faction);
-		const std::vector<const Faction*>& CandidateFactions(const Sector::System* sys) const;
+		void Build(const FactionList& factions);
+		bool IsBuilt() const { return m_built; }
+
+		// answers whether the faction was in the coarse octant cell of the system at the time it was added
+		bool InCell(const Faction* faction, const Sector::System* sys) const { return m_cellMasks[faction->idx] & CellBit(sys->sx, sys->sy, sys->sz); }
+
+		const Faction* FindClaimant(const Sector::System* sys) const;
+		template <typename Visitor> void VisitContaining(const vector3f& pos, Visitor visit) const;
+		const std::vector<const Faction*>& GetUnbounded() const { return m_unbounded; }
 
 	private:
-		std::vector<const Faction*> octbox[2][2][2];
+		struct Node {
+			Aabb   bounds;
+			Uint32 first;  // right child for inner nodes (the left one is the next node), first entry of m_items for leaves
+			Uint32 count;  // number of items for leaves, 0 for inner nodes
+		};
+		struct Item {
+			Aabb           bounds;
+			vector3d       centre;
+			const Faction* faction;
+		};
+		struct ClaimHash {
+			size_t operator()(const SystemPath& path) const {
+				return size_t(path.sectorX) * 73856093u ^ size_t(path.sectorY) * 19349663u ^ size_t(path.sectorZ) * 83492791u ^ size_t(path.systemIndex);
+			}
+		};
+		typedef std::unordered_map<SystemPath, std::vector<const Faction*>, ClaimHash> ClaimMap;
+
+		static const Uint32 MAX_LEAF_ITEMS = 4;
+		static const int    MAX_DEPTH      = 64;
+
 		static const int BoxIndex(Sint32 sectorIndex) { return sectorIndex < 0 ? 0: 1; };
-		void PruneDuplicates(const int bx, const int by, const int bz);
+		static const Uint8 CellBit(Sint32 x, Sint32 y, Sint32 z) { return Uint8(1 << (BoxIndex(x) * 4 + BoxIndex(y) * 2 + BoxIndex(z))); }
+		Uint32 BuildNode(Uint32 begin, Uint32 end, int depth);
+
+		bool                        m_built;
+		std::vector<Uint8>          m_cellMasks;   // per faction index
+		std::vector<Node>           m_nodes;
+		std::vector<Item>           m_items;
+		std::vector<const Faction*> m_unbounded;   // factions without a usable homeworld, they may contain any system
+		ClaimMap                    m_claims;
 	};
 
-	typedef std::vector<Faction*> FactionList;
 	typedef FactionList::iterator FactionIterator;
 	typedef const std::vector<const Faction*> ConstFactionList;
 	typedef ConstFactionList::const_iterator ConstFactionIterator;
@@ -134,7 +175,7 @@ private:
 	FactionList       m_factions;
 	FactionMap        m_factions_byName;
 	HomeSystemSet     m_homesystems;
-	Octsapling        m_spatial_index;
+	SpatialIndex      m_spatial_index;
 	bool              m_may_assign_factions;
 	bool              m_initialized = false;
 	MissingFactionsMap m_missingFactionsMap;
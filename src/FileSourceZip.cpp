@@ -13,7 +13,7 @@ extern "C" {
 
 namespace FileSystem {
 
-FileSourceZip::FileSourceZip(FileSourceFS &fs, const std::string &zipPath) : FileSource(zipPath), m_archive(0)
+FileSourceZip::FileSourceZip(FileSourceFS &fs, const std::string &zipPath) : FileSource(zipPath), m_archive(0), m_lock(SDL_CreateMutex())
 {
 	mz_zip_archive *zip = static_cast<mz_zip_archive*>(std::calloc(1, sizeof(mz_zip_archive)));
 	FILE *file = fs.OpenReadStream(zipPath);
@@ -45,6 +45,7 @@ FileSourceZip::FileSourceZip(FileSourceFS &fs, const std::string &zipPath) : Fil
 
 FileSourceZip::~FileSourceZip()
 {
+	SDL_DestroyMutex(m_lock);
 	if (!m_archive) return;
 	mz_zip_archive *zip = static_cast<mz_zip_archive*>(m_archive);
 	mz_zip_reader_end(zip);
@@ -124,8 +125,12 @@ RefCountedPtr<FileData> FileSourceZip::ReadFile(const std::string &path)
 	const FileStat &st = (*i).second;
 
 	char *data = static_cast<char*>(std::malloc(st.size));
-	if (!mz_zip_reader_extract_to_mem(zip, st.index, data, st.size, 0)) {
+	SDL_LockMutex(m_lock);
+	const bool extracted = mz_zip_reader_extract_to_mem(zip, st.index, data, st.size, 0);
+	SDL_UnlockMutex(m_lock);
+	if (!extracted) {
 		Output("FileSourceZip::ReadFile: couldn't extract '%s'\n", path.c_str());
+		std::free(data);
 		return RefCountedPtr<FileData>();
 	}
 
@@ -6,6 +6,7 @@
 
 #include "FileSystem.h"
 #include <SDL_stdinc.h>
+#include <SDL_mutex.h>
 #include <map>
 #include <string>
 
@@ -24,6 +25,9 @@ public:
 
 private:
 	void *m_archive;
+	// the archive can only extract one file at a time, textures are read
+	// from worker threads
+	SDL_mutex *m_lock;
 
 	struct FileStat {
 		FileStat(Uint32 _index, Uint64 _size, const FileInfo &_info) : index(_index), size(_size), info(_info) {}
@@ -93,6 +93,7 @@ namespace FileSystem {
 		const FileSource &GetSource() const { return *m_source; }
 
 		RefCountedPtr<FileData> Read() const;
+		RefCountedPtr<FileData> Map() const;
 
 		friend bool operator==(const FileInfo &a, const FileInfo &b)
 		{ return (a.m_source == b.m_source && a.m_type == b.m_type && a.m_path == b.m_path); }
@@ -166,6 +167,11 @@ namespace FileSystem {
 		virtual RefCountedPtr<FileData> ReadFile(const std::string &path) = 0;
 		virtual bool ReadDirectory(const std::string &path, std::vector<FileInfo> &output) = 0;
 
+		// as ReadFile, but where the source can the data is the file mapped
+		// read-only into memory, so only the pages used are read and nothing
+		// is copied
+		virtual RefCountedPtr<FileData> MapFile(const std::string &path) { return ReadFile(path); }
+
 		bool IsTrusted() const { return m_trusted; }
 
 	protected:
@@ -185,6 +191,7 @@ namespace FileSystem {
 		virtual FileInfo Lookup(const std::string &path);
 		virtual RefCountedPtr<FileData> ReadFile(const std::string &path);
 		virtual bool ReadDirectory(const std::string &path, std::vector<FileInfo> &output);
+		virtual RefCountedPtr<FileData> MapFile(const std::string &path);
 
 		bool MakeDirectory(const std::string &path);
 
@@ -213,6 +220,7 @@ namespace FileSystem {
 		virtual FileInfo Lookup(const std::string &path);
 		virtual RefCountedPtr<FileData> ReadFile(const std::string &path);
 		virtual bool ReadDirectory(const std::string &path, std::vector<FileInfo> &output);
+		virtual RefCountedPtr<FileData> MapFile(const std::string &path);
 
 	private:
 		std::vector<FileSource*> m_sources;
@@ -258,4 +266,7 @@ inline std::string FileSystem::FileInfo::GetAbsolutePath() const
 inline RefCountedPtr<FileSystem::FileData> FileSystem::FileInfo::Read() const
 { return m_source->ReadFile(m_path); }
 
+inline RefCountedPtr<FileSystem::FileData> FileSystem::FileInfo::Map() const
+{ return m_source->MapFile(m_path); }
+
 #endif
@@ -9,6 +9,8 @@
 #include "SpaceStation.h"
 #include "HyperspaceCloud.h"
 #include "Pi.h"
+#include "ModelCache.h"
+#include "ShipType.h"
 #include "ShipCpanel.h"
 #include "Sfx.h"
 #include "MathUtil.h"
@@ -32,6 +34,15 @@ static const int  s_saveVersion   = 84;
 static const char s_saveStart[]   = "PIONEER";
 static const char s_saveEnd[]     = "END";
 
+// scripts spawn ships of any type the moment a system is entered, and a ship
+// takes its model straight away, so have them all loading in the background
+// first. Those already loaded or on their way are skipped
+static void RequestShipModels()
+{
+	for (auto &it : ShipType::types)
+		Pi::modelCache->RequestModel(it.second.modelName);
+}
+
 Game::Game(const SystemPath &path, double time) :
 	m_galaxy(GalaxyGenerator::Create()),
 	m_time(time),
@@ -41,6 +52,8 @@ Game::Game(const SystemPath &path, double time) :
 	m_requestedTimeAccel(TIMEACCEL_1X),
 	m_forceTimeAccel(false)
 {
+	RequestShipModels();
+
 	// Now that we have a Galaxy, check the starting location
 	if (!path.IsBodyPath())
 		throw InvalidGameStartLocation("SystemPath is not a body path");
@@ -114,6 +127,8 @@ m_timeAccel(TIMEACCEL_PAUSED),
 m_requestedTimeAccel(TIMEACCEL_PAUSED),
 m_forceTimeAccel(false)
 {
+	RequestShipModels();
+
 	// signature check
 	if (!jsonObj.isMember("signature")) throw SavedGameCorruptException();
 	Json::Value signature = jsonObj["signature"];
@@ -416,6 +431,9 @@ void Game::RemoveHyperspaceCloud(HyperspaceCloud* cloud)
 void Game::SwitchToHyperspace()
 {
 	PROFILE_SCOPED()
+	// they have the jump to load in
+	RequestShipModels();
+
 	// remember where we came from so we can properly place the player on exit
 	m_hyperspaceSource = m_space->GetStarSystem()->GetPath();
 	m_hyperspaceDest =  m_player->GetHyperspaceDest();
@@ -494,6 +512,9 @@ void Game::SwitchToNormalSpace()
 	// remove the player from hyperspace
 	m_space->RemoveBody(m_player.get());
 
+	// routes scripts asked for were all relative to the system we just left
+	m_galaxy->GetRouteCache()->ClearCache();
+
 	// create a new space for the system
 	m_space.reset(new Space(this, m_galaxy, m_hyperspaceDest, m_space.get()));
 
@@ -56,6 +56,9 @@ GameConfig::GameConfig(const map_string &override_)
 	map["EnableGLDebug"] = "0";
 	map["EnableGPUJobs"] = "1";
 	map["GL3ForwardCompatible"] = "1";
+	map["UseProgramCache"] = "1";
+	map["StreamTextures"] = "1";
+	map["TextureBudget"] = "512"; // MB, 0 to keep every texture loaded
 
 	Load();
 
@@ -5,6 +5,7 @@
 #include "GeoPatchContext.h"
 #include "GeoPatch.h"
 #include "GeoPatchJobs.h"
+#include "GeoPatchPool.h"
 #include "GeoSphere.h"
 #include "perlin.h"
 #include "Pi.h"
@@ -48,6 +49,7 @@ GeoPatch::GeoPatch(const RefCountedPtr<GeoPatchContext> &ctx_, GeoSphere *gs,
  	}
 	m_roughLength = GEOPATCH_SUBDIVIDE_AT_CAMDIST / pow(2.0, depth) * distMult;
 	m_needUpdateVBOs = false;
+	m_poolSlot = GeoPatchPool::INVALID_SLOT;
 }
 
 GeoPatch::~GeoPatch() {
@@ -55,6 +57,8 @@ GeoPatch::~GeoPatch() {
 	for (int i=0; i<NUM_KIDS; i++) {
 		kids[i].reset();
 	}
+	if (m_poolSlot != GeoPatchPool::INVALID_SLOT)
+		geosphere->GetPatchPool()->Free(m_poolSlot);
 	heights.reset();
 	normals.reset();
 	colors.reset();
@@ -67,22 +71,32 @@ void GeoPatch::UpdateVBOs(Graphics::Renderer *renderer)
 		assert(renderer);
 		m_needUpdateVBOs = false;
 
-		//create buffer and upload data
-		Graphics::VertexBufferDesc vbd;
-		vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
-		vbd.attrib[0].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
-		vbd.attrib[1].semantic = Graphics::ATTRIB_NORMAL;
-		vbd.attrib[1].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
-		vbd.attrib[2].semantic = Graphics::ATTRIB_DIFFUSE;
-		vbd.attrib[2].format   = Graphics::ATTRIB_FORMAT_UBYTE4;
-		vbd.attrib[3].semantic = Graphics::ATTRIB_UV0;
-		vbd.attrib[3].format   = Graphics::ATTRIB_FORMAT_FLOAT2;
-		vbd.numVertices = ctx->NUMVERTICES();
-		vbd.usage = Graphics::BUFFER_USAGE_STATIC;
-		m_vertexBuffer.reset(renderer->CreateVertexBuffer(vbd));
-
-		GeoPatchContext::VBOVertex* VBOVtxPtr = m_vertexBuffer->Map<GeoPatchContext::VBOVertex>(Graphics::BUFFER_MAP_WRITE);
-		assert(m_vertexBuffer->GetDesc().stride == sizeof(GeoPatchContext::VBOVertex));
+		GeoPatchPool *pool = geosphere->GetPatchPool();
+		GeoPatchContext::VBOVertex* VBOVtxPtr;
+		if (pool) {
+			// build the vertices on the side and copy them into our slot
+			assert(pool->GetPatchVertices() == Uint32(ctx->NUMVERTICES()));
+			if (m_poolSlot == GeoPatchPool::INVALID_SLOT)
+				m_poolSlot = pool->Allocate();
+			VBOVtxPtr = pool->GetScratch();
+		} else {
+			//create buffer and upload data
+			Graphics::VertexBufferDesc vbd;
+			vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
+			vbd.attrib[0].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
+			vbd.attrib[1].semantic = Graphics::ATTRIB_NORMAL;
+			vbd.attrib[1].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
+			vbd.attrib[2].semantic = Graphics::ATTRIB_DIFFUSE;
+			vbd.attrib[2].format   = Graphics::ATTRIB_FORMAT_UBYTE4;
+			vbd.attrib[3].semantic = Graphics::ATTRIB_UV0;
+			vbd.attrib[3].format   = Graphics::ATTRIB_FORMAT_FLOAT2;
+			vbd.numVertices = ctx->NUMVERTICES();
+			vbd.usage = Graphics::BUFFER_USAGE_STATIC;
+			m_vertexBuffer.reset(renderer->CreateVertexBuffer(vbd));
+
+			VBOVtxPtr = m_vertexBuffer->Map<GeoPatchContext::VBOVertex>(Graphics::BUFFER_MAP_WRITE);
+			assert(m_vertexBuffer->GetDesc().stride == sizeof(GeoPatchContext::VBOVertex));
+		}
 
 		const Sint32 edgeLen = ctx->GetEdgeLen();
 		const double frac = ctx->GetFrac();
@@ -224,7 +238,10 @@ void GeoPatch::UpdateVBOs(Graphics::Renderer *renderer)
 
 		// ----------------------------------------------------
 		// end of mapping
-		m_vertexBuffer->Unmap();
+		if (pool)
+			pool->Upload(m_poolSlot);
+		else
+			m_vertexBuffer->Unmap();
 
 		// Don't need this anymore so throw it away
 		normals.reset();
@@ -267,19 +284,27 @@ void GeoPatch::Render(Graphics::Renderer *renderer, const vector3d &campos, cons
 	if (kids[0]) {
 		for (int i=0; i<NUM_KIDS; i++) kids[i]->Render(renderer, campos, modelView, frustum);
 	} else if (heights) {
-		RefCountedPtr<Graphics::Material> mat = geosphere->GetSurfaceMaterial();
-		Graphics::RenderState *rs = geosphere->GetSurfRenderState();
-
 		const vector3d relpos = clipCentroid - campos;
-		renderer->SetTransform(modelView * matrix4x4d::Translation(relpos));
 
 		Pi::statSceneTris += (ctx->GetNumTris());
 		++Pi::statNumPatches;
 
-		// per-patch detail texture scaling value
-		geosphere->GetMaterialParameters().patchDepth = m_depth;
+		GeoPatchPool *pool = geosphere->GetPatchPool();
+		if (pool) {
+			// drawn along with all the others at the end of GeoSphere::Render
+			const float detailFrequency = pow(2.0f, float(geosphere->GetMaterialParameters().maxPatchDepth - m_depth));
+			pool->AddPatch(m_poolSlot, vector3f(relpos), detailFrequency);
+		} else {
+			RefCountedPtr<Graphics::Material> mat = geosphere->GetSurfaceMaterial();
+			Graphics::RenderState *rs = geosphere->GetSurfRenderState();
 
-		renderer->DrawBufferIndexed(m_vertexBuffer.get(), ctx->GetIndexBuffer(), rs, mat.Get());
+			renderer->SetTransform(modelView * matrix4x4d::Translation(relpos));
+
+			// per-patch detail texture scaling value
+			geosphere->GetMaterialParameters().patchDepth = m_depth;
+
+			renderer->DrawBufferIndexed(m_vertexBuffer.get(), ctx->GetIndexBuffer(), rs, mat.Get());
+		}
 #ifdef DEBUG_BOUNDING_SPHERES
 		if(m_boundsphere.get()) {
 			renderer->SetWireFrameMode(true);
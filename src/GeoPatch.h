@@ -45,6 +45,7 @@ private:
 	double clipRadius;
 	Sint32 m_depth;
 	bool m_needUpdateVBOs;
+	Uint32 m_poolSlot; // in the GeoSphere's GeoPatchPool, if it has one
 
 	const GeoPatchID mPatchID;
 	Job::Handle m_job;
@@ -0,0 +1,112 @@
+// Copyright © 2008-2018 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "libs.h"
+#include "GeoPatchPool.h"
+#include "graphics/Renderer.h"
+#include "graphics/Material.h"
+
+// aim for vertex buffers of about this many bytes
+static const Uint32 POOL_BUFFER_SIZE = 16 * 1024 * 1024;
+
+GeoPatchPool::GeoPatchPool(Graphics::Renderer *r, Uint32 patchVertices) :
+	m_renderer(r),
+	m_patchVertices(patchVertices),
+	m_scratch(patchVertices)
+{
+	const Uint32 patchSize = patchVertices * sizeof(GeoPatchContext::VBOVertex);
+	m_slotsPerBuffer = std::max(POOL_BUFFER_SIZE / patchSize, 16U);
+}
+
+GeoPatchPool::~GeoPatchPool()
+{
+}
+
+void GeoPatchPool::AddBuffer()
+{
+	PROFILE_SCOPED()
+	Graphics::VertexBufferDesc vbd;
+	vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
+	vbd.attrib[0].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
+	vbd.attrib[1].semantic = Graphics::ATTRIB_NORMAL;
+	vbd.attrib[1].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
+	vbd.attrib[2].semantic = Graphics::ATTRIB_DIFFUSE;
+	vbd.attrib[2].format   = Graphics::ATTRIB_FORMAT_UBYTE4;
+	vbd.attrib[3].semantic = Graphics::ATTRIB_UV0;
+	vbd.attrib[3].format   = Graphics::ATTRIB_FORMAT_FLOAT2;
+	vbd.numVertices = m_slotsPerBuffer * m_patchVertices;
+	vbd.usage = Graphics::BUFFER_USAGE_STATIC;
+
+	m_buffers.push_back(Buffer());
+	Buffer &buf = m_buffers.back();
+	buf.vertexBuffer.reset(m_renderer->CreateVertexBuffer(vbd));
+	assert(buf.vertexBuffer->GetDesc().stride == sizeof(GeoPatchContext::VBOVertex));
+	buf.patchData.resize(m_slotsPerBuffer * 4, 0.0f);
+
+	// hand out the lowest slots first
+	buf.freeSlots.reserve(m_slotsPerBuffer);
+	for (Uint32 i = m_slotsPerBuffer; i > 0; i--)
+		buf.freeSlots.push_back(i - 1);
+}
+
+Uint32 GeoPatchPool::Allocate()
+{
+	for (Uint32 b = 0; b < m_buffers.size(); b++) {
+		Buffer &buf = m_buffers[b];
+		if (!buf.freeSlots.empty()) {
+			const Uint32 slot = buf.freeSlots.back();
+			buf.freeSlots.pop_back();
+			return b * m_slotsPerBuffer + slot;
+		}
+	}
+
+	AddBuffer();
+	Buffer &buf = m_buffers.back();
+	const Uint32 slot = buf.freeSlots.back();
+	buf.freeSlots.pop_back();
+	return (m_buffers.size() - 1) * m_slotsPerBuffer + slot;
+}
+
+void GeoPatchPool::Free(Uint32 slot)
+{
+	assert(slot != INVALID_SLOT);
+	m_buffers[slot / m_slotsPerBuffer].freeSlots.push_back(slot % m_slotsPerBuffer);
+}
+
+void GeoPatchPool::Upload(Uint32 slot)
+{
+	PROFILE_SCOPED()
+	const size_t patchSize = m_patchVertices * sizeof(GeoPatchContext::VBOVertex);
+	Buffer &buf = m_buffers[slot / m_slotsPerBuffer];
+	buf.vertexBuffer->BufferSubData((slot % m_slotsPerBuffer) * patchSize, patchSize, &m_scratch[0]);
+}
+
+void GeoPatchPool::AddPatch(Uint32 slot, const vector3f &offset, float detailFrequency)
+{
+	Buffer &buf = m_buffers[slot / m_slotsPerBuffer];
+	const Uint32 idx = slot % m_slotsPerBuffer;
+	float *data = &buf.patchData[idx * 4];
+	data[0] = offset.x;
+	data[1] = offset.y;
+	data[2] = offset.z;
+	data[3] = detailFrequency;
+	buf.baseVertices.push_back(idx * m_patchVertices);
+}
+
+void GeoPatchPool::Draw(Graphics::Renderer *r, Graphics::RenderState *rs, Graphics::Material *mat, BaseSphere::MaterialParameters &params)
+{
+	PROFILE_SCOPED()
+	params.patchVertices = m_patchVertices;
+	for (Buffer &buf : m_buffers) {
+		if (buf.baseVertices.empty())
+			continue;
+
+		params.patchData = &buf.patchData[0];
+		params.numPatchData = m_slotsPerBuffer;
+		r->DrawBufferIndexedMulti(buf.vertexBuffer.get(), GeoPatchContext::GetIndexBuffer(), rs, mat,
+			&buf.baseVertices[0], buf.baseVertices.size());
+		buf.baseVertices.clear();
+	}
+	params.patchData = nullptr;
+	params.numPatchData = 0;
+}
@@ -0,0 +1,66 @@
+// Copyright © 2008-2018 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GEOPATCHPOOL_H
+#define _GEOPATCHPOOL_H
+
+#include <SDL_stdinc.h>
+
+#include "vector3.h"
+#include "GeoPatchContext.h"
+#include "BaseSphere.h"
+#include "graphics/VertexBuffer.h"
+
+#include <memory>
+#include <vector>
+
+namespace Graphics {
+	class Renderer;
+	class RenderState;
+	class Material;
+}
+
+// Shares a few large vertex buffers between all the patches of a GeoSphere.
+// Each patch gets a slot holding its vertices, and the visible ones are drawn
+// with one multi-draw call per buffer instead of one call per patch. The
+// per-patch data that used to be set between draws (camera relative offset
+// and detail texture frequency) goes to the terrain shader in a buffer,
+// indexed by the slot its vertices are in.
+class GeoPatchPool {
+public:
+	static const Uint32 INVALID_SLOT = ~0U;
+
+	GeoPatchPool(Graphics::Renderer *r, Uint32 patchVertices);
+	~GeoPatchPool();
+
+	Uint32 GetPatchVertices() const { return m_patchVertices; }
+
+	Uint32 Allocate();
+	void Free(Uint32 slot);
+
+	// space for one patch's vertices, to be filled and then uploaded
+	GeoPatchContext::VBOVertex *GetScratch() { return &m_scratch[0]; }
+	void Upload(Uint32 slot);
+
+	// collects this frame's visible patches, then draws them
+	void AddPatch(Uint32 slot, const vector3f &offset, float detailFrequency);
+	void Draw(Graphics::Renderer *r, Graphics::RenderState *rs, Graphics::Material *mat, BaseSphere::MaterialParameters &params);
+
+private:
+	struct Buffer {
+		std::unique_ptr<Graphics::VertexBuffer> vertexBuffer;
+		std::vector<Uint32> freeSlots;
+		std::vector<Uint32> baseVertices; // of the slots to draw this frame
+		std::vector<float> patchData;     // 4 floats per slot
+	};
+
+	void AddBuffer();
+
+	Graphics::Renderer *m_renderer;
+	Uint32 m_patchVertices;
+	Uint32 m_slotsPerBuffer;
+	std::vector<Buffer> m_buffers;
+	std::vector<GeoPatchContext::VBOVertex> m_scratch;
+};
+
+#endif /* _GEOPATCHPOOL_H */
@@ -3,9 +3,11 @@
 
 #include "libs.h"
 #include "GeoSphere.h"
+#include "Bench.h"
 #include "GeoPatchContext.h"
 #include "GeoPatch.h"
 #include "GeoPatchJobs.h"
+#include "GeoPatchPool.h"
 #include "perlin.h"
 #include "Pi.h"
 #include "RefCounted.h"
@@ -67,6 +69,7 @@ static void print_info(const SystemBody *sbody, const Terrain *terrain)
 void GeoSphere::UpdateAllGeoSpheres()
 {
 	PROFILE_SCOPED()
+	BENCH_SCOPED(SECTION_GEOSPHERE_LOD)
 	for(std::vector<GeoSphere*>::iterator i = s_allGeospheres.begin(); i != s_allGeospheres.end(); ++i)
 	{
 		(*i)->Update();
@@ -462,10 +465,19 @@ void GeoSphere::Render(Graphics::Renderer *renderer, const matrix4x4d &modelView
 
 	renderer->SetTransform(modelView);
 
+	// the patch size changes with the detail level, by which time Reset has
+	// already thrown away all of the patches using the old pool
+	if (m_patchPool && m_patchPool->GetPatchVertices() != Uint32(GeoPatchContext::NUMVERTICES()))
+		m_patchPool.reset(new GeoPatchPool(renderer, GeoPatchContext::NUMVERTICES()));
+
 	for (int i=0; i<NUM_PATCHES; i++) {
 		m_patches[i]->Render(renderer, campos, modelView, frustum);
 	}
 
+	// pooled patches only queue themselves up in Render
+	if (m_patchPool)
+		m_patchPool->Draw(renderer, m_surfRenderState, m_surfaceMaterial.Get(), m_materialParameters);
+
 	renderer->SetAmbientColor(oldAmbient);
 
 	renderer->GetStats().AddToStatCount(Graphics::Stats::STAT_PLANETS, 1);
@@ -521,6 +533,11 @@ void GeoSphere::SetUpMaterials()
 	if (bEnableDetailMaps) {
 		surfDesc.quality |= Graphics::HAS_DETAIL_MAPS;
 	}
+	// terrain (not stars) can draw all of its patches from one shared pool
+	if (surfDesc.effect != Graphics::EFFECT_GEOSPHERE_STAR && Pi::renderer->SupportsMultiDraw()) {
+		surfDesc.quality |= Graphics::HAS_PATCH_BATCHING;
+		m_patchPool.reset(new GeoPatchPool(Pi::renderer, GeoPatchContext::NUMVERTICES()));
+	}
 	m_surfaceMaterial.Reset(Pi::renderer->CreateMaterial(surfDesc));
 
 	m_texHi.Reset( Graphics::TextureBuilder::Model("textures/high.dds").GetOrCreateTexture(Pi::renderer, "model") );
@@ -22,6 +22,7 @@ namespace Graphics { class Renderer; }
 class SystemBody;
 class GeoPatch;
 class GeoPatchContext;
+class GeoPatchPool;
 class SQuadSplitRequest;
 class SQuadSplitResult;
 class SSingleSplitResult;
@@ -67,6 +68,8 @@ public:
 	virtual void Reset() override;
 
 	inline Sint32 GetMaxDepth() const { return m_maxDepth; }
+	// nullptr when each patch has its own vertex buffer
+	GeoPatchPool *GetPatchPool() const { return m_patchPool.get(); }
 
 	void AddQuadSplitRequest(double, SQuadSplitRequest*, GeoPatch*);
 
@@ -78,6 +81,8 @@ private:
 	}
 	void ProcessQuadSplitRequests();
 
+	// declared first so that it outlives the patches holding slots in it
+	std::unique_ptr<GeoPatchPool> m_patchPool;
 	std::unique_ptr<GeoPatch> m_patches[6];
 	struct TDistanceRequest {
 		TDistanceRequest(double dist, SQuadSplitRequest *pRequest, GeoPatch *pRequester) :
@@ -15,6 +15,7 @@
 #include "FileSystem.h"
 #include "ui/Context.h"
 #include "graphics/Graphics.h"
+#include "graphics/Renderer.h"
 #include "Sound.h"
 #include "SoundMusic.h"
 #include "KeyBindings.h"
@@ -195,6 +196,78 @@ static int l_engine_get_video_mode_list(lua_State *l)
 	return 1;
 }
 
+/*
+ * Method: GetFrameTimings
+ *
+ * Get the average CPU and GPU time of the major rendering passes
+ *
+ * > timings = Engine.GetFrameTimings(frames)
+ *
+ * Parameters:
+ *
+ *   frames - optional, how many of the last frames to average over. Defaults to 30
+ *
+ * Returns:
+ *
+ *   timings - a table with the milliseconds per frame in cpu and gpu, and a
+ *             list of passes each with a name, depth, cpu and gpu. gpu is nil
+ *             where the renderer can't time it
+ *
+ * Availability:
+ *
+ *   2018-06
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_engine_get_frame_timings(lua_State *l)
+{
+	LUA_DEBUG_START(l);
+
+	const Uint32 frames = luaL_optinteger(l, 1, 30);
+	std::vector<Graphics::FrameTimings::Summary> passes;
+	double cpu, gpu;
+	Pi::renderer->GetFrameTimings().GetSummary(frames, passes, cpu, gpu);
+
+	lua_createtable(l, 0, 3);
+	lua_pushnumber(l, cpu);
+	lua_setfield(l, -2, "cpu");
+	if (gpu >= 0.0) {
+		lua_pushnumber(l, gpu);
+		lua_setfield(l, -2, "gpu");
+	}
+	lua_createtable(l, passes.size(), 0);
+	for (size_t i = 0; i < passes.size(); ++i) {
+		lua_createtable(l, 0, 4);
+		lua_pushstring(l, passes[i].name);
+		lua_setfield(l, -2, "name");
+		lua_pushinteger(l, passes[i].depth);
+		lua_setfield(l, -2, "depth");
+		lua_pushnumber(l, passes[i].cpuTime);
+		lua_setfield(l, -2, "cpu");
+		if (passes[i].gpuTime >= 0.0) {
+			lua_pushnumber(l, passes[i].gpuTime);
+			lua_setfield(l, -2, "gpu");
+		}
+		lua_rawseti(l, -2, i+1);
+	}
+	lua_setfield(l, -2, "passes");
+
+	LUA_DEBUG_END(l, 1);
+	return 1;
+}
+
+static int l_engine_get_display_frame_timings(lua_State *l)
+{
+#if WITH_DEVKEYS
+	lua_pushboolean(l, Pi::showFrameTimings);
+#else
+	lua_pushboolean(l, false);
+#endif
+	return 1;
+}
+
 /*
 * Method: GetMaximumAASamples
 *
@@ -1326,6 +1399,8 @@ void LuaEngine::Register()
 		{ "Quit", l_engine_quit },
 
 		{ "GetVideoModeList", l_engine_get_video_mode_list },
+		{ "GetFrameTimings", l_engine_get_frame_timings },
+		{ "GetDisplayFrameTimings", l_engine_get_display_frame_timings },
 		{ "GetMaximumAASamples", l_engine_get_maximum_aa_samples },
 		{ "GetVideoResolution", l_engine_get_video_resolution },
 		{ "SetVideoResolution", l_engine_set_video_resolution },
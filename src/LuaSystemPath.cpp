@@ -10,6 +10,7 @@
 #include "galaxy/StarSystem.h"
 #include "galaxy/Sector.h"
 #include "galaxy/GalaxyCache.h"
+#include "galaxy/RouteCache.h"
 
 /*
  * Class: SystemPath
@@ -313,6 +314,152 @@ static int l_sbodypath_distance_to(lua_State *l)
 	return 1;
 }
 
+static RefCountedPtr<const RouteTree> _check_route_tree(lua_State *l, const char *method, const SystemPath *origin, int rangeArg)
+{
+	if (!origin->HasValidSystem())
+		luaL_error(l, "SystemPath:%s() self argument does not refer to a system", method);
+
+	const double range = luaL_checknumber(l, rangeArg);
+	const int maxJumps = luaL_checkinteger(l, rangeArg + 1);
+	if (range <= 0.0)
+		luaL_error(l, "SystemPath:%s() jump range must be positive", method);
+	if (maxJumps < 1)
+		luaL_error(l, "SystemPath:%s() must allow at least one jump", method);
+
+	return Pi::game->GetGalaxy()->GetRouteCache()->GetRouteTree(*origin, float(range), maxJumps);
+}
+
+static void _push_route(lua_State *l, const RouteTree::Route &route)
+{
+	lua_createtable(l, 0, 3);
+	lua_pushliteral(l, "path");
+	LuaObject<SystemPath>::PushToLua(route.path);
+	lua_rawset(l, -3);
+	pi_lua_settable(l, "jumps", route.jumps);
+	pi_lua_settable(l, "distance", double(route.distance));
+}
+
+/*
+ * Method: GetReachableSystems
+ *
+ * Find every system that can be reached from this one with a limited number
+ * of hyperjumps of limited range
+ *
+ * > routes = path:GetReachableSystems(range, maxJumps)
+ *
+ * The search is done once per origin, range and jump limit and cached until
+ * the player moves to another system, so it is cheap to call repeatedly.
+ *
+ * Parameters:
+ *
+ *   range - maximum length of a single jump, in light years
+ *
+ *   maxJumps - maximum number of jumps
+ *
+ * Return:
+ *
+ *   routes - an array of tables, one per reachable system (not including
+ *            this one), ordered by number of jumps and then by distance. Each
+ *            table has the fields path (a <SystemPath>), jumps (the fewest
+ *            jumps needed) and distance (the shortest total distance in light
+ *            years using that many jumps)
+ *
+ * Availability:
+ *
+ *   2018-10-18
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_sbodypath_get_reachable_systems(lua_State *l)
+{
+	PROFILE_SCOPED()
+	LUA_DEBUG_START(l);
+
+	const SystemPath *path = LuaObject<SystemPath>::CheckFromLua(1);
+	RefCountedPtr<const RouteTree> tree = _check_route_tree(l, "GetReachableSystems", path, 2);
+
+	const std::vector<RouteTree::Route> &routes = tree->GetRoutes();
+	lua_createtable(l, routes.size() > 0 ? int(routes.size() - 1) : 0, 0);
+	// the first route is the origin itself
+	for (size_t i = 1; i < routes.size(); i++) {
+		_push_route(l, routes[i]);
+		lua_rawseti(l, -2, int(i));
+	}
+
+	LUA_DEBUG_END(l, 1);
+	return 1;
+}
+
+/*
+ * Method: GetRoutesTo
+ *
+ * Find the number of jumps and total distance needed to reach each of a set
+ * of target systems
+ *
+ * > routes = path:GetRoutesTo(targets, range, maxJumps)
+ *
+ * All targets are answered from the same cached search as
+ * <GetReachableSystems>.
+ *
+ * Parameters:
+ *
+ *   targets - an array of <SystemPath> or <StarSystem> objects
+ *
+ *   range - maximum length of a single jump, in light years
+ *
+ *   maxJumps - maximum number of jumps
+ *
+ * Return:
+ *
+ *   routes - an array with one entry per target, in the same order. Each
+ *            entry is either a table with the fields path, jumps and distance
+ *            as described for <GetReachableSystems>, or false if the target
+ *            can't be reached within the given limits
+ *
+ * Availability:
+ *
+ *   2018-10-18
+ *
+ * Status:
+ *
+ *   experimental
+ */
+static int l_sbodypath_get_routes_to(lua_State *l)
+{
+	PROFILE_SCOPED()
+	LUA_DEBUG_START(l);
+
+	const SystemPath *path = LuaObject<SystemPath>::CheckFromLua(1);
+	luaL_checktype(l, 2, LUA_TTABLE);
+	RefCountedPtr<const RouteTree> tree = _check_route_tree(l, "GetRoutesTo", path, 3);
+
+	const int numTargets = int(lua_rawlen(l, 2));
+	lua_createtable(l, numTargets, 0);
+	for (int i = 1; i <= numTargets; i++) {
+		lua_rawgeti(l, 2, i);
+		const SystemPath *target = LuaObject<SystemPath>::GetFromLua(-1);
+		if (!target) {
+			StarSystem *sys = LuaObject<StarSystem>::GetFromLua(-1);
+			if (!sys)
+				return luaL_error(l, "SystemPath:GetRoutesTo() target #%d is not a SystemPath or StarSystem", i);
+			target = &sys->GetPath();
+		}
+		const RouteTree::Route *route = target->HasValidSystem() ? tree->FindRoute(target->SystemOnly()) : nullptr;
+		lua_pop(l, 1);
+
+		if (route)
+			_push_route(l, *route);
+		else
+			lua_pushboolean(l, false);
+		lua_rawseti(l, -2, i);
+	}
+
+	LUA_DEBUG_END(l, 1);
+	return 1;
+}
+
 /*
  * Method: GetStarSystem
  *
@@ -631,6 +778,9 @@ template <> void LuaObject<SystemPath>::RegisterClass()
 
 		{ "DistanceTo", l_sbodypath_distance_to },
 
+		{ "GetReachableSystems", l_sbodypath_get_reachable_systems },
+		{ "GetRoutesTo",         l_sbodypath_get_routes_to         },
+
 		{ "GetStarSystem", l_sbodypath_get_star_system },
 		{ "GetSystemBody", l_sbodypath_get_system_body },
 		{ "IsSystemPath",  l_sbodypath_is_system_path },
@@ -3,10 +3,45 @@
 
 #include "ModelCache.h"
 #include "scenegraph/SceneGraph.h"
+#include "scenegraph/BinaryConverter.h"
 #include "Shields.h"
+#include "utils.h"
 
-ModelCache::ModelCache(Graphics::Renderer *r)
+ModelCache::Prepared::Prepared() : done(SDL_CreateSemaphore(0)), failed(false)
+{
+}
+
+ModelCache::Prepared::~Prepared()
+{
+	SDL_DestroySemaphore(done);
+}
+
+class ModelCache::PrepareJob : public Job {
+public:
+	PrepareJob(const std::shared_ptr<Prepared> &prepared, const std::string &name) : m_prepared(prepared), m_name(name) {}
+
+	// RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
+	virtual void OnRun() override {
+		// whatever happens FindModel may be waiting, and the queue doesn't catch
+		try {
+			m_prepared->model.reset(SceneGraph::BinaryConverter::Prepare(m_name));
+		} catch (...) {
+			m_prepared->failed = true;
+		}
+		SDL_SemPost(m_prepared->done);
+	}
+
+	// the cache picks the model up itself, FindModel can't wait for FinishJobs
+	virtual void OnFinish() override {}
+
+private:
+	std::shared_ptr<Prepared> m_prepared;
+	std::string m_name;
+};
+
+ModelCache::ModelCache(Graphics::Renderer *r, JobQueue *queue)
 : m_renderer(r)
+, m_queue(queue)
 {
 
 }
@@ -16,26 +51,100 @@ ModelCache::~ModelCache()
 	Flush();
 }
 
+SceneGraph::Model *ModelCache::Load(const std::string &name, SceneGraph::PreparedModel *prepared)
+{
+	PROFILE_SCOPED()
+	try {
+		SceneGraph::Model *m = nullptr;
+		if (prepared) {
+			SceneGraph::BinaryConverter bc(m_renderer);
+			m = bc.Load(*prepared);
+		}
+		// no .sgm, or one that can't be used
+		if (!m) {
+			SceneGraph::Loader loader(m_renderer, false, false);
+			m = loader.LoadModel(name);
+		}
+		Shields::ReparentShieldNodes(m);
+		m_models[name] = m;
+		return m;
+	} catch (SceneGraph::LoadingError &) {
+		m_missing.insert(name);
+		throw ModelNotFoundException();
+	}
+}
+
+SceneGraph::Model *ModelCache::Finish(std::map<std::string, Request>::iterator it)
+{
+	const std::string name = it->first;
+	if (it->second.prepared->failed)
+		Output("Could not prepare %s.sgm, loading the model instead\n", name.c_str());
+	std::unique_ptr<SceneGraph::PreparedModel> prepared(std::move(it->second.prepared->model));
+	m_requests.erase(it);
+	return Load(name, prepared.get());
+}
+
 SceneGraph::Model *ModelCache::FindModel(const std::string &name)
 {
 	ModelMap::iterator it = m_models.find(name);
+	if (it != m_models.end())
+		return it->second;
+	if (m_missing.count(name))
+		throw ModelNotFoundException();
+
+	auto req = m_requests.find(name);
+	if (req == m_requests.end()) {
+		std::unique_ptr<SceneGraph::PreparedModel> prepared(SceneGraph::BinaryConverter::Prepare(name));
+		return Load(name, prepared.get());
+	}
+
+	// it's on its way, wait for that job alone
+	SDL_SemWait(req->second.prepared->done);
+	return Finish(req);
+}
 
-	if (it == m_models.end()) {
+void ModelCache::RequestModel(const std::string &name)
+{
+	if (m_models.count(name) || m_missing.count(name) || m_requests.count(name))
+		return;
+	Request &req = m_requests[name];
+	req.prepared.reset(new Prepared());
+	req.job = m_queue->Queue(new PrepareJob(req.prepared, name));
+}
+
+SceneGraph::Model *ModelCache::FindModelIfLoaded(const std::string &name)
+{
+	ModelMap::iterator it = m_models.find(name);
+	if (it != m_models.end())
+		return it->second;
+	if (m_missing.count(name))
+		throw ModelNotFoundException();
+	RequestModel(name);
+	return nullptr;
+}
+
+void ModelCache::Update()
+{
+	PROFILE_SCOPED()
+	// one a frame, the nodes and buffers still take a while
+	for (auto it = m_requests.begin(); it != m_requests.end(); ++it) {
+		if (SDL_SemTryWait(it->second.prepared->done) != 0)
+			continue;
+		const std::string name = it->first;
 		try {
-			SceneGraph::Loader loader(m_renderer);
-			SceneGraph::Model *m = loader.LoadModel(name);
-			Shields::ReparentShieldNodes(m);
-			m_models[name] = m;
-			return m;
-		} catch (SceneGraph::LoadingError &) {
-			throw ModelNotFoundException();
+			Finish(it);
+		} catch (const ModelNotFoundException &) {
+			Output("Could not find model: %s\n", name.c_str());
 		}
+		break;
 	}
-	return it->second;
 }
 
 void ModelCache::Flush()
 {
+	// the job handles cancel anything still being prepared
+	m_requests.clear();
+	m_missing.clear();
 	for(ModelMap::iterator it = m_models.begin(); it != m_models.end(); ++it) {
 		delete it->second;
 	}
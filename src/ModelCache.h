@@ -4,29 +4,68 @@
 #ifndef _MODELCACHE_H
 #define _MODELCACHE_H
 /*
- * This class is a quick thoughtless hack
+ * Models by name, loaded once and kept until Flush. A model can be requested
+ * ahead of use, in which case finding, reading and inflating its .sgm and
+ * building its collision mesh happen on the job queue, leaving only the nodes
+ * and their GPU buffers for the main thread. Models without a .sgm are loaded
+ * whole on the main thread when they're finished.
  * Also it only deals in New Models
  */
 #include "libs.h"
+#include "JobQueue.h"
 #include <stdexcept>
 
 namespace Graphics { class Renderer; }
-namespace SceneGraph { class Model; }
+namespace SceneGraph { class Model; class PreparedModel; }
 
 class ModelCache {
 public:
 	struct ModelNotFoundException : public std::runtime_error {
 		ModelNotFoundException() : std::runtime_error("Could not find model") { }
 	};
-	ModelCache(Graphics::Renderer*);
+	ModelCache(Graphics::Renderer*, JobQueue*);
 	~ModelCache();
+
+	// loads the model now, or waits for a requested one
 	SceneGraph::Model *FindModel(const std::string&);
+
+	// starts loading the model in the background, unless it already is
+	void RequestModel(const std::string&);
+	// the model if it's loaded, otherwise null and it's requested
+	SceneGraph::Model *FindModelIfLoaded(const std::string&);
+
+	// call once per frame from the main thread, finishes a requested model
+	void Update();
+
 	void Flush();
 
 private:
+	// what a job prepares, shared as a cancelled job may still be running
+	struct Prepared {
+		Prepared();
+		~Prepared();
+		SDL_sem *done; // posted by the job once model is set, or it failed
+		std::unique_ptr<SceneGraph::PreparedModel> model; // null without a .sgm
+		bool failed; // Prepare threw, the model is loaded from its .model instead
+	};
+
+	// a requested model, prepared on the job queue
+	struct Request {
+		Job::Handle job;
+		std::shared_ptr<Prepared> prepared;
+	};
+
+	class PrepareJob;
+
+	SceneGraph::Model *Load(const std::string &name, SceneGraph::PreparedModel *prepared);
+	SceneGraph::Model *Finish(std::map<std::string, Request>::iterator it);
+
 	typedef std::map<std::string, SceneGraph::Model*> ModelMap;
 	ModelMap m_models;
+	std::map<std::string, Request> m_requests;
+	std::set<std::string> m_missing;
 	Graphics::Renderer *m_renderer;
+	JobQueue *m_queue;
 };
 
 #endif
@@ -193,6 +193,7 @@ void ModelViewer::Run(const std::string &modelName)
 	delete renderer;
 	Shields::Uninit();
 	NavLights::Uninit();
+	SceneGraph::Thruster::Uninit();
 	Graphics::Uninit();
 	FileSystem::Uninit();
 	SDL_Quit();
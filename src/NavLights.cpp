@@ -16,6 +16,12 @@ static RefCountedPtr<Graphics::Texture> texHalos4x4;
 static RefCountedPtr<Graphics::Material> matHalos4x4;
 
 static bool g_initted = false;
+
+// the lights of everything rendered since BeginBatch, in view space
+static bool s_batching = false;
+static Graphics::VertexArray s_batchTris(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_NORMAL);
+static RefCountedPtr<Graphics::VertexBuffer> s_batchVB;
+static Graphics::RenderState *s_batchRS = nullptr;
 static vector2f m_lightColorsUVoffsets[(NavLights::NAVLIGHT_YELLOW+1)] = {
 	vector2f(0.0f,0.0f),
 	vector2f(0.5f,0.0f),
@@ -69,9 +75,58 @@ void NavLights::Uninit()
 {
 	assert(g_initted);
 
+	s_batchVB.Reset();
+	s_batchRS = nullptr;
 	g_initted = false;
 }
 
+static void DrawBillboards(Graphics::Renderer *renderer, const Graphics::VertexArray &tris, RefCountedPtr<Graphics::VertexBuffer> &vb, Graphics::RenderState *rs)
+{
+	if (!vb.Valid() || tris.GetNumVerts() > vb->GetCapacity())
+	{
+		//create buffer
+		// NB - we're (ab)using the normal type to hold (uv coordinate offset value + point size)
+		Graphics::VertexBufferDesc vbd;
+		vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
+		vbd.attrib[0].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
+		vbd.attrib[1].semantic = Graphics::ATTRIB_NORMAL;
+		vbd.attrib[1].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
+		vbd.numVertices = tris.GetNumVerts();
+		vbd.usage = Graphics::BUFFER_USAGE_DYNAMIC;	// we could be updating this per-frame
+		vb.Reset( renderer->CreateVertexBuffer(vbd) );
+	}
+
+	vb->Populate(tris);
+	renderer->SetTransform(matrix4x4f::Identity());
+	renderer->DrawBuffer(vb.Get(), rs, matHalos4x4.Get(), Graphics::POINTS);
+	renderer->GetStats().AddToStatCount(Graphics::Stats::STAT_BILLBOARD, 1);
+}
+
+void NavLights::BeginBatch()
+{
+	assert(!s_batching);
+	s_batching = true;
+}
+
+void NavLights::EndBatch(Graphics::Renderer *renderer)
+{
+	PROFILE_SCOPED();
+	assert(s_batching);
+	s_batching = false;
+	if (s_batchTris.IsEmpty())
+		return;
+
+	if (!s_batchRS) {
+		Graphics::RenderStateDesc rsd;
+		rsd.blendMode = Graphics::BLEND_ADDITIVE;
+		rsd.depthWrite = false;
+		s_batchRS = renderer->CreateRenderState(rsd);
+	}
+
+	DrawBillboards(renderer, s_batchTris, s_batchVB, s_batchRS);
+	s_batchTris.Clear();
+}
+
 NavLights::NavLights(SceneGraph::Model *model, float period)
 : m_time(0.f)
 , m_period(period)
@@ -200,33 +255,17 @@ void NavLights::Render(Graphics::Renderer *renderer)
 		m_billboardRS = renderer->CreateRenderState(rsd);
 	}
 
-	const bool isVBValid = m_billboardVB.Valid();
-	const bool hasVerts = !m_billboardTris.IsEmpty();
-	const bool isVertCountEnough = isVBValid && (m_billboardTris.GetNumVerts() <= m_billboardVB->GetCapacity());
-	if( hasVerts && (!isVBValid || !isVertCountEnough) )
-	{
-		//create buffer
-		// NB - we're (ab)using the normal type to hold (uv coordinate offset value + point size)
-		Graphics::VertexBufferDesc vbd;
-		vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
-		vbd.attrib[0].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
-		vbd.attrib[1].semantic = Graphics::ATTRIB_NORMAL;
-		vbd.attrib[1].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
-		vbd.numVertices = m_billboardTris.GetNumVerts();
-		vbd.usage = Graphics::BUFFER_USAGE_DYNAMIC;	// we could be updating this per-frame
-		m_billboardVB.Reset( renderer->CreateVertexBuffer(vbd) );
-	}
+	if (m_billboardTris.IsEmpty())
+		return;
 
-	if(m_billboardVB.Valid())
-	{
-		if(hasVerts) {
-			m_billboardVB->Populate(m_billboardTris);
-			renderer->SetTransform(matrix4x4f::Identity());
-			renderer->DrawBuffer(m_billboardVB.Get(), m_billboardRS, matHalos4x4.Get(), Graphics::POINTS);
-			renderer->GetStats().AddToStatCount(Graphics::Stats::STAT_BILLBOARD, 1);
-		}
-		m_billboardTris.Clear();
+	if (s_batching) {
+		// the billboards were added in view space, so they can all go together
+		for (Uint32 i = 0; i < m_billboardTris.GetNumVerts(); i++)
+			s_batchTris.Add(m_billboardTris.position[i], m_billboardTris.normal[i]);
+	} else {
+		DrawBillboards(renderer, m_billboardTris, m_billboardVB, m_billboardRS);
 	}
+	m_billboardTris.Clear();
 }
 
 void NavLights::SetColor(unsigned int group, LightColor c)
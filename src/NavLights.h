@@ -5,6 +5,9 @@
 #define _NAVLIGHTS_H
 /*
  * Blinking navigation lights for ships and stations
+ *
+ * Lights rendered between BeginBatch and EndBatch are kept back and drawn
+ * together, all ships and stations in one draw call.
  */
 #include "libs.h"
 #include "json/json.h"
@@ -47,6 +50,9 @@ public:
 	static void Init(Graphics::Renderer*);
 	static void Uninit();
 
+	static void BeginBatch();
+	static void EndBatch(Graphics::Renderer *renderer);
+
 protected:
 
 	class TGroupLights {
@@ -12,7 +12,9 @@
 #include "FileSystem.h"
 #include "Frame.h"
 #include "Game.h"
+#include "GameSaveError.h"
 #include "BaseSphere.h"
+#include "Bench.h"
 #include "Intro.h"
 #include "Lang.h"
 #include "LuaComms.h"
@@ -72,11 +74,15 @@
 // ------------------------------------------------------------
 #include "graphics/gl2/GL2Renderer.h"
 #include "graphics/opengl/RendererGL.h"
+#include "graphics/dummy/RendererDummy.h"
 // ------------------------------------------------------------
 #include "graphics/Graphics.h"
 #include "graphics/Light.h"
 #include "graphics/Renderer.h"
 #include "graphics/Stats.h"
+#include "graphics/TextureBuilder.h"
+#include "graphics/TextureStreamer.h"
+#include "graphics/TextureResidency.h"
 #include "gui/Gui.h"
 #include "scenegraph/Model.h"
 #include "scenegraph/Lua.h"
@@ -130,6 +136,7 @@ Random Pi::rng;
 float Pi::frameTime;
 #if WITH_DEVKEYS
 bool Pi::showDebugInfo = false;
+bool Pi::showFrameTimings = false;
 #endif
 #if PIONEER_PROFILER
 std::string Pi::profilerPath;
@@ -166,6 +173,8 @@ FILE *Pi::ffmpegFile = nullptr;
 Sound::MusicPlayer Pi::musicPlayer;
 std::unique_ptr<AsyncJobQueue> Pi::asyncJobQueue;
 std::unique_ptr<SyncJobQueue> Pi::syncJobQueue;
+std::unique_ptr<Graphics::TextureStreamer> Pi::textureStreamer;
+std::unique_ptr<Graphics::TextureResidency> Pi::textureResidency;
 
 // Leaving define in place in case of future rendering problems.
 #define USE_RTT 0
@@ -258,6 +267,9 @@ void Pi::EndRenderTarget() {
 
 static void draw_progress(float progress)
 {
+	// headless, there's nothing to show it on
+	if (Pi::renderer->GetRendererType() == Graphics::RENDERER_DUMMY)
+		return;
 
 	Pi::renderer->ClearScreen();
 	PiGui::NewFrame(Pi::renderer->GetSDLWindow());
@@ -415,8 +427,11 @@ void TestGPUJobsSupport()
 	}
 }
 
-void Pi::Init(const std::map<std::string,std::string> &options, bool no_gui)
+void Pi::Init(const std::map<std::string,std::string> &options, bool no_gui, bool headless)
 {
+	if (headless)
+		no_gui = true;
+
 #ifdef PIONEER_PROFILER
 	Profiler::reset();
 #endif
@@ -439,6 +454,8 @@ void Pi::Init(const std::map<std::string,std::string> &options, bool no_gui)
 
 	if (config->Int("RedirectStdio"))
 		OS::RedirectStdio();
+	if (headless)
+		config->SetInt("DisableSound", 1);
 
 	std::string version(PIONEER_VERSION);
 	if (strlen(PIONEER_EXTRAVERSION)) version += " (" PIONEER_EXTRAVERSION ")";
@@ -463,6 +480,9 @@ void Pi::Init(const std::map<std::string,std::string> &options, bool no_gui)
 
 	// Initialize SDL
 	Uint32 sdlInitFlags = SDL_INIT_VIDEO | SDL_INIT_JOYSTICK;
+	// machines without a display still need events and timers
+	if (headless)
+		SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
 #if defined(DEBUG) || defined(_DEBUG)
 	sdlInitFlags |= SDL_INIT_NOPARACHUTE;
 #endif
@@ -474,6 +494,7 @@ void Pi::Init(const std::map<std::string,std::string> &options, bool no_gui)
 
 	Graphics::RendererGL2::RegisterRenderer();
 	Graphics::RendererOGL::RegisterRenderer();
+	Graphics::RendererDummy::RegisterRenderer();
 
 	// determine what renderer we should use, default to Opengl 3.x
 	const std::string rendererName = config->String("RendererName", Graphics::RendererNameFromType(Graphics::RENDERER_OPENGL_3x));
@@ -486,6 +507,8 @@ void Pi::Init(const std::map<std::string,std::string> &options, bool no_gui)
 	{
 		rType = Graphics::RENDERER_OPENGL_3x;
 	}
+	if (headless)
+		rType = Graphics::RENDERER_DUMMY;
 
 	// Do rest of SDL video initialization and create Renderer
 	Graphics::Settings videoSettings = {};
@@ -500,6 +523,7 @@ void Pi::Init(const std::map<std::string,std::string> &options, bool no_gui)
 	videoSettings.useAnisotropicFiltering = (config->Int("UseAnisotropicFiltering") != 0);
 	videoSettings.enableDebugMessages = (config->Int("EnableGLDebug") != 0);
 	videoSettings.gl3ForwardCompatible = (config->Int("GL3ForwardCompatible") != 0);
+	videoSettings.useProgramCache = (config->Int("UseProgramCache") != 0);
 	videoSettings.iconFile = OS::GetIconFilename();
 	videoSettings.title = "Pioneer";
 
@@ -522,7 +546,10 @@ void Pi::Init(const std::map<std::string,std::string> &options, bool no_gui)
 	speedLinesDisplayed = (config->Int("SpeedLines")) ? true : false;
 	hudTrailsDisplayed = (config->Int("HudTrails")) ? true : false;
 
-	TestGPUJobsSupport();
+	if (headless)
+		config->SetInt("EnableGPUJobs", 0); // not saved, there's no GPU to try
+	else
+		TestGPUJobsSupport();
 
 	EnumStrings::Init();
 
@@ -535,6 +562,18 @@ void Pi::Init(const std::map<std::string,std::string> &options, bool no_gui)
 	Output("started %d worker threads\n", numThreads);
 	syncJobQueue.reset(new SyncJobQueue);
 
+	if (config->Int("StreamTextures") && Pi::renderer->SupportsTextureStreaming()) {
+		textureStreamer.reset(new Graphics::TextureStreamer(Pi::renderer, asyncJobQueue.get(), TEXTURE_UPLOAD_BUDGET));
+		Graphics::TextureBuilder::SetStreamer(textureStreamer.get());
+
+		// evicted textures are loaded again by the streamer, so it needs one
+		const size_t textureBudget = size_t(config->Int("TextureBudget")) * 1024 * 1024;
+		if (textureBudget > 0) {
+			textureResidency.reset(new Graphics::TextureResidency(textureStreamer.get(), textureBudget));
+			Graphics::TextureBuilder::SetResidency(textureResidency.get());
+		}
+	}
+
 	Output("ShipType::Init()\n");
 	// XXX early, Lua init needs it
 	ShipType::Init();
@@ -596,7 +635,7 @@ void Pi::Init(const std::map<std::string,std::string> &options, bool no_gui)
 	draw_progress(0.2f);
 
 	Output("new ModelCache\n");
-	modelCache = new ModelCache(Pi::renderer);
+	modelCache = new ModelCache(Pi::renderer, asyncJobQueue.get());
 	draw_progress(0.3f);
 
 	Output("Shields::Init\n");
@@ -727,7 +766,8 @@ void Pi::Init(const std::map<std::string,std::string> &options, bool no_gui)
 			double xsize = 0.0, ysize = 0.0, zsize = 0.0, fakevol = 0.0, rescale = 0.0, brad = 0.0;
 			if (model) {
 				std::unique_ptr<SceneGraph::Model> inst(model->MakeInstance());
-				model->CreateCollisionMesh();
+				if (!model->GetCollisionMesh())
+					model->CreateCollisionMesh();
 				Aabb aabb = model->GetCollisionMesh()->GetAabb();
 				xsize = aabb.max.x-aabb.min.x;
 				ysize = aabb.max.y-aabb.min.y;
@@ -773,7 +813,7 @@ bool Pi::IsConsoleActive()
 	return luaConsole && luaConsole->IsActive();
 }
 
-void Pi::Quit()
+void Pi::Quit(int exitCode)
 {
 	if (Pi::ffmpegFile != nullptr) {
 		_pclose(Pi::ffmpegFile);
@@ -782,6 +822,7 @@ void Pi::Quit()
 	delete Pi::intro;
 	delete Pi::luaConsole;
 	NavLights::Uninit();
+	SceneGraph::Thruster::Uninit();
 	Shields::Uninit();
 	SfxManager::Uninit();
 	Sound::Uninit();
@@ -794,6 +835,10 @@ void Pi::Quit()
 	Pi::pigui.Reset(0);
 	LuaUninit();
 	Gui::Uninit();
+	Graphics::TextureBuilder::SetResidency(nullptr);
+	textureResidency.reset();
+	Graphics::TextureBuilder::SetStreamer(nullptr);
+	textureStreamer.reset();
 	delete Pi::modelCache;
 	delete Pi::renderer;
 	delete Pi::config;
@@ -803,7 +848,7 @@ void Pi::Quit()
 	FileSystem::Uninit();
 	asyncJobQueue.reset();
 	syncJobQueue.reset();
-	exit(0);
+	exit(exitCode);
 }
 
 void Pi::BoinkNoise()
@@ -956,6 +1001,21 @@ void Pi::HandleEvents()
 #if WITH_DEVKEYS
 						case SDLK_i: // Toggle Debug info
 							Pi::showDebugInfo = !Pi::showDebugInfo;
+							if (Pi::showDebugInfo && textureResidency)
+								textureResidency->LogTopConsumers(20);
+							break;
+
+						case SDLK_t: // Toggle frame timings, shift to save them for chrome://tracing
+							if (KeyState(SDLK_LSHIFT) || KeyState(SDLK_RSHIFT)) {
+								FILE *f = FileSystem::userFiles.OpenWriteStream("frametimings.json", FileSystem::FileSourceFS::WRITE_TEXT);
+								if (f) {
+									Pi::renderer->GetFrameTimings().WriteChromeTrace(f);
+									fclose(f);
+									Output("frame timings written to %s\n", FileSystem::JoinPath(FileSystem::userFiles.GetRoot(), "frametimings.json").c_str());
+								} else
+									Output("Could not open 'frametimings.json'\n");
+							} else
+								Pi::showFrameTimings = !Pi::showFrameTimings;
 							break;
 
 #ifdef PIONEER_PROFILER
@@ -1295,6 +1355,14 @@ void Pi::Start(const int& startPlanet)
 				while (SDL_PollEvent(&event)) {}
 		}
 
+		// the menu ships' textures stream in too
+		asyncJobQueue->FinishJobs();
+		if (textureStreamer)
+			textureStreamer->Update();
+		if (textureResidency)
+			textureResidency->Update();
+		modelCache->Update();
+
 		Pi::BeginRenderTarget();
 		Pi::renderer->BeginFrame();
 		intro->Draw(_time);
@@ -1460,7 +1528,10 @@ void Pi::MainLoop()
 		game->GetSpace()->GetRootFrame()->UpdateInterpTransform(Pi::GetGameTickAlpha());
 
 		currentView->Update();
-		currentView->Draw3D();
+		{
+			TIMING_SCOPED(Pi::renderer, "scene")
+			currentView->Draw3D();
+		}
 
 		// hide cursor for ship control. Do this before imgui runs, to prevent the mouse pointer from jumping
 		SetMouseGrab(Pi::MouseButtonState(SDL_BUTTON_RIGHT) | Pi::MouseButtonState(SDL_BUTTON_MIDDLE));
@@ -1481,35 +1552,38 @@ void Pi::MainLoop()
 		Pi::renderer->EndFrame();
 
 		Pi::renderer->ClearDepthBuffer();
-		if( DrawGUI ) {
-			Gui::Draw();
-		} else if (game && game->IsNormalSpace()) {
-			if (config->Int("DisableScreenshotInfo")==0) {
-				const RefCountedPtr<StarSystem> sys = game->GetSpace()->GetStarSystem();
-				const SystemPath sp = sys->GetPath();
-				std::ostringstream pathStr;
-
-				// fill in pathStr from sp values and sys->GetName()
-				static const std::string comma(", ");
-				pathStr << Pi::player->GetFrame()->GetLabel() << comma << sys->GetName() << " (" << sp.sectorX << comma << sp.sectorY << comma << sp.sectorZ << ")";
-
-				// display pathStr
-				Gui::Screen::EnterOrtho();
-				Gui::Screen::PushFont("ConsoleFont");
-				static RefCountedPtr<Graphics::VertexBuffer> s_pathvb;
-				Gui::Screen::RenderStringBuffer(s_pathvb, pathStr.str(), 0, 0);
-				Gui::Screen::PopFont();
-				Gui::Screen::LeaveOrtho();
+		{
+			TIMING_SCOPED(Pi::renderer, "ui")
+			if( DrawGUI ) {
+				Gui::Draw();
+			} else if (game && game->IsNormalSpace()) {
+				if (config->Int("DisableScreenshotInfo")==0) {
+					const RefCountedPtr<StarSystem> sys = game->GetSpace()->GetStarSystem();
+					const SystemPath sp = sys->GetPath();
+					std::ostringstream pathStr;
+
+					// fill in pathStr from sp values and sys->GetName()
+					static const std::string comma(", ");
+					pathStr << Pi::player->GetFrame()->GetLabel() << comma << sys->GetName() << " (" << sp.sectorX << comma << sp.sectorY << comma << sp.sectorZ << ")";
+
+					// display pathStr
+					Gui::Screen::EnterOrtho();
+					Gui::Screen::PushFont("ConsoleFont");
+					static RefCountedPtr<Graphics::VertexBuffer> s_pathvb;
+					Gui::Screen::RenderStringBuffer(s_pathvb, pathStr.str(), 0, 0);
+					Gui::Screen::PopFont();
+					Gui::Screen::LeaveOrtho();
+				}
 			}
-		}
 
-		// XXX don't draw the UI during death obviously a hack, and still
-		// wrong, because we shouldn't this when the HUD is disabled, but
-		// probably sure draw it if they switch to eg infoview while the HUD is
-		// disabled so we need much smarter control for all this rubbish
-		if ((!Pi::game || Pi::GetView() != Pi::game->GetDeathView()) && DrawGUI) {
-			Pi::ui->Update();
-			Pi::ui->Draw();
+			// XXX don't draw the UI during death obviously a hack, and still
+			// wrong, because we shouldn't this when the HUD is disabled, but
+			// probably sure draw it if they switch to eg infoview while the HUD is
+			// disabled so we need much smarter control for all this rubbish
+			if ((!Pi::game || Pi::GetView() != Pi::game->GetDeathView()) && DrawGUI) {
+				Pi::ui->Update();
+				Pi::ui->Draw();
+			}
 		}
 
 		Pi::EndRenderTarget();
@@ -1560,6 +1634,11 @@ void Pi::MainLoop()
 		syncJobQueue->RunJobs(SYNC_JOBS_PER_LOOP);
 		asyncJobQueue->FinishJobs();
 		syncJobQueue->FinishJobs();
+		if (textureStreamer)
+			textureStreamer->Update();
+		if (textureResidency)
+			textureResidency->Update();
+		modelCache->Update();
 
 #if WITH_DEVKEYS
 		if (Pi::showDebugInfo && SDL_GetTicks() - last_stats > 1000) {
@@ -1570,8 +1649,14 @@ void Pi::MainLoop()
 			const Graphics::Stats::TFrameData &stats = Pi::renderer->GetStats().FrameStatsPrevious();
 			const Uint32 numDrawCalls			= stats.m_stats[Graphics::Stats::STAT_DRAWCALL];
 			const Uint32 numBuffersCreated		= stats.m_stats[Graphics::Stats::STAT_CREATE_BUFFER];
+			const Uint32 numTransientBytes		= stats.m_stats[Graphics::Stats::STAT_TRANSIENT_BYTES];
+			const Uint32 numTextureUploadBytes	= stats.m_stats[Graphics::Stats::STAT_TEXTURE_UPLOAD_BYTES];
+			const Uint32 numTexturesStreaming	= stats.m_stats[Graphics::Stats::STAT_TEXTURES_STREAMING];
 			const Uint32 numDrawTris			= stats.m_stats[Graphics::Stats::STAT_DRAWTRIS];
 			const Uint32 numDrawPointSprites	= stats.m_stats[Graphics::Stats::STAT_DRAWPOINTSPRITES];
+			const Uint32 numStateChanges		= stats.m_stats[Graphics::Stats::STAT_STATE_CHANGES];
+			const Uint32 numMaterialApplies		= stats.m_stats[Graphics::Stats::STAT_MATERIAL_APPLIES];
+			const Uint32 numProgramBinds		= stats.m_stats[Graphics::Stats::STAT_PROGRAM_BINDS];
 			const Uint32 numDrawBuildings		= stats.m_stats[Graphics::Stats::STAT_BUILDINGS];
 			const Uint32 numDrawCities			= stats.m_stats[Graphics::Stats::STAT_CITIES];
 			const Uint32 numDrawGroundStations	= stats.m_stats[Graphics::Stats::STAT_GROUNDSTATIONS];
@@ -1588,15 +1673,23 @@ void Pi::MainLoop()
 				"%d fps (%.1f ms/f), %d phys updates, %d triangles, %.3f M tris/sec, %d glyphs/sec, %d patches/frame\n"
 				"Lua mem usage: %d MB + %d KB + %d bytes (stack top: %d)\n\n"
 				"Draw Calls (%u), of which were:\n Tris (%u)\n Point Sprites (%u)\n Billboards (%u)\n"
+				"State changes (%u), Material applies (%u), Program binds (%u)\n"
 				"Buildings (%u), Cities (%u), GroundStations (%u), SpaceStations (%u), Atmospheres (%u)\n"
 				"Patches (%u), Planets (%u), GasGiants (%u), Stars (%u), Ships (%u)\n"
-				"Buffers Created(%u)\n",
+				"Buffers Created(%u), Transient vertex bytes (%u)\n"
+				"Textures streaming (%u), Texture upload bytes (%u)\n"
+				"Texture memory (%u MB of %u MB), Textures evicted (%u)\n",
 				frame_stat, (1000.0/frame_stat), phys_stat, Pi::statSceneTris, Pi::statSceneTris*frame_stat*1e-6,
 				Text::TextureFont::GetGlyphCount(), Pi::statNumPatches,
 				lua_memMB, lua_memKB, lua_memB, lua_gettop(Lua::manager->GetLuaState()),
 				numDrawCalls, numDrawTris, numDrawPointSprites, numDrawBillBoards,
+				numStateChanges, numMaterialApplies, numProgramBinds,
 				numDrawBuildings, numDrawCities, numDrawGroundStations, numDrawSpaceStations, numDrawAtmospheres,
-				numDrawPatches, numDrawPlanets, numDrawGasGiants, numDrawStars, numDrawShips, numBuffersCreated
+				numDrawPatches, numDrawPlanets, numDrawGasGiants, numDrawStars, numDrawShips, numBuffersCreated, numTransientBytes,
+				numTexturesStreaming, numTextureUploadBytes,
+				textureResidency ? Uint32(textureResidency->GetResidentBytes() >> 20) : 0,
+				textureResidency ? Uint32(textureResidency->GetBudget() >> 20) : 0,
+				textureResidency ? textureResidency->GetNumEvicted() : 0
 			);
 			frame_stat = 0;
 			phys_stat = 0;
@@ -1638,6 +1731,92 @@ void Pi::MainLoop()
 	}
 }
 
+bool Pi::Bench(const std::string &source, Uint32 frames, FILE *out)
+{
+	// a new game at a body path, otherwise a save file
+	const std::vector<std::string> coords = SplitString(source, ",");
+	try {
+		if (coords.size() == 5) {
+			const SystemPath path(atoi(coords[0].c_str()), atoi(coords[1].c_str()), atoi(coords[2].c_str()),
+				atoi(coords[3].c_str()), atoi(coords[4].c_str()));
+			Pi::game = new Game(path);
+		} else
+			Pi::game = Game::LoadGame(source);
+	}
+	catch (InvalidGameStartLocation &e) {
+		Output("bench: invalid starting location: %s\n", e.error.c_str());
+		return false;
+	}
+	catch (SavedGameCorruptException) {
+		Output("bench: %s\n", Lang::GAME_LOAD_CORRUPT);
+		return false;
+	}
+	catch (SavedGameWrongVersionException) {
+		Output("bench: %s\n", Lang::GAME_LOAD_WRONG_VERSION);
+		return false;
+	}
+	catch (CouldNotOpenFileException) {
+		Output("bench: could not open saved game '%s'\n", source.c_str());
+		return false;
+	}
+
+	InitGame();
+	StartGame();
+
+	// one physics step per frame at a fixed rate, so every run does the same
+	// work however fast the machine is. Docking drops the rate, so it's put
+	// back each frame
+	const Game::TimeAccel accel = Game::TIMEACCEL_10X;
+	Pi::game->SetTimeAccel(accel);
+	Pi::gameTickAlpha = 1.0;
+
+	Bench::Start();
+	const Uint64 start = SDL_GetPerformanceCounter();
+	Uint32 frame = 0;
+	for (; frame < frames && Pi::game && !Pi::player->IsDead(); frame++) {
+		PROFILE_SCOPED()
+
+		if (Pi::game->GetTimeAccel() != accel)
+			Pi::game->SetTimeAccel(accel);
+		const float step = Pi::game->GetTimeStep();
+		Pi::frameTime = step * Pi::game->GetInvTimeAccelRate();
+
+		game->TimeStep(step);
+		BaseSphere::UpdateAllBaseSphereDerivatives();
+
+		Pi::renderer->SetViewport(0, 0, Graphics::GetScreenWidth(), Graphics::GetScreenHeight());
+		Pi::renderer->BeginFrame();
+		Pi::renderer->SetTransform(matrix4x4f::Identity());
+		for (Body* b : game->GetSpace()->GetBodies()) {
+			b->UpdateInterpTransform(Pi::GetGameTickAlpha());
+		}
+		game->GetSpace()->GetRootFrame()->UpdateInterpTransform(Pi::GetGameTickAlpha());
+		currentView->Update();
+		currentView->Draw3D();
+		Pi::renderer->EndFrame();
+		Pi::renderer->SwapBuffers();
+
+		{
+			BENCH_SCOPED(SECTION_JOBS)
+			syncJobQueue->RunJobs(SYNC_JOBS_PER_LOOP);
+			asyncJobQueue->FinishJobs();
+			syncJobQueue->FinishJobs();
+		}
+		if (textureStreamer)
+			textureStreamer->Update();
+		if (textureResidency)
+			textureResidency->Update();
+		modelCache->Update();
+	}
+	const Uint64 total = SDL_GetPerformanceCounter() - start;
+	Bench::Stop();
+
+	if (frame < frames)
+		Output("bench: stopped after %u of %u frames, the player died\n", frame, frames);
+	Bench::Write(out, source, frame, Pi::game ? Pi::game->GetTimeStep() : 0.0, total);
+	return true;
+}
+
 void Pi::InitJoysticks() {
 	int joy_count = SDL_NumJoysticks();
 	for (int n = 0; n < joy_count; n++) {
@@ -1752,6 +1931,7 @@ float Pi::GetMoveSpeedShiftModifier() {
 }
 
 void Pi::DrawPiGui(double delta, std::string handler) {
+	TIMING_SCOPED(Pi::renderer, "pigui")
 	//  #define PROFILE_LUA_TIME 1
 	#ifdef PROFILE_LUA_TIME
 	auto before = clock();
@@ -35,7 +35,7 @@ class SDLGraphics;
 #if ENABLE_SERVER_AGENT
 class ServerAgent;
 #endif
-namespace Graphics { class Renderer; }
+namespace Graphics { class Renderer; class TextureStreamer; class TextureResidency; }
 namespace SceneGraph { class Model; }
 namespace Sound { class MusicPlayer; }
 namespace UI { class Context; }
@@ -58,7 +58,8 @@ class Game;
 
 class Pi {
 public:
-	static void Init(const std::map<std::string,std::string> &options, bool no_gui = false);
+	// headless runs on the dummy renderer, without a window or sound
+	static void Init(const std::map<std::string,std::string> &options, bool no_gui = false, bool headless = false);
 	static void InitGame();
 	static void StartGame();
 	static void RequestEndGame(); // request that the game is ended as soon as safely possible
@@ -66,8 +67,11 @@ public:
 	static void Start(const int& startPlanet);
 	static void MainLoop();
 	static void TombStoneLoop();
+	// runs a save file, or a new game at a body path "x,y,z,system,body", for a
+	// number of frames and writes the time spent in each subsystem to out
+	static bool Bench(const std::string &source, Uint32 frames, FILE *out);
 	static void OnChangeDetailLevel();
-	static void Quit() __attribute((noreturn));
+	static void Quit(int exitCode = 0) __attribute((noreturn));
 	static float GetFrameTime() { return frameTime; }
 	static float GetGameTickAlpha() { return gameTickAlpha; }
 	static bool KeyState(SDL_Keycode k) { return keyState[k]; }
@@ -154,6 +158,7 @@ public:
 
 #if WITH_DEVKEYS
 	static bool showDebugInfo;
+	static bool showFrameTimings; // the PiGui overlay
 #endif
 #if PIONEER_PROFILER
 	static std::string profilerPath;
@@ -187,8 +192,11 @@ private:
 	static void InitJoysticks();
 
 	static const Uint32 SYNC_JOBS_PER_LOOP = 1;
+	static const Uint32 TEXTURE_UPLOAD_BUDGET = 4 * 1024 * 1024; // bytes per frame
 	static std::unique_ptr<AsyncJobQueue> asyncJobQueue;
 	static std::unique_ptr<SyncJobQueue> syncJobQueue;
+	static std::unique_ptr<Graphics::TextureStreamer> textureStreamer;
+	static std::unique_ptr<Graphics::TextureResidency> textureResidency;
 
 	static bool menuDone;
 
@@ -178,8 +178,11 @@ void PiGui::Init(SDL_Window *window) {
 	switch(Pi::renderer->GetRendererType())
 		{
 		default:
+			Error("Unsupported renderer for PiGui, aborting.");
+			return;
 		case Graphics::RENDERER_DUMMY:
-			Error("RENDERER_DUMMY is not a valid renderer, aborting.");
+			// headless (-bench), Lua still needs somewhere to register its
+			// handlers but no frame is ever started or drawn
 			return;
 		case Graphics::RENDERER_OPENGL_21:
 			ImGui_ImplSdl_Init(window);
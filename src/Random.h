@@ -240,6 +240,8 @@ public:
 	}
 
 	const pcg32 &GetPCG() const { return mPCG; }
+	// Continue the sequence from a state previously taken with GetPCG
+	void SetPCG(const pcg32 &pcg) { mPCG = pcg; cached = false; }
 private:
 	Random(const Random&); // copy constructor not defined
 	void operator=(const Random&); // assignment operator not defined
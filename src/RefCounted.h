@@ -16,6 +16,14 @@ public:
 	inline void IncRefCount() const { ++m_refCount; }
 	inline void DecRefCount() const { assert(m_refCount > 0); if (! --m_refCount) delete this; }
 	inline int GetRefCount() const { return m_refCount; }
+	// for holders of plain pointers: takes a reference, unless the last one
+	// has just gone on another thread and the object is being deleted
+	inline bool IncRefCountIfAlive() const {
+		int count = m_refCount.load();
+		while (count > 0)
+			if (m_refCount.compare_exchange_weak(count, count + 1)) return true;
+		return false;
+	}
 
 private:
 	// vs2012 doesn't support the `= delete` syntax
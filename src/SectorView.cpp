@@ -36,6 +36,8 @@ static const int DRAW_RAD = 5;
 static const float FAR_THRESHOLD = 7.5f;
 static const float FAR_LIMIT     = 36.f;
 static const float FAR_MAX       = 46.f;
+static const int FAR_CHUNK_SIZE = 4;               // in sectors along each axis
+static const int FAR_CHUNK_BUILDS_PER_FRAME = 32;
 
 enum DetailSelection {
 	DETAILBOX_NONE    = 0,
@@ -129,6 +131,9 @@ void SectorView::InitDefaults()
 
 	m_secPosFar = vector3f(INT_MAX, INT_MAX, INT_MAX);
 	m_radiusFar = 0;
+	m_farChunkSerial = 0;
+	m_farFactionsDirty = true;
+	m_farRotX = m_farRotZ = m_farStarSize = 0.0f;
 	m_cacheXMin = 0;
 	m_cacheXMax = 0;
 	m_cacheYMin = 0;
@@ -521,6 +526,7 @@ void SectorView::DrawNearSectors(const matrix4x4f& modelview)
 {
 	PROFILE_SCOPED()
 		m_visibleFactions.clear();
+	m_farFactionsDirty = true; // the far view has to collect them again from its chunks
 
 	RefCountedPtr<const Sector> playerSec = GetCached(m_current);
 	const vector3f playerPos = Sector::SIZE * vector3f(float(m_current.sectorX), float(m_current.sectorY), float(m_current.sectorZ)) + playerSec->m_systems[m_current.systemIndex].GetPosition();
@@ -938,64 +944,222 @@ void SectorView::DrawFarSectors(const matrix4x4f& modelview)
 
 	const vector3f secOrigin = vector3f(int(floorf(m_pos.x)), int(floorf(m_pos.y)), int(floorf(m_pos.z)));
 
-	// build vertex and colour arrays for all the stars we want to see, if we don't already have them
+	// work out which chunks enter or leave the sphere we're viewing, if it moved
 	if (m_toggledFaction || buildRadius != m_radiusFar || !secOrigin.ExactlyEqual(m_secPosFar)) {
-		m_farstars       .clear();
-		m_farstarsColor  .clear();
-		m_visibleFactions.clear();
-
-		for (int sx = secOrigin.x-buildRadius; sx <= secOrigin.x+buildRadius; sx++) {
-			for (int sy = secOrigin.y-buildRadius; sy <= secOrigin.y+buildRadius; sy++) {
-				for (int sz = secOrigin.z-buildRadius; sz <= secOrigin.z+buildRadius; sz++) {
-					if ((vector3f(sx,sy,sz) - secOrigin).Length() <= buildRadius){
-						BuildFarSector(GetCached(SystemPath(sx, sy, sz)), Sector::SIZE * secOrigin, m_farstars, m_farstarsColor);
-					}
-				}
-			}
-		}
+		UpdateFarChunks(secOrigin, buildRadius);
 
 		m_secPosFar      = secOrigin;
 		m_radiusFar      = buildRadius;
 		m_toggledFaction = false;
 	}
 
-	// always draw the stars, slightly altering their size for different different resolutions, so they still look okay
-	if (m_farstars.size() > 0) {
-		m_farstarsPoints.SetData(m_renderer, m_farstars.size(), &m_farstars[0], &m_farstarsColor[0], modelview, 0.25f * (Graphics::GetScreenHeight() / 720.f));
-		m_farstarsPoints.Draw(m_renderer, m_alphaBlendState);
+	// slightly alter the size of the stars for different resolutions, so they still look okay.
+	// the billboards only depend on the rotation, so panning doesn't touch chunks that didn't change
+	const float starSize = 0.25f * (Graphics::GetScreenHeight() / 720.f);
+	const bool rotated = m_rotX != m_farRotX || m_rotZ != m_farRotZ || starSize != m_farStarSize;
+	m_farRotX     = m_rotX;
+	m_farRotZ     = m_rotZ;
+	m_farStarSize = starSize;
+
+	int builds = 0;
+	for (auto &it : m_farChunks) {
+		FarChunk &chunk = *it.second;
+		if (!chunk.loaded)
+			continue;
+
+		// chunks that are still waiting for their turn are drawn as they were
+		if (chunk.dirty && builds < FAR_CHUNK_BUILDS_PER_FRAME) {
+			BuildFarChunk(it.first, chunk, secOrigin, buildRadius);
+			builds++;
+		}
+
+		if (chunk.stars.empty())
+			continue;
+
+		if (chunk.refresh || rotated) {
+			chunk.points.SetData(m_renderer, chunk.stars.size(), &chunk.stars[0], &chunk.colors[0], modelview, starSize);
+			chunk.refresh = false;
+		}
+
+		// stars are stored relative to the chunk (origin must be m_pos's *sector* or we get judder)
+		const vector3f offset = Sector::SIZE * (FAR_CHUNK_SIZE * vector3f(it.first.sectorX, it.first.sectorY, it.first.sectorZ) - secOrigin);
+		m_renderer->SetTransform(modelview * matrix4x4f::Translation(offset.x, offset.y, offset.z));
+		chunk.points.Draw(m_renderer, m_alphaBlendState);
+	}
+	m_renderer->SetTransform(modelview);
+
+	if (m_farFactionsDirty) {
+		m_visibleFactions.clear();
+		for (auto &it : m_farChunks)
+			m_visibleFactions.insert(it.second->factions.begin(), it.second->factions.end());
+		m_farFactionsDirty = false;
 	}
 
 	// also add labels for any faction homeworlds among the systems we've drawn
 	PutFactionLabels(Sector::SIZE * secOrigin);
 }
 
-void SectorView::BuildFarSector(RefCountedPtr<Sector> sec, const vector3f &origin, std::vector<vector3f> &points, std::vector<Color> &colors)
+// Squared distances, in sectors, from secOrigin to the nearest and farthest
+// sector of the chunk.
+static void FarChunkExtent(const SystemPath &chunkPath, const vector3f &secOrigin, float &nearSqr, float &farSqr)
+{
+	const int c[3] = { chunkPath.sectorX, chunkPath.sectorY, chunkPath.sectorZ };
+	const int o[3] = { int(secOrigin.x), int(secOrigin.y), int(secOrigin.z) };
+	nearSqr = farSqr = 0.0f;
+	for (int i = 0; i < 3; i++) {
+		const int lo = c[i] * FAR_CHUNK_SIZE - o[i];
+		const int hi = lo + FAR_CHUNK_SIZE - 1;
+		const int nearest = lo > 0 ? lo : (hi < 0 ? hi : 0);
+		const int farthest = std::max(abs(lo), abs(hi));
+		nearSqr += float(nearest * nearest);
+		farSqr += float(farthest * farthest);
+	}
+}
+
+void SectorView::UpdateFarChunks(const vector3f &secOrigin, int buildRadius)
 {
 	PROFILE_SCOPED()
-		Color starColor;
+	const float radiusSqr = float(buildRadius * buildRadius);
+	// systems further out than this get cut by the sphere test in BuildFarSector. the test
+	// is against m_pos rather than its sector, which can be up to two sectors apart
+	const float cutRadius = std::min(float(buildRadius), (m_zoomClamped/FAR_THRESHOLD) * DRAW_RAD - 2.0f);
+	const float innerSqr = cutRadius > 0.0f ? cutRadius * cutRadius : -1.0f;
+
+	// throw away chunks that have left the sphere. inner chunks don't depend on where
+	// we're looking from, so only chunks on the edge have to be built again
+	for (auto it = m_farChunks.begin(); it != m_farChunks.end();) {
+		float nearSqr, farSqr;
+		FarChunkExtent(it->first, secOrigin, nearSqr, farSqr);
+		if (nearSqr > radiusSqr) {
+			m_farChunks.erase(it++);
+			m_farFactionsDirty = true;
+			continue;
+		}
+		FarChunk &chunk = *it->second;
+		const bool edge = farSqr > innerSqr;
+		if (m_toggledFaction || edge || chunk.edge)
+			chunk.dirty = chunk.loaded;
+		chunk.edge = edge;
+		++it;
+	}
+
+	// find the chunks that have entered it
+	const int cmin[3] = {
+		int(floorf((secOrigin.x - buildRadius) / FAR_CHUNK_SIZE)),
+		int(floorf((secOrigin.y - buildRadius) / FAR_CHUNK_SIZE)),
+		int(floorf((secOrigin.z - buildRadius) / FAR_CHUNK_SIZE)) };
+	const int cmax[3] = {
+		int(floorf((secOrigin.x + buildRadius) / FAR_CHUNK_SIZE)),
+		int(floorf((secOrigin.y + buildRadius) / FAR_CHUNK_SIZE)),
+		int(floorf((secOrigin.z + buildRadius) / FAR_CHUNK_SIZE)) };
+
+	std::vector<std::pair<float, SystemPath> > entered;
+	for (int cx = cmin[0]; cx <= cmax[0]; cx++) {
+		for (int cy = cmin[1]; cy <= cmax[1]; cy++) {
+			for (int cz = cmin[2]; cz <= cmax[2]; cz++) {
+				const SystemPath chunkPath(cx, cy, cz);
+				float nearSqr, farSqr;
+				FarChunkExtent(chunkPath, secOrigin, nearSqr, farSqr);
+				if (nearSqr > radiusSqr || m_farChunks.count(chunkPath))
+					continue;
+				FarChunk *chunk = new FarChunk;
+				chunk->edge = farSqr > innerSqr;
+				chunk->serial = ++m_farChunkSerial;
+				m_farChunks[chunkPath].reset(chunk);
+				entered.push_back(std::make_pair(nearSqr, chunkPath));
+			}
+		}
+	}
+
+	// order the closest chunks first, so the view fills in from the middle
+	std::sort(entered.begin(), entered.end(), [](const std::pair<float, SystemPath> &a, const std::pair<float, SystemPath> &b) {
+		return a.first < b.first;
+	});
+
+	SectorCache::PathVector paths;
+	paths.reserve(FAR_CHUNK_SIZE * FAR_CHUNK_SIZE * FAR_CHUNK_SIZE);
+	for (const auto &e : entered) {
+		const SystemPath &chunkPath = e.second;
+		paths.clear();
+		for (int x = 0; x < FAR_CHUNK_SIZE; x++)
+			for (int y = 0; y < FAR_CHUNK_SIZE; y++)
+				for (int z = 0; z < FAR_CHUNK_SIZE; z++)
+					paths.push_back(SystemPath(chunkPath.sectorX * FAR_CHUNK_SIZE + x, chunkPath.sectorY * FAR_CHUNK_SIZE + y, chunkPath.sectorZ * FAR_CHUNK_SIZE + z));
+
+		// the callback runs once all of this chunk's sectors are in, however many
+		// other chunks are still loading. if they're all in the master cache already
+		// it runs straight away
+		const unsigned serial = m_farChunks[chunkPath]->serial;
+		m_sectorCache->FillCache(paths, [this, chunkPath, serial]() { OnFarChunkLoaded(chunkPath, serial); });
+	}
+}
+
+void SectorView::OnFarChunkLoaded(const SystemPath &chunkPath, unsigned serial)
+{
+	auto it = m_farChunks.find(chunkPath);
+	// the chunk may have left the sphere (and maybe come back) while its sectors were being made
+	if (it == m_farChunks.end() || it->second->serial != serial)
+		return;
+
+	FarChunk &chunk = *it->second;
+	chunk.sectors.clear();
+	chunk.sectors.reserve(FAR_CHUNK_SIZE * FAR_CHUNK_SIZE * FAR_CHUNK_SIZE);
+	for (int x = 0; x < FAR_CHUNK_SIZE; x++)
+		for (int y = 0; y < FAR_CHUNK_SIZE; y++)
+			for (int z = 0; z < FAR_CHUNK_SIZE; z++)
+				chunk.sectors.push_back(GetCached(SystemPath(chunkPath.sectorX * FAR_CHUNK_SIZE + x, chunkPath.sectorY * FAR_CHUNK_SIZE + y, chunkPath.sectorZ * FAR_CHUNK_SIZE + z)));
+	chunk.loaded = true;
+	chunk.dirty = true;
+}
+
+void SectorView::BuildFarChunk(const SystemPath &chunkPath, FarChunk &chunk, const vector3f &secOrigin, int buildRadius)
+{
+	PROFILE_SCOPED()
+	chunk.stars.clear();
+	chunk.colors.clear();
+	chunk.factions.clear();
+
+	const vector3f origin = Sector::SIZE * FAR_CHUNK_SIZE * vector3f(chunkPath.sectorX, chunkPath.sectorY, chunkPath.sectorZ);
+	for (const RefCountedPtr<Sector> &sec : chunk.sectors)
+		BuildFarSector(sec, secOrigin, buildRadius, chunk.edge, origin, chunk);
+
+	chunk.dirty = false;
+	chunk.refresh = true;
+	m_farFactionsDirty = true;
+}
+
+void SectorView::BuildFarSector(RefCountedPtr<Sector> sec, const vector3f &secOrigin, int buildRadius, bool edge, const vector3f &origin, FarChunk &chunk)
+{
+	PROFILE_SCOPED()
+	// only chunks on the edge of the sphere need to check which of their stars are inside it
+	if (edge) {
+		if ((vector3f(sec->sx, sec->sy, sec->sz) - secOrigin).Length() > buildRadius)
+			return;
+	}
+
+	Color starColor;
 	for (std::vector<Sector::System>::iterator i = sec->m_systems.begin(); i != sec->m_systems.end(); ++i) {
 		// skip the system if it doesn't fall within the sphere we're viewing.
-		if ((m_pos*Sector::SIZE - (*i).GetFullPosition()).Length() > (m_zoomClamped/FAR_THRESHOLD )*OUTER_RADIUS) continue;
+		if (edge && (m_pos*Sector::SIZE - (*i).GetFullPosition()).Length() > (m_zoomClamped/FAR_THRESHOLD )*OUTER_RADIUS) continue;
 
 		if (!i->IsExplored())
 		{
-			points.push_back((*i).GetFullPosition() - origin);
-			colors.push_back({ 100,100,100,155 });					// flat gray for unexplored systems
+			chunk.stars.push_back((*i).GetFullPosition() - origin);
+			chunk.colors.push_back({ 100,100,100,155 });				// flat gray for unexplored systems
 			continue;
 		}
 
 		// if the system belongs to a faction we've chosen to hide also skip it, if it's not selectd in some way
-		m_visibleFactions.insert(i->GetFaction());
+		chunk.factions.insert(i->GetFaction());
 		if (m_hiddenFactions.find(i->GetFaction()) != m_hiddenFactions.end()
 				&& !i->IsSameSystem(m_selected) && !i->IsSameSystem(m_hyperspaceTarget) && !i->IsSameSystem(m_current)) continue;
 
-		// otherwise add the system's position (origin must be m_pos's *sector* or we get judder)
-		// and faction color to the list to draw
+		// otherwise add the system's position and faction color to the list to draw
 		starColor = i->GetFaction()->colour;
 		starColor.a = 120;
 
-		points.push_back((*i).GetFullPosition() - origin);
-		colors.push_back(starColor);
+		chunk.stars.push_back((*i).GetFullPosition() - origin);
+		chunk.colors.push_back(starColor);
 	}
 }
 
@@ -100,8 +100,30 @@ private:
 	void DrawNearSector(const int sx, const int sy, const int sz, const vector3f &playerAbsPos, const matrix4x4f &trans);
 	void PutSystemLabels(RefCountedPtr<Sector> sec, const vector3f &origin, int drawRadius);
 
+	// The far view keeps its stars in chunks of FAR_CHUNK_SIZE^3 sectors, each
+	// with its own vertex buffer. Sectors are generated by the slave cache's
+	// worker jobs and a chunk is only drawn once all of them have arrived.
+	struct FarChunk {
+		FarChunk() : serial(0), loaded(false), dirty(false), refresh(false), edge(true) {}
+		unsigned serial;     // identifies the FillCache request that will load this chunk
+		bool loaded;         // all sectors are in 'sectors'
+		bool dirty;          // star list needs to be built again
+		bool refresh;        // star list changed since the last upload
+		bool edge;           // the chunk crosses the edge of the visible sphere
+		std::vector<RefCountedPtr<Sector> > sectors;
+		std::vector<vector3f> stars; // relative to the chunk's first sector
+		std::vector<Color> colors;
+		std::set<const Faction*> factions;
+		Graphics::Drawables::Points points;
+	};
+	// chunks are keyed by their coordinates in units of FAR_CHUNK_SIZE sectors
+	typedef std::map<SystemPath, std::unique_ptr<FarChunk>, SystemPath::LessSectorOnly> FarChunkMap;
+
 	void DrawFarSectors(const matrix4x4f& modelview);
-	void BuildFarSector(RefCountedPtr<Sector> sec, const vector3f &origin, std::vector<vector3f> &points, std::vector<Color> &colors);
+	void UpdateFarChunks(const vector3f &secOrigin, int buildRadius);
+	void OnFarChunkLoaded(const SystemPath &chunkPath, unsigned serial);
+	void BuildFarChunk(const SystemPath &chunkPath, FarChunk &chunk, const vector3f &secOrigin, int buildRadius);
+	void BuildFarSector(RefCountedPtr<Sector> sec, const vector3f &secOrigin, int buildRadius, bool edge, const vector3f &origin, FarChunk &chunk);
 	void PutFactionLabels(const vector3f &secPos);
 	void AddStarBillboard(const matrix4x4f &modelview, const vector3f &pos, const Color &col, float size);
 
@@ -173,8 +195,10 @@ private:
 	RefCountedPtr<Graphics::Material> m_material; //flat colour
 	RefCountedPtr<Graphics::Material> m_starMaterial;
 
-	std::vector<vector3f> m_farstars;
-	std::vector<Color>    m_farstarsColor;
+	FarChunkMap m_farChunks;
+	unsigned    m_farChunkSerial;
+	bool        m_farFactionsDirty;
+	float       m_farRotX, m_farRotZ, m_farStarSize; // billboards of all chunks were built for these
 
 	vector3f m_secPosFar;
 	int      m_radiusFar;
@@ -195,7 +219,6 @@ private:
 
 	Graphics::Drawables::Lines m_lines;
 	Graphics::Drawables::Lines m_sectorlines;
-	Graphics::Drawables::Points m_farstarsPoints;
 };
 
 #endif /* _SECTORVIEW_H */
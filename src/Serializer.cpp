@@ -117,6 +117,14 @@ void Writer::Color4UB(const Color &c)
 	Byte(c.a);
 }
 
+void Writer::AlignedBlob(const void *data, Uint32 size, Uint32 alignment)
+{
+	Int32(size);
+	while (m_str.size() % alignment)
+		Byte(0);
+	m_str.append(static_cast<const char*>(data), size);
+}
+
 Reader::Reader(const ByteRange &data):
 	m_data(data),
 	m_at(data.begin)
@@ -219,6 +227,22 @@ ByteRange Reader::Blob()
 	return range;
 }
 
+ByteRange Reader::AlignedBlob(Uint32 alignment)
+{
+	const Uint32 size = Int32();
+	while ((m_at - m_data.begin) % alignment)
+		++m_at;
+
+	if (size > Uint32(m_data.end - m_at)) {
+		assert(0 && "Serializer:Reader stream is truncated");
+		throw SavedGameCorruptException();
+	}
+
+	ByteRange range = ByteRange(m_at, m_at + size);
+	m_at += size;
+	return range;
+}
+
 std::string Reader::String()
 {
 	ByteRange range = Blob();
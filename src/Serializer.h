@@ -29,6 +29,9 @@ namespace Serializer {
 		void Vector3d(vector3d vec);
 		void WrQuaternionf(const Quaternionf &q);
 		void Color4UB(const Color&);
+		// raw bytes starting at a multiple of alignment from the start of the
+		// stream, so they can be used in place by a reader
+		void AlignedBlob(const void *data, Uint32 size, Uint32 alignment);
 		void WrSection(const std::string &section_label, const std::string &section_data) {
 			String(section_label);
 			String(section_data);
@@ -62,6 +65,8 @@ namespace Serializer {
 		vector3d Vector3d();
 		Quaternionf RdQuaternionf();
 		Color Color4UB();
+		// points into the stream, no copy is made
+		ByteRange AlignedBlob(Uint32 alignment);
 		Reader RdSection(const std::string &section_label_expected);
 		/** Best not to use these except in templates */
 		void Auto(Sint32 *x) { *x = Int32(); }
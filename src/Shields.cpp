@@ -118,6 +118,8 @@ void Shields::ReparentShieldNodes(SceneGraph::Model* model)
 					RefCountedPtr<StaticGeometry> sg(dynamic_cast<StaticGeometry*>(node));
 					assert(sg.Valid());
 					sg->SetNodeMask(SceneGraph::NODE_TRANSPARENT);
+					// each instance shows and hides its own shields
+					sg->SetNodeFlags(sg->GetNodeFlags() | SceneGraph::NODE_INSTANCE);
 
 					// We can early-out if we've already processed this models scenegraph.
 					if (Graphics::BLEND_ALPHA == sg->m_blendMode) {
@@ -3,6 +3,7 @@
 
 #include "libs.h"
 #include "Space.h"
+#include "Bench.h"
 #include "Body.h"
 #include "Frame.h"
 #include "Star.h"
@@ -934,6 +935,7 @@ void Space::CollideFrame(Frame *f)
 void Space::TimeStep(float step)
 {
 	PROFILE_SCOPED()
+	BENCH_SCOPED(SECTION_SPACE)
 
 	if( Pi::MustRefreshBackgroundClearFlag() )
 		RefreshBackground();
@@ -958,8 +960,11 @@ void Space::TimeStep(float step)
 	for (Body* b : m_bodies)
 		b->TimeStepUpdate(step);
 
-	LuaEvent::Emit();
-	Pi::luaTimer->Tick();
+	{
+		BENCH_SCOPED(SECTION_LUA)
+		LuaEvent::Emit();
+		Pi::luaTimer->Tick();
+	}
 
 	UpdateBodies();
 
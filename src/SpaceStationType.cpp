@@ -4,6 +4,7 @@
 #include "SpaceStationType.h"
 #include "FileSystem.h"
 #include "Pi.h"
+#include "ModelCache.h"
 #include "MathUtil.h"
 #include "Ship.h"
 #include "StringF.h"
@@ -65,9 +66,15 @@ SpaceStationType::SpaceStationType(const std::string &id_, const std::string &pa
 
 	padOffset = data.get("pad_offset", 150.f).asFloat();
 
+	// picked up by LoadModel once every type has asked for its own
+	Pi::modelCache->RequestModel(modelName);
+}
+
+void SpaceStationType::LoadModel()
+{
 	model = Pi::FindModel(modelName, /* allowPlaceholder = */ false);
 	if (!model) {
-		Output("couldn't initialize station type '%s' because the corresponding model ('%s') could not be found.\n", path_.c_str(), modelName.c_str());
+		Output("couldn't initialize station type '%s' because the corresponding model ('%s') could not be found.\n", id.c_str(), modelName.c_str());
 		throw StationTypeLoadError();
 	}
 	OnSetupComplete();
@@ -426,6 +433,16 @@ void SpaceStationType::Init()
 			}
 		}
 	}
+
+	// the models were all requested above, so they've been loading together
+	try {
+		for (SpaceStationType &st : surfaceTypes)
+			st.LoadModel();
+		for (SpaceStationType &st : orbitalTypes)
+			st.LoadModel();
+	} catch (StationTypeLoadError) {
+		Error("Error while loading Space Station data (check stdout/output.txt).\n");
+	}
 }
 
 /*static*/
@@ -59,6 +59,8 @@ private:
 	static std::vector<SpaceStationType> surfaceTypes;
 	static std::vector<SpaceStationType> orbitalTypes;
 
+	void LoadModel();
+
 public:
 	SpaceStationType(const std::string &id, const std::string &path);
 
@@ -2,11 +2,15 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "BVHTree.h"
+#include "BuildTasks.h"
 #include "../buildopts.h"
 #include <stdio.h>
 #include <float.h>
 
 const int MAX_SPLITPOS_RETRIES = 15;
+// subtrees this big this near the root get a thread each, up to 2^depth of them
+const int MIN_PARALLEL_OBJS = 4096;
+const int MAX_PARALLEL_DEPTH = 2;
 
 BVHTree::BVHTree(int numObjs, const objPtr_t *objPtrs, const Aabb *objAabbs)
 {
@@ -26,7 +30,7 @@ BVHTree::BVHTree(int numObjs, const objPtr_t *objPtrs, const Aabb *objAabbs)
 	m_nodeAllocMax = numObjs*2 + 1;
 
 	m_root = AllocNode();
-	BuildNode(m_root, objPtrs, objAabbs, activeObjIdxs);
+	BuildNode(m_root, objPtrs, objAabbs, activeObjIdxs, 0);
 
 	timer.Stop();
 	//Output(" - - - BVHTree::BVHTree took: %lf milliseconds\n", timer.millicycles());
@@ -37,24 +41,26 @@ void BVHTree::MakeLeaf(BVHNode *node, const objPtr_t *objPtrs, std::vector<objPt
 	const size_t numTris = objs.size();
 	if (numTris <= 0) Error("MakeLeaf called with no elements in objs.");
 
-	if (numTris > m_objPtrAllocMax - m_objPtrAllocPos) {
-		Error("Out of space in m_objPtrAlloc. Left: " SIZET_FMT "; required: " SIZET_FMT ".", m_objPtrAllocMax - m_objPtrAllocPos, numTris);
+	size_t pos = m_objPtrAllocPos.fetch_add(numTris);
+	if (pos + numTris > m_objPtrAllocMax) {
+		Error("Out of space in m_objPtrAlloc. Left: " SIZET_FMT "; required: " SIZET_FMT ".", m_objPtrAllocMax - std::min(pos, m_objPtrAllocMax), numTris);
 	}
 
 	node->numTris = numTris;
-	node->triIndicesStart = &m_objPtrAlloc[m_objPtrAllocPos];
+	node->triIndicesStart = &m_objPtrAlloc[pos];
 	//if (objs.size()>3) Output("fat node %d\n", objs.size());
 
 	// copy tri indices to the stinking flat array
 	for (int i=numTris-1; i>=0; i--) {
-		m_objPtrAlloc[m_objPtrAllocPos++] = objPtrs[objs[i]];
+		m_objPtrAlloc[pos++] = objPtrs[objs[i]];
 	}
 }
 
 void BVHTree::BuildNode(BVHNode *node,
 			const objPtr_t *objPtrs,
 			const Aabb *objAabbs,
-			std::vector<objPtr_t> &activeObjIdx)
+			std::vector<objPtr_t> &activeObjIdx,
+			int depth)
 {
 	const int numTris = activeObjIdx.size();
 	if (numTris <= 0) Error("BuildNode called with no elements in activeObjIndex.");
@@ -145,6 +151,8 @@ void BVHTree::BuildNode(BVHNode *node,
 	node->kids[0] = AllocNode();
 	node->kids[1] = AllocNode();
 
-	BuildNode(node->kids[0], objPtrs, objAabbs, side[0]);
-	BuildNode(node->kids[1], objPtrs, objAabbs, side[1]);
-}
\ No newline at end of file
+	BuildTasks tasks(depth < MAX_PARALLEL_DEPTH && numTris >= MIN_PARALLEL_OBJS);
+	tasks.Run([&]() { BuildNode(node->kids[0], objPtrs, objAabbs, side[0], depth + 1); });
+	BuildNode(node->kids[1], objPtrs, objAabbs, side[1], depth + 1);
+	tasks.Wait();
+}
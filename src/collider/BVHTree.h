@@ -5,6 +5,7 @@
 #define _BVHTREE_H
 
 #include <assert.h>
+#include <atomic>
 #include <vector>
 #include "../vector3.h"
 #include "../Aabb.h"
@@ -29,6 +30,8 @@ struct BVHNode {
 	}
 };
 
+// big trees are built a subtree per thread near the top, so nodes and leaf
+// lists are taken from their arrays atomically
 class BVHTree {
 public:
 	typedef int objPtr_t;
@@ -42,19 +45,21 @@ private:
 	void BuildNode(BVHNode *node,
 			const objPtr_t *objPtrs,
 			const Aabb *objAabbs,
-			std::vector<objPtr_t> &activeObjIdxs);
+			std::vector<objPtr_t> &activeObjIdxs,
+			int depth);
 	void MakeLeaf(BVHNode *node, const objPtr_t *objPtrs, std::vector<objPtr_t> &objs);
 	BVHNode *AllocNode() {
-		if (m_nodeAllocPos >= m_nodeAllocMax) Error("Out of space in m_bvhNodes.");
-		return &m_bvhNodes[m_nodeAllocPos++];
+		const size_t pos = m_nodeAllocPos++;
+		if (pos >= m_nodeAllocMax) Error("Out of space in m_bvhNodes.");
+		return &m_bvhNodes[pos];
 	}
 	BVHNode *m_root;
 	objPtr_t *m_objPtrAlloc;
-	size_t m_objPtrAllocPos;
+	std::atomic<size_t> m_objPtrAllocPos;
 	size_t m_objPtrAllocMax;
 
 	BVHNode *m_bvhNodes;
-	size_t m_nodeAllocPos;
+	std::atomic<size_t> m_nodeAllocPos;
 	size_t m_nodeAllocMax;
 };
 
@@ -0,0 +1,79 @@
+// Copyright © 2008-2018 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _BUILDTASKS_H
+#define _BUILDTASKS_H
+
+#include "../OS.h"
+#include "SDL_thread.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Runs the independent parts of a collision tree build (the triangle and
+// edge trees, the halves of a big BVH) at the same time, each on a thread of
+// its own. GeomTrees are built on the main thread and in model loading jobs
+// alike, so this can't use the job queue: a job waiting for other jobs could
+// hold up the very ones it's waiting for. Builds started together (one per
+// job thread, say) share one thread for each core but the first, tasks that
+// find none free just run where they are.
+class BuildTasks {
+public:
+	// with parallel false tasks just run as they're given, for builds too
+	// small to be worth a thread
+	BuildTasks(bool parallel) : m_parallel(parallel) {}
+	~BuildTasks() { Wait(); }
+
+	void Run(const std::function<void()> &task) {
+		if (m_parallel && ReserveThread()) {
+			std::function<void()> *t = new std::function<void()>(task);
+			SDL_Thread *thread = SDL_CreateThread(&BuildTasks::Trampoline, "CollisionBuild", t);
+			if (thread) {
+				m_threads.push_back(thread);
+				return;
+			}
+			delete t;
+			--RunningThreads();
+		}
+		task();
+	}
+
+	// until every task is done
+	void Wait() {
+		for (SDL_Thread *thread : m_threads)
+			SDL_WaitThread(thread, nullptr);
+		m_threads.clear();
+	}
+
+private:
+	BuildTasks(const BuildTasks&);
+	BuildTasks &operator=(const BuildTasks&);
+
+	static int Trampoline(void *data) {
+		std::unique_ptr<std::function<void()> > task(static_cast<std::function<void()>*>(data));
+		(*task)();
+		--RunningThreads();
+		return 0;
+	}
+
+	// of all the builds
+	static std::atomic<int> &RunningThreads() {
+		static std::atomic<int> s_running(0);
+		return s_running;
+	}
+
+	static bool ReserveThread() {
+		static const int maxThreads = std::max(OS::GetNumCores() - 1, 0);
+		if (++RunningThreads() <= maxThreads)
+			return true;
+		--RunningThreads();
+		return false;
+	}
+
+	bool m_parallel;
+	std::vector<SDL_Thread*> m_threads;
+};
+
+#endif /* _BUILDTASKS_H */
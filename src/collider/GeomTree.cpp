@@ -4,12 +4,17 @@
 #include "../libs.h"
 #include "GeomTree.h"
 #include "BVHTree.h"
+#include "BuildTasks.h"
 #include "Weld.h"
+#include <algorithm>
 
 GeomTree::~GeomTree()
 {
 }
 
+// triangle meshes this big are built with the two trees on threads of their own
+static const int MIN_PARALLEL_TRIS = 2048;
+
 GeomTree::GeomTree(const int numVerts, const int numTris, const std::vector<vector3f> &vertices, const Uint32 *indices, const Uint32 *triflags)
 : m_numVertices(numVerts)
 , m_numTris(numTris)
@@ -17,36 +22,10 @@ GeomTree::GeomTree(const int numVerts, const int numTris, const std::vector<vect
 {
 	PROFILE_SCOPED()
 	assert(static_cast<int>(vertices.size()) == m_numVertices);
-	Profiler::Timer timer;
-	timer.Start();
-
-	const int numIndices = numTris * 3;
-	m_indices.reserve(numIndices);
-	for (int i = 0; i < numIndices; ++i) {
-		m_indices.push_back(indices[i]);
-	}
-
-	m_triFlags.reserve(numTris);
-	for (int i = 0; i < numTris; ++i) {
-		m_triFlags.push_back(triflags[i]);
-	}
-
-	m_aabb.min = vector3d(FLT_MAX,FLT_MAX,FLT_MAX);
-	m_aabb.max = vector3d(-FLT_MAX,-FLT_MAX,-FLT_MAX);
+	const Uint64 start = SDL_GetPerformanceCounter();
 
-	// activeTris = tris we are still trying to put into leaves
-	std::vector<int> activeTris;
-	activeTris.reserve(numTris);
-	for (int i=0; i<numTris; i++)
-	{
-		activeTris.push_back(i*3);
-	}
-
-	typedef std::map< std::pair<int,int>, int > EdgeType;
-	EdgeType edges;
-#define ADD_EDGE(_i1,_i2,_triflag) \
-	if ((_i1) < (_i2)) edges[std::pair<int,int>(_i1,_i2)] = _triflag; \
-	else if ((_i1) > (_i2)) edges[std::pair<int,int>(_i2,_i1)] = _triflag;
+	m_indices.assign(indices, indices + numTris * 3);
+	m_triFlags.assign(triflags, triflags + numTris);
 
 	// eliminate duplicate vertices
 	{
@@ -58,103 +37,125 @@ GeomTree::GeomTree(const int numVerts, const int numTris, const std::vector<vect
 		//Output("---   %d vertices welded\n", count - newCount);
 
 		// Remap faces.
-		const Uint32 faceCount = numTris;
-		for (Uint32 f = 0; f < faceCount; f++)
-		{
-			const Uint32 idx = (f * 3);
-			m_indices[idx+0] = xrefs.at(m_indices[idx+0]);
-			m_indices[idx+1] = xrefs.at(m_indices[idx+1]);
-			m_indices[idx+2] = xrefs.at(m_indices[idx+2]);
-		}
+		for (Uint32 &idx : m_indices)
+			idx = xrefs.at(idx);
 	}
 
-	// Get radius, m_aabb, and merge duplicate edges
+	// the edges and their tree don't need the triangle tree, nor it them
+	BuildTasks tasks(numTris >= MIN_PARALLEL_TRIS);
+	tasks.Run([this]() {
+		BuildEdges();
+		BuildEdgeTree();
+	});
+
+	// Get radius and m_aabb
+	m_aabb.min = vector3d(FLT_MAX,FLT_MAX,FLT_MAX);
+	m_aabb.max = vector3d(-FLT_MAX,-FLT_MAX,-FLT_MAX);
 	m_radius = 0;
-	for (int i=0; i<numTris; i++)
+	for (const Uint32 idx : m_indices)
 	{
-		const Uint32 triflag = m_triFlags[i];
-		const int vi1 = m_indices[3*i+0];
-		const int vi2 = m_indices[3*i+1];
-		const int vi3 = m_indices[3*i+2];
-
-		ADD_EDGE(vi1, vi2, triflag);
-		ADD_EDGE(vi1, vi3, triflag);
-		ADD_EDGE(vi2, vi3, triflag);
-
-		vector3d v[3];
-		v[0] = vector3d(m_vertices[vi1]);
-		v[1] = vector3d(m_vertices[vi2]);
-		v[2] = vector3d(m_vertices[vi3]);
-		m_aabb.Update(v[0]);
-		m_aabb.Update(v[1]);
-		m_aabb.Update(v[2]);
-		for (int j=0; j<3; j++) {
-			const double rad = v[j].x*v[j].x + v[j].y*v[j].y + v[j].z*v[j].z;
-			if (rad>m_radius) m_radius = rad;
-		}
+		const vector3d v(m_vertices[idx]);
+		m_aabb.Update(v);
+		const double rad = v.x*v.x + v.y*v.y + v.z*v.z;
+		if (rad>m_radius) m_radius = rad;
 	}
 	m_radius = sqrt(m_radius);
 
-	{
-		Aabb *aabbs = new Aabb[activeTris.size()];
-		for (Uint32 i = 0; i < activeTris.size(); i++)
-		{
-			const vector3d v1 = vector3d(m_vertices[m_indices[activeTris[i] + 0]]);
-			const vector3d v2 = vector3d(m_vertices[m_indices[activeTris[i] + 1]]);
-			const vector3d v3 = vector3d(m_vertices[m_indices[activeTris[i] + 2]]);
-			aabbs[i].min = aabbs[i].max = v1;
-			aabbs[i].Update(v2);
-			aabbs[i].Update(v3);
-		}
+	BuildTriTree();
+	tasks.Wait();
+
+	m_buildTime = double(SDL_GetPerformanceCounter() - start) * 1000.0 / double(SDL_GetPerformanceFrequency());
+	//Output(" - - GeomTree::GeomTree took: %lf milliseconds\n", m_buildTime);
+}
 
-		//int t = SDL_GetTicks();
-		m_triTree.reset(new BVHTree(activeTris.size(), &activeTris[0], aabbs));
-		delete[] aabbs;
+void GeomTree::BuildTriTree()
+{
+	PROFILE_SCOPED()
+	// activeTris = tris we are still trying to put into leaves
+	std::vector<int> activeTris(m_numTris);
+	std::vector<Aabb> aabbs(m_numTris);
+	for (int i = 0; i < m_numTris; i++)
+	{
+		activeTris[i] = i * 3;
+		const vector3d v1 = vector3d(m_vertices[m_indices[activeTris[i] + 0]]);
+		const vector3d v2 = vector3d(m_vertices[m_indices[activeTris[i] + 1]]);
+		const vector3d v3 = vector3d(m_vertices[m_indices[activeTris[i] + 2]]);
+		aabbs[i].min = aabbs[i].max = v1;
+		aabbs[i].Update(v2);
+		aabbs[i].Update(v3);
 	}
-	//Output("Tri tree of %d tris build in %dms\n", activeTris.size(), SDL_GetTicks() - t);
 
-	m_numEdges = edges.size();
-	m_edges.resize( m_numEdges );
-	// to build Edge bvh tree with.
-	m_aabbs.resize( m_numEdges );
-	int *edgeIdxs = new int[m_numEdges];
+	m_triTree.reset(new BVHTree(activeTris.size(), activeTris.data(), aabbs.data()));
+}
+
+void GeomTree::BuildEdges()
+{
+	PROFILE_SCOPED()
+	// every triangle's edges, smaller vertex index first, sorted so the
+	// copies of each edge are together. Where triangles share an edge it
+	// takes the flag of the last one
+	struct TriEdge {
+		Uint64 key; // vertex indices
+		int tri;
+		bool operator<(const TriEdge &o) const { return key < o.key || (key == o.key && tri < o.tri); }
+	};
+	std::vector<TriEdge> triEdges;
+	triEdges.reserve(m_numTris * 3);
+	for (int i = 0; i < m_numTris; i++)
+	{
+		for (int j = 0; j < 3; j++) {
+			const Uint32 a = m_indices[3*i + (j == 2 ? 1 : 0)];
+			const Uint32 b = m_indices[3*i + (j == 0 ? 1 : 2)];
+			if (a < b) triEdges.push_back({ (Uint64(a) << 32) | b, i });
+			else if (a > b) triEdges.push_back({ (Uint64(b) << 32) | a, i });
+		}
+	}
+	std::sort(triEdges.begin(), triEdges.end());
 
-	int pos = 0;
-	typedef EdgeType::iterator MapPairIter;
-	for (MapPairIter i = edges.begin(), iEnd = edges.end();	i != iEnd; ++i, pos++)
+	m_edges.clear();
+	m_edges.reserve(triEdges.size() / 2);
+	for (size_t i = 0; i < triEdges.size(); i++)
 	{
+		if (i + 1 < triEdges.size() && triEdges[i + 1].key == triEdges[i].key)
+			continue;
+
 		// precalc some jizz
-		const std::pair<int, int> &vtx = (*i).first;
-		const int triflag = (*i).second;
-		const vector3f &v1 = m_vertices[vtx.first];
-		const vector3f &v2 = m_vertices[vtx.second];
-		vector3f dir = (v2-v1);
-		const float len = dir.Length();
-		dir *= 1.0f/len;
-
-		m_edges[pos].v1i = vtx.first;
-		m_edges[pos].v2i = vtx.second;
-		m_edges[pos].triFlag = triflag;
-		m_edges[pos].len = len;
-		m_edges[pos].dir = dir;
-
-		edgeIdxs[pos] = pos;
-		m_aabbs[pos].min = m_aabbs[pos].max = vector3d(v1);
-		m_aabbs[pos].Update(vector3d(v2));
+		Edge edge;
+		edge.v1i = int(triEdges[i].key >> 32);
+		edge.v2i = int(triEdges[i].key & 0xffffffff);
+		edge.triFlag = m_triFlags[triEdges[i].tri];
+		const vector3f &v1 = m_vertices[edge.v1i];
+		const vector3f &v2 = m_vertices[edge.v2i];
+		edge.dir = (v2-v1);
+		edge.len = edge.dir.Length();
+		edge.dir *= 1.0f/edge.len;
+		m_edges.push_back(edge);
 	}
+	m_numEdges = m_edges.size();
 
-	//t = SDL_GetTicks();
-	m_edgeTree.reset(new BVHTree(m_numEdges, edgeIdxs, &m_aabbs[0]));
-	delete [] edgeIdxs;
-	//Output("Edge tree of %d edges build in %dms\n", m_numEdges, SDL_GetTicks() - t);
+	// to build Edge bvh tree with.
+	m_aabbs.resize(m_numEdges);
+	for (int i = 0; i < m_numEdges; i++)
+	{
+		m_aabbs[i].min = m_aabbs[i].max = vector3d(m_vertices[m_edges[i].v1i]);
+		m_aabbs[i].Update(vector3d(m_vertices[m_edges[i].v2i]));
+	}
+}
 
-	timer.Stop();
-	//Output(" - - GeomTree::GeomTree took: %lf milliseconds\n", timer.millicycles());
+void GeomTree::BuildEdgeTree()
+{
+	PROFILE_SCOPED()
+	std::vector<int> edgeIdxs(m_numEdges);
+	for (int i = 0; i < m_numEdges; i++) {
+		edgeIdxs[i] = i;
+	}
+	m_edgeTree.reset(new BVHTree(m_numEdges, edgeIdxs.data(), m_aabbs.data()));
 }
 
 GeomTree::GeomTree(Serializer::Reader &rd)
 {
 	PROFILE_SCOPED()
+	const Uint64 start = SDL_GetPerformanceCounter();
 	m_numVertices = rd.Int32();
 	m_numEdges = rd.Int32();
 	m_numTris = rd.Int32();
@@ -193,35 +194,13 @@ GeomTree::GeomTree(Serializer::Reader &rd)
 		m_triFlags[iTri] = rd.Int32();
 	}
 
-	// activeTris = tris we are still trying to put into leaves
-	std::vector<int> activeTris;
-	activeTris.reserve(m_numTris);
-	for (int i = 0; i<m_numTris; i++)
-	{
-		activeTris.push_back(i * 3);
-	}
+	// the trees themselves aren't saved, so regenerate them
+	BuildTasks tasks(m_numTris >= MIN_PARALLEL_TRIS);
+	tasks.Run([this]() { BuildEdgeTree(); });
+	BuildTriTree();
+	tasks.Wait();
 
-	// regenerate the aabb data
-	Aabb *aabbs = new Aabb[activeTris.size()];
-	for (Uint32 i = 0; i<activeTris.size(); i++)
-	{
-		const vector3d v1 = vector3d(m_vertices[m_indices[activeTris[i] + 0]]);
-		const vector3d v2 = vector3d(m_vertices[m_indices[activeTris[i] + 1]]);
-		const vector3d v3 = vector3d(m_vertices[m_indices[activeTris[i] + 2]]);
-		aabbs[i].min = aabbs[i].max = v1;
-		aabbs[i].Update(v2);
-		aabbs[i].Update(v3);
-	}
-	m_triTree.reset(new BVHTree(activeTris.size(), &activeTris[0], aabbs));
-	delete[] aabbs;
-
-	//
-	int *edgeIdxs = new int[m_numEdges];
-	memset(edgeIdxs, 0, sizeof(int)*m_numEdges);
-	for (int i = 0; i<m_numEdges; i++) {
-		edgeIdxs[i] = i;
-	}
-	m_edgeTree.reset(new BVHTree(m_numEdges, edgeIdxs, &m_aabbs[0]));
+	m_buildTime = double(SDL_GetPerformanceCounter() - start) * 1000.0 / double(SDL_GetPerformanceFrequency());
 }
 
 static bool SlabsRayAabbTest(const BVHNode *n, const vector3f &start, const vector3f &invDir, isect_t *isect)
@@ -32,6 +32,8 @@ public:
 	vector3f GetTriNormal(int triIdx) const;
 	Uint32 GetTriFlag(int triIdx) const { return m_triFlags[triIdx]; }
 	double GetRadius() const { return m_radius; }
+	// milliseconds taken to build, or to load and rebuild the trees
+	double GetBuildTime() const { return m_buildTime; }
 	struct Edge {
 		int v1i, v2i;
 		float len;
@@ -74,6 +76,9 @@ public:
 	void Save(Serializer::Writer &wr) const;
 
 private:
+	void BuildTriTree();
+	void BuildEdges();
+	void BuildEdgeTree();
 	void RayTriIntersect(int numRays, const vector3f &origin, const vector3f *dirs, int triIdx, isect_t *isects) const;
 
 	int m_numVertices;
@@ -81,6 +86,7 @@ private:
 	int m_numTris;
 
 	double m_radius;
+	double m_buildTime;
 	Aabb m_aabb;
 	std::vector<Aabb> m_aabbs;
 
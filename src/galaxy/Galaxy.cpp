@@ -6,6 +6,9 @@
 #include "Galaxy.h"
 #include "GalaxyGenerator.h"
 #include "Sector.h"
+#include "StarSystem.h"
+#include "EnumStrings.h"
+#include "JobQueue.h"
 #include "Pi.h"
 #include "FileSystem.h"
 #include "GameSaveError.h"
@@ -14,7 +17,8 @@ Galaxy::Galaxy(RefCountedPtr<GalaxyGenerator> galaxyGenerator, float radius, flo
 	const std::string& factionsDir, const std::string& customSysDir)
 	: GALAXY_RADIUS(radius), SOL_OFFSET_X(sol_offset_x), SOL_OFFSET_Y(sol_offset_y),
 	m_initialized(false), m_galaxyGenerator(galaxyGenerator), m_sectorCache(this),
-	m_starSystemCache(this), m_factions(this, factionsDir), m_customSystems(this, customSysDir)
+	m_starSystemCache(this), m_routeCache(this), m_factions(this, factionsDir), m_customSystems(this, customSysDir),
+	m_systemNameLock(SDL_CreateMutex())
 {
 }
 
@@ -41,6 +45,7 @@ void Galaxy::SetGalaxyGenerator(RefCountedPtr<GalaxyGenerator> galaxyGenerator)
 
 Galaxy::~Galaxy()
 {
+	SDL_DestroyMutex(m_systemNameLock);
 }
 
 void Galaxy::Init()
@@ -71,6 +76,8 @@ void Galaxy::Init()
 void Galaxy::FlushCaches()
 {
 	m_factions.ClearCache();
+	m_routeCache.OutputCacheStatistics();
+	m_routeCache.ClearCache();
 	m_starSystemCache.OutputCacheStatistics();
 	m_starSystemCache.ClearCache();
 	m_sectorCache.OutputCacheStatistics();
@@ -78,15 +85,203 @@ void Galaxy::FlushCaches()
 	assert(m_sectorCache.IsEmpty());
 }
 
-void Galaxy::Dump(FILE* file, Sint32 centerX, Sint32 centerY, Sint32 centerZ, Sint32 radius)
-{
-	for (Sint32 sx = centerX - radius; sx <= centerX + radius; ++sx) {
-		for (Sint32 sy = centerY - radius; sy <= centerY + radius; ++sy) {
-			for (Sint32 sz = centerZ - radius; sz <= centerZ + radius; ++sz) {
-				RefCountedPtr<const Sector> sector = GetSector(SystemPath(sx, sy, sz));
-				sector->Dump(file);
+namespace {
+	// CSV fields are always quoted, JSON strings escaped
+	std::string DumpQuote(const std::string& str, bool json)
+	{
+		std::string out(1, '"');
+		for (const char c : str) {
+			if (json && (c == '"' || c == '\\')) {
+				out += '\\';
+				out += c;
+			} else if (json && Uint8(c) < 0x20) {
+				char buf[8];
+				snprintf(buf, sizeof(buf), "\\u%04x", unsigned(c));
+				out += buf;
+			} else if (!json && c == '"') {
+				out += "\"\"";
+			} else
+				out += c;
+		}
+		out += '"';
+		return out;
+	}
+
+	void DumpSystemRecord(FILE* file, const Sector::System& sys, const StarSystem* ssys, bool json)
+	{
+		std::string starTypes;
+		for (unsigned i = 0; i < sys.GetNumStars(); ++i) {
+			if (i) starTypes += ';';
+			starTypes += EnumStrings::GetString("BodyType", sys.GetStarType(i));
+		}
+		const char* govType = EnumStrings::GetString("PolitGovType", ssys->GetSysPolit().govType);
+		const std::string faction = sys.GetFaction() ? sys.GetFaction()->name : "";
+
+		if (json) {
+			fprintf(file, "{\"sector\":[%d,%d,%d],\"index\":%u,\"name\":%s,\"pos\":[%f,%f,%f],"
+				"\"explored\":%s,\"custom\":%s,\"faction\":%s,\"seed\":%u,\"population\":%.0f,"
+				"\"stars\":%s,\"bodies\":%u,\"stations\":%u,\"government\":%s,\"lawlessness\":%f,"
+				"\"econ\":%d,\"industrial\":%f,\"agricultural\":%f}\n",
+				sys.sx, sys.sy, sys.sz, sys.idx, DumpQuote(sys.GetName(), true).c_str(),
+				double(sys.GetPosition().x), double(sys.GetPosition().y), double(sys.GetPosition().z),
+				sys.IsExplored() ? "true" : "false", sys.GetCustomSystem() ? "true" : "false",
+				sys.GetFaction() ? DumpQuote(faction, true).c_str() : "null", sys.GetSeed(), sys.GetPopulation().ToDouble() * 1e9,
+				DumpQuote(starTypes, true).c_str(), ssys->GetNumBodies(), ssys->GetNumSpaceStations(),
+				govType ? DumpQuote(govType, true).c_str() : "null", ssys->GetSysPolit().lawlessness.ToDouble(),
+				int(ssys->GetEconType()), ssys->GetIndustrial().ToDouble(), ssys->GetAgricultural().ToDouble());
+		} else {
+			fprintf(file, "%d,%d,%d,%u,%s,%f,%f,%f,%d,%d,%s,%u,%.0f,%s,%u,%u,%s,%f,%d,%f,%f\n",
+				sys.sx, sys.sy, sys.sz, sys.idx, DumpQuote(sys.GetName(), false).c_str(),
+				double(sys.GetPosition().x), double(sys.GetPosition().y), double(sys.GetPosition().z),
+				sys.IsExplored() ? 1 : 0, sys.GetCustomSystem() ? 1 : 0,
+				DumpQuote(faction, false).c_str(), sys.GetSeed(), sys.GetPopulation().ToDouble() * 1e9,
+				DumpQuote(starTypes, false).c_str(), ssys->GetNumBodies(), ssys->GetNumSpaceStations(),
+				govType ? govType : "", ssys->GetSysPolit().lawlessness.ToDouble(),
+				int(ssys->GetEconType()), ssys->GetIndustrial().ToDouble(), ssys->GetAgricultural().ToDouble());
+		}
+	}
+
+	// Dumps one column of sectors (all sz for one sx, sy) to its own temporary
+	// file, which Galaxy::Dump copies to the output in order once it is done.
+	class DumpJob : public Job {
+	public:
+		struct Column {
+			std::vector<RefCountedPtr<const Sector> > sectors;
+			FILE* file;
+			Uint32 systems;
+		};
+
+		DumpJob(RefCountedPtr<Galaxy> galaxy, Column* column, Galaxy::DumpFormat format) :
+			m_galaxy(galaxy), m_galaxyGenerator(galaxy->GetGenerator()), m_column(column), m_format(format) {}
+
+		virtual void OnRun() override    // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
+		{
+			// the sectors are in the galaxy's cache already, so generating the systems only reads from it
+			std::vector<RefCountedPtr<const StarSystem> > systems;
+			for (const RefCountedPtr<const Sector>& sector : m_column->sectors) {
+				systems.clear();
+				for (const Sector::System& sys : sector->m_systems)
+					systems.push_back(m_galaxyGenerator->Generate<StarSystem,StarSystemCache>(m_galaxy, sys.GetPath(), nullptr));
+
+				if (m_format == Galaxy::DUMP_TEXT)
+					sector->Dump(m_column->file, systems);
+				else {
+					for (const Sector::System& sys : sector->m_systems)
+						DumpSystemRecord(m_column->file, sys, systems[sys.idx].Get(), m_format == Galaxy::DUMP_JSONL);
+				}
+				m_column->systems += sector->m_systems.size();
 			}
-			m_starSystemCache.ClearCache();
+		}
+		virtual void OnFinish() override {}
+
+	private:
+		RefCountedPtr<Galaxy> m_galaxy;
+		RefCountedPtr<GalaxyGenerator> m_galaxyGenerator;
+		Column* m_column;
+		Galaxy::DumpFormat m_format;
+	};
+}
+
+// Sectors are dumped in the same order as they always were, a column of sectors
+// along z at a time. Each wave of columns is generated in two steps: the sectors
+// through a slave cache (the star system generator looks them up in the galaxy's
+// cache), then the star systems and output in one job per column. Only one wave
+// is ever in memory.
+void Galaxy::Dump(FILE* file, Sint32 centerX, Sint32 centerY, Sint32 centerZ, Sint32 radius, DumpFormat format)
+{
+	PROFILE_SCOPED()
+	static const Uint32 WAVE_COLUMNS = 64;
+
+	if (format == DUMP_CSV)
+		fprintf(file, "sx,sy,sz,index,name,x,y,z,explored,custom,faction,seed,population,stars,bodies,stations,government,lawlessness,econ,industrial,agricultural\n");
+
+	JobQueue* queue = Pi::GetAsyncJobQueue();
+	RefCountedPtr<SectorCache::Slave> sectorCache = NewSectorSlaveCache();
+	JobSet jobs(queue);
+
+	const Uint32 side = 2 * radius + 1;
+	const Uint32 numColumns = side * side;
+	const Uint64 numSectors = Uint64(numColumns) * side;
+	Uint64 sectorsDone = 0, systemsDone = 0;
+	const Uint32 startTime = SDL_GetTicks();
+	Uint32 lastReport = startTime;
+
+	// factions look their home sectors up when first needed, which would
+	// have several jobs filling in the same faction at once
+	for (Uint32 i = 0; i < m_factions.GetNumFactions(); i++) {
+		const Faction* faction = m_factions.GetFaction(i);
+		if (faction->hasHomeworld)
+			faction->GetHomeSector();
+	}
+
+	std::vector<DumpJob::Column> columns;
+	SectorCache::PathVector paths;
+	for (Uint32 first = 0; first < numColumns; first += WAVE_COLUMNS) {
+		const Uint32 count = std::min(WAVE_COLUMNS, numColumns - first);
+
+		// generate the sectors of this wave
+		paths.clear();
+		for (Uint32 c = first; c < first + count; c++) {
+			const Sint32 sx = centerX - radius + Sint32(c / side);
+			const Sint32 sy = centerY - radius + Sint32(c % side);
+			for (Sint32 sz = centerZ - radius; sz <= centerZ + radius; ++sz)
+				paths.push_back(SystemPath(sx, sy, sz));
+		}
+		auto checkSectors = [&]() {
+			for (const SystemPath& path : paths)
+				if (!sectorCache->GetIfCached(path))
+					return false;
+			return true;
+		};
+		sectorCache->FillCache(paths);
+		bool sectorsReady = checkSectors();
+		while (!sectorsReady) {
+			if (queue->FinishJobs())
+				sectorsReady = checkSectors();
+			else
+				SDL_Delay(1);
+		}
+
+		// the jobs only read the wave's sectors, held here. anything else the star
+		// system generator looks up goes through the master cache, which is locked
+		columns.resize(count);
+		size_t p = 0;
+		for (DumpJob::Column& column : columns) {
+			column.sectors.clear();
+			for (Uint32 i = 0; i < side; i++)
+				column.sectors.push_back(sectorCache->GetIfCached(paths[p++]));
+			column.systems = 0;
+			column.file = tmpfile();
+			if (!column.file)
+				Error("Galaxy::Dump: couldn't create a temporary file: %s\n", strerror(errno));
+			jobs.Order(new DumpJob(RefCountedPtr<Galaxy>(this), &column, format));
+		}
+		while (!jobs.IsEmpty()) {
+			if (!queue->FinishJobs())
+				SDL_Delay(1);
+		}
+
+		// stream the wave to the output in order
+		char buf[16384];
+		for (DumpJob::Column& column : columns) {
+			rewind(column.file);
+			size_t n;
+			while ((n = fread(buf, 1, sizeof(buf), column.file)) > 0)
+				fwrite(buf, 1, n, file);
+			fclose(column.file);
+			column.sectors.clear();
+			systemsDone += column.systems;
+		}
+		sectorCache->ClearCache();
+		sectorsDone += Uint64(count) * side;
+
+		const Uint32 now = SDL_GetTicks();
+		if (now - lastReport >= 1000 || sectorsDone == numSectors) {
+			const double seconds = std::max(0.001, (now - startTime) / 1000.0);
+			Output("Galaxy::Dump: %llu/%llu sectors (%.1f%%), %llu systems, %.0f sectors/s, %.0f systems/s\n",
+				(unsigned long long)sectorsDone, (unsigned long long)numSectors, 100.0 * sectorsDone / numSectors,
+				(unsigned long long)systemsDone, sectorsDone / seconds, systemsDone / seconds);
+			lastReport = now;
 		}
 	}
 }
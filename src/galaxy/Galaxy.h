@@ -9,9 +9,11 @@
 #include "Factions.h"
 #include "CustomSystem.h"
 #include "GalaxyCache.h"
+#include "RouteCache.h"
 #include "json/json.h"
 
 struct SDL_Surface;
+struct SDL_mutex;
 class GalaxyGenerator;
 
 class Galaxy : public RefCounted {
@@ -46,20 +48,31 @@ public:
 	RefCountedPtr<StarSystem> GetStarSystem(const SystemPath& path) { return m_starSystemCache.GetCached(path); }
 	RefCountedPtr<StarSystemCache::Slave> NewStarSystemSlaveCache() { return m_starSystemCache.NewSlaveCache(); }
 
+	RouteCache* GetRouteCache() { return &m_routeCache; }
+
+	enum DumpFormat {
+		DUMP_TEXT,  // nested blocks with every body of every system
+		DUMP_CSV,   // one line per system, after a header line
+		DUMP_JSONL  // one JSON object per system and line
+	};
+
 	void FlushCaches();
-	void Dump(FILE* file, Sint32 centerX, Sint32 centerY, Sint32 centerZ, Sint32 radius);
+	void Dump(FILE* file, Sint32 centerX, Sint32 centerY, Sint32 centerZ, Sint32 radius, DumpFormat format = DUMP_TEXT);
 
 	RefCountedPtr<GalaxyGenerator> GetGenerator() const;
 	const std::string& GetGeneratorName() const;
 	int GetGeneratorVersion() const;
 
 private:
+	friend class Sector;
 	bool m_initialized;
 	RefCountedPtr<GalaxyGenerator> m_galaxyGenerator;
 	SectorCache m_sectorCache;
 	StarSystemCache m_starSystemCache;
+	RouteCache m_routeCache;
 	FactionsDatabase m_factions;
 	CustomSystemsDatabase m_customSystems;
+	SDL_mutex *m_systemNameLock; // for the deferred names of random systems
 };
 
 class DensityMapGalaxy : public Galaxy {
@@ -22,19 +22,38 @@ GalaxyObjectCache<T,CompareT>::~GalaxyObjectCache()
 	for (Slave* s : m_slaves)
 		s->MasterDeleted();
 	assert(m_attic.empty()); // otherwise the objects will deregister at a cache that no longer exists
+	SDL_DestroyMutex(m_lock);
+}
+
+// with m_lock held
+template <typename T, typename CompareT>
+RefCountedPtr<T> GalaxyObjectCache<T,CompareT>::FindInAttic(const SystemPath& path)
+{
+	RefCountedPtr<T> s;
+	typename AtticMap::iterator i = m_attic.find(path);
+	// the object may be on its way out on another thread, and not be removed yet
+	if (i != m_attic.end() && i->second->IncRefCountIfAlive()) {
+		s.Reset(i->second);
+		i->second->DecRefCount();
+	}
+	return s;
 }
 
 template <typename T, typename CompareT>
 void GalaxyObjectCache<T,CompareT>::AddToCache(std::vector<RefCountedPtr<T> >& objects)
 {
+	SDL_LockMutex(m_lock);
 	for (auto it = objects.begin(), itEnd = objects.end(); it != itEnd; ++it) {
-		auto inserted = m_attic.insert( std::make_pair(it->Get()->GetPath(), it->Get()) );
-		if (!inserted.second) {
-			it->Reset(inserted.first->second);
+		const SystemPath path = it->Get()->GetPath();
+		RefCountedPtr<T> cached = FindInAttic(path);
+		if (cached) {
+			*it = cached;
 		} else {
+			m_attic[path] = it->Get();
 			(*it)->SetCache(this);
 		}
 	}
+	SDL_UnlockMutex(m_lock);
 }
 
 template <typename T, typename CompareT>
@@ -42,12 +61,9 @@ RefCountedPtr<T> GalaxyObjectCache<T,CompareT>::GetIfCached(const SystemPath& pa
 {
 	PROFILE_SCOPED()
 
-	RefCountedPtr<T> s;
-	typename AtticMap::iterator i = m_attic.find(path);
-	if (i != m_attic.end()) {
-		s.Reset(i->second);
-	}
-
+	SDL_LockMutex(m_lock);
+	RefCountedPtr<T> s = FindInAttic(path);
+	SDL_UnlockMutex(m_lock);
 	return s;
 }
 
@@ -56,15 +72,22 @@ RefCountedPtr<T> GalaxyObjectCache<T,CompareT>::GetCached(const SystemPath& path
 {
 	PROFILE_SCOPED()
 
-	RefCountedPtr<T> s = this->GetIfCached(path);
-	if (!s) {
-		++m_cacheMisses;
-		s = m_galaxy->GetGenerator()->Generate<T,GalaxyObjectCache<T,CompareT>>(RefCountedPtr<Galaxy>(m_galaxy), path, this);
-		m_attic.insert( std::make_pair(path, s.Get()));
-	} else {
+	SDL_LockMutex(m_lock);
+	RefCountedPtr<T> s = FindInAttic(path);
+	if (s) {
 		++m_cacheHits;
+		SDL_UnlockMutex(m_lock);
+		return s;
 	}
-	return s;
+	++m_cacheMisses;
+	SDL_UnlockMutex(m_lock);
+
+	// generated unlocked, so other threads can carry on meanwhile. one of
+	// them might make the same object, in which case the first one in is kept
+	s = m_galaxy->GetGenerator()->Generate<T,GalaxyObjectCache<T,CompareT>>(RefCountedPtr<Galaxy>(m_galaxy), path, nullptr);
+	std::vector<RefCountedPtr<T> > objects(1, s);
+	AddToCache(objects);
+	return objects[0];
 }
 
 template <typename T, typename CompareT>
@@ -72,13 +95,21 @@ bool GalaxyObjectCache<T,CompareT>::HasCached(const SystemPath& path) const
 {
 	PROFILE_SCOPED()
 
-	return (m_attic.find(path) != m_attic.end());
+	SDL_LockMutex(m_lock);
+	const bool cached = (m_attic.find(path) != m_attic.end());
+	SDL_UnlockMutex(m_lock);
+	return cached;
 }
 
 template <typename T, typename CompareT>
-void GalaxyObjectCache<T,CompareT>::RemoveFromAttic(const SystemPath& path)
+void GalaxyObjectCache<T,CompareT>::RemoveFromAttic(const SystemPath& path, const T* object)
 {
-	m_attic.erase(path);
+	SDL_LockMutex(m_lock);
+	// unless it has already been replaced by a new object for the same path
+	typename AtticMap::iterator i = m_attic.find(path);
+	if (i != m_attic.end() && i->second == object)
+		m_attic.erase(i);
+	SDL_UnlockMutex(m_lock);
 }
 
 template <typename T, typename CompareT>
@@ -91,9 +122,11 @@ void GalaxyObjectCache<T,CompareT>::ClearCache()
 template <typename T, typename CompareT>
 void GalaxyObjectCache<T,CompareT>::OutputCacheStatistics(bool reset)
 {
+	SDL_LockMutex(m_lock);
 	Output("%s: misses: %llu, slave hits: %llu, master hits: %llu\n", CACHE_NAME.c_str(), m_cacheMisses, m_cacheHitsSlave, m_cacheHits);
 	if (reset)
 		m_cacheMisses = m_cacheHitsSlave = m_cacheHits = 0;
+	SDL_UnlockMutex(m_lock);
 }
 
 template <typename T, typename CompareT>
@@ -231,9 +264,11 @@ void GalaxyObjectCache<T,CompareT>::Slave::FillCache(const typename GalaxyObject
 		if (callback)
 			callback();
 	} else {
-		// now add the batched jobs
+		// now add the batched jobs. the callback is for this request alone, so it
+		// runs when its own jobs are done, whatever else the slave is filling
+		std::shared_ptr<unsigned> pending(new unsigned(vec_paths.size()));
 		for (auto it = vec_paths.begin(), itEnd = vec_paths.end(); it != itEnd; ++it)
-			m_jobs.Order(new GalaxyObjectCache<T,CompareT>::CacheJob(std::move(*it), this, m_galaxy, callback));
+			m_jobs.Order(new GalaxyObjectCache<T,CompareT>::CacheJob(std::move(*it), this, m_galaxy, callback, pending));
 	}
 }
 
@@ -241,8 +276,8 @@ void GalaxyObjectCache<T,CompareT>::Slave::FillCache(const typename GalaxyObject
 template <typename T, typename CompareT>
 GalaxyObjectCache<T,CompareT>::CacheJob::CacheJob(std::unique_ptr<std::vector<SystemPath> > path,
 	typename GalaxyObjectCache<T,CompareT>::Slave* slaveCache, RefCountedPtr<Galaxy> galaxy,
-	typename GalaxyObjectCache<T,CompareT>::CacheFilledCallback callback)
-	: Job(), m_paths(std::move(path)), m_slaveCache(slaveCache), m_galaxy(galaxy), m_galaxyGenerator(galaxy->GetGenerator()), m_callback(callback)
+	typename GalaxyObjectCache<T,CompareT>::CacheFilledCallback callback, std::shared_ptr<unsigned> pending)
+	: Job(), m_paths(std::move(path)), m_slaveCache(slaveCache), m_galaxy(galaxy), m_galaxyGenerator(galaxy->GetGenerator()), m_callback(callback), m_pending(pending)
 {
 	m_objects.reserve(m_paths->size());
 }
@@ -260,7 +295,7 @@ template <typename T, typename CompareT>
 void GalaxyObjectCache<T,CompareT>::CacheJob::OnFinish()  // runs in primary thread of the context
 {
 	m_slaveCache->AddToCache(m_objects);
-	if (m_slaveCache->m_jobs.IsEmpty() && m_callback)
+	if (m_pending && --*m_pending == 0 && m_callback)
 		m_callback();
 }
 
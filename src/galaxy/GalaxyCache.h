@@ -24,7 +24,7 @@ class GalaxyObjectCache {
 public:
 	static const std::string CACHE_NAME;
 
-	GalaxyObjectCache(Galaxy* galaxy) : m_galaxy(galaxy), m_cacheHits(0), m_cacheHitsSlave(0), m_cacheMisses(0) { }
+	GalaxyObjectCache(Galaxy* galaxy) : m_galaxy(galaxy), m_cacheHits(0), m_cacheHitsSlave(0), m_cacheMisses(0), m_lock(SDL_CreateMutex()) { }
 	~GalaxyObjectCache();
 
 	RefCountedPtr<T> GetCached(const SystemPath& path);
@@ -73,7 +73,8 @@ private:
 
 	void AddToCache(std::vector<RefCountedPtr<T> >& objects);
 	bool HasCached(const SystemPath& path) const;
-	void RemoveFromAttic(const SystemPath& path);
+	void RemoveFromAttic(const SystemPath& path, const T* object);
+	RefCountedPtr<T> FindInAttic(const SystemPath& path);
 
 	// ********************************************************************************
 	// Overloaded Job class to handle generating a collection of sectors
@@ -81,7 +82,8 @@ private:
 	class CacheJob : public Job
 	{
 	public:
-		CacheJob(std::unique_ptr<std::vector<SystemPath> > path, Slave* slaveCache, RefCountedPtr<Galaxy> galaxy, CacheFilledCallback callback = CacheFilledCallback());
+		CacheJob(std::unique_ptr<std::vector<SystemPath> > path, Slave* slaveCache, RefCountedPtr<Galaxy> galaxy,
+			CacheFilledCallback callback = CacheFilledCallback(), std::shared_ptr<unsigned> pending = std::shared_ptr<unsigned>());
 
 		virtual void OnRun();    // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
 		virtual void OnFinish();  // runs in primary thread of the context
@@ -94,6 +96,7 @@ private:
 		RefCountedPtr<Galaxy> m_galaxy;
 		RefCountedPtr<GalaxyGenerator> m_galaxyGenerator;
 		CacheFilledCallback m_callback;
+		std::shared_ptr<unsigned> m_pending; // jobs of the same FillCache still to finish
 	};
 
 	Galaxy* m_galaxy;
@@ -105,6 +108,10 @@ private:
 	unsigned long long m_cacheHits;
 	unsigned long long m_cacheHitsSlave;
 	unsigned long long m_cacheMisses;
+
+	// the master cache is also used by star system generation in jobs (cache
+	// jobs, galaxy dumps), so the attic and statistics are behind this
+	SDL_mutex* m_lock;
 };
 
 class Sector;
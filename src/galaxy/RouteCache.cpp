@@ -0,0 +1,160 @@
+// Copyright © 2008-2018 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "libs.h"
+#include "utils.h"
+#include "galaxy/RouteCache.h"
+#include "galaxy/Galaxy.h"
+#include "galaxy/Sector.h"
+
+const RouteTree::Route* RouteTree::FindRoute(const SystemPath& path) const
+{
+	auto it = m_index.find(path);
+	return it != m_index.end() ? &m_routes[it->second] : nullptr;
+}
+
+RefCountedPtr<const RouteTree> RouteCache::GetRouteTree(const SystemPath& origin, float range, int maxJumps)
+{
+	PROFILE_SCOPED()
+	assert(origin.HasValidSystem());
+
+	Key key;
+	key.origin = origin.SystemOnly();
+	key.range = range;
+	key.maxJumps = maxJumps;
+
+	auto it = m_trees.find(key);
+	if (it != m_trees.end()) {
+		++m_cacheHits;
+		return it->second;
+	}
+
+	++m_cacheMisses;
+	// scripts only ever ask about a handful of origins between player jumps,
+	// so when that stops being true just start over
+	if (m_trees.size() >= MAX_CACHED_TREES)
+		m_trees.clear();
+
+	RefCountedPtr<RouteTree> tree = BuildRouteTree(key.origin, range, maxJumps);
+	m_trees.insert(std::make_pair(key, tree));
+	return tree;
+}
+
+void RouteCache::OutputCacheStatistics(bool reset)
+{
+	Output("RouteCache: misses: %llu, hits: %llu\n", m_cacheMisses, m_cacheHits);
+	if (reset)
+		m_cacheMisses = m_cacheHits = 0;
+}
+
+// Breadth-first search, one jump count per layer. Within a layer a system keeps
+// the parent giving the shortest total distance, so the result is a shortest
+// path tree ordered by (jumps, distance).
+RefCountedPtr<RouteTree> RouteCache::BuildRouteTree(const SystemPath& origin, float range, int maxJumps)
+{
+	PROFILE_SCOPED()
+	RefCountedPtr<RouteTree> tree(new RouteTree(origin, range, maxJumps));
+
+	// sectors are kept alive here for the duration of the search so that the
+	// System pointers below stay valid
+	std::map<SystemPath, RefCountedPtr<const Sector>, SystemPath::LessSectorOnly> sectors;
+	auto getSector = [&](const SystemPath& path) -> const Sector* {
+		auto it = sectors.find(path);
+		if (it == sectors.end())
+			it = sectors.insert(std::make_pair(path, m_galaxy->GetSector(path))).first;
+		return it->second.Get();
+	};
+
+	const Sector* originSec = getSector(origin);
+	if (origin.systemIndex >= originSec->m_systems.size())
+		return tree;
+
+	std::vector<RouteTree::Route>& routes = tree->m_routes;
+	std::vector<const Sector::System*> systems;
+
+	RouteTree::Route start = { origin, 0, 0.0f, -1 };
+	routes.push_back(start);
+	systems.push_back(&originSec->m_systems[origin.systemIndex]);
+	tree->m_index[origin] = 0;
+
+	const int diffSec = int(ceil(range / Sector::SIZE));
+	const float rangeSqr = range * range;
+
+	std::vector<size_t> frontier(1, 0);
+	std::vector<size_t> next;
+	for (int jump = 1; jump <= maxJumps && !frontier.empty(); jump++) {
+		next.clear();
+		for (size_t from : frontier) {
+			const Sector::System* a = systems[from];
+			const float baseDist = routes[from].distance;
+			for (int x = a->sx - diffSec; x <= a->sx + diffSec; x++) {
+				for (int y = a->sy - diffSec; y <= a->sy + diffSec; y++) {
+					for (int z = a->sz - diffSec; z <= a->sz + diffSec; z++) {
+						// position of the sector's origin relative to the system we're jumping from
+						const vector3f secOffset = Sector::SIZE * vector3f(float(x - a->sx), float(y - a->sy), float(z - a->sz)) - a->GetPosition();
+
+						// skip sectors whose bounding box is entirely out of range
+						const vector3f nearest(
+							Clamp(0.0f, secOffset.x, secOffset.x + Sector::SIZE),
+							Clamp(0.0f, secOffset.y, secOffset.y + Sector::SIZE),
+							Clamp(0.0f, secOffset.z, secOffset.z + Sector::SIZE));
+						if (nearest.LengthSqr() > rangeSqr)
+							continue;
+
+						const Sector* sec = getSector(SystemPath(x, y, z));
+						for (const Sector::System& b : sec->m_systems) {
+							const float distSqr = (secOffset + b.GetPosition()).LengthSqr();
+							if (distSqr > rangeSqr)
+								continue;
+
+							const float total = baseDist + sqrt(distSqr);
+							const SystemPath bpath(x, y, z, b.idx);
+							auto found = tree->m_index.find(bpath);
+							if (found == tree->m_index.end()) {
+								RouteTree::Route r = { bpath, jump, total, int(from) };
+								tree->m_index[bpath] = routes.size();
+								next.push_back(routes.size());
+								routes.push_back(r);
+								systems.push_back(&b);
+							} else {
+								RouteTree::Route& r = routes[found->second];
+								// anything from an earlier layer already has fewer jumps
+								if (r.jumps == jump && total < r.distance) {
+									r.distance = total;
+									r.parent = int(from);
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+		frontier.swap(next);
+	}
+
+	// layers are already in jump order, sort by distance within each of them
+	std::vector<size_t> order(routes.size());
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&routes](size_t a, size_t b) {
+		if (routes[a].jumps != routes[b].jumps) return routes[a].jumps < routes[b].jumps;
+		return routes[a].distance < routes[b].distance;
+	});
+
+	std::vector<int> remap(routes.size());
+	for (size_t i = 0; i < order.size(); i++)
+		remap[order[i]] = int(i);
+
+	std::vector<RouteTree::Route> sorted;
+	sorted.reserve(routes.size());
+	for (size_t i : order) {
+		RouteTree::Route r = routes[i];
+		if (r.parent >= 0)
+			r.parent = remap[r.parent];
+		tree->m_index[r.path] = sorted.size();
+		sorted.push_back(r);
+	}
+	routes.swap(sorted);
+
+	return tree;
+}
@@ -0,0 +1,83 @@
+// Copyright © 2008-2018 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _ROUTECACHE_H
+#define _ROUTECACHE_H
+
+#include <map>
+#include <vector>
+#include "RefCounted.h"
+#include "galaxy/SystemPath.h"
+
+class Galaxy;
+
+// All systems reachable from one origin in at most maxJumps hyperjumps of at
+// most range light years each. Every system is reached with the fewest jumps
+// possible and, for that number of jumps, the shortest total distance.
+class RouteTree : public RefCounted {
+public:
+	struct Route {
+		SystemPath path;
+		int jumps;
+		float distance; // sum of all jump lengths, in light years
+		int parent;     // index of the previous hop in GetRoutes(), -1 for the origin
+	};
+
+	const SystemPath& GetOrigin() const { return m_origin; }
+	float GetRange() const { return m_range; }
+	int GetMaxJumps() const { return m_maxJumps; }
+
+	// sorted by jumps, then by distance; the first entry is the origin itself
+	const std::vector<Route>& GetRoutes() const { return m_routes; }
+	// nullptr if the system can't be reached within the limits of this tree
+	const Route* FindRoute(const SystemPath& path) const;
+
+private:
+	friend class RouteCache;
+	RouteTree(const SystemPath& origin, float range, int maxJumps) :
+		m_origin(origin), m_range(range), m_maxJumps(maxJumps) {}
+
+	SystemPath m_origin;
+	float m_range;
+	int m_maxJumps;
+	std::vector<Route> m_routes;
+	std::map<SystemPath, size_t, SystemPath::LessSystemOnly> m_index;
+};
+
+// Caches one RouteTree per (origin, range, maxJumps) query, so that scripts
+// asking about many targets around the same system only pay for one search.
+// The game flushes it whenever the player arrives in a new system.
+class RouteCache {
+public:
+	RouteCache(Galaxy* galaxy) : m_galaxy(galaxy), m_cacheHits(0), m_cacheMisses(0) {}
+
+	RefCountedPtr<const RouteTree> GetRouteTree(const SystemPath& origin, float range, int maxJumps);
+
+	void ClearCache() { m_trees.clear(); }
+	void OutputCacheStatistics(bool reset = true);
+
+private:
+	static const size_t MAX_CACHED_TREES = 16;
+
+	struct Key {
+		SystemPath origin;
+		float range;
+		int maxJumps;
+
+		bool operator<(const Key& b) const {
+			if (range != b.range) return range < b.range;
+			if (maxJumps != b.maxJumps) return maxJumps < b.maxJumps;
+			return SystemPath::LessSystemOnly()(origin, b.origin);
+		}
+	};
+
+	RefCountedPtr<RouteTree> BuildRouteTree(const SystemPath& origin, float range, int maxJumps);
+
+	Galaxy* m_galaxy;
+	std::map<Key, RefCountedPtr<RouteTree> > m_trees;
+
+	unsigned long long m_cacheHits;
+	unsigned long long m_cacheMisses;
+};
+
+#endif /* _ROUTECACHE_H */
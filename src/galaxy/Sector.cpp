@@ -2,6 +2,7 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "Sector.h"
+#include "SectorGenerator.h"
 #include "StarSystem.h"
 #include "CustomSystem.h"
 #include "Galaxy.h"
@@ -21,7 +22,7 @@ Sector::Sector(RefCountedPtr<Galaxy> galaxy, const SystemPath& path, SectorCache
 Sector::~Sector()
 {
 	if (m_cache)
-		m_cache->RemoveFromAttic(SystemPath(sx, sy, sz));
+		m_cache->RemoveFromAttic(SystemPath(sx, sy, sz), this);
 }
 
 float Sector::DistanceBetween(RefCountedPtr<const Sector> a, int sysIdxA, RefCountedPtr<const Sector> b, int sysIdxB)
@@ -66,6 +67,16 @@ void Sector::System::SetExplored(StarSystem::ExplorationState e, double time)
 
 void Sector::Dump(FILE* file, const char* indent) const
 {
+	std::vector<RefCountedPtr<const StarSystem> > systems;
+	systems.reserve(m_systems.size());
+	for (const Sector::System& sys : m_systems)
+		systems.push_back(m_galaxy->GetStarSystem(SystemPath(sys.sx, sys.sy, sys.sz, sys.idx)));
+	Dump(file, systems, indent);
+}
+
+void Sector::Dump(FILE* file, const std::vector<RefCountedPtr<const StarSystem> >& systems, const char* indent) const
+{
+	assert(systems.size() == m_systems.size());
 	fprintf(file, "Sector(%d,%d,%d) {\n", sx, sy, sz);
 	fprintf(file, "\t" SIZET_FMT " systems\n", m_systems.size());
 	for (const Sector::System& sys : m_systems) {
@@ -82,7 +93,7 @@ void Sector::Dump(FILE* file, const char* indent) const
 		for (unsigned i = 0; i < sys.GetNumStars(); ++i)
 			fprintf(file, "\t\t\t%s\n", EnumStrings::GetString("BodyType", sys.GetStarType(i)));
 		if (sys.GetNumStars() > 0) fprintf(file, "\t\t}\n");
-		RefCountedPtr<const StarSystem> ssys = m_galaxy->GetStarSystem(SystemPath(sys.sx, sys.sy, sys.sz, sys.idx));
+		const RefCountedPtr<const StarSystem>& ssys = systems[sys.idx];
 		assert(ssys->GetPath().IsSameSystem(SystemPath(sys.sx, sys.sy, sys.sz, sys.idx)));
 		assert(ssys->GetNumStars() == sys.GetNumStars());
 		assert(ssys->GetName() == sys.GetName());
@@ -106,6 +117,23 @@ float Sector::System::DistanceBetween(const System* a, const System* b)
 	return dv.Length();
 }
 
+const std::string& Sector::System::GetName() const
+{
+	// sectors from the galaxy's caches are shared with jobs, so the name of a
+	// random system is built under the galaxy's lock the first time anybody
+	// asks for it. After that m_name never changes again
+	if (m_deferredName) {
+		SDL_mutex *lock = m_sector->m_galaxy->m_systemNameLock;
+		SDL_LockMutex(lock);
+		if (m_deferredName) {
+			m_name = SectorRandomSystemsGenerator::GenName(*this);
+			m_deferredName = false;
+		}
+		SDL_UnlockMutex(lock);
+	}
+	return m_name;
+}
+
 void Sector::System::AssignFaction() const
 {
 	assert(m_sector->m_galaxy->GetFactions()->MayAssignFactions());
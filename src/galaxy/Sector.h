@@ -10,6 +10,7 @@
 #include "galaxy/CustomSystem.h"
 #include "GalaxyCache.h"
 #include "RefCounted.h"
+#include <atomic>
 #include <string>
 #include <vector>
 
@@ -38,13 +39,13 @@ public:
 	public:
 		System(Sector* sector, int x, int y, int z, Uint32 si) : sx(x), sy(y), sz(z), idx(si), m_sector(sector),
 			m_numStars(0), m_seed(0), m_customSys(nullptr), m_faction(nullptr), m_population(-1),
-			m_explored(StarSystem::eUNEXPLORED), m_exploredTime(0.0) {}
+			m_explored(StarSystem::eUNEXPLORED), m_exploredTime(0.0), m_nameStyle(0) {}
 
 		static float DistanceBetween(const System* a, const System* b);
 
 		// Check that we've had our habitation status set
 
-		const std::string& GetName() const { return m_name; }
+		const std::string& GetName() const;
 		const vector3f& GetPosition() const { return m_pos; }
 		vector3f GetFullPosition() const { return Sector::SIZE*vector3f(float(sx), float(sy), float(sz)) + m_pos; };
 		unsigned GetNumStars() const { return m_numStars; }
@@ -78,8 +79,21 @@ public:
 
 		void AssignFaction() const;
 
+		// set while the name is still to be built. Read without a lock, and
+		// copyable, unlike std::atomic, so systems can go in a vector
+		class DeferredFlag {
+		public:
+			DeferredFlag() : m_set(false) {}
+			DeferredFlag(const DeferredFlag &other) : m_set(other.m_set.load()) {}
+			DeferredFlag &operator=(const DeferredFlag &other) { m_set = other.m_set.load(); return *this; }
+			DeferredFlag &operator=(bool set) { m_set = set; return *this; }
+			operator bool() const { return m_set; }
+		private:
+			std::atomic<bool> m_set;
+		};
+
 		Sector* m_sector;
-		std::string m_name;
+		mutable std::string m_name; // mutable because names of random systems are only generated on demand
 		vector3f m_pos;
 		unsigned m_numStars;
 		SystemBody::BodyType m_starType[4];
@@ -89,11 +103,16 @@ public:
 		fixed m_population;
 		StarSystem::ExplorationState m_explored;
 		double m_exploredTime;
+		mutable DeferredFlag m_deferredName;
+		Uint8 m_nameStyle;
+		pcg32 m_nameRng; // generator state the deferred name is drawn from
 	};
 	std::vector<System> m_systems;
 	const int sx, sy, sz;
 
 	void Dump(FILE* file, const char* indent = "") const;
+	// same, with the star systems (one per entry in m_systems) supplied by the caller
+	void Dump(FILE* file, const std::vector<RefCountedPtr<const StarSystem> >& systems, const char* indent = "") const;
 
 	sigc::signal<void, Sector::System*, StarSystem::ExplorationState, double> onSetExplorationState;
 
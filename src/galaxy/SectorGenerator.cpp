@@ -65,16 +65,11 @@ bool SectorCustomSystemsGenerator::Apply(Random& rng, RefCountedPtr<Galaxy> gala
 	return true;
 }
 
-const std::string SectorRandomSystemsGenerator::GenName(RefCountedPtr<Galaxy> galaxy, const Sector& sec, Sector::System &sys, int si, Random &rng)
+// odds against a system getting a "real" name rather than a catalogue number
+static int NameChance(SystemBody::BodyType primaryType, int dist)
 {
-	std::string name;
-	const int sx = sec.sx;
-	const int sy = sec.sy;
-	const int sz = sec.sz;
-	const int dist = std::max(std::max(abs(sx),abs(sy)),abs(sz));
-
 	int chance = 100;
-	switch (sys.m_starType[0]) {
+	switch (primaryType) {
 		case SystemBody::TYPE_STAR_O:
 		case SystemBody::TYPE_STAR_B: break;
 		case SystemBody::TYPE_STAR_A: chance += dist; break;
@@ -104,28 +99,66 @@ const std::string SectorRandomSystemsGenerator::GenName(RefCountedPtr<Galaxy> ga
 		case SystemBody::TYPE_STAR_M_HYPER_GIANT: chance = 1; break;  //Should give a nice name almost all the time
 		default: chance += 16*dist; break;
 	}
+	return chance;
+}
+
+/* First pass of name generation, run as part of Apply. Makes every draw the name
+   needs, so that the rest of the sector sees exactly the same random sequence,
+   but leaves building the string to GenName.
+*/
+void SectorRandomSystemsGenerator::DeferName(RefCountedPtr<Galaxy> galaxy, Sector::System &sys, Random &rng)
+{
+	const int dist = std::max(std::max(abs(sys.sx),abs(sys.sy)),abs(sys.sz));
 
-	Uint32 weight = rng.Int32(chance);
-	if (weight < 500 || galaxy->GetFactions()->IsHomeSystem(SystemPath(sx, sy, sz, si))) {
-		/* well done. you get a real name  */
+	Uint32 weight = rng.Int32(NameChance(sys.m_starType[0], dist));
+	if (weight < 500 || galaxy->GetFactions()->IsHomeSystem(sys.GetPath()))
+		sys.m_nameStyle = NAME_REAL;
+	else if (weight < 800)
+		sys.m_nameStyle = NAME_MJBN;
+	else if (weight < 1200)
+		sys.m_nameStyle = NAME_SC;
+	else
+		sys.m_nameStyle = NAME_DSC;
+	sys.m_nameRng = rng.GetPCG();
+	sys.m_deferredName = true;
+
+	if (sys.m_nameStyle == NAME_REAL) {
 		int len = rng.Int32(2,3);
-		for (int i=0; i<len; i++) {
-			name += sys_names[rng.Int32(0,SYS_NAME_FRAGS-1)];
-		}
-		name[0] = toupper(name[0]);
-		return name;
-	} else if (weight < 800) {
-		char buf[128];
-		snprintf(buf, sizeof(buf), "MJBN %d%+d%+d", rng.Int32(10,999),sx,sy); // MJBN -> Morton Jordan Bennett Norris
-		return buf;
-	} else if (weight < 1200) {
-		char buf[128];
-		snprintf(buf, sizeof(buf), "SC %d%+d%+d", rng.Int32(1000,9999),sx,sy);
-		return buf;
+		for (int i=0; i<len; i++)
+			rng.Int32();
 	} else {
-		char buf[128];
-		snprintf(buf, sizeof(buf), "DSC %d%+d%+d", rng.Int32(1000,9999),sx,sy);
-		return buf;
+		rng.Int32();
+	}
+}
+
+// static
+std::string SectorRandomSystemsGenerator::GenName(const Sector::System &sys)
+{
+	assert(sys.m_deferredName);
+	Random rng;
+	rng.SetPCG(sys.m_nameRng);
+
+	char buf[128];
+	switch (sys.m_nameStyle) {
+		case NAME_REAL: {
+			/* well done. you get a real name  */
+			std::string name;
+			int len = rng.Int32(2,3);
+			for (int i=0; i<len; i++) {
+				name += sys_names[rng.Int32(0,SYS_NAME_FRAGS-1)];
+			}
+			name[0] = toupper(name[0]);
+			return name;
+		}
+		case NAME_MJBN:
+			snprintf(buf, sizeof(buf), "MJBN %d%+d%+d", rng.Int32(10,999),sys.sx,sys.sy); // MJBN -> Morton Jordan Bennett Norris
+			return buf;
+		case NAME_SC:
+			snprintf(buf, sizeof(buf), "SC %d%+d%+d", rng.Int32(1000,9999),sys.sx,sys.sy);
+			return buf;
+		default:
+			snprintf(buf, sizeof(buf), "DSC %d%+d%+d", rng.Int32(1000,9999),sys.sx,sys.sy);
+			return buf;
 	}
 }
 
@@ -143,10 +176,11 @@ bool SectorRandomSystemsGenerator::Apply(Random& rng, RefCountedPtr<Galaxy> gala
 	const Sint64 freq = (1 + sx * sx + sy * sy);
 
 	const int numSystems = (rng.Int32(4,20) * galaxy->GetSectorDensity(sx, sy, sz)) >> 8;
-	sector->m_systems.reserve(numSystems);
+	sector->m_systems.reserve(customCount + numSystems);
 
 	for (int i=0; i<numSystems; i++) {
-		Sector::System s(sector.Get(), sx, sy, sz, customCount + i);
+		sector->m_systems.emplace_back(sector.Get(), sx, sy, sz, customCount + i);
+		Sector::System &s = sector->m_systems.back();
 
 		switch (rng.Int32(15)) {
 			case 0:
@@ -316,10 +350,8 @@ bool SectorRandomSystemsGenerator::Apply(Random& rng, RefCountedPtr<Galaxy> gala
 			//Output("%d: %d%\n", sx, sy);
 		}
 
-		s.m_name = GenName(galaxy, *sector, s, customCount + i,  rng);
-		//Output("%s: \n", s.m_name.c_str());
-
-		sector->m_systems.push_back(s);
+		// the name is only built when somebody asks for it, most far away systems never get looked at
+		DeferName(galaxy, s, rng);
 	}
 	return true;
 }
@@ -22,8 +22,19 @@ private:
 class SectorRandomSystemsGenerator : public SectorGeneratorStage {
 public:
 	virtual bool Apply(Random& rng, RefCountedPtr<Galaxy> galaxy, RefCountedPtr<Sector> sector, GalaxyGenerator::SectorConfig* config);
+
+	// builds the name deferred by Apply, see Sector::System::GetName
+	static std::string GenName(const Sector::System &sys);
+
 private:
-	const std::string GenName(RefCountedPtr<Galaxy> galaxy, const Sector& sec, Sector::System &sys, int si, Random &rand);
+	enum NameStyle {
+		NAME_REAL,
+		NAME_MJBN,
+		NAME_SC,
+		NAME_DSC
+	};
+
+	void DeferName(RefCountedPtr<Galaxy> galaxy, Sector::System &sys, Random &rng);
 };
 
 class SectorPersistenceGenerator : public SectorGeneratorStage {
@@ -19,14 +19,17 @@ public:
 		unsigned int pattern = 0;
 		if (lua_gettop(l) > 3 && !lua_isnoneornil(l, 4))
 			pattern = luaL_checkinteger(l, 4) - 1; // Lua counts from 1
-		SceneGraph::Model *model = Pi::FindModel(name);
-		LuaObject<ModelSpinner>::PushToLua(new ModelSpinner(c, model, *skin, pattern));
+		LuaObject<ModelSpinner>::PushToLua(new ModelSpinner(c, name, *skin, pattern));
 		return 1;
 	}
 
 	static int l_attr_model(lua_State *l) {
 		ModelSpinner *ms = LuaObject<ModelSpinner>::CheckFromLua(1);
-		LuaObject<SceneGraph::Model>::PushToLua(ms->GetModel());
+		// nil while it's loading
+		if (ms->GetModel())
+			LuaObject<SceneGraph::Model>::PushToLua(ms->GetModel());
+		else
+			lua_pushnil(l);
 		return 1;
 	}
 
@@ -6,21 +6,27 @@
 #include "Ship.h"
 #include "Pi.h"
 #include "Game.h"
+#include "ModelCache.h"
 #include "scenegraph/Model.h"
 
 using namespace UI;
 
 namespace GameUI {
 
-ModelSpinner::ModelSpinner(Context *context, SceneGraph::Model *model, const SceneGraph::ModelSkin &skin, unsigned int pattern) : Widget(context),
+ModelSpinner::ModelSpinner(Context *context, const std::string &modelName, const SceneGraph::ModelSkin &skin, unsigned int pattern) : Widget(context),
+	m_modelName(modelName),
 	m_skin(skin),
+	m_pattern(pattern),
 	m_rotX(DEG2RAD(-15.0)), m_rotY(DEG2RAD(180.0)),
 	m_rightMouseButton(false)
 {
-	m_model.reset(model->MakeInstance());
-	m_skin.Apply(m_model.get());
-	m_model->SetPattern(pattern);
-	m_shields.reset(new Shields(model));
+	try {
+		SceneGraph::Model *model = Pi::modelCache->FindModelIfLoaded(modelName);
+		if (model)
+			SetModel(model);
+	} catch (const ModelCache::ModelNotFoundException&) {
+		SetModel(Pi::FindModel(modelName));
+	}
 
 	Color lc(Color::WHITE);
 	m_light.SetDiffuse(lc);
@@ -29,6 +35,14 @@ ModelSpinner::ModelSpinner(Context *context, SceneGraph::Model *model, const Sce
 	m_light.SetType(Graphics::Light::LIGHT_DIRECTIONAL);
 }
 
+void ModelSpinner::SetModel(SceneGraph::Model *model)
+{
+	m_model.reset(model->MakeInstance());
+	m_skin.Apply(m_model.get());
+	m_model->SetPattern(m_pattern);
+	m_shields.reset(new Shields(model));
+}
+
 void ModelSpinner::Layout()
 {
 	Point size(GetSize());
@@ -42,6 +56,17 @@ void ModelSpinner::Update()
 	if (!(m_rightMouseButton && IsMouseActive()))
 		m_rotY += Pi::GetFrameTime();
 
+	if (!m_model) {
+		try {
+			SceneGraph::Model *model = Pi::modelCache->FindModelIfLoaded(m_modelName);
+			if (model)
+				SetModel(model);
+		} catch (const ModelCache::ModelNotFoundException&) {
+			// the placeholder
+			SetModel(Pi::FindModel(m_modelName));
+		}
+	}
+
 	if (m_model) {
 		m_shields->SetEnabled(false);
 		m_shields->Update(0.0f, 0.0f);
@@ -50,6 +75,9 @@ void ModelSpinner::Update()
 
 void ModelSpinner::Draw()
 {
+	if (!m_model)
+		return;
+
 	Graphics::Renderer *r = GetContext()->GetRenderer();
 
 	Graphics::Renderer::StateTicket ticket(r);
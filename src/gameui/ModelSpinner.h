@@ -15,7 +15,8 @@ namespace GameUI {
 
 class ModelSpinner : public UI::Widget {
 public:
-	ModelSpinner(UI::Context *context, SceneGraph::Model *model, const SceneGraph::ModelSkin &skin, unsigned int pattern);
+	// the model is loaded in the background, nothing is drawn until it's ready
+	ModelSpinner(UI::Context *context, const std::string &modelName, const SceneGraph::ModelSkin &skin, unsigned int pattern);
 
 	virtual UI::Point PreferredSize() { return UI::Point(INT_MAX); }
 	virtual void Layout();
@@ -29,8 +30,12 @@ protected:
 	virtual void HandleMouseMove(const UI::MouseMotionEvent &event);
 
 private:
+	void SetModel(SceneGraph::Model *model);
+
+	std::string m_modelName;
 	std::unique_ptr<SceneGraph::Model> m_model;
 	SceneGraph::ModelSkin m_skin;
+	unsigned int m_pattern;
 	std::unique_ptr<Shields> m_shields;
 
 	float m_rotX, m_rotY;
@@ -0,0 +1,266 @@
+// Copyright © 2008-2018 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "FrameTimings.h"
+#include "Renderer.h"
+#include <algorithm>
+
+namespace Graphics {
+
+FrameTimings::FrameTimings(Renderer *r) :
+	m_renderer(r),
+	m_current(0),
+	m_frameCount(0),
+	m_depth(0),
+	m_msPerTick(1000.0 / double(SDL_GetPerformanceFrequency()))
+{
+	memset(m_frames, 0, sizeof(m_frames));
+	// the renderer isn't ready for queries yet, so the first frame has no GPU times
+	m_frames[0].start = SDL_GetPerformanceCounter();
+	m_frames[0].gpuTime = -1.0;
+}
+
+double FrameTimings::Elapsed(const Frame &frame) const
+{
+	return double(SDL_GetPerformanceCounter() - frame.start) * m_msPerTick;
+}
+
+void FrameTimings::FreeQueries(Frame &frame)
+{
+	for (Uint32 q : frame.queries)
+		if (q) m_renderer->FreeGPUTimestamp(q);
+	for (Uint32 i = 0; i < frame.numSpans; i++)
+		for (Uint32 q : frame.spans[i].queries)
+			if (q) m_renderer->FreeGPUTimestamp(q);
+	frame.gpuPending = false;
+}
+
+void FrameTimings::ResolveGPU(Frame &frame)
+{
+	// timestamps are written in order, so when the last one is in they all are
+	Uint64 start, end;
+	if (!m_renderer->GetGPUTimestamp(frame.queries[1], end))
+		return;
+	m_renderer->GetGPUTimestamp(frame.queries[0], start);
+	frame.gpuTime = double(end - start) * 1e-6;
+	for (Uint32 i = 0; i < frame.numPasses; i++)
+		if (!frame.passes[i].gpuMissing)
+			frame.passes[i].gpuTime = 0.0;
+	for (Uint32 i = 0; i < frame.numSpans; i++) {
+		Span &s = frame.spans[i];
+		Pass &p = frame.passes[s.pass];
+		Uint64 ss, se;
+		if (m_renderer->GetGPUTimestamp(s.queries[0], ss) && m_renderer->GetGPUTimestamp(s.queries[1], se)) {
+			s.gpuStart = double(ss - start) * 1e-6;
+			s.gpuEnd = double(se - start) * 1e-6;
+			if (p.gpuTime >= 0.0)
+				p.gpuTime += s.gpuEnd - s.gpuStart;
+		} else {
+			p.gpuTime = -1.0;
+		}
+	}
+	FreeQueries(frame);
+}
+
+void FrameTimings::StartFrame()
+{
+	Frame &frame = m_frames[m_current];
+	// the GPU is a long way behind, or gone
+	if (frame.gpuPending)
+		FreeQueries(frame);
+	frame.number = m_frameCount;
+	frame.start = SDL_GetPerformanceCounter();
+	frame.cpuTime = 0.0;
+	frame.gpuTime = -1.0;
+	frame.queries[0] = m_renderer->QueryGPUTimestamp();
+	frame.queries[1] = 0;
+	frame.gpuPending = frame.queries[0] != 0;
+	frame.numPasses = 0;
+	frame.numSpans = 0;
+}
+
+void FrameTimings::NextFrame()
+{
+	Frame &frame = m_frames[m_current];
+	assert(m_depth == 0);
+	frame.cpuTime = Elapsed(frame);
+	if (frame.gpuPending)
+		frame.queries[1] = m_renderer->QueryGPUTimestamp();
+
+	m_current = (m_current + 1) % MAX_FRAMES;
+	m_frameCount++;
+	StartFrame();
+
+	for (Uint32 ago = 0; ago < GetNumFrames(); ago++) {
+		Frame &f = m_frames[(m_current + MAX_FRAMES - 1 - ago) % MAX_FRAMES];
+		if (f.gpuPending)
+			ResolveGPU(f);
+	}
+}
+
+int FrameTimings::BeginPass(const char *name)
+{
+	Frame &frame = m_frames[m_current];
+	const Uint32 depth = m_depth++;
+	if (depth >= MAX_DEPTH)
+		return -1;
+
+	Uint32 pass = 0;
+	while (pass < frame.numPasses && !(frame.passes[pass].depth == depth && strcmp(frame.passes[pass].name, name) == 0))
+		pass++;
+	if (pass == frame.numPasses) {
+		if (frame.numPasses >= MAX_PASSES)
+			return -1;
+		Pass &p = frame.passes[frame.numPasses++];
+		p.name = name;
+		p.depth = depth;
+		p.cpuTime = 0.0;
+		p.gpuTime = -1.0;
+		p.gpuMissing = false;
+	}
+
+	Open &open = m_open[depth];
+	open.cpuStart = Elapsed(frame);
+	open.span = -1;
+
+	// the same pass again straight after the last one (the bodies of one type
+	// in a row, say) carries on with its span
+	if (frame.numSpans > 0) {
+		Span &last = frame.spans[frame.numSpans - 1];
+		if (last.pass == pass && last.cpuEnd >= 0.0) {
+			last.cpuEnd = -1.0;
+			if (last.queries[1]) {
+				m_renderer->FreeGPUTimestamp(last.queries[1]);
+				last.queries[1] = 0;
+			}
+			open.span = frame.numSpans - 1;
+			return pass;
+		}
+	}
+
+	if (frame.numSpans >= MAX_SPANS || !frame.gpuPending) {
+		frame.passes[pass].gpuMissing = true;
+		if (frame.numSpans >= MAX_SPANS)
+			return pass;
+	}
+	Span &s = frame.spans[frame.numSpans];
+	s.pass = pass;
+	s.cpuStart = open.cpuStart;
+	s.cpuEnd = -1.0;
+	s.gpuStart = s.gpuEnd = -1.0;
+	s.queries[0] = frame.gpuPending ? m_renderer->QueryGPUTimestamp() : 0;
+	s.queries[1] = 0;
+	open.span = frame.numSpans++;
+	return pass;
+}
+
+void FrameTimings::EndPass(int pass)
+{
+	assert(m_depth > 0);
+	m_depth--;
+	if (pass < 0)
+		return;
+	Frame &frame = m_frames[m_current];
+	const Open &open = m_open[m_depth];
+	const double end = Elapsed(frame);
+	frame.passes[pass].cpuTime += end - open.cpuStart;
+	if (open.span < 0)
+		return;
+	Span &s = frame.spans[open.span];
+	s.cpuEnd = end;
+	if (s.queries[0])
+		s.queries[1] = m_renderer->QueryGPUTimestamp();
+}
+
+Uint32 FrameTimings::GetNumFrames() const
+{
+	return std::min(m_frameCount, MAX_FRAMES - 1);
+}
+
+const FrameTimings::Frame &FrameTimings::GetFrame(Uint32 ago) const
+{
+	assert(ago < GetNumFrames());
+	return m_frames[(m_current + MAX_FRAMES - 1 - ago) % MAX_FRAMES];
+}
+
+void FrameTimings::GetSummary(Uint32 frames, std::vector<Summary> &passes, double &cpuFrameTime, double &gpuFrameTime) const
+{
+	passes.clear();
+	frames = std::min(frames, GetNumFrames());
+	cpuFrameTime = gpuFrameTime = 0.0;
+	if (frames == 0)
+		return;
+
+	// oldest first, so the order is that of a frame
+	std::vector<bool> hasGpu;
+	Uint32 numGpuFrames = 0;
+	for (Uint32 ago = frames; ago-- > 0; ) {
+		const Frame &frame = GetFrame(ago);
+		const bool gpu = frame.gpuTime >= 0.0;
+		cpuFrameTime += frame.cpuTime;
+		if (gpu) {
+			gpuFrameTime += frame.gpuTime;
+			numGpuFrames++;
+		}
+		for (Uint32 i = 0; i < frame.numPasses; i++) {
+			const Pass &p = frame.passes[i];
+			auto it = std::find_if(passes.begin(), passes.end(), [&p](const Summary &s) {
+				return s.depth == p.depth && strcmp(s.name, p.name) == 0;
+			});
+			if (it == passes.end()) {
+				passes.push_back({ p.name, p.depth, 0.0, 0.0 });
+				hasGpu.push_back(false);
+				it = passes.end() - 1;
+			}
+			it->cpuTime += p.cpuTime;
+			if (gpu && p.gpuTime >= 0.0) {
+				it->gpuTime += p.gpuTime;
+				hasGpu[it - passes.begin()] = true;
+			}
+		}
+	}
+
+	cpuFrameTime /= frames;
+	gpuFrameTime = numGpuFrames > 0 ? gpuFrameTime / numGpuFrames : -1.0;
+	for (size_t i = 0; i < passes.size(); i++) {
+		passes[i].cpuTime /= frames;
+		passes[i].gpuTime = hasGpu[i] ? passes[i].gpuTime / numGpuFrames : -1.0;
+	}
+}
+
+void FrameTimings::WriteChromeTrace(FILE *f) const
+{
+	const Uint32 frames = GetNumFrames();
+	if (frames == 0) {
+		fputs("{ \"traceEvents\": [] }\n", f);
+		return;
+	}
+
+	// microseconds from the oldest frame, CPU on one thread and GPU on another
+	const Uint64 origin = GetFrame(frames - 1).start;
+	fputs("{ \"traceEvents\": [\n", f);
+	fputs("{ \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 1, \"args\": { \"name\": \"CPU\" } },\n", f);
+	fputs("{ \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 2, \"args\": { \"name\": \"GPU (from the start of each frame)\" } }", f);
+	const char *sep = ",\n";
+	for (Uint32 ago = frames; ago-- > 0; ) {
+		const Frame &frame = GetFrame(ago);
+		const double base = double(frame.start - origin) * m_msPerTick * 1000.0;
+		fprintf(f, "%s{ \"name\": \"frame %u\", \"cat\": \"cpu\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": %.3f, \"dur\": %.3f }",
+			sep, frame.number, base, frame.cpuTime * 1000.0);
+		if (frame.gpuTime >= 0.0)
+			fprintf(f, "%s{ \"name\": \"frame %u\", \"cat\": \"gpu\", \"ph\": \"X\", \"pid\": 1, \"tid\": 2, \"ts\": %.3f, \"dur\": %.3f }",
+				sep, frame.number, base, frame.gpuTime * 1000.0);
+		for (Uint32 i = 0; i < frame.numSpans; i++) {
+			const Span &s = frame.spans[i];
+			const char *name = frame.passes[s.pass].name;
+			fprintf(f, "%s{ \"name\": \"%s\", \"cat\": \"cpu\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, \"ts\": %.3f, \"dur\": %.3f }",
+				sep, name, base + s.cpuStart * 1000.0, (s.cpuEnd - s.cpuStart) * 1000.0);
+			if (frame.gpuTime >= 0.0 && s.gpuStart >= 0.0)
+				fprintf(f, "%s{ \"name\": \"%s\", \"cat\": \"gpu\", \"ph\": \"X\", \"pid\": 1, \"tid\": 2, \"ts\": %.3f, \"dur\": %.3f }",
+					sep, name, base + s.gpuStart * 1000.0, (s.gpuEnd - s.gpuStart) * 1000.0);
+		}
+	}
+	fputs("\n] }\n", f);
+}
+
+}
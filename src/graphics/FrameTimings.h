@@ -0,0 +1,125 @@
+// Copyright © 2008-2018 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GRAPHICS_FRAMETIMINGS_H
+#define _GRAPHICS_FRAMETIMINGS_H
+
+#include "libs.h"
+#include <cstdio>
+
+namespace Graphics {
+
+class Renderer;
+
+// CPU and GPU time of the major passes over the last couple of seconds of
+// frames. Passes are marked with TIMING_SCOPED, which also shows them in the
+// profiler, and can nest. A pass entered more than once in a frame (the
+// bodies of each type, in between each other) is added up under its name and
+// depth. GPU times come from timestamp queries where the renderer has them,
+// so arrive a few frames late; until then, or without them, they're negative.
+class FrameTimings {
+public:
+	static const Uint32 MAX_FRAMES = 128;
+	static const Uint32 MAX_PASSES = 32; // different ones per frame, any more aren't timed
+	static const Uint32 MAX_SPANS = 128; // passes entered per frame, any more are only timed on the CPU
+	static const Uint32 MAX_DEPTH = 16;
+
+	// all the times a pass was entered in a frame
+	struct Pass {
+		const char *name;  // never copied, so a literal
+		Uint32 depth;
+		double cpuTime;    // ms
+		double gpuTime;    // negative unless every span of it was timed on the GPU
+		bool gpuMissing;   // a span that had no room or no queries
+	};
+
+	// one time a pass was entered
+	struct Span {
+		Uint32 pass;
+		double cpuStart;   // ms from the start of the frame
+		double cpuEnd;
+		double gpuStart;   // likewise, on the GPU
+		double gpuEnd;
+		Uint32 queries[2];
+	};
+
+	struct Frame {
+		Uint32 number;
+		Uint64 start;      // performance counter
+		double cpuTime;    // ms
+		double gpuTime;
+		Uint32 queries[2];
+		bool gpuPending;
+		Uint32 numPasses;
+		Pass passes[MAX_PASSES];
+		Uint32 numSpans;
+		Span spans[MAX_SPANS];
+	};
+
+	// average time a frame spends in a pass
+	struct Summary {
+		const char *name;
+		Uint32 depth;
+		double cpuTime;
+		double gpuTime;
+	};
+
+	FrameTimings(Renderer *r);
+
+	// call from SwapBuffers, ends one frame and starts the next
+	void NextFrame();
+
+	int BeginPass(const char *name);
+	void EndPass(int pass);
+
+	// completed frames, 0 being the last one
+	Uint32 GetNumFrames() const;
+	const Frame &GetFrame(Uint32 ago) const;
+
+	// over the last frames, in the order the passes were first seen. Passes
+	// run more than once a frame are added together
+	void GetSummary(Uint32 frames, std::vector<Summary> &passes, double &cpuFrameTime, double &gpuFrameTime) const;
+
+	// all the frames held, for chrome://tracing
+	void WriteChromeTrace(FILE *f) const;
+
+private:
+	void StartFrame();
+	void ResolveGPU(Frame &frame);
+	void FreeQueries(Frame &frame);
+	double Elapsed(const Frame &frame) const;
+
+	// a pass being timed, one for each depth
+	struct Open {
+		double cpuStart;
+		int span;          // negative if it got none
+	};
+
+	Renderer *m_renderer;
+	Frame m_frames[MAX_FRAMES];
+	Open m_open[MAX_DEPTH];
+	Uint32 m_current;
+	Uint32 m_frameCount;
+	Uint32 m_depth;
+	double m_msPerTick;
+};
+
+// times the rest of the scope as a pass of the current frame
+class ScopedTiming {
+public:
+	ScopedTiming(FrameTimings &timings, const char *name) : m_timings(timings), m_pass(timings.BeginPass(name)) {}
+	~ScopedTiming() { m_timings.EndPass(m_pass); }
+private:
+	ScopedTiming(const ScopedTiming&);
+	ScopedTiming &operator=(const ScopedTiming&);
+	FrameTimings &m_timings;
+	int m_pass;
+};
+
+}
+
+#define TIMING_SCOPED(renderer, name) \
+	PROFILE_SCOPED_RAW(name) \
+	Graphics::ScopedTiming PROFILE_LINENAME(timing)((renderer)->GetFrameTimings(), name);
+
+#endif
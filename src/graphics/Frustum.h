@@ -25,6 +25,9 @@ public:
 	// test if point (sphere) is in the frustum, ignoring the far plane
 	bool TestPointInfinite(const vector3d &p, double radius) const;
 
+	// the far plane is the last
+	const SPlane &GetPlane(int i) const { return m_planes[i]; }
+
 	// project a point onto the near plane (typically the screen)
 	bool ProjectPoint(const vector3d &in, vector3d &out) const;
 
@@ -31,6 +31,7 @@ namespace Graphics {
 		bool useAnisotropicFiltering;
 		bool enableDebugMessages;
 		bool gl3ForwardCompatible;
+		bool useProgramCache;
 		int vsync;
 		int requestedSamples;
 		int height;
@@ -60,4 +60,23 @@ bool operator==(const MaterialDescriptor &a, const MaterialDescriptor &b)
 	);
 }
 
+size_t MaterialDescriptorHash::operator()(const MaterialDescriptor &desc) const
+{
+	// the flags are packed so padding doesn't end up in the hash
+	const Uint32 flags =
+		Uint32(desc.alphaTest) |
+		Uint32(desc.glowMap) << 1 |
+		Uint32(desc.ambientMap) << 2 |
+		Uint32(desc.lighting) << 3 |
+		Uint32(desc.normalMap) << 4 |
+		Uint32(desc.specularMap) << 5 |
+		Uint32(desc.usePatterns) << 6 |
+		Uint32(desc.vertexColors) << 7 |
+		Uint32(desc.instanced) << 8;
+	const Uint32 words[] = {
+		Uint32(desc.effect), flags, Uint32(desc.textures), desc.dirLights, desc.quality, desc.numShadows
+	};
+	return lookup3_hashword(words, COUNTOF(words), 0);
+}
+
 }
@@ -50,7 +50,8 @@ enum MaterialQuality {
 	HAS_ATMOSPHERE		= 1 << 0,
 	HAS_ECLIPSES		= 1 << 1,
 	HAS_HEAT_GRADIENT   = 1 << 2,
-	HAS_DETAIL_MAPS		= 1 << 3
+	HAS_DETAIL_MAPS		= 1 << 3,
+	HAS_PATCH_BATCHING	= 1 << 4	// GeoSphere patches drawn from a GeoPatchPool
 };
 
 // Renderer creates a material that best matches these requirements.
@@ -76,6 +77,10 @@ public:
 	friend bool operator==(const MaterialDescriptor &a, const MaterialDescriptor &b);
 };
 
+struct MaterialDescriptorHash {
+	size_t operator()(const MaterialDescriptor &desc) const;
+};
+
 /*
  * A generic material with some generic parameters.
  */
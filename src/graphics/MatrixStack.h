@@ -0,0 +1,57 @@
+// Copyright © 2008-2018 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _GRAPHICS_MATRIXSTACK_H
+#define _GRAPHICS_MATRIXSTACK_H
+
+#include "libs.h"
+
+namespace Graphics {
+
+// A fixed depth stack of matrices for the renderer's model view and
+// projection, so pushing and popping never allocates. The top gets a new
+// serial number whenever it changes, so whatever is worked out from it can
+// tell when it needs doing again.
+class MatrixStack {
+public:
+	static const Uint32 MAX_DEPTH = 32;
+
+	MatrixStack() : m_depth(0), m_serial(1) { m_stack[0] = matrix4x4f::Identity(); }
+
+	const matrix4x4f &Top() const { return m_stack[m_depth]; }
+	Uint32 GetSerial() const { return m_serial; }
+
+	void Push() {
+		assert(m_depth + 1 < MAX_DEPTH);
+		m_stack[m_depth + 1] = m_stack[m_depth];
+		m_depth++;
+	}
+
+	void Pop() {
+		assert(m_depth > 0);
+		// most pushes are undone without anything having changed
+		const bool same = memcmp(&m_stack[m_depth], &m_stack[m_depth - 1], sizeof(matrix4x4f)) == 0;
+		m_depth--;
+		if (!same)
+			m_serial++;
+	}
+
+	void Load(const matrix4x4f &m) {
+		if (memcmp(&m, &m_stack[m_depth], sizeof(matrix4x4f)) != 0) {
+			m_stack[m_depth] = m;
+			m_serial++;
+		}
+	}
+
+	void Translate(float x, float y, float z) { m_stack[m_depth].Translate(x, y, z); m_serial++; }
+	void Scale(float x, float y, float z) { m_stack[m_depth].Scale(x, y, z); m_serial++; }
+
+private:
+	matrix4x4f m_stack[MAX_DEPTH];
+	Uint32 m_depth;
+	Uint32 m_serial;
+};
+
+}
+
+#endif
@@ -2,12 +2,15 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "Renderer.h"
+#include "RenderState.h"
 #include "Texture.h"
+#include <algorithm>
+#include <unordered_map>
 
 namespace Graphics {
 
 Renderer::Renderer(SDL_Window *window, int w, int h) :
-	m_width(w), m_height(h), m_ambient(Color::BLACK), m_window(window)
+	m_width(w), m_height(h), m_ambient(Color::BLACK), m_frameTimings(this), m_window(window), m_commandDepth(0)
 {
 }
 
@@ -45,6 +48,97 @@ void Renderer::RemoveAllCachedTextures()
 	m_textures.clear();
 }
 
+void Renderer::BeginCommands()
+{
+	++m_commandDepth;
+}
+
+void Renderer::EndCommands()
+{
+	assert(m_commandDepth > 0);
+	if (--m_commandDepth == 0)
+		FlushCommands();
+}
+
+bool Renderer::QueueBufferIndexed(VertexBuffer *vb, IndexBuffer *ib, RenderState *state, Material *mat, float depth, Uint32 pass, PrimitiveType type)
+{
+	if (!IsRecordingCommands())
+		return DrawBufferIndexed(vb, ib, state, mat, type);
+
+	DrawCommand cmd;
+	cmd.key = 0;
+	cmd.vertexBuffer = vb;
+	cmd.indexBuffer = ib;
+	cmd.state = state;
+	cmd.material = mat;
+	cmd.type = type;
+	cmd.pass = pass;
+	cmd.depth = depth;
+	cmd.modelView = GetCurrentModelView();
+	m_commands.push_back(cmd);
+	return true;
+}
+
+// sort key layout, most significant first:
+//  opaque:      pass:4 | 0:1 | program:11 | material:16 | depth:32
+//  translucent: pass:4 | 1:1 | ~depth:32 | program:11 | material:16
+static const Uint64 KEY_PASS_MAX = 0xf;
+static const Uint64 KEY_PROGRAM_MAX = 0x7ff;
+static const Uint64 KEY_MATERIAL_MAX = 0xffff;
+
+void Renderer::FlushCommands()
+{
+	PROFILE_SCOPED()
+	if (m_commands.empty())
+		return;
+
+	// number programs and materials in order of first use so they fit their bits
+	std::unordered_map<Uint32, Uint64> programIds;
+	std::unordered_map<const Material*, Uint64> materialIds;
+
+	m_commandOrder.clear();
+	m_commandOrder.reserve(m_commands.size());
+	for (Uint32 i = 0; i < m_commands.size(); i++) {
+		DrawCommand &cmd = m_commands[i];
+
+		const Uint64 newProgram = programIds.size();
+		const Uint64 program = std::min(programIds.insert(std::make_pair(GetProgramSortId(cmd.material), newProgram)).first->second, KEY_PROGRAM_MAX);
+		const Uint64 newMaterial = materialIds.size();
+		const Uint64 material = std::min(materialIds.insert(std::make_pair(cmd.material, newMaterial)).first->second, KEY_MATERIAL_MAX);
+
+		// non-negative floats order the same as their bits
+		const float depth = std::max(cmd.depth, 0.0f);
+		Uint32 depthBits;
+		memcpy(&depthBits, &depth, sizeof(depthBits));
+
+		Uint64 key = std::min(Uint64(cmd.pass), KEY_PASS_MAX) << 60;
+		if (cmd.state->GetDesc().blendMode != BLEND_SOLID)
+			key |= (Uint64(1) << 59) | (Uint64(~depthBits) << 27) | (program << 16) | material;
+		else
+			key |= (program << 48) | (material << 32) | depthBits;
+		cmd.key = key;
+
+		m_commandOrder.push_back(std::make_pair(key, i));
+	}
+	// the index breaks ties in recording order
+	std::sort(m_commandOrder.begin(), m_commandOrder.end());
+
+	MatrixTicket ticket(this, MatrixMode::MODELVIEW);
+	const DrawCommand *prev = nullptr;
+	for (const auto &it : m_commandOrder) {
+		const DrawCommand &cmd = m_commands[it.second];
+		SubmitCommand(cmd, prev);
+		prev = &cmd;
+	}
+	m_commands.clear();
+}
+
+void Renderer::SubmitCommand(const DrawCommand &cmd, const DrawCommand *prev)
+{
+	SetTransform(cmd.modelView);
+	DrawBufferIndexed(cmd.vertexBuffer, cmd.indexBuffer, cmd.state, cmd.material, cmd.type);
+}
+
 void Renderer::SetGrab(const bool grabbed)
 {
 	SDL_SetWindowGrab(m_window, SDL_bool(grabbed));
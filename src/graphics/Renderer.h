@@ -9,8 +9,10 @@
 #include "Types.h"
 #include "Light.h"
 #include "Stats.h"
+#include "FrameTimings.h"
 #include <map>
 #include <memory>
+#include <vector>
 
 namespace Graphics {
 
@@ -55,6 +57,12 @@ public:
 	virtual void CheckRenderErrors(const char *func = nullptr, const int line = -1) const {}
 
 	virtual bool SupportsInstancing() = 0;
+	// DrawBufferIndexedMulti
+	virtual bool SupportsMultiDraw() const { return false; }
+	// Texture::Reallocate and Texture::UpdateLevel, for TextureStreamer
+	virtual bool SupportsTextureStreaming() const { return false; }
+	// the compact vertex formats, see VertexBufferDesc
+	virtual bool SupportsCompactVertices() const { return false; }
 
 	SDL_Window *GetSDLWindow() const { return m_window; }
 	float GetDisplayAspect() const { return static_cast<float>(m_width) / static_cast<float>(m_height); }
@@ -117,6 +125,22 @@ public:
 	// instanced variations of the above
 	virtual bool DrawBufferInstanced(VertexBuffer*, RenderState*, Material*, InstanceBuffer*, PrimitiveType type=TRIANGLES) = 0;
 	virtual bool DrawBufferIndexedInstanced(VertexBuffer*, IndexBuffer*, RenderState*, Material*, InstanceBuffer*, PrimitiveType=TRIANGLES) = 0;
+	// draws the whole index buffer count times in one call, the indices of the
+	// i'th draw being offset by baseVertices[i]
+	virtual bool DrawBufferIndexedMulti(VertexBuffer*, IndexBuffer*, RenderState*, Material*, const Uint32 *baseVertices, Uint32 count, PrimitiveType=TRIANGLES) { return false; }
+
+	// Deferred drawing. Between BeginCommands and EndCommands, QueueBufferIndexed
+	// records draws instead of issuing them. The outermost EndCommands sorts them
+	// by pass, translucency, program, material and depth, then submits them
+	// skipping state the previous draw already set. Everything a queued draw uses
+	// (buffers, render state, material parameters, lights, projection) must stay
+	// as it is until then.
+	void BeginCommands();
+	void EndCommands();
+	bool IsRecordingCommands() const { return m_commandDepth > 0; }
+	// draws straight away when not recording. depth is the distance from the
+	// camera, opaque draws go front to back and translucent ones back to front
+	bool QueueBufferIndexed(VertexBuffer*, IndexBuffer*, RenderState*, Material*, float depth, Uint32 pass = 0, PrimitiveType type=TRIANGLES);
 
 	//creates a unique material based on the descriptor. It will not be deleted automatically.
 	virtual Material *CreateMaterial(const MaterialDescriptor &descriptor) = 0;
@@ -187,6 +211,14 @@ public:
 	virtual bool FrameGrab(ScreendumpState &sd) { return false;	}
 
 	Stats& GetStats() { return m_stats; }
+	FrameTimings& GetFrameTimings() { return m_frameTimings; }
+
+	// GPU timestamps for FrameTimings, written when the GPU gets to this point
+	// in the frame. Returns 0 where the renderer can't
+	virtual Uint32 QueryGPUTimestamp() { return 0; }
+	// in nanoseconds, false until the GPU has got there
+	virtual bool GetGPUTimestamp(Uint32 query, Uint64 &timestamp) { return false; }
+	virtual void FreeGPUTimestamp(Uint32 query) {}
 
 	void SetGrab(const bool grabbed);
 
@@ -196,12 +228,35 @@ protected:
 	Color m_ambient;
 	Light m_lights[4];
 	Stats m_stats;
+	FrameTimings m_frameTimings;
 	SDL_Window *m_window;
 
 	virtual void PushState() = 0;
 	virtual void PopState() = 0;
 
+	struct DrawCommand {
+		Uint64 key;
+		VertexBuffer *vertexBuffer;
+		IndexBuffer *indexBuffer;
+		RenderState *state;
+		Material *material;
+		PrimitiveType type;
+		Uint32 pass;
+		float depth;
+		matrix4x4f modelView;
+	};
+	// materials with the same id share a shader program
+	virtual Uint32 GetProgramSortId(const Material*) const { return 0; }
+	// prev is the command submitted just before this one, nullptr for the first
+	virtual void SubmitCommand(const DrawCommand &cmd, const DrawCommand *prev);
+
 private:
+	void FlushCommands();
+
+	Uint32 m_commandDepth;
+	std::vector<DrawCommand> m_commands;
+	std::vector<std::pair<Uint64, Uint32> > m_commandOrder;
+
 	typedef std::pair<std::string,std::string> TextureCacheKey;
 	typedef std::map<TextureCacheKey,RefCountedPtr<Texture>*> TextureCacheMap;
 	TextureCacheMap m_textures;
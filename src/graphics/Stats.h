@@ -19,10 +19,16 @@ public:
 		STAT_DRAWCALL = 0,
 		STAT_DRAWTRIS,
 		STAT_DRAWPOINTSPRITES,
+		STAT_STATE_CHANGES,    // render states applied
+		STAT_MATERIAL_APPLIES, // textures and uniforms set up for a draw
+		STAT_PROGRAM_BINDS,
 
 		// buffers
 		STAT_CREATE_BUFFER,
 		STAT_DESTROY_BUFFER,
+		STAT_TRANSIENT_BYTES, // vertices streamed by immediate mode draws
+		STAT_TEXTURE_UPLOAD_BYTES, // by TextureStreamer
+		STAT_TEXTURES_STREAMING,   // waiting to be decoded or uploaded
 
 		// objects
 		STAT_BUILDINGS,
@@ -63,6 +63,23 @@ public:
 
 	vector2f GetOriginalSize() const { return vector2f(dataSize.x * texSize.x, dataSize.y * texSize.y); }
 
+	// roughly what a texture like this takes up once uploaded
+	size_t GetApproxMemSize() const {
+		size_t bytes = size_t(dataSize.x) * size_t(dataSize.y);
+		switch (format) {
+			case TEXTURE_DXT1: bytes /= 2; break;
+			case TEXTURE_DXT5:
+			case TEXTURE_INTENSITY_8: break;
+			case TEXTURE_LUMINANCE_ALPHA_88: bytes *= 2; break;
+			default: bytes *= 4; break; // RGB is usually padded out too
+		}
+		if (generateMipmaps || numberOfMipMaps > 1)
+			bytes += bytes / 3;
+		if (type == TEXTURE_CUBE_MAP)
+			bytes *= 6;
+		return bytes;
+	}
+
 	const TextureFormat format;
 	const vector2f dataSize;
 	const vector2f texSize;
@@ -100,16 +117,29 @@ public:
 	virtual void BuildMipmaps() = 0;
 	virtual uint32_t GetTextureID() const = 0;
 
+	// For TextureStreamer, if the renderer supports it. Reallocate gives a
+	// placeholder texture its real size and numberOfMipMaps levels, which are
+	// then filled with UpdateLevel from the smallest up. The texture samples
+	// from the largest level filled so far.
+	virtual void Reallocate(const TextureDescriptor &descriptor) { assert(0); }
+	virtual void UpdateLevel(const void *data, size_t size, unsigned int level) { assert(0); }
+
 	virtual void Bind() = 0;
 	virtual void Unbind() = 0;
 
+	// whether it has been bound since the last call, for TextureResidency
+	bool TakeUsed() { const bool used = m_used; m_used = false; return used; }
+
 	virtual ~Texture() {}
 
 protected:
-	Texture(const TextureDescriptor &descriptor) : m_descriptor(descriptor) {}
+	Texture(const TextureDescriptor &descriptor) : m_descriptor(descriptor), m_used(true) {}
+	void SetDescriptor(const TextureDescriptor &descriptor) { m_descriptor = descriptor; }
+	void MarkUsed() { m_used = true; }
 
 private:
 	TextureDescriptor m_descriptor;
+	bool m_used;
 };
 
 }
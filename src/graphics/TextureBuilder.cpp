@@ -2,6 +2,8 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "TextureBuilder.h"
+#include "TextureStreamer.h"
+#include "TextureResidency.h"
 #include "FileSystem.h"
 #include "utils.h"
 #include <SDL_image.h>
@@ -14,14 +16,16 @@ namespace Graphics {
 
 //static
 SDL_mutex *TextureBuilder::m_textureLock = nullptr;
+TextureStreamer *TextureBuilder::s_streamer = nullptr;
+TextureResidency *TextureBuilder::s_residency = nullptr;
 
 TextureBuilder::TextureBuilder(const SDLSurfacePtr &surface, TextureSampleMode sampleMode, bool generateMipmaps, bool potExtend, bool forceRGBA, bool compressTextures, bool anisoFiltering) :
-    m_surface(surface), m_sampleMode(sampleMode), m_generateMipmaps(generateMipmaps), m_potExtend(potExtend), m_forceRGBA(forceRGBA), m_compressTextures(compressTextures), m_anisotropicFiltering(anisoFiltering), m_textureType(TEXTURE_2D), m_prepared(false)
+    m_surface(surface), m_sampleMode(sampleMode), m_generateMipmaps(generateMipmaps), m_potExtend(potExtend), m_forceRGBA(forceRGBA), m_compressTextures(compressTextures), m_anisotropicFiltering(anisoFiltering), m_textureType(TEXTURE_2D), m_streamed(false), m_prepared(false)
 {
 }
 
 TextureBuilder::TextureBuilder(const std::string &filename, TextureSampleMode sampleMode, bool generateMipmaps, bool potExtend, bool forceRGBA, bool compressTextures, bool anisoFiltering, TextureType textureType) :
-    m_filename(filename), m_sampleMode(sampleMode), m_generateMipmaps(generateMipmaps), m_potExtend(potExtend), m_forceRGBA(forceRGBA), m_compressTextures(compressTextures), m_anisotropicFiltering(anisoFiltering), m_textureType(textureType), m_prepared(false)
+    m_filename(filename), m_sampleMode(sampleMode), m_generateMipmaps(generateMipmaps), m_potExtend(potExtend), m_forceRGBA(forceRGBA), m_compressTextures(compressTextures), m_anisotropicFiltering(anisoFiltering), m_textureType(textureType), m_streamed(false), m_prepared(false)
 {
 }
 
@@ -34,6 +38,27 @@ void TextureBuilder::Init()
 	m_textureLock = SDL_CreateMutex();
 }
 
+Texture *TextureBuilder::GetOrCreateTexture(Renderer *r, const std::string &type)
+{
+	if(m_filename.empty()) {
+		return CreateTexture(r);
+	}
+	SDL_LockMutex(m_textureLock);
+	Texture *t = r->GetCachedTexture(type, m_filename);
+	if (t) { SDL_UnlockMutex(m_textureLock); return t; }
+	if (m_streamed && s_streamer && CanStream() && !m_prepared)
+		t = s_streamer->CreateTexture(*this);
+	else
+		t = CreateTexture(r);
+	r->AddCachedTexture(type, m_filename, t);
+	// only streamed textures are drawn through Bind, which is what brings an
+	// evicted one back. others (gas giant bake inputs) must stay as they are
+	if (s_residency && m_streamed && CanStream())
+		s_residency->Add(*this, t);
+	SDL_UnlockMutex(m_textureLock);
+	return t;
+}
+
 // RGBA and RGBpixel format for converting textures
 // XXX little-endian. if we ever have a port to a big-endian arch, invert shift and mask
 #if SDL_BYTEORDER != SDL_LIL_ENDIAN
@@ -9,11 +9,15 @@
 #include "Texture.h"
 #include "Renderer.h"
 #include "SDLWrappers.h"
+#include "Color.h"
 
 #include "PicoDDS/PicoDDS.h"
 
 namespace Graphics {
 
+class TextureStreamer;
+class TextureResidency;
+
 class TextureBuilder {
 public:
 	TextureBuilder(const SDLSurfacePtr &surface, TextureSampleMode sampleMode = LINEAR_CLAMP, bool generateMipmaps = false, bool potExtend = false, bool forceRGBA = true, bool compressTextures = true, bool anisoFiltering = true);
@@ -45,20 +49,22 @@ public:
 		return TextureBuilder(filename, LINEAR_CLAMP, true, true, false, true, false, TEXTURE_CUBE_MAP);
 	}
 
+	// load the file in the background if there is a streamer, the texture is
+	// drawn as the placeholder colour until its first mip levels arrive
+	TextureBuilder &Streamed(const Color &placeholder) {
+		m_streamed = true;
+		m_placeholder = placeholder;
+		return *this;
+	}
+
 	const TextureDescriptor &GetDescriptor() { PrepareSurface(); return m_descriptor; }
 
-	Texture *GetOrCreateTexture(Renderer *r, const std::string &type) {
-		if(m_filename.empty()) {
-			return CreateTexture(r);
-		}
-		SDL_LockMutex(m_textureLock);
-		Texture *t = r->GetCachedTexture(type, m_filename);
-		if (t) { SDL_UnlockMutex(m_textureLock); return t; }
-		t = CreateTexture(r);
-		r->AddCachedTexture(type, m_filename, t);
-		SDL_UnlockMutex(m_textureLock);
-		return t;
-	}
+	Texture *GetOrCreateTexture(Renderer *r, const std::string &type);
+
+	// used by Streamed() builders, or none to always load straight away
+	static void SetStreamer(TextureStreamer *streamer) { s_streamer = streamer; }
+	// told about cached textures that can be evicted and loaded again, or none
+	static void SetResidency(TextureResidency *residency) { s_residency = residency; }
 
 	//commonly used dummy textures
 	static Texture *GetWhiteTexture(Renderer *);
@@ -79,6 +85,9 @@ private:
 	bool m_anisotropicFiltering;
 	TextureType m_textureType;
 
+	bool m_streamed;
+	Color m_placeholder;
+
 	TextureDescriptor m_descriptor;
 
 	Texture *CreateTexture(Renderer *r) {
@@ -87,6 +96,8 @@ private:
 		return t;
 	}
 	void UpdateTexture(Texture *texture); // XXX pass src/dest rectangles
+	// TextureStreamer can load it straight into a plain 2D texture
+	bool CanStream() const { return m_textureType == TEXTURE_2D && !m_potExtend; }
 	void PrepareSurface();
 	bool m_prepared;
 
@@ -94,6 +105,11 @@ private:
 	void LoadDDS();
 
 	static SDL_mutex *m_textureLock;
+	static TextureStreamer *s_streamer;
+	static TextureResidency *s_residency;
+
+	friend class TextureStreamer;
+	friend class TextureResidency;
 };
 
 }
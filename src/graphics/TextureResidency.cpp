@@ -0,0 +1,131 @@
+// Copyright © 2008-2018 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "TextureResidency.h"
+#include "TextureStreamer.h"
+#include "utils.h"
+#include <algorithm>
+
+namespace Graphics {
+
+// textures used more recently than this are never evicted, so whatever is on
+// screen stays there even when it's all over budget
+static const Uint32 MIN_IDLE_FRAMES = 300;
+
+TextureResidency::TextureResidency(TextureStreamer *streamer, size_t budget) :
+	m_streamer(streamer),
+	m_budget(budget),
+	m_residentBytes(0),
+	m_frame(0),
+	m_numEvicted(0),
+	m_entriesLock(SDL_CreateMutex())
+{
+}
+
+TextureResidency::~TextureResidency()
+{
+	SDL_DestroyMutex(m_entriesLock);
+}
+
+void TextureResidency::Add(const TextureBuilder &builder, Texture *texture)
+{
+	assert(builder.m_streamed && builder.CanStream() && !builder.m_filename.empty());
+	SDL_LockMutex(m_entriesLock);
+	m_entries.push_back(Entry {
+		RefCountedPtr<Texture>(texture),
+		TextureBuilder(builder.m_filename, builder.m_sampleMode, builder.m_generateMipmaps, builder.m_potExtend,
+			builder.m_forceRGBA, builder.m_compressTextures, builder.m_anisotropicFiltering, builder.m_textureType),
+		m_frame,
+		false
+	});
+	// evicted textures show the builder's placeholder
+	m_entries.back().builder.Streamed(builder.m_placeholder);
+	SDL_UnlockMutex(m_entriesLock);
+}
+
+void TextureResidency::Evict(Entry &e)
+{
+	const TextureDescriptor &desc = e.texture->GetDescriptor();
+	const TextureDescriptor placeholderDesc(TEXTURE_RGBA_8888, vector2f(1.0f, 1.0f), desc.sampleMode,
+		false, false, desc.useAnisotropicFiltering, 0, TEXTURE_2D);
+	e.texture->Reallocate(placeholderDesc);
+	e.texture->UpdateLevel(&e.builder.m_placeholder, sizeof(Color), 0);
+	e.evicted = true;
+	m_numEvicted++;
+}
+
+void TextureResidency::EnforceBudget()
+{
+	PROFILE_SCOPED()
+	std::vector<Entry*> candidates;
+	for (Entry &e : m_entries) {
+		if (!e.evicted && e.lastUsed + MIN_IDLE_FRAMES <= m_frame && !m_streamer->IsStreaming(e.texture.Get()))
+			candidates.push_back(&e);
+	}
+	std::sort(candidates.begin(), candidates.end(), [](const Entry *a, const Entry *b) {
+		return a->lastUsed < b->lastUsed;
+	});
+
+	for (Entry *e : candidates) {
+		if (m_residentBytes <= m_budget)
+			break;
+		m_residentBytes -= e->texture->GetDescriptor().GetApproxMemSize();
+		Evict(*e);
+	}
+}
+
+void TextureResidency::Update()
+{
+	PROFILE_SCOPED()
+	SDL_LockMutex(m_entriesLock);
+	m_frame++;
+	m_residentBytes = 0;
+	for (auto it = m_entries.begin(); it != m_entries.end(); ) {
+		Entry &e = *it;
+		// only ours now, it's gone from the cache
+		if (e.texture->GetRefCount() == 1) {
+			it = m_entries.erase(it);
+			continue;
+		}
+
+		if (e.texture->TakeUsed()) {
+			e.lastUsed = m_frame;
+			if (e.evicted) {
+				m_streamer->Reload(e.texture.Get(), e.builder);
+				e.evicted = false;
+			}
+		}
+		if (!e.evicted)
+			m_residentBytes += e.texture->GetDescriptor().GetApproxMemSize();
+		++it;
+	}
+
+	if (m_residentBytes > m_budget)
+		EnforceBudget();
+	SDL_UnlockMutex(m_entriesLock);
+}
+
+void TextureResidency::LogTopConsumers(unsigned int count) const
+{
+	SDL_LockMutex(m_entriesLock);
+	std::vector<std::pair<size_t, const Entry*> > sizes;
+	for (const Entry &e : m_entries) {
+		if (!e.evicted)
+			sizes.push_back(std::make_pair(e.texture->GetDescriptor().GetApproxMemSize(), &e));
+	}
+	count = std::min<unsigned int>(count, sizes.size());
+	std::partial_sort(sizes.begin(), sizes.begin() + count, sizes.end(),
+		[](const std::pair<size_t, const Entry*> &a, const std::pair<size_t, const Entry*> &b) { return a.first > b.first; });
+
+	Output("Textures: %u KB resident of %u KB budget, %u tracked, %u evictions so far\n",
+		Uint32(m_residentBytes / 1024), Uint32(m_budget / 1024), Uint32(m_entries.size()), m_numEvicted);
+	for (unsigned int i = 0; i < count; i++) {
+		const Entry &e = *sizes[i].second;
+		const vector2f size = e.texture->GetDescriptor().dataSize;
+		Output("  %8u KB  %4dx%-4d  idle %5u frames  %s\n", Uint32(sizes[i].first / 1024),
+			int(size.x), int(size.y), m_frame - e.lastUsed, e.builder.m_filename.c_str());
+	}
+	SDL_UnlockMutex(m_entriesLock);
+}
+
+}
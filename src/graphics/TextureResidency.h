@@ -0,0 +1,64 @@
+// Copyright © 2008-2018 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _TEXTURERESIDENCY_H
+#define _TEXTURERESIDENCY_H
+
+#include "libs.h"
+#include "Texture.h"
+#include "TextureBuilder.h"
+
+#include <list>
+
+namespace Graphics {
+
+class TextureStreamer;
+
+// Keeps the streamed textures in the renderer's cache within a memory budget. Cached
+// textures are never deleted, as materials point straight at them, so the
+// least recently used ones are evicted by shrinking them to a single texel of
+// their placeholder colour. When one is bound again the streamer loads its
+// file back into the same texture.
+class TextureResidency {
+public:
+	TextureResidency(TextureStreamer *streamer, size_t budget);
+	~TextureResidency();
+
+	// a streamed texture just added to the cache, that the builder can load
+	// again. Safe from any thread, as textures are created in jobs too
+	void Add(const TextureBuilder &builder, Texture *texture);
+
+	// call once per frame from the main thread, after the streamer. Brings
+	// back evicted textures that were used, then evicts until under budget
+	void Update();
+
+	size_t GetResidentBytes() const { return m_residentBytes; }
+	size_t GetBudget() const { return m_budget; }
+	Uint32 GetNumEvicted() const { return m_numEvicted; }
+
+	// the biggest textures in memory, to the log
+	void LogTopConsumers(unsigned int count) const;
+
+private:
+	struct Entry {
+		RefCountedPtr<Texture> texture;
+		TextureBuilder builder; // unprepared, ready to load the file again
+		Uint32 lastUsed;        // frame
+		bool evicted;
+	};
+
+	void Evict(Entry &e);
+	void EnforceBudget();
+
+	TextureStreamer *m_streamer;
+	size_t m_budget;
+	size_t m_residentBytes;
+	Uint32 m_frame;
+	Uint32 m_numEvicted;
+	std::list<Entry> m_entries;
+	SDL_mutex *m_entriesLock;
+};
+
+}
+
+#endif
@@ -0,0 +1,201 @@
+// Copyright © 2008-2018 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "TextureStreamer.h"
+#include "TextureBuilder.h"
+#include "Renderer.h"
+#include "Stats.h"
+
+namespace Graphics {
+
+// levels this small go up along with the first one, whatever the budget
+static const size_t SMALL_LEVEL_SIZE = 16 * 1024;
+// compressed chains stop at this size, as they do in TextureGL
+static const unsigned int MIN_COMPRESSED_TEXTURE_DIMENSION = 16;
+
+// halves an 8 bit per channel image with a box filter
+static void downsample(const Uint8 *src, unsigned int w, unsigned int h, unsigned int bpp, Uint8 *dst)
+{
+	const unsigned int dw = std::max(w / 2, 1U);
+	const unsigned int dh = std::max(h / 2, 1U);
+	for (unsigned int y = 0; y < dh; y++) {
+		const Uint8 *row0 = src + std::min(2 * y, h - 1) * w * bpp;
+		const Uint8 *row1 = src + std::min(2 * y + 1, h - 1) * w * bpp;
+		for (unsigned int x = 0; x < dw; x++) {
+			const unsigned int x0 = std::min(2 * x, w - 1) * bpp;
+			const unsigned int x1 = std::min(2 * x + 1, w - 1) * bpp;
+			for (unsigned int c = 0; c < bpp; c++)
+				*dst++ = Uint8((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+		}
+	}
+}
+
+class TextureStreamer::DecodeJob : public Job {
+public:
+	DecodeJob(Request *req, const TextureBuilder &builder) : m_request(req), m_builder(builder), m_failed(false) {}
+
+	virtual void OnRun() override {
+		PROFILE_SCOPED()
+		// reads and converts the file
+		const TextureDescriptor &desc = m_builder.GetDescriptor();
+		if (!m_builder.m_prepared) {
+			m_failed = true;
+			return;
+		}
+
+		unsigned int w = desc.dataSize.x;
+		unsigned int h = desc.dataSize.y;
+		if (m_builder.m_surface) {
+			// tightly packed, with a chain of levels if they're wanted
+			const SDL_Surface *s = m_builder.m_surface.Get();
+			const unsigned int bpp = s->format->BytesPerPixel;
+			size_t total = 0;
+			for (unsigned int lw = w, lh = h; ; lw = std::max(lw / 2, 1U), lh = std::max(lh / 2, 1U)) {
+				m_levels.push_back({ total, size_t(lw) * lh * bpp });
+				total += m_levels.back().size;
+				if (!desc.generateMipmaps || (lw == 1 && lh == 1))
+					break;
+			}
+			m_data.resize(total);
+			for (unsigned int y = 0; y < h; y++)
+				memcpy(&m_data[y * w * bpp], static_cast<const Uint8*>(s->pixels) + y * s->pitch, w * bpp);
+			for (size_t i = 1; i < m_levels.size(); i++) {
+				downsample(&m_data[m_levels[i - 1].offset], w, h, bpp, &m_data[m_levels[i].offset]);
+				w = std::max(w / 2, 1U);
+				h = std::max(h / 2, 1U);
+			}
+		} else {
+			// already has its levels, one after the other
+			const PicoDDS::DDSImage &dds = m_builder.m_dds;
+			const size_t blockSize = (desc.format == TEXTURE_DXT1) ? 8 : 16;
+			size_t offset = 0;
+			for (unsigned int i = 0; i < unsigned(dds.imgdata_.numMipMaps); ++i) {
+				const size_t size = ((w + 3) / 4) * ((h + 3) / 4) * blockSize;
+				if (offset + size > size_t(dds.imgdata_.size))
+					break;
+				m_levels.push_back({ offset, size });
+				offset += size;
+				if (w <= MIN_COMPRESSED_TEXTURE_DIMENSION || h <= MIN_COMPRESSED_TEXTURE_DIMENSION)
+					break;
+				w /= 2;
+				h /= 2;
+			}
+			if (m_levels.empty()) {
+				m_failed = true;
+				return;
+			}
+			m_data.assign(dds.imgdata_.imgData, dds.imgdata_.imgData + offset);
+		}
+
+		m_descriptor = TextureDescriptor(desc.format, desc.dataSize, desc.texSize, desc.sampleMode,
+			desc.generateMipmaps, desc.allowCompression, desc.useAnisotropicFiltering, m_levels.size(), TEXTURE_2D);
+	}
+
+	virtual void OnFinish() override {
+		m_request->decoded = true;
+		m_request->failed = m_failed;
+		if (m_failed)
+			return;
+		m_request->descriptor = m_descriptor;
+		m_request->data.swap(m_data);
+		m_request->levels.swap(m_levels);
+		m_request->nextLevel = int(m_request->levels.size()) - 1;
+	}
+
+private:
+	Request *m_request;
+	TextureBuilder m_builder;
+	bool m_failed;
+	TextureDescriptor m_descriptor;
+	std::vector<Uint8> m_data;
+	std::vector<Level> m_levels;
+};
+
+TextureStreamer::TextureStreamer(Renderer *r, JobQueue *queue, Uint32 uploadBudget) :
+	m_renderer(r),
+	m_queue(queue),
+	m_uploadBudget(uploadBudget)
+{
+	assert(r->SupportsTextureStreaming());
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	// the job handles cancel anything still being decoded
+	m_pending.clear();
+}
+
+Texture *TextureStreamer::CreateTexture(const TextureBuilder &builder)
+{
+	PROFILE_SCOPED()
+	const TextureDescriptor placeholderDesc(TEXTURE_RGBA_8888, vector2f(1.0f, 1.0f), builder.m_sampleMode,
+		false, false, builder.m_anisotropicFiltering, 0, TEXTURE_2D);
+	Texture *t = m_renderer->CreateTexture(placeholderDesc);
+	t->Update(&builder.m_placeholder, vector2f(1.0f, 1.0f), TEXTURE_RGBA_8888);
+	Reload(t, builder);
+	return t;
+}
+
+void TextureStreamer::Reload(Texture *texture, const TextureBuilder &builder)
+{
+	assert(!IsStreaming(texture));
+	m_pending.push_back(Request());
+	Request &req = m_pending.back();
+	req.texture.Reset(texture);
+	req.decoded = false;
+	req.failed = false;
+	req.allocated = false;
+	req.nextLevel = -1;
+	req.job = m_queue->Queue(new DecodeJob(&req, builder));
+}
+
+bool TextureStreamer::IsStreaming(const Texture *texture) const
+{
+	for (const Request &req : m_pending)
+		if (req.texture.Get() == texture)
+			return true;
+	return false;
+}
+
+void TextureStreamer::Upload(Request &req, Uint32 &uploaded)
+{
+	while (req.nextLevel >= 0) {
+		const Level &level = req.levels[req.nextLevel];
+		// always make some progress, even with a level bigger than the budget
+		if (level.size > SMALL_LEVEL_SIZE && uploaded > 0 && uploaded + level.size > m_uploadBudget)
+			break;
+		// only once the smallest level can go straight in, so the texture
+		// always has something to sample
+		if (!req.allocated) {
+			req.texture->Reallocate(req.descriptor);
+			req.allocated = true;
+		}
+		req.texture->UpdateLevel(&req.data[level.offset], level.size, req.nextLevel);
+		uploaded += level.size;
+		req.nextLevel--;
+	}
+}
+
+void TextureStreamer::Update()
+{
+	PROFILE_SCOPED()
+	Uint32 uploaded = 0;
+	for (auto it = m_pending.begin(); it != m_pending.end(); ) {
+		if (!it->decoded || (uploaded >= m_uploadBudget && !it->failed)) {
+			++it;
+			continue;
+		}
+		if (!it->failed)
+			Upload(*it, uploaded);
+		if (it->failed || it->nextLevel < 0)
+			it = m_pending.erase(it);
+		else
+			++it;
+	}
+
+	Stats &stats = m_renderer->GetStats();
+	stats.AddToStatCount(Stats::STAT_TEXTURE_UPLOAD_BYTES, uploaded);
+	stats.AddToStatCount(Stats::STAT_TEXTURES_STREAMING, m_pending.size());
+}
+
+}
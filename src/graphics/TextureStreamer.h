@@ -0,0 +1,72 @@
+// Copyright © 2008-2018 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _TEXTURESTREAMER_H
+#define _TEXTURESTREAMER_H
+
+#include "libs.h"
+#include "JobQueue.h"
+#include "Texture.h"
+
+#include <list>
+
+namespace Graphics {
+
+class Renderer;
+class TextureBuilder;
+
+// Loads the textures of Streamed() TextureBuilders in the background. Files
+// are read, decoded and converted (with a mip chain built for formats that
+// have none) on the job queue, then uploaded a mip level at a time, smallest
+// first, within a per-frame budget. Until its first levels are uploaded the
+// texture is a single texel of the builder's placeholder colour.
+class TextureStreamer {
+public:
+	TextureStreamer(Renderer *r, JobQueue *queue, Uint32 uploadBudget);
+	~TextureStreamer();
+
+	// a placeholder that will turn into the builder's texture
+	Texture *CreateTexture(const TextureBuilder &builder);
+
+	// loads the builder's file into an existing texture, which keeps drawing
+	// as it is now until the first levels arrive
+	void Reload(Texture *texture, const TextureBuilder &builder);
+	bool IsStreaming(const Texture *texture) const;
+
+	// call once per frame from the main thread, uploads what fits in the budget
+	void Update();
+
+	Uint32 GetNumPending() const { return m_pending.size(); }
+
+private:
+	struct Level {
+		size_t offset;
+		size_t size;
+	};
+
+	// a texture being streamed in, from request to last upload
+	struct Request {
+		RefCountedPtr<Texture> texture;
+		Job::Handle job;
+		bool decoded;
+		bool failed;
+		bool allocated;
+		TextureDescriptor descriptor;
+		std::vector<Uint8> data;
+		std::vector<Level> levels; // largest first
+		int nextLevel;             // next one to upload, counting down
+	};
+
+	class DecodeJob;
+
+	void Upload(Request &req, Uint32 &uploaded);
+
+	Renderer *m_renderer;
+	JobQueue *m_queue;
+	Uint32 m_uploadBudget;
+	std::list<Request> m_pending;
+};
+
+}
+
+#endif
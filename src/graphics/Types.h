@@ -27,7 +27,11 @@ enum VertexAttribFormat {
 	ATTRIB_FORMAT_FLOAT2,
 	ATTRIB_FORMAT_FLOAT3,
 	ATTRIB_FORMAT_FLOAT4,
-	ATTRIB_FORMAT_UBYTE4
+	ATTRIB_FORMAT_UBYTE4,
+	ATTRIB_FORMAT_HALF2,    //16 bit floats
+	ATTRIB_FORMAT_HALF4,
+	ATTRIB_FORMAT_SHORT2N,  //16 bit integers read as -1..1
+	ATTRIB_FORMAT_USHORT4N  //16 bit integers read as 0..1
 };
 
 enum BufferUsage {
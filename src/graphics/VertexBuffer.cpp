@@ -15,7 +15,12 @@ Uint32 VertexBufferDesc::GetAttribSize(VertexAttribFormat f)
 	case ATTRIB_FORMAT_FLOAT4:
 		return 16;
 	case ATTRIB_FORMAT_UBYTE4:
+	case ATTRIB_FORMAT_HALF2:
+	case ATTRIB_FORMAT_SHORT2N:
 		return 4;
+	case ATTRIB_FORMAT_HALF4:
+	case ATTRIB_FORMAT_USHORT4N:
+		return 8;
 	default:
 		return 0;
 	}
@@ -25,6 +30,8 @@ VertexBufferDesc::VertexBufferDesc()
 	: numVertices(0)
 	, stride(0)
 	, usage(BUFFER_USAGE_STATIC)
+	, positionScale(1.0f)
+	, positionOffset(0.0f)
 {
 	for (Uint32 i = 0; i < MAX_ATTRIBS; i++) {
 		attrib[i].semantic = ATTRIB_NONE;
@@ -49,6 +56,24 @@ Uint32 VertexBufferDesc::GetOffset(VertexAttrib attr) const
 	return 0;
 }
 
+VertexAttribFormat VertexBufferDesc::GetFormat(VertexAttrib attr) const
+{
+	for (Uint32 i = 0; i < MAX_ATTRIBS; i++) {
+		if (attrib[i].semantic == attr)
+			return attrib[i].format;
+	}
+	return ATTRIB_FORMAT_NONE;
+}
+
+bool VertexBufferDesc::IsCompact() const
+{
+	for (Uint32 i = 0; i < MAX_ATTRIBS && attrib[i].semantic != ATTRIB_NONE; i++) {
+		if (attrib[i].format >= ATTRIB_FORMAT_HALF2)
+			return true;
+	}
+	return false;
+}
+
 Uint32 VertexBufferDesc::CalculateOffset(const VertexBufferDesc &desc, VertexAttrib attr)
 {
 	Uint32 offs = 0;
@@ -63,6 +88,195 @@ Uint32 VertexBufferDesc::CalculateOffset(const VertexBufferDesc &desc, VertexAtt
 	return 0;
 }
 
+// IEEE half floats, rounded to nearest. Values too small for a half
+// become zero and ones too big infinity
+static Uint16 FloatToHalf(float f)
+{
+	Uint32 x;
+	memcpy(&x, &f, sizeof(x));
+	const Uint16 sign = (x >> 16) & 0x8000;
+	const Sint32 exponent = Sint32((x >> 23) & 0xff) - 127 + 15;
+	Uint32 mantissa = x & 0x7fffff;
+	if (exponent >= 31)
+		return sign | (((x & 0x7fffffff) > 0x7f800000) ? 0x7e00 : 0x7c00);
+	if (exponent <= 0) {
+		if (exponent < -10)
+			return sign;
+		mantissa |= 0x800000;
+		const Uint32 shift = 14 - exponent;
+		return sign | Uint16((mantissa + (1u << (shift - 1))) >> shift);
+	}
+	// a carry out of the mantissa correctly bumps the exponent
+	return sign | Uint16(((Uint32(exponent) << 10) | (mantissa >> 13)) + ((mantissa >> 12) & 1));
+}
+
+static float HalfToFloat(Uint16 h)
+{
+	const Uint32 sign = Uint32(h & 0x8000) << 16;
+	const Uint32 exponent = (h >> 10) & 0x1f;
+	const Uint32 mantissa = h & 0x3ff;
+	float f;
+	if (exponent == 0) {
+		f = std::ldexp(float(mantissa), -24);
+		return sign ? -f : f;
+	}
+	const Uint32 x = sign | ((exponent == 31 ? 0xff : exponent - 15 + 127) << 23) | (mantissa << 13);
+	memcpy(&f, &x, sizeof(f));
+	return f;
+}
+
+static Sint16 FloatToSnorm16(float f)
+{
+	return Sint16(std::floor(Clamp(f, -1.0f, 1.0f) * 32767.0f + 0.5f));
+}
+
+static Uint16 FloatToUnorm16(float f)
+{
+	return Uint16(std::floor(Clamp(f, 0.0f, 1.0f) * 65535.0f + 0.5f));
+}
+
+// unit vector to a point in -1..1 on an octahedron folded out flat
+static vector2f OctEncode(const vector3f &n)
+{
+	const float l1 = fabs(n.x) + fabs(n.y) + fabs(n.z);
+	if (l1 <= 0.0f)
+		return vector2f(0.0f);
+	vector2f e(n.x / l1, n.y / l1);
+	if (n.z < 0.0f) {
+		e = vector2f((1.0f - fabs(e.y)) * (e.x >= 0.0f ? 1.0f : -1.0f),
+			(1.0f - fabs(e.x)) * (e.y >= 0.0f ? 1.0f : -1.0f));
+	}
+	return e;
+}
+
+static vector3f OctDecode(float x, float y)
+{
+	vector3f n(x, y, 1.0f - fabs(x) - fabs(y));
+	if (n.z < 0.0f) {
+		n.x = (1.0f - fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		n.y = (1.0f - fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+	}
+	return n.NormalizedSafe();
+}
+
+static bool IsOctEncoded(const VertexAttribDesc &attr)
+{
+	return attr.format == ATTRIB_FORMAT_SHORT2N && (attr.semantic == ATTRIB_NORMAL || attr.semantic == ATTRIB_TANGENT);
+}
+
+static bool IsRelativePosition(const VertexAttribDesc &attr)
+{
+	return attr.semantic == ATTRIB_POSITION && attr.format >= ATTRIB_FORMAT_HALF2;
+}
+
+// an attribute as the shader sees it, before any decoding
+static void ReadAttrib(VertexAttribFormat format, const Uint8 *in, float out[4])
+{
+	out[0] = out[1] = out[2] = 0.0f;
+	out[3] = 1.0f;
+	switch (format) {
+	case ATTRIB_FORMAT_FLOAT2:
+	case ATTRIB_FORMAT_FLOAT3:
+	case ATTRIB_FORMAT_FLOAT4:
+		memcpy(out, in, VertexBufferDesc::GetAttribSize(format));
+		break;
+	case ATTRIB_FORMAT_UBYTE4:
+		for (int i = 0; i < 4; i++) out[i] = in[i] / 255.0f;
+		break;
+	case ATTRIB_FORMAT_HALF2:
+	case ATTRIB_FORMAT_HALF4: {
+		const Uint16 *h = reinterpret_cast<const Uint16*>(in);
+		for (Uint32 i = 0; i < VertexBufferDesc::GetAttribSize(format) / 2; i++) out[i] = HalfToFloat(h[i]);
+		break;
+	}
+	case ATTRIB_FORMAT_SHORT2N: {
+		const Sint16 *s = reinterpret_cast<const Sint16*>(in);
+		for (int i = 0; i < 2; i++) out[i] = std::max(s[i] / 32767.0f, -1.0f);
+		break;
+	}
+	case ATTRIB_FORMAT_USHORT4N: {
+		const Uint16 *s = reinterpret_cast<const Uint16*>(in);
+		for (int i = 0; i < 4; i++) out[i] = s[i] / 65535.0f;
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+static void WriteAttrib(VertexAttribFormat format, const float in[4], Uint8 *out)
+{
+	switch (format) {
+	case ATTRIB_FORMAT_FLOAT2:
+	case ATTRIB_FORMAT_FLOAT3:
+	case ATTRIB_FORMAT_FLOAT4:
+		memcpy(out, in, VertexBufferDesc::GetAttribSize(format));
+		break;
+	case ATTRIB_FORMAT_UBYTE4:
+		for (int i = 0; i < 4; i++) out[i] = Uint8(Clamp(in[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+		break;
+	case ATTRIB_FORMAT_HALF2:
+	case ATTRIB_FORMAT_HALF4: {
+		Uint16 h[4];
+		for (Uint32 i = 0; i < VertexBufferDesc::GetAttribSize(format) / 2; i++) h[i] = FloatToHalf(in[i]);
+		memcpy(out, h, VertexBufferDesc::GetAttribSize(format));
+		break;
+	}
+	case ATTRIB_FORMAT_SHORT2N: {
+		const Sint16 s[2] = { FloatToSnorm16(in[0]), FloatToSnorm16(in[1]) };
+		memcpy(out, s, sizeof(s));
+		break;
+	}
+	case ATTRIB_FORMAT_USHORT4N: {
+		const Uint16 s[4] = { FloatToUnorm16(in[0]), FloatToUnorm16(in[1]), FloatToUnorm16(in[2]), FloatToUnorm16(in[3]) };
+		memcpy(out, s, sizeof(s));
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+void ConvertVertices(const VertexBufferDesc &fromDesc, const Uint8 *from, const VertexBufferDesc &toDesc, Uint8 *to, Uint32 numVertices)
+{
+	PROFILE_SCOPED()
+	const vector3f fromScale = fromDesc.positionScale;
+	const vector3f toScale(
+		toDesc.positionScale.x != 0.0f ? 1.0f / toDesc.positionScale.x : 0.0f,
+		toDesc.positionScale.y != 0.0f ? 1.0f / toDesc.positionScale.y : 0.0f,
+		toDesc.positionScale.z != 0.0f ? 1.0f / toDesc.positionScale.z : 0.0f);
+
+	for (Uint32 a = 0; a < MAX_ATTRIBS && toDesc.attrib[a].semantic != ATTRIB_NONE; a++) {
+		const VertexAttribDesc &out = toDesc.attrib[a];
+		const VertexAttribDesc *in = nullptr;
+		for (Uint32 b = 0; b < MAX_ATTRIBS && fromDesc.attrib[b].semantic != ATTRIB_NONE; b++) {
+			if (fromDesc.attrib[b].semantic == out.semantic)
+				in = &fromDesc.attrib[b];
+		}
+
+		for (Uint32 v = 0; v < numVertices; v++) {
+			float value[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+			if (in) {
+				ReadAttrib(in->format, from + v * fromDesc.stride + in->offset, value);
+				if (IsOctEncoded(*in)) {
+					const vector3f n = OctDecode(value[0], value[1]);
+					value[0] = n.x; value[1] = n.y; value[2] = n.z;
+				} else if (IsRelativePosition(*in)) {
+					for (int i = 0; i < 3; i++) value[i] = value[i] * fromScale[i] + fromDesc.positionOffset[i];
+				}
+			}
+			if (IsOctEncoded(out)) {
+				const vector2f e = OctEncode(vector3f(value[0], value[1], value[2]));
+				value[0] = e.x; value[1] = e.y;
+			} else if (IsRelativePosition(out)) {
+				for (int i = 0; i < 3; i++) value[i] = (value[i] - toDesc.positionOffset[i]) * toScale[i];
+				value[3] = 1.0f;
+			}
+			WriteAttrib(out.format, value, to + v * toDesc.stride + out.offset);
+		}
+	}
+}
+
 VertexBuffer::~VertexBuffer()
 {
 }
@@ -17,6 +17,13 @@
  * especially with static buffers.
  *
  * Expansion possibilities: range-based Map
+ *
+ * Compact formats: positions in a half or normalised format
+ * are relative to the mesh, and are scaled by positionScale and
+ * moved by positionOffset when drawn. Normals and tangents in
+ * ATTRIB_FORMAT_SHORT2N are octahedron encoded. Only renderers
+ * that SupportsCompactVertices decode them, and only for
+ * materials with shaders that do (MultiMaterial).
  */
 #include "libs.h"
 #include "Types.h"
@@ -43,6 +50,11 @@ struct VertexBufferDesc {
 	//byte offset of an existing attribute
 	Uint32 GetOffset(VertexAttrib) const;
 
+	//format of an existing attribute
+	VertexAttribFormat GetFormat(VertexAttrib) const;
+	//uses any of the compact formats
+	bool IsCompact() const;
+
 	//used internally for calculating offsets
 	static Uint32 CalculateOffset(const VertexBufferDesc&, VertexAttrib);
 	static Uint32 GetAttribSize(VertexAttribFormat);
@@ -54,8 +66,15 @@ struct VertexBufferDesc {
 	//automatically calculated for created buffers
 	Uint32 stride;
 	BufferUsage usage;
+	//see above, identity unless positions are compact
+	vector3f positionScale;
+	vector3f positionOffset;
 };
 
+// copies vertices from one layout to another with the same attributes,
+// converting their formats. Attributes missing from the source are zeroed
+void ConvertVertices(const VertexBufferDesc &fromDesc, const Uint8 *from, const VertexBufferDesc &toDesc, Uint8 *to, Uint32 numVertices);
+
 class Mappable : public RefCounted {
 public:
 	virtual ~Mappable() { }
@@ -94,6 +113,8 @@ public:
 
 	// change the buffer data without mapping
 	virtual void BufferData(const size_t, void*) = 0;
+	// change part of the buffer (offset and size in bytes) without mapping
+	virtual void BufferSubData(const size_t offset, const size_t size, const void*) = 0;
 
 	virtual void Bind() = 0;
 	virtual void Release() = 0;
@@ -112,6 +133,8 @@ public:
 
 	// change the buffer data without mapping
 	virtual void BufferData(const size_t, void*) = 0;
+	// change part of the buffer (offset and size in bytes) without mapping
+	virtual void BufferSubData(const size_t offset, const size_t size, const void*) = 0;
 
 	Uint32 GetIndexCount() const { return m_indexCount; }
 	void SetIndexCount(Uint32);
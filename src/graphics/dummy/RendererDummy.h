@@ -27,12 +27,14 @@ public:
 	virtual const char *GetName() const override final { return "Dummy"; }
 	virtual RendererType GetRendererType() const  override final { return RENDERER_DUMMY; }
 	virtual bool SupportsInstancing() override final { return false; }
+	// so modelcompiler writes them
+	virtual bool SupportsCompactVertices() const override final { return true; }
 	virtual int GetMaximumNumberAASamples() const override final { return 0; }
 	virtual bool GetNearFarRange(float &near_, float &far_) const override final { return true; }
 
 	virtual bool BeginFrame() override final { return true; }
 	virtual bool EndFrame() override final { return true; }
-	virtual bool SwapBuffers() override final { return true; }
+	virtual bool SwapBuffers() override final { m_frameTimings.NextFrame(); return true; }
 
 	virtual bool SetRenderState(RenderState*) override final { return true; }
 	virtual bool SetRenderTarget(RenderTarget*) override final { return true; }
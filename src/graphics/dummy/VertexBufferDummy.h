@@ -21,6 +21,7 @@ public:
 
 	// change the buffer data without mapping
 	virtual void BufferData(const size_t, void*) override final {}
+	virtual void BufferSubData(const size_t offset, const size_t size, const void *data) override final { memcpy(m_buffer.get() + offset, data, size); }
 
 	virtual void Bind() override final {}
 	virtual void Release() override final {}
@@ -44,6 +45,7 @@ public:
 	virtual void Unmap() override final {}
 
 	virtual void BufferData(const size_t, void*) override final {}
+	virtual void BufferSubData(const size_t offset, const size_t size, const void *data) override final { memcpy(reinterpret_cast<Uint8*>(m_buffer.get()) + offset, data, size); }
 
 	virtual void Bind() override final {}
 	virtual void Release() override final {}
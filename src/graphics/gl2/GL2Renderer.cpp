@@ -429,6 +429,7 @@ bool RendererGL2::SwapBuffers()
 	CheckRenderErrors(__FUNCTION__,__LINE__);
 
 	SDL_GL_SwapWindow(m_window);
+	m_frameTimings.NextFrame();
 	return true;
 }
 
@@ -324,6 +324,17 @@ void VertexBuffer::BufferData(const size_t size, void *data)
 	}
 }
 
+void VertexBuffer::BufferSubData(const size_t offset, const size_t size, const void *data)
+{
+	assert(m_mapMode == BUFFER_MAP_NONE); //must not be currently mapped
+	assert(offset + size <= m_desc.numVertices * m_desc.stride);
+	if (m_data)
+		memcpy(m_data + offset, data, size);
+	glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 void VertexBuffer::Bind() {
 	glBindVertexArray(m_vao);
 
@@ -432,6 +443,17 @@ void IndexBuffer::BufferData(const size_t size, void *data)
 	}
 }
 
+void IndexBuffer::BufferSubData(const size_t offset, const size_t size, const void *data)
+{
+	assert(m_mapMode == BUFFER_MAP_NONE); //must not be currently mapped
+	assert(offset + size <= sizeof(Uint32) * m_size);
+	if (m_data)
+		memcpy(reinterpret_cast<Uint8*>(m_data) + offset, data, size);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_buffer);
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
 void IndexBuffer::Bind() {
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_buffer);
 }
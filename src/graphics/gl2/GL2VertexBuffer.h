@@ -28,6 +28,7 @@ public:
 
 	// change the buffer data without mapping
 	virtual void BufferData(const size_t, void*) override final;
+	virtual void BufferSubData(const size_t offset, const size_t size, const void*) override final;
 
 	virtual void Bind() override final;
 	virtual void Release() override final;
@@ -50,6 +51,7 @@ public:
 
 	// change the buffer data without mapping
 	virtual void BufferData(const size_t, void*) override final;
+	virtual void BufferSubData(const size_t offset, const size_t size, const void*) override final;
 
 	virtual void Bind() override final;
 	virtual void Release() override final;
@@ -64,7 +64,7 @@ Program *GasGiantSurfaceMaterial::CreateProgram(const MaterialDescriptor &desc)
 	if (desc.quality & HAS_ECLIPSES)
 		ss << "#define ECLIPSE\n";
 
-	ss << stringf("#define NUM_SHADOWS %0{u}\n", m_curNumShadows);
+	ss << stringf("#define NUM_SHADOWS %0{u}\n", desc.numShadows);
 
 	return new Graphics::OGL::GasGiantProgram("gassphere_base", ss.str());
 }
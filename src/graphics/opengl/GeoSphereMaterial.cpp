@@ -35,6 +35,9 @@ void GeoSphereProgram::InitUniforms()
 	detailScaleHi.Init("detailScaleHi", m_program);
 	detailScaleLo.Init("detailScaleLo", m_program);
 
+	patchData.Init("patchData", m_program);
+	patchVertices.Init("patchVertices", m_program);
+
 	shadowCentreX.Init("shadowCentreX", m_program);
 	shadowCentreY.Init("shadowCentreY", m_program);
 	shadowCentreZ.Init("shadowCentreZ", m_program);
@@ -43,12 +46,20 @@ void GeoSphereProgram::InitUniforms()
 	sdivlrad.Init("sdivlrad", m_program);
 }
 
-GeoSphereSurfaceMaterial::GeoSphereSurfaceMaterial() : m_curNumShadows(0)
+GeoSphereSurfaceMaterial::GeoSphereSurfaceMaterial() : m_curNumShadows(0), m_patchBuffer(0), m_patchTexture(0)
 {
 	for(int i=0;i<4;i++)
 		m_programs[i] = nullptr;
 }
 
+GeoSphereSurfaceMaterial::~GeoSphereSurfaceMaterial()
+{
+	if (m_patchBuffer) {
+		glDeleteTextures(1, &m_patchTexture);
+		glDeleteBuffers(1, &m_patchBuffer);
+	}
+}
+
 Program *GeoSphereSurfaceMaterial::CreateProgram(const MaterialDescriptor &desc)
 {
 	assert((desc.effect == EFFECT_GEOSPHERE_TERRAIN) ||
@@ -71,8 +82,10 @@ Program *GeoSphereSurfaceMaterial::CreateProgram(const MaterialDescriptor &desc)
 		ss << "#define ECLIPSE\n";
 	if (desc.quality & HAS_DETAIL_MAPS)
 		ss << "#define DETAIL_MAPS\n";
+	if (desc.quality & HAS_PATCH_BATCHING)
+		ss << "#define PATCH_BATCHING\n";
 
-	ss << stringf("#define NUM_SHADOWS %0{u}\n", m_curNumShadows);
+	ss << stringf("#define NUM_SHADOWS %0{u}\n", desc.numShadows);
 
 	return new Graphics::OGL::GeoSphereProgram("geosphere_terrain", ss.str());
 }
@@ -121,12 +134,17 @@ void GeoSphereSurfaceMaterial::SetGSUniforms()
 		p->texture0.Set(this->texture0, 0);
 		p->texture1.Set(this->texture1, 1);
 
-		const float fDetailFrequency = pow(2.0f, float(params.maxPatchDepth) - float(params.patchDepth));
+		// batched patches bring their own frequency, see GeoPatchPool
+		const float fDetailFrequency = (m_descriptor.quality & HAS_PATCH_BATCHING) ? 1.0f :
+			pow(2.0f, float(params.maxPatchDepth) - float(params.patchDepth));
 
 		p->detailScaleHi.Set(hiScale * fDetailFrequency);
 		p->detailScaleLo.Set(loScale * fDetailFrequency);
 	}
 
+	if (m_descriptor.quality & HAS_PATCH_BATCHING)
+		SetPatchData();
+
 	//Light uniform parameters
 	for( Uint32 i=0 ; i<m_renderer->GetNumLights() ; i++ ) {
 		const Light& Light = m_renderer->GetLight(i);
@@ -163,6 +181,36 @@ void GeoSphereSurfaceMaterial::SetGSUniforms()
 	p->sdivlrad.Set(sdivlrad);
 }
 
+// after the two detail textures
+static const int PATCH_DATA_UNIT = 2;
+
+void GeoSphereSurfaceMaterial::SetPatchData()
+{
+	const GeoSphere::MaterialParameters &params = *static_cast<GeoSphere::MaterialParameters*>(this->specialParameter0);
+	if (!params.patchData)
+		return;
+
+	if (!m_patchBuffer) {
+		glGenBuffers(1, &m_patchBuffer);
+		glGenTextures(1, &m_patchTexture);
+		glBindTexture(GL_TEXTURE_BUFFER, m_patchTexture);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_patchBuffer);
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
+	}
+
+	glBindBuffer(GL_TEXTURE_BUFFER, m_patchBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, params.numPatchData * 4 * sizeof(float), params.patchData, GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	glActiveTexture(GL_TEXTURE0 + PATCH_DATA_UNIT);
+	glBindTexture(GL_TEXTURE_BUFFER, m_patchTexture);
+	glActiveTexture(GL_TEXTURE0);
+
+	GeoSphereProgram *p = static_cast<GeoSphereProgram*>(m_program);
+	p->patchData.Set(PATCH_DATA_UNIT);
+	p->patchVertices.Set(int(params.patchVertices));
+}
+
 void GeoSphereSurfaceMaterial::SwitchShadowVariant()
 {
 	const GeoSphere::MaterialParameters params = *static_cast<GeoSphere::MaterialParameters*>(this->specialParameter0);
@@ -196,7 +244,7 @@ Program *GeoSphereSkyMaterial::CreateProgram(const MaterialDescriptor &desc)
 	if (desc.quality & HAS_ECLIPSES)
 		ss << "#define ECLIPSE\n";
 
-	ss << stringf("#define NUM_SHADOWS %0{u}\n", m_curNumShadows);
+	ss << stringf("#define NUM_SHADOWS %0{u}\n", desc.numShadows);
 
 	return new Graphics::OGL::GeoSphereProgram("geosphere_sky", ss.str());
 }
@@ -28,6 +28,9 @@ namespace Graphics {
 			Uniform detailScaleHi;
 			Uniform detailScaleLo;
 
+			Uniform patchData;
+			Uniform patchVertices;
+
 			Uniform shadowCentreX;
 			Uniform shadowCentreY;
 			Uniform shadowCentreZ;
@@ -42,6 +45,7 @@ namespace Graphics {
 		class GeoSphereSurfaceMaterial : public Material {
 		public:
 			GeoSphereSurfaceMaterial();
+			virtual ~GeoSphereSurfaceMaterial();
 			virtual Program *CreateProgram(const MaterialDescriptor &) override;
 			virtual void SetProgram(Program *p) override;
 			virtual void Apply() override;
@@ -52,8 +56,12 @@ namespace Graphics {
 			// We actually have multiple programs at work here, one compiled for each of the number of shadows.
 			// They are chosen/created based on what the current parameters passed in by the specialParameter0 are.
 			void SwitchShadowVariant();
+			void SetPatchData();
 			Program* m_programs[4];	// 0 to 3 shadows
 			Uint32 m_curNumShadows;
+			// texture buffer with the data of batched patches
+			GLuint m_patchBuffer;
+			GLuint m_patchTexture;
 		};
 
 		class GeoSphereSkyMaterial : public GeoSphereSurfaceMaterial {
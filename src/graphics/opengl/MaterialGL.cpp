@@ -23,17 +23,53 @@ bool Material::IsProgramLoaded() const
 	return m_program->Loaded();
 }
 
-void Material::SetCommonUniforms(const matrix4x4f& mv, const matrix4x4f& proj)
+void TransformState::Update(const matrix4x4f &mv, const matrix4x4f &proj)
 {
-	const matrix4x4f ViewProjection = proj * mv;
+	modelView = mv;
+	projection = proj;
+	viewProjection = proj * mv;
+	viewInverse = mv.Inverse();
 	const matrix3x3f orient(mv.GetOrient());
-	const matrix3x3f NormalMatrix(orient.Inverse());
+	normal = orient.Inverse();
+}
+
+void Material::SetCommonUniforms(const matrix4x4f& mv, const matrix4x4f& proj)
+{
+	TransformState ts;
+	ts.Update(mv, proj);
+	SetTransformUniforms(ts);
+}
 
-	m_program->uProjectionMatrix.Set( proj );
-	m_program->uViewMatrix.Set( mv );
-	m_program->uViewMatrixInverse.Set( mv.Inverse() );
-	m_program->uViewProjectionMatrix.Set( ViewProjection );
-	m_program->uNormalMatrix.Set( NormalMatrix );
+void Material::SetTransformUniforms(const TransformState &ts)
+{
+	// uniforms belong to the program, so they are still set from the last
+	// material that used it with the same transforms
+	if (ts.serial != 0 && m_program->transformSerial == ts.serial)
+		return;
+	m_program->transformSerial = ts.serial;
+
+	m_program->uProjectionMatrix.Set( ts.projection );
+	m_program->uViewMatrix.Set( ts.modelView );
+	m_program->uViewMatrixInverse.Set( ts.viewInverse );
+	m_program->uViewProjectionMatrix.Set( ts.viewProjection );
+	m_program->uNormalMatrix.Set( ts.normal );
+	CHECKERRORS();
+}
+
+void Material::SetVertexFormatUniforms(const VertexBufferDesc &desc)
+{
+	Program *p = m_program;
+	if (!p->uPositionScale.IsValid())
+		return;
+	const int octNormals = desc.GetFormat(ATTRIB_NORMAL) == ATTRIB_FORMAT_SHORT2N ? 1 : 0;
+	if (p->octNormals == octNormals && p->positionScale == desc.positionScale && p->positionOffset == desc.positionOffset)
+		return;
+	p->octNormals = octNormals;
+	p->positionScale = desc.positionScale;
+	p->positionOffset = desc.positionOffset;
+	p->uPositionScale.Set(desc.positionScale);
+	p->uPositionOffset.Set(desc.positionOffset);
+	p->uOctNormals.Set(octNormals);
 	CHECKERRORS();
 }
 
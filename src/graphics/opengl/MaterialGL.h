@@ -14,6 +14,7 @@
  */
 #include "OpenGLLibs.h"
 #include "graphics/Material.h"
+#include "graphics/VertexBuffer.h"
 
 namespace Graphics {
 
@@ -23,6 +24,21 @@ namespace Graphics {
 
 		class Program;
 
+		// The matrices every program takes, worked out by the renderer once
+		// for each change of model view or projection and then shared by all
+		// the materials drawn with them
+		struct TransformState {
+			TransformState() : serial(0) {}
+			void Update(const matrix4x4f &mv, const matrix4x4f &proj);
+
+			Uint32 serial; // 0 for one that isn't shared
+			matrix4x4f modelView;
+			matrix4x4f projection;
+			matrix4x4f viewProjection;
+			matrix4x4f viewInverse;
+			matrix3x3f normal;
+		};
+
 		class Material : public Graphics::Material {
 		public:
 			Material() { }
@@ -34,6 +50,10 @@ namespace Graphics {
 			virtual bool IsProgramLoaded() const override final;
 			virtual void SetProgram(Program *p) { m_program = p; }
 			virtual void SetCommonUniforms(const matrix4x4f& mv, const matrix4x4f& proj) override;
+			// skips the upload if the program already has these
+			void SetTransformUniforms(const TransformState &ts);
+			// how to decode the vertices of the buffer drawn, for programs that can
+			void SetVertexFormatUniforms(const VertexBufferDesc &desc);
 
 		protected:
 			friend class Graphics::RendererOGL;
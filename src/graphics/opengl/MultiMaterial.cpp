@@ -65,7 +65,7 @@ Program *MultiMaterial::CreateProgram(const MaterialDescriptor &desc)
 
 Program *LitMultiMaterial::CreateProgram(const MaterialDescriptor &desc)
 {
-	m_curNumLights = m_renderer->m_numDirLights;
+	m_curNumLights = desc.dirLights;
 	return new MultiProgram(desc, m_curNumLights);
 }
 
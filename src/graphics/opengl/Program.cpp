@@ -19,6 +19,28 @@ namespace OGL {
 // #version 330 for OpenGL3.3
 static const char *s_glslVersion = "#version 140\n";
 GLuint Program::s_curProgram = 0;
+Uint32 Program::s_numBinds = 0;
+bool Program::s_binaryCache = false;
+Uint32 Program::s_numCached = 0;
+Uint32 Program::s_numCompiled = 0;
+
+// linked program binaries, named after the hash of their source
+static const char BINARY_CACHE_DIR[] = "shaders/cache";
+// bump this to throw away everything in the cache
+static const Uint32 BINARY_CACHE_VERSION = 1;
+static const char BINARY_CACHE_MAGIC[4] = { 'P', 'G', 'P', 'B' };
+
+// the binaries are only good for the driver that produced them
+static Uint32 s_driverHash[2] = { 0, 0 };
+
+struct BinaryCacheHeader {
+	char magic[4];
+	Uint32 version;
+	Uint32 driverHash[2];
+	Uint32 sourceHash[2];
+	Uint32 format;
+	Uint32 size;
+};
 
 // Check and warn about compile & link errors
 static bool check_glsl_errors(const char *filename, GLuint obj)
@@ -76,6 +98,9 @@ static bool check_glsl_errors(const char *filename, GLuint obj)
 
 struct Shader {
 	Shader(GLenum type, const std::string &filename, const std::string &defines)
+	: shader(0)
+	, m_type(type)
+	, m_filename(filename)
 	{
 		RefCountedPtr<FileSystem::FileData> filecode = FileSystem::gameDataFiles.ReadFile(filename);
 
@@ -121,14 +146,15 @@ struct Shader {
 		const StringRange code(strCode.c_str(), strCode.size());
 
 		// Build the final shader text to be compiled
-		AppendSource(s_glslVersion);
-		AppendSource(defines.c_str());
+		source = s_glslVersion;
+		source += defines;
 		if (type == GL_VERTEX_SHADER) {
-			AppendSource("#define VERTEX_SHADER\n");
+			source += "#define VERTEX_SHADER\n";
 		} else {
-			AppendSource("#define FRAGMENT_SHADER\n");
+			source += "#define FRAGMENT_SHADER\n";
 		}
-		AppendSource(code.StripUTF8BOM());
+		const StringRange body = code.StripUTF8BOM();
+		source.append(body.begin, body.Size());
 #if 0
 		static bool s_bDumpShaderSource = true;
 		if (s_bDumpShaderSource) {
@@ -140,63 +166,100 @@ struct Shader {
 			FILE *tmp = fopen(outFilename.c_str(), "wb");
 			if(tmp) {
 				Output("%s", filename);
-				for( Uint32 i=0; i<blocks.size(); i++ ) {
-					const char *block = blocks[i];
-					const GLint sizes = block_sizes[i];
-					if(block && sizes>0) {
-						fprintf(tmp, "%.*s", sizes, block);
-					}
-				}
+				fwrite(source.data(), 1, source.size(), tmp);
 				fclose(tmp);
 			} else {
 				Output("Could not open file %s", outFilename.c_str());
 			}
 		}
 #endif
-		shader = glCreateShader(type);
+	};
+
+	~Shader() {
+		glDeleteShader(shader);
+	}
+
+	// not needed when the linked program comes from the binary cache
+	void Compile()
+	{
+		shader = glCreateShader(m_type);
 		if(glIsShader(shader)!=GL_TRUE)
 			throw ShaderException();
 
-		Compile(shader);
+		const GLchar *str = source.c_str();
+		const GLint length = source.size();
+		glShaderSource(shader, 1, &str, &length);
+		glCompileShader(shader);
 
 		// CheckGLSL may use OS::Warning instead of Error so the game may still (attempt to) run
-		if (!check_glsl_errors(filename.c_str(), shader))
+		if (!check_glsl_errors(m_filename.c_str(), shader))
 			throw ShaderException();
-	};
-
-	~Shader() {
-		glDeleteShader(shader);
 	}
 
 	GLuint shader;
+	std::string source;
 
 private:
-	void AppendSource(const char *str)
-	{
-		blocks.push_back(str);
-		block_sizes.push_back(std::strlen(str));
+	GLenum m_type;
+	std::string m_filename;
+	std::set<std::string> previousIncludes;
+};
+
+static std::string binary_cache_path(const Uint32 sourceHash[2])
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%08x%08x.bin", sourceHash[0], sourceHash[1]);
+	return FileSystem::JoinPathBelow(BINARY_CACHE_DIR, name);
+}
+
+void Program::InitBinaryCache(bool enable)
+{
+	s_binaryCache = false;
+	if (!enable)
+		return;
+
+	if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary) {
+		Output("Program binary cache: not supported by the driver\n");
+		return;
 	}
 
-	void AppendSource(StringRange str)
-	{
-		blocks.push_back(str.begin);
-		block_sizes.push_back(str.Size());
+	// drivers may support the extension but not save anything
+	GLint numFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+	if (numFormats <= 0) {
+		Output("Program binary cache: the driver has no binary formats\n");
+		return;
 	}
 
-	void Compile(GLuint shader_id)
-	{
-		assert(blocks.size() == block_sizes.size());
-		glShaderSource(shader_id, blocks.size(), &blocks[0], &block_sizes[0]);
-		glCompileShader(shader_id);
+	if (!FileSystem::userFiles.MakeDirectory(BINARY_CACHE_DIR)) {
+		Output("Program binary cache: could not create %s\n", BINARY_CACHE_DIR);
+		return;
 	}
 
-	std::vector<const char*> blocks;
-	std::vector<GLint> block_sizes;
-	std::set<std::string> previousIncludes;
-};
+	std::string driver(reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+	driver += "\n";
+	driver += reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+	driver += "\n";
+	driver += reinterpret_cast<const char*>(glGetString(GL_VERSION));
+	s_driverHash[0] = s_driverHash[1] = BINARY_CACHE_VERSION;
+	lookup3_hashlittle2(driver.data(), driver.size(), &s_driverHash[0], &s_driverHash[1]);
+
+	s_binaryCache = true;
+}
+
+void Program::TakeLoadCounts(Uint32 &cached, Uint32 &compiled)
+{
+	cached = s_numCached;
+	compiled = s_numCompiled;
+	s_numCached = s_numCompiled = 0;
+}
 
 Program::Program()
-: m_name("")
+: transformSerial(0)
+, positionScale(0.0f)
+, positionOffset(0.0f)
+, octNormals(-1)
+, m_name("")
 , m_defines("")
 , m_program(0)
 , success(false)
@@ -204,7 +267,11 @@ Program::Program()
 }
 
 Program::Program(const std::string &name, const std::string &defines)
-: m_name(name)
+: transformSerial(0)
+, positionScale(0.0f)
+, positionOffset(0.0f)
+, octNormals(-1)
+, m_name(name)
 , m_defines(defines)
 , m_program(0)
 , success(false)
@@ -224,12 +291,16 @@ void Program::Reload()
 	glDeleteProgram(m_program);
 	LoadShaders(m_name, m_defines);
 	InitUniforms();
+	transformSerial = 0;
+	octNormals = -1;
 }
 
 void Program::Use()
 {
-	if (s_curProgram != m_program)
+	if (s_curProgram != m_program) {
 		glUseProgram(m_program);
+		s_numBinds++;
+	}
 	s_curProgram = m_program;
 }
 
@@ -245,15 +316,32 @@ void Program::LoadShaders(const std::string &name, const std::string &defines)
 	PROFILE_SCOPED()
 	const std::string filename = std::string("shaders/opengl/") + name;
 
-	//load, create and compile shaders
+	//load shaders
 	Shader vs(GL_VERTEX_SHADER, filename + ".vert", defines);
 	Shader fs(GL_FRAGMENT_SHADER, filename + ".frag", defines);
 
-	//create program, attach shaders and link
 	m_program = glCreateProgram();
 	if(glIsProgram(m_program)!=GL_TRUE)
 		throw ProgramException();
 
+	// the cache is keyed by the full text of both stages, so edited shaders
+	// (and changed includes or defines) miss it by themselves
+	Uint32 sourceHash[2] = { 0, 0 };
+	if (s_binaryCache) {
+		lookup3_hashlittle2(vs.source.data(), vs.source.size(), &sourceHash[0], &sourceHash[1]);
+		lookup3_hashlittle2(fs.source.data(), fs.source.size(), &sourceHash[0], &sourceHash[1]);
+		if (LoadBinary(sourceHash)) {
+			success = true;
+			s_numCached++;
+			return;
+		}
+	}
+
+	//compile shaders, attach them and link
+	vs.Compile();
+	fs.Compile();
+	s_numCompiled++;
+
 	glAttachShader(m_program, vs.shader);
 
 	glAttachShader(m_program, fs.shader);
@@ -271,13 +359,80 @@ void Program::LoadShaders(const std::string &name, const std::string &defines)
 
 	glBindFragDataLocation(m_program, 0, "frag_color");
 
+	if (s_binaryCache)
+		glProgramParameteri(m_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
 	glLinkProgram(m_program);
 
 	success = check_glsl_errors(name.c_str(), m_program);
 
+	if (success && s_binaryCache)
+		SaveBinary(sourceHash);
+
 	//shaders may now be deleted by Shader destructor
 }
 
+bool Program::LoadBinary(const Uint32 sourceHash[2])
+{
+	PROFILE_SCOPED()
+	RefCountedPtr<FileSystem::FileData> file = FileSystem::userFiles.ReadFile(binary_cache_path(sourceHash));
+	if (!file.Valid() || file->GetSize() < sizeof(BinaryCacheHeader))
+		return false;
+
+	BinaryCacheHeader header;
+	memcpy(&header, file->GetData(), sizeof(header));
+	if (memcmp(header.magic, BINARY_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+		header.version != BINARY_CACHE_VERSION ||
+		header.driverHash[0] != s_driverHash[0] || header.driverHash[1] != s_driverHash[1] ||
+		header.sourceHash[0] != sourceHash[0] || header.sourceHash[1] != sourceHash[1] ||
+		header.size != file->GetSize() - sizeof(header))
+		return false;
+
+	// the binary includes the attribute and frag data bindings
+	glProgramBinary(m_program, header.format, file->GetData() + sizeof(header), header.size);
+
+	// drivers are allowed to reject binaries for any reason, in which case the
+	// program is left unlinked and gets built from source as usual
+	GLint status = GL_FALSE;
+	glGetProgramiv(m_program, GL_LINK_STATUS, &status);
+	return status == GL_TRUE;
+}
+
+void Program::SaveBinary(const Uint32 sourceHash[2])
+{
+	PROFILE_SCOPED()
+	GLint length = 0;
+	glGetProgramiv(m_program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(m_program, length, &length, &format, &binary[0]);
+
+	BinaryCacheHeader header;
+	memcpy(header.magic, BINARY_CACHE_MAGIC, sizeof(header.magic));
+	header.version = BINARY_CACHE_VERSION;
+	header.driverHash[0] = s_driverHash[0];
+	header.driverHash[1] = s_driverHash[1];
+	header.sourceHash[0] = sourceHash[0];
+	header.sourceHash[1] = sourceHash[1];
+	header.format = format;
+	header.size = length;
+
+	const std::string path = binary_cache_path(sourceHash);
+	FILE *f = FileSystem::userFiles.OpenWriteStream(path);
+	if (!f) {
+		Output("Program binary cache: could not write %s\n", path.c_str());
+		return;
+	}
+	const bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+		fwrite(&binary[0], length, 1, f) == 1;
+	fclose(f);
+	if (!ok)
+		Output("Program binary cache: could not write %s\n", path.c_str());
+}
+
 void Program::InitUniforms()
 {
 	PROFILE_SCOPED()
@@ -287,6 +442,9 @@ void Program::InitUniforms()
 	uViewMatrixInverse.Init("uViewMatrixInverse", m_program);
 	uViewProjectionMatrix.Init("uViewProjectionMatrix", m_program);
 	uNormalMatrix.Init("uNormalMatrix", m_program);
+	uPositionScale.Init("uPositionScale", m_program);
+	uPositionOffset.Init("uPositionOffset", m_program);
+	uOctNormals.Init("uOctNormals", m_program);
 
 	//Light uniform parameters
 	char cLight[64];
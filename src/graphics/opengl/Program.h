@@ -29,6 +29,18 @@ namespace Graphics {
 			virtual void Use();
 			virtual void Unuse();
 			bool Loaded() const { return success; }
+			GLuint GetName() const { return m_program; }
+
+			// number of glUseProgram calls since the last call
+			static Uint32 TakeBindCount() { const Uint32 n = s_numBinds; s_numBinds = 0; return n; }
+
+			// Linked programs are saved to the user dir when the driver can hand
+			// them back (ARB_get_program_binary), so that later runs (and
+			// reloads of unchanged shaders) can skip compiling and linking
+			static void InitBinaryCache(bool enable);
+			static bool IsBinaryCacheEnabled() { return s_binaryCache; }
+			// programs loaded from the cache and compiled from source since the last call
+			static void TakeLoadCounts(Uint32 &cached, Uint32 &compiled);
 
 			// Uniforms.
 			Uniform uProjectionMatrix;
@@ -37,6 +49,11 @@ namespace Graphics {
 			Uniform uViewProjectionMatrix;
 			Uniform uNormalMatrix;
 
+			// compact vertices, see VertexBufferDesc
+			Uniform uPositionScale;
+			Uniform uPositionOffset;
+			Uniform uOctNormals;
+
 			Uniform invLogZfarPlus1;
 			Uniform diffuse;
 			Uniform emission;
@@ -64,10 +81,23 @@ namespace Graphics {
 			};
 			UniformLight lights[4];
 
+			// the TransformState the matrix uniforms were last set from, 0 if unknown
+			Uint32 transformSerial;
+			// what the vertex format uniforms were last set to
+			vector3f positionScale;
+			vector3f positionOffset;
+			int octNormals;
+
 		protected:
 			static GLuint s_curProgram;
+			static Uint32 s_numBinds;
+			static bool s_binaryCache;
+			static Uint32 s_numCached;
+			static Uint32 s_numCompiled;
 
 			void LoadShaders(const std::string&, const std::string &defines);
+			bool LoadBinary(const Uint32 sourceHash[2]);
+			void SaveBinary(const Uint32 sourceHash[2]);
 			virtual void InitUniforms();
 			std::string m_name;
 			std::string m_defines;
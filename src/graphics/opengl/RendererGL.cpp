@@ -5,8 +5,10 @@
 #include "graphics/Graphics.h"
 #include "graphics/Light.h"
 #include "graphics/Material.h"
+#include "FileSystem.h"
 #include "OS.h"
 #include "StringF.h"
+#include "StringRange.h"
 #include "graphics/Texture.h"
 #include "graphics/TextureBuilder.h"
 #include "TextureGL.h"
@@ -19,6 +21,7 @@
 #include "RenderStateGL.h"
 #include "RenderTargetGL.h"
 #include "VertexBufferGL.h"
+#include "VertexRingGL.h"
 #include "MultiMaterial.h"
 #include "Program.h"
 #include "RingMaterial.h"
@@ -139,10 +142,16 @@ void RendererOGL::RegisterRenderer() {
 
 // static member instantiations
 bool RendererOGL::initted = false;
-RendererOGL::AttribBufferMap RendererOGL::s_AttribBufferMap;
 
-// typedefs
-typedef std::vector<std::pair<MaterialDescriptor, OGL::Program*> >::const_iterator ProgramIterator;
+// starting size of each frame's part of the transient vertex ring, it grows if needed
+static const Uint32 VERTEX_RING_FRAME_SIZE = 1024 * 1024;
+
+// descriptors of every program built so far, so later runs can prewarm them
+static const char PROGRAM_LIST_FILE[] = "shaders/cache/programs.txt";
+static const char PROGRAM_LIST_HEADER[] = "# program list 1";
+// new programs come in bursts (a new planet, a new ship), so the list is written
+// at most this often, and once more at shutdown
+static const Uint32 PROGRAM_LIST_SAVE_INTERVAL = 10000; // ms
 
 // ----------------------------------------------------------------------------
 RendererOGL::RendererOGL(SDL_Window *window, const Graphics::Settings &vs, SDL_GLContext &glContext)
@@ -155,10 +164,17 @@ RendererOGL::RendererOGL(SDL_Window *window, const Graphics::Settings &vs, SDL_G
 , m_minZNear(0.001f)
 , m_maxZFar(100000000.0f)
 , m_useCompressedTextures(false)
+, m_useMultiDraw(false)
+, m_useTimerQueries(false)
+, m_prewarmingPrograms(false)
+, m_programListDirty(false)
+, m_programListSaved(0)
 , m_invLogZfarPlus1(0.f)
 , m_activeRenderTarget(0)
 , m_activeRenderState(nullptr)
 , m_matrixMode(MatrixMode::MODELVIEW)
+, m_transformsModelViewSerial(0)
+, m_transformsProjectionSerial(0)
 , m_glContext(glContext)
 {
 	glewExperimental = true;
@@ -208,6 +224,9 @@ RendererOGL::RendererOGL(SDL_Window *window, const Graphics::Settings &vs, SDL_G
 	const bool useAnisotropicFiltering = vs.useAnisotropicFiltering;
 	m_useAnisotropicFiltering = useAnisotropicFiltering;
 
+	m_useMultiDraw = GLEW_VERSION_3_2 || GLEW_ARB_draw_elements_base_vertex;
+	m_useTimerQueries = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+
 	//XXX bunch of fixed function states here!
 	glCullFace(GL_BACK);
 	glFrontFace(GL_CCW);
@@ -226,15 +245,17 @@ RendererOGL::RendererOGL(SDL_Window *window, const Graphics::Settings &vs, SDL_G
 
 	SetMatrixMode(MatrixMode::MODELVIEW);
 
-	m_modelViewStack.push(matrix4x4f::Identity());
-	m_projectionStack.push(matrix4x4f::Identity());
-
 	SetClearColor(Color4f(0.f, 0.f, 0.f, 0.f));
 	SetViewport(0, 0, m_width, m_height);
 
 	if (vs.enableDebugMessages)
 		GLDebug::Enable();
 
+	m_vertexRing.reset(new OGL::VertexRing(VERTEX_RING_FRAME_SIZE));
+
+	OGL::Program::InitBinaryCache(vs.useProgramCache);
+	PrewarmPrograms();
+
 	// check enum PrimitiveType matches OpenGL values
 	assert(POINTS == GL_POINTS);
 	assert(LINE_SINGLE == GL_LINES);
@@ -252,6 +273,14 @@ RendererOGL::~RendererOGL()
 	for (auto state : m_renderStates)
 		delete state.second;
 
+	if (m_programListDirty)
+		SaveProgramList();
+
+	m_vertexRing.reset();
+	OGL::TextureGL::FreeUploadBuffer();
+	if (!m_timerQueries.empty())
+		glDeleteQueries(m_timerQueries.size(), &m_timerQueries[0]);
+
 	SDL_GL_DeleteContext(m_glContext);
 }
 
@@ -482,15 +511,58 @@ bool RendererOGL::SwapBuffers()
 	CheckRenderErrors(__FUNCTION__,__LINE__);
 
 	SDL_GL_SwapWindow(m_window);
+	m_vertexRing->NextFrame();
+	m_stats.AddToStatCount(Stats::STAT_PROGRAM_BINDS, OGL::Program::TakeBindCount());
 	m_stats.NextFrame();
+	m_frameTimings.NextFrame();
+
+	if (m_programListDirty && SDL_GetTicks() - m_programListSaved >= PROGRAM_LIST_SAVE_INTERVAL)
+		SaveProgramList();
+	return true;
+}
+
+Uint32 RendererOGL::QueryGPUTimestamp()
+{
+	if (!m_useTimerQueries)
+		return 0;
+	GLuint query;
+	if (m_freeTimerQueries.empty()) {
+		glGenQueries(1, &query);
+		m_timerQueries.push_back(query);
+	} else {
+		query = m_freeTimerQueries.back();
+		m_freeTimerQueries.pop_back();
+	}
+	glQueryCounter(query, GL_TIMESTAMP);
+	return query;
+}
+
+bool RendererOGL::GetGPUTimestamp(Uint32 query, Uint64 &timestamp)
+{
+	if (!query)
+		return false;
+	GLint available = 0;
+	glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+		return false;
+	GLuint64 result;
+	glGetQueryObjectui64v(query, GL_QUERY_RESULT, &result);
+	timestamp = result;
 	return true;
 }
 
+void RendererOGL::FreeGPUTimestamp(Uint32 query)
+{
+	assert(query);
+	m_freeTimerQueries.push_back(query);
+}
+
 bool RendererOGL::SetRenderState(RenderState *rs)
 {
 	if (m_activeRenderState != rs) {
 		static_cast<OGL::RenderState*>(rs)->Apply();
 		m_activeRenderState = rs;
+		m_stats.AddToStatCount(Stats::STAT_STATE_CHANGES, 1);
 	}
 	CheckRenderErrors(__FUNCTION__,__LINE__);
 	return true;
@@ -659,9 +731,18 @@ bool RendererOGL::SetScissor(bool enabled, const vector2f &pos, const vector2f &
 	return true;
 }
 
-void RendererOGL::SetMaterialShaderTransforms(Material *m)
+void RendererOGL::SetMaterialShaderTransforms(Material *m, const VertexBufferDesc &vbDesc)
 {
-	m->SetCommonUniforms(m_modelViewStack.top(), m_projectionStack.top());
+	// only work the matrices out again when the stacks have changed, most
+	// draws share them with the one before
+	if (m_transformsModelViewSerial != m_modelViewStack.GetSerial() || m_transformsProjectionSerial != m_projectionStack.GetSerial()) {
+		m_transforms.Update(m_modelViewStack.Top(), m_projectionStack.Top());
+		m_transforms.serial++;
+		m_transformsModelViewSerial = m_modelViewStack.GetSerial();
+		m_transformsProjectionSerial = m_projectionStack.GetSerial();
+	}
+	static_cast<OGL::Material*>(m)->SetTransformUniforms(m_transforms);
+	static_cast<OGL::Material*>(m)->SetVertexFormatUniforms(vbDesc);
 	CheckRenderErrors(__FUNCTION__,__LINE__);
 }
 
@@ -670,59 +751,43 @@ bool RendererOGL::DrawTriangles(const VertexArray *v, RenderState *rs, Material
 	PROFILE_SCOPED()
 	if (!v || v->position.size() < 3) return false;
 
-	const AttributeSet attribs = v->GetAttributeSet();
-	RefCountedPtr<VertexBuffer> drawVB;
-
-	// see if we have a buffer to re-use
-	AttribBufferIter iter = s_AttribBufferMap.find(std::make_pair(attribs, v->position.size()));
-	if (iter == s_AttribBufferMap.end()) {
-		// not found a buffer so create a new one
-		VertexBufferDesc vbd;
-		Uint32 attribIdx = 0;
-		assert(v->HasAttrib(ATTRIB_POSITION));
-		vbd.attrib[attribIdx].semantic = ATTRIB_POSITION;
+	VertexBufferDesc vbd;
+	Uint32 attribIdx = 0;
+	assert(v->HasAttrib(ATTRIB_POSITION));
+	vbd.attrib[attribIdx].semantic = ATTRIB_POSITION;
+	vbd.attrib[attribIdx].format = ATTRIB_FORMAT_FLOAT3;
+	++attribIdx;
+
+	if (v->HasAttrib(ATTRIB_NORMAL)) {
+		vbd.attrib[attribIdx].semantic = ATTRIB_NORMAL;
 		vbd.attrib[attribIdx].format = ATTRIB_FORMAT_FLOAT3;
 		++attribIdx;
-
-		if (v->HasAttrib(ATTRIB_NORMAL)) {
-			vbd.attrib[attribIdx].semantic = ATTRIB_NORMAL;
-			vbd.attrib[attribIdx].format = ATTRIB_FORMAT_FLOAT3;
-			++attribIdx;
-		}
-		if (v->HasAttrib(ATTRIB_DIFFUSE)) {
-			vbd.attrib[attribIdx].semantic = ATTRIB_DIFFUSE;
-			vbd.attrib[attribIdx].format = ATTRIB_FORMAT_UBYTE4;
-			++attribIdx;
-		}
-		if (v->HasAttrib(ATTRIB_UV0)) {
-			vbd.attrib[attribIdx].semantic = ATTRIB_UV0;
-			vbd.attrib[attribIdx].format = ATTRIB_FORMAT_FLOAT2;
-			++attribIdx;
-		}
-		if (v->HasAttrib(ATTRIB_TANGENT)) {
-			vbd.attrib[attribIdx].semantic = ATTRIB_TANGENT;
-			vbd.attrib[attribIdx].format = ATTRIB_FORMAT_FLOAT3;
-			++attribIdx;
-		}
-		vbd.numVertices = static_cast<Uint32>(v->position.size());
-		vbd.usage = BUFFER_USAGE_DYNAMIC;	// dynamic since we'll be reusing these buffers if possible
-
-		// VertexBuffer
-		RefCountedPtr<VertexBuffer> vb;
-		vb.Reset(CreateVertexBuffer(vbd));
-		vb->Populate(*v);
-
-		// add to map
-		s_AttribBufferMap[std::make_pair(attribs, v->position.size())] = vb;
-		drawVB = vb;
 	}
-	else {
-		// got a buffer so use it and fill it with newest data
-		drawVB = iter->second;
-		drawVB->Populate(*v);
+	if (v->HasAttrib(ATTRIB_DIFFUSE)) {
+		vbd.attrib[attribIdx].semantic = ATTRIB_DIFFUSE;
+		vbd.attrib[attribIdx].format = ATTRIB_FORMAT_UBYTE4;
+		++attribIdx;
 	}
+	if (v->HasAttrib(ATTRIB_UV0)) {
+		vbd.attrib[attribIdx].semantic = ATTRIB_UV0;
+		vbd.attrib[attribIdx].format = ATTRIB_FORMAT_FLOAT2;
+		++attribIdx;
+	}
+	if (v->HasAttrib(ATTRIB_TANGENT)) {
+		vbd.attrib[attribIdx].semantic = ATTRIB_TANGENT;
+		vbd.attrib[attribIdx].format = ATTRIB_FORMAT_FLOAT3;
+		++attribIdx;
+	}
+	vbd.numVertices = static_cast<Uint32>(v->position.size());
+	OGL::CompleteVertexBufferDesc(vbd);
 
-	const bool res = DrawBuffer(drawVB.Get(), rs, m, t);
+	// stream the vertices through this frame's part of the ring
+	Uint32 first;
+	Uint8 *data = AllocateTransient(vbd, vbd.numVertices, first);
+	OGL::CopyVertexArray(data, vbd, *v);
+	m_vertexRing->Commit();
+
+	const bool res = DrawTransient(vbd, first, vbd.numVertices, rs, m, t);
 	CheckRenderErrors(__FUNCTION__,__LINE__);
 
 	m_stats.AddToStatCount(Stats::STAT_DRAWTRIS, 1);
@@ -730,6 +795,27 @@ bool RendererOGL::DrawTriangles(const VertexArray *v, RenderState *rs, Material
 	return res;
 }
 
+// NB - we're (ab)using the normal type to hold (uv coordinate offset value + point size)
+#pragma pack(push, 4)
+struct PointSpriteVert {
+	vector3f pos;
+	vector3f norm;
+};
+#pragma pack(pop)
+
+static VertexBufferDesc PointSpriteDesc(const Uint32 count)
+{
+	VertexBufferDesc vbd;
+	vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
+	vbd.attrib[0].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
+	vbd.attrib[1].semantic = Graphics::ATTRIB_NORMAL;
+	vbd.attrib[1].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
+	vbd.numVertices = count;
+	OGL::CompleteVertexBufferDesc(vbd);
+	assert(vbd.stride == sizeof(PointSpriteVert));
+	return vbd;
+}
+
 bool RendererOGL::DrawPointSprites(const Uint32 count, const vector3f *positions, RenderState *rs, Material *material, float size)
 {
 	PROFILE_SCOPED()
@@ -738,51 +824,18 @@ bool RendererOGL::DrawPointSprites(const Uint32 count, const vector3f *positions
 
 	size = Clamp(size, 0.1f, FLT_MAX);
 
-	#pragma pack(push, 4)
-	struct PosNormVert {
-		vector3f pos;
-		vector3f norm;
-	};
-	#pragma pack(pop)
-
-	RefCountedPtr<VertexBuffer> drawVB;
-	AttribBufferIter iter = s_AttribBufferMap.find(std::make_pair(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_NORMAL, count));
-	if (iter == s_AttribBufferMap.end())
-	{
-		// NB - we're (ab)using the normal type to hold (uv coordinate offset value + point size)
-		Graphics::VertexBufferDesc vbd;
-		vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
-		vbd.attrib[0].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
-		vbd.attrib[1].semantic = Graphics::ATTRIB_NORMAL;
-		vbd.attrib[1].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
-		vbd.numVertices = count;
-		vbd.usage = Graphics::BUFFER_USAGE_DYNAMIC;	// we could be updating this per-frame
-
-		// VertexBuffer
-		RefCountedPtr<VertexBuffer> vb;
-		vb.Reset(CreateVertexBuffer(vbd));
-
-		// add to map
-		s_AttribBufferMap[std::make_pair(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_NORMAL, count)] = vb;
-		drawVB = vb;
-	}
-	else
-	{
-		drawVB = iter->second;
-	}
-
-	// got a buffer so use it and fill it with newest data
-	PosNormVert* vtxPtr = drawVB->Map<PosNormVert>(Graphics::BUFFER_MAP_WRITE);
-	assert(drawVB->GetDesc().stride == sizeof(PosNormVert));
+	const VertexBufferDesc vbd = PointSpriteDesc(count);
+	Uint32 first;
+	PointSpriteVert* vtxPtr = reinterpret_cast<PointSpriteVert*>(AllocateTransient(vbd, count, first));
 	for(Uint32 i=0 ; i<count ; i++)
 	{
 		vtxPtr[i].pos	= positions[i];
 		vtxPtr[i].norm	= vector3f(0.0f, 0.0f, size);
 	}
-	drawVB->Unmap();
+	m_vertexRing->Commit();
 
 	SetTransform(matrix4x4f::Identity());
-	DrawBuffer(drawVB.Get(), rs, material, Graphics::POINTS);
+	DrawTransient(vbd, first, count, rs, material, Graphics::POINTS);
 	GetStats().AddToStatCount(Graphics::Stats::STAT_DRAWPOINTSPRITES, 1);
 	CheckRenderErrors(__FUNCTION__,__LINE__);
 
@@ -795,64 +848,120 @@ bool RendererOGL::DrawPointSprites(const Uint32 count, const vector3f *positions
 	if (count == 0 || !material || !material->texture0)
 		return false;
 
-	#pragma pack(push, 4)
-	struct PosNormVert {
-		vector3f pos;
-		vector3f norm;
-	};
-	#pragma pack(pop)
-
-	RefCountedPtr<VertexBuffer> drawVB;
-	AttribBufferIter iter = s_AttribBufferMap.find(std::make_pair(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_NORMAL, count));
-	if (iter == s_AttribBufferMap.end())
-	{
-		// NB - we're (ab)using the normal type to hold (uv coordinate offset value + point size)
-		Graphics::VertexBufferDesc vbd;
-		vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
-		vbd.attrib[0].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
-		vbd.attrib[1].semantic = Graphics::ATTRIB_NORMAL;
-		vbd.attrib[1].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
-		vbd.numVertices = count;
-		vbd.usage = Graphics::BUFFER_USAGE_DYNAMIC;	// we could be updating this per-frame
-
-		// VertexBuffer
-		RefCountedPtr<VertexBuffer> vb;
-		vb.Reset(CreateVertexBuffer(vbd));
-
-		// add to map
-		s_AttribBufferMap[std::make_pair(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_NORMAL, count)] = vb;
-		drawVB = vb;
-	}
-	else
-	{
-		drawVB = iter->second;
-	}
-
-	// got a buffer so use it and fill it with newest data
-	PosNormVert* vtxPtr = drawVB->Map<PosNormVert>(Graphics::BUFFER_MAP_WRITE);
-	assert(drawVB->GetDesc().stride == sizeof(PosNormVert));
+	const VertexBufferDesc vbd = PointSpriteDesc(count);
+	Uint32 first;
+	PointSpriteVert* vtxPtr = reinterpret_cast<PointSpriteVert*>(AllocateTransient(vbd, count, first));
 	for(Uint32 i=0 ; i<count ; i++)
 	{
 		vtxPtr[i].pos	= positions[i];
 		vtxPtr[i].norm	= vector3f(offsets[i], Clamp(sizes[i], 0.1f, FLT_MAX));
 	}
-	drawVB->Unmap();
+	m_vertexRing->Commit();
 
 	SetTransform(matrix4x4f::Identity());
-	DrawBuffer(drawVB.Get(), rs, material, Graphics::POINTS);
+	DrawTransient(vbd, first, count, rs, material, Graphics::POINTS);
 	GetStats().AddToStatCount(Graphics::Stats::STAT_DRAWPOINTSPRITES, 1);
 	CheckRenderErrors(__FUNCTION__,__LINE__);
 
 	return true;
 }
 
-bool RendererOGL::DrawBuffer(VertexBuffer* vb, RenderState* state, Material* mat, PrimitiveType pt)
+Uint8 *RendererOGL::AllocateTransient(const VertexBufferDesc &desc, Uint32 count, Uint32 &first)
+{
+	Uint8 *data = m_vertexRing->Allocate(desc, count, first);
+	m_stats.AddToStatCount(Stats::STAT_TRANSIENT_BYTES, count * desc.stride);
+	// only non-zero when the ring had to grow
+	m_stats.AddToStatCount(Stats::STAT_CREATE_BUFFER, m_vertexRing->TakeBuffersCreated());
+	return data;
+}
+
+bool RendererOGL::DrawTransient(const VertexBufferDesc &desc, Uint32 first, Uint32 count, RenderState *state, Material *mat, PrimitiveType pt)
 {
 	PROFILE_SCOPED()
 	SetRenderState(state);
+	ApplyMaterial(mat);
+
+	SetMaterialShaderTransforms(mat, desc);
+
+	m_vertexRing->Bind(desc);
+	glDrawArrays(pt, first, count);
+	m_vertexRing->Release();
+	CheckRenderErrors(__FUNCTION__,__LINE__);
+
+	m_stats.AddToStatCount(Stats::STAT_DRAWCALL, 1);
+
+	return true;
+}
+
+bool RendererOGL::DrawBufferIndexedMulti(VertexBuffer *vb, IndexBuffer *ib, RenderState *state, Material *mat, const Uint32 *baseVertices, Uint32 count, PrimitiveType pt)
+{
+	PROFILE_SCOPED()
+	if (!m_useMultiDraw)
+		return false;
+	if (count == 0)
+		return true;
+
+	m_multiDrawCounts.assign(count, GLsizei(ib->GetIndexCount()));
+	m_multiDrawOffsets.assign(count, nullptr);
+	m_multiDrawBaseVertices.assign(baseVertices, baseVertices + count);
+
+	SetRenderState(state);
+	ApplyMaterial(mat);
+
+	SetMaterialShaderTransforms(mat, vb->GetDesc());
+
+	vb->Bind();
+	ib->Bind();
+	glMultiDrawElementsBaseVertex(pt, &m_multiDrawCounts[0], GL_UNSIGNED_INT, const_cast<GLvoid**>(&m_multiDrawOffsets[0]), count, &m_multiDrawBaseVertices[0]);
+	ib->Release();
+	vb->Release();
+	CheckRenderErrors(__FUNCTION__,__LINE__);
+
+	m_stats.AddToStatCount(Stats::STAT_DRAWCALL, 1);
+
+	return true;
+}
+
+void RendererOGL::ApplyMaterial(Material *mat)
+{
 	mat->Apply();
+	m_stats.AddToStatCount(Stats::STAT_MATERIAL_APPLIES, 1);
+}
+
+Uint32 RendererOGL::GetProgramSortId(const Material *mat) const
+{
+	return static_cast<const OGL::Material*>(mat)->m_program->GetName();
+}
 
-	SetMaterialShaderTransforms(mat);
+void RendererOGL::SubmitCommand(const DrawCommand &cmd, const DrawCommand *prev)
+{
+	PROFILE_SCOPED()
+	SetTransform(cmd.modelView);
+	SetRenderState(cmd.state);
+	// queued materials can't change before they are submitted, so if the
+	// previous draw applied this one its textures and uniforms are still set
+	if (!prev || prev->material != cmd.material)
+		ApplyMaterial(cmd.material);
+
+	SetMaterialShaderTransforms(cmd.material, cmd.vertexBuffer->GetDesc());
+
+	cmd.vertexBuffer->Bind();
+	cmd.indexBuffer->Bind();
+	glDrawElements(cmd.type, cmd.indexBuffer->GetIndexCount(), GL_UNSIGNED_INT, 0);
+	cmd.indexBuffer->Release();
+	cmd.vertexBuffer->Release();
+	CheckRenderErrors(__FUNCTION__,__LINE__);
+
+	m_stats.AddToStatCount(Stats::STAT_DRAWCALL, 1);
+}
+
+bool RendererOGL::DrawBuffer(VertexBuffer* vb, RenderState* state, Material* mat, PrimitiveType pt)
+{
+	PROFILE_SCOPED()
+	SetRenderState(state);
+	ApplyMaterial(mat);
+
+	SetMaterialShaderTransforms(mat, vb->GetDesc());
 
 	vb->Bind();
 	glDrawArrays(pt, 0, vb->GetSize());
@@ -868,9 +977,9 @@ bool RendererOGL::DrawBufferIndexed(VertexBuffer *vb, IndexBuffer *ib, RenderSta
 {
 	PROFILE_SCOPED()
 	SetRenderState(state);
-	mat->Apply();
+	ApplyMaterial(mat);
 
-	SetMaterialShaderTransforms(mat);
+	SetMaterialShaderTransforms(mat, vb->GetDesc());
 
 	vb->Bind();
 	ib->Bind();
@@ -888,9 +997,9 @@ bool RendererOGL::DrawBufferInstanced(VertexBuffer* vb, RenderState* state, Mate
 {
 	PROFILE_SCOPED()
 	SetRenderState(state);
-	mat->Apply();
+	ApplyMaterial(mat);
 
-	SetMaterialShaderTransforms(mat);
+	SetMaterialShaderTransforms(mat, vb->GetDesc());
 
 	vb->Bind();
 	instb->Bind();
@@ -908,9 +1017,9 @@ bool RendererOGL::DrawBufferIndexedInstanced(VertexBuffer *vb, IndexBuffer *ib,
 {
 	PROFILE_SCOPED()
 	SetRenderState(state);
-	mat->Apply();
+	ApplyMaterial(mat);
 
-	SetMaterialShaderTransforms(mat);
+	SetMaterialShaderTransforms(mat, vb->GetDesc());
 
 	vb->Bind();
 	ib->Bind();
@@ -926,20 +1035,11 @@ bool RendererOGL::DrawBufferIndexedInstanced(VertexBuffer *vb, IndexBuffer *ib,
 	return true;
 }
 
-Material *RendererOGL::CreateMaterial(const MaterialDescriptor &d)
+// Create the material. It will be also used to create the shader,
+// like a tiny factory
+static OGL::Material *new_material(const MaterialDescriptor &desc)
 {
-	PROFILE_SCOPED()
-	MaterialDescriptor desc = d;
-
 	OGL::Material *mat = 0;
-	OGL::Program *p = 0;
-
-	if (desc.lighting) {
-		desc.dirLights = m_numDirLights;
-	}
-
-	// Create the material. It will be also used to create the shader,
-	// like a tiny factory
 	switch (desc.effect) {
 	case EFFECT_VTXCOLOR:
 		mat = new OGL::VtxColorMaterial();
@@ -992,7 +1092,22 @@ Material *RendererOGL::CreateMaterial(const MaterialDescriptor &d)
 		else
 			mat = new OGL::MultiMaterial();
 	}
+	return mat;
+}
+
+Material *RendererOGL::CreateMaterial(const MaterialDescriptor &d)
+{
+	PROFILE_SCOPED()
+	MaterialDescriptor desc = d;
 
+	OGL::Material *mat = 0;
+	OGL::Program *p = 0;
+
+	if (desc.lighting) {
+		desc.dirLights = m_numDirLights;
+	}
+
+	mat = new_material(desc);
 	mat->m_renderer = this;
 	mat->m_descriptor = desc;
 
@@ -1006,10 +1121,12 @@ Material *RendererOGL::CreateMaterial(const MaterialDescriptor &d)
 bool RendererOGL::ReloadShaders()
 {
 	Output("Reloading " SIZET_FMT " programs...\n", m_programs.size());
-	for (ProgramIterator it = m_programs.begin(); it != m_programs.end(); ++it) {
-		it->second->Reload();
+	for (auto &it : m_programs) {
+		it.second->Reload();
 	}
-	Output("Done.\n");
+	Uint32 cached, compiled;
+	OGL::Program::TakeLoadCounts(cached, compiled);
+	Output("Done, %u compiled, %u unchanged.\n", compiled, cached);
 
 	return true;
 }
@@ -1021,23 +1138,119 @@ OGL::Program* RendererOGL::GetOrCreateProgram(OGL::Material *mat)
 	OGL::Program *p = 0;
 
 	// Find an existing program...
-	for (ProgramIterator it = m_programs.begin(); it != m_programs.end(); ++it) {
-		if ((*it).first == desc) {
-			p = (*it).second;
-			break;
-		}
+	auto it = m_programs.find(desc);
+	if (it != m_programs.end()) {
+		p = it->second;
 	}
 
 	// ...or create a new one
 	if (!p) {
 		p = mat->CreateProgram(desc);
-		m_programs.push_back(std::make_pair(desc, p));
+		m_programs[desc] = p;
+		if (!m_prewarmingPrograms)
+			m_programListDirty = true;
 	}
 	CheckRenderErrors(__FUNCTION__,__LINE__);
 
 	return p;
 }
 
+static std::string descriptor_to_string(const MaterialDescriptor &desc)
+{
+	char buf[128];
+	snprintf(buf, sizeof(buf), "%d %d %d %d %d %d %d %d %d %d %d %u %u %u",
+		int(desc.effect), int(desc.alphaTest), int(desc.glowMap), int(desc.ambientMap),
+		int(desc.lighting), int(desc.normalMap), int(desc.specularMap), int(desc.usePatterns),
+		int(desc.vertexColors), int(desc.instanced), desc.textures, desc.dirLights,
+		desc.quality, desc.numShadows);
+	return buf;
+}
+
+static bool descriptor_from_string(const std::string &str, MaterialDescriptor &desc)
+{
+	int v[14];
+	if (sscanf(str.c_str(), "%d %d %d %d %d %d %d %d %d %d %d %d %d %d",
+		&v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6],
+		&v[7], &v[8], &v[9], &v[10], &v[11], &v[12], &v[13]) != 14)
+		return false;
+	if (v[0] < EFFECT_DEFAULT || v[0] > EFFECT_BILLBOARD)
+		return false;
+	desc.effect = EffectType(v[0]);
+	desc.alphaTest = v[1] != 0;
+	desc.glowMap = v[2] != 0;
+	desc.ambientMap = v[3] != 0;
+	desc.lighting = v[4] != 0;
+	desc.normalMap = v[5] != 0;
+	desc.specularMap = v[6] != 0;
+	desc.usePatterns = v[7] != 0;
+	desc.vertexColors = v[8] != 0;
+	desc.instanced = v[9] != 0;
+	desc.textures = v[10];
+	desc.dirLights = Uint32(v[11]);
+	desc.quality = Uint32(v[12]);
+	desc.numShadows = Uint32(v[13]);
+	return desc.dirLights <= TOTAL_NUM_LIGHTS && desc.numShadows <= 4;
+}
+
+void RendererOGL::PrewarmPrograms()
+{
+	PROFILE_SCOPED()
+	// without binaries every program would be compiled here, which would make
+	// startup slower rather than faster
+	if (!OGL::Program::IsBinaryCacheEnabled())
+		return;
+
+	RefCountedPtr<FileSystem::FileData> file = FileSystem::userFiles.ReadFile(PROGRAM_LIST_FILE);
+	if (!file.Valid())
+		return;
+
+	const Uint32 start = SDL_GetTicks();
+	m_prewarmingPrograms = true;
+
+	StringRange buffer = file->AsStringRange();
+	if (buffer.ReadLine().StripSpace().ToString() != PROGRAM_LIST_HEADER) {
+		Output("Ignoring out of date %s\n", PROGRAM_LIST_FILE);
+		buffer = StringRange();
+	}
+	while (!buffer.Empty()) {
+		MaterialDescriptor desc;
+		if (!descriptor_from_string(buffer.ReadLine().StripSpace().ToString(), desc))
+			continue;
+		if (m_programs.find(desc) != m_programs.end())
+			continue;
+
+		// the material is only needed to pick and build the program
+		OGL::Material *mat = new_material(desc);
+		mat->m_renderer = this;
+		mat->m_descriptor = desc;
+		GetOrCreateProgram(mat);
+		delete mat;
+	}
+
+	m_prewarmingPrograms = false;
+
+	Uint32 cached, compiled;
+	OGL::Program::TakeLoadCounts(cached, compiled);
+	Output("Prewarmed %u programs (%u compiled) in %u ms\n", cached + compiled, compiled, SDL_GetTicks() - start);
+}
+
+void RendererOGL::SaveProgramList()
+{
+	PROFILE_SCOPED()
+	m_programListDirty = false;
+	m_programListSaved = SDL_GetTicks();
+	if (!OGL::Program::IsBinaryCacheEnabled())
+		return;
+
+	FILE *f = FileSystem::userFiles.OpenWriteStream(PROGRAM_LIST_FILE, FileSystem::FileSourceFS::WRITE_TEXT);
+	if (!f)
+		return;
+	fprintf(f, "%s\n", PROGRAM_LIST_HEADER);
+	for (const auto &it : m_programs)
+		fprintf(f, "%s\n", descriptor_to_string(it.first).c_str());
+	fclose(f);
+}
+
 Texture *RendererOGL::CreateTexture(const TextureDescriptor &descriptor)
 {
 	PROFILE_SCOPED()
@@ -1156,10 +1369,10 @@ void RendererOGL::PushMatrix()
 {
 	switch(m_matrixMode) {
 		case MatrixMode::MODELVIEW:
-			m_modelViewStack.push(m_modelViewStack.top());
+			m_modelViewStack.Push();
 			break;
 		case MatrixMode::PROJECTION:
-			m_projectionStack.push(m_projectionStack.top());
+			m_projectionStack.Push();
 			break;
 	}
 }
@@ -1168,12 +1381,10 @@ void RendererOGL::PopMatrix()
 {
 	switch(m_matrixMode) {
 		case MatrixMode::MODELVIEW:
-			m_modelViewStack.pop();
-			assert(m_modelViewStack.size());
+			m_modelViewStack.Pop();
 			break;
 		case MatrixMode::PROJECTION:
-			m_projectionStack.pop();
-			assert(m_projectionStack.size());
+			m_projectionStack.Pop();
 			break;
 	}
 }
@@ -1182,10 +1393,10 @@ void RendererOGL::LoadIdentity()
 {
 	switch(m_matrixMode) {
 		case MatrixMode::MODELVIEW:
-			m_modelViewStack.top() = matrix4x4f::Identity();
+			m_modelViewStack.Load(matrix4x4f::Identity());
 			break;
 		case MatrixMode::PROJECTION:
-			m_projectionStack.top() = matrix4x4f::Identity();
+			m_projectionStack.Load(matrix4x4f::Identity());
 			break;
 	}
 }
@@ -1194,10 +1405,10 @@ void RendererOGL::LoadMatrix(const matrix4x4f &m)
 {
 	switch(m_matrixMode) {
 		case MatrixMode::MODELVIEW:
-			m_modelViewStack.top() = m;
+			m_modelViewStack.Load(m);
 			break;
 		case MatrixMode::PROJECTION:
-			m_projectionStack.top() = m;
+			m_projectionStack.Load(m);
 			break;
 	}
 }
@@ -1206,10 +1417,10 @@ void RendererOGL::Translate( const float x, const float y, const float z )
 {
 	switch(m_matrixMode) {
 		case MatrixMode::MODELVIEW:
-			m_modelViewStack.top().Translate(x,y,z);
+			m_modelViewStack.Translate(x,y,z);
 			break;
 		case MatrixMode::PROJECTION:
-			m_projectionStack.top().Translate(x,y,z);
+			m_projectionStack.Translate(x,y,z);
 			break;
 	}
 }
@@ -1218,10 +1429,10 @@ void RendererOGL::Scale( const float x, const float y, const float z )
 {
 	switch(m_matrixMode) {
 		case MatrixMode::MODELVIEW:
-			m_modelViewStack.top().Scale(x,y,z);
+			m_modelViewStack.Scale(x,y,z);
 			break;
 		case MatrixMode::PROJECTION:
-			m_modelViewStack.top().Scale(x,y,z);
+			m_projectionStack.Scale(x,y,z);
 			break;
 	}
 }
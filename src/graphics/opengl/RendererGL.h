@@ -15,6 +15,10 @@
  */
 #include "OpenGLLibs.h"
 #include "graphics/Renderer.h"
+#include "graphics/Material.h"
+#include "graphics/MatrixStack.h"
+#include "graphics/opengl/MaterialGL.h"
+#include <memory>
 #include <stack>
 #include <unordered_map>
 
@@ -40,6 +44,7 @@ namespace OGL {
 	class ShieldMaterial;
 	class UIMaterial;
 	class BillboardMaterial;
+	class VertexRing;
 }
 
 class RendererOGL : public Renderer
@@ -59,6 +64,9 @@ public:
 	static void CheckErrors(const char *func = nullptr, const int line = -1);
 
 	virtual bool SupportsInstancing() override final { return true; }
+	virtual bool SupportsMultiDraw() const override final { return m_useMultiDraw; }
+	virtual bool SupportsTextureStreaming() const override final { return true; }
+	virtual bool SupportsCompactVertices() const override final { return true; }
 
 	virtual int GetMaximumNumberAASamples() const override final;
 	virtual bool GetNearFarRange(float &near_, float &far_) const override final;
@@ -99,6 +107,7 @@ public:
 	virtual bool DrawBufferIndexed(VertexBuffer*, IndexBuffer*, RenderState*, Material*, PrimitiveType) override final;
 	virtual bool DrawBufferInstanced(VertexBuffer*, RenderState*, Material*, InstanceBuffer*, PrimitiveType type=TRIANGLES) override final;
 	virtual bool DrawBufferIndexedInstanced(VertexBuffer*, IndexBuffer*, RenderState*, Material*, InstanceBuffer*, PrimitiveType=TRIANGLES) override final;
+	virtual bool DrawBufferIndexedMulti(VertexBuffer*, IndexBuffer*, RenderState*, Material*, const Uint32 *baseVertices, Uint32 count, PrimitiveType=TRIANGLES) override final;
 
 	virtual Material *CreateMaterial(const MaterialDescriptor &descriptor) override final;
 	virtual Texture *CreateTexture(const TextureDescriptor &descriptor) override final;
@@ -110,8 +119,8 @@ public:
 
 	virtual bool ReloadShaders() override final;
 
-	virtual const matrix4x4f& GetCurrentModelView() const override final { return m_modelViewStack.top(); }
-	virtual const matrix4x4f& GetCurrentProjection() const override final { return m_projectionStack.top(); }
+	virtual const matrix4x4f& GetCurrentModelView() const override final { return m_modelViewStack.Top(); }
+	virtual const matrix4x4f& GetCurrentProjection() const override final { return m_projectionStack.Top(); }
 	virtual void GetCurrentViewport(Sint32 *vp) const override final {
 		const Viewport &cur = m_viewportStack.top();
 		vp[0] = cur.x; vp[1] = cur.y; vp[2] = cur.w; vp[3] = cur.h;
@@ -128,6 +137,10 @@ public:
 	virtual bool Screendump(ScreendumpState &sd) override final;
 	virtual bool FrameGrab(ScreendumpState &sd) override final;
 
+	virtual Uint32 QueryGPUTimestamp() override final;
+	virtual bool GetGPUTimestamp(Uint32 query, Uint64 &timestamp) override final;
+	virtual void FreeGPUTimestamp(Uint32 query) override final;
+
 protected:
 	virtual void PushState() override final;
 	virtual void PopState() override final;
@@ -139,13 +152,37 @@ protected:
 	float m_maxZFar;
 	bool m_useCompressedTextures;
 	bool m_useAnisotropicFiltering;
-
-	void SetMaterialShaderTransforms(Material *);
+	bool m_useMultiDraw;
+	bool m_useTimerQueries;
+	std::vector<GLuint> m_timerQueries;     // all of them, for deleting
+	std::vector<GLuint> m_freeTimerQueries;
+	// DrawBufferIndexedMulti arguments
+	std::vector<GLsizei> m_multiDrawCounts;
+	std::vector<const GLvoid*> m_multiDrawOffsets;
+	std::vector<GLint> m_multiDrawBaseVertices;
+
+	// and how to decode the vertices drawn
+	void SetMaterialShaderTransforms(Material *, const VertexBufferDesc &);
+	void ApplyMaterial(Material *);
+
+	virtual Uint32 GetProgramSortId(const Material *) const override final;
+	virtual void SubmitCommand(const DrawCommand &cmd, const DrawCommand *prev) override final;
 
 	matrix4x4f& GetCurrentTransform() { return m_currentTransform; }
 	matrix4x4f m_currentTransform;
 
+	// immediate mode draws stream their vertices through m_vertexRing
+	Uint8 *AllocateTransient(const VertexBufferDesc &desc, Uint32 count, Uint32 &first);
+	bool DrawTransient(const VertexBufferDesc &desc, Uint32 first, Uint32 count, RenderState *state, Material *mat, PrimitiveType pt);
+	std::unique_ptr<OGL::VertexRing> m_vertexRing;
+
 	OGL::Program* GetOrCreateProgram(OGL::Material*);
+	// builds the programs of earlier runs up front instead of on first use
+	void PrewarmPrograms();
+	void SaveProgramList();
+	bool m_prewarmingPrograms;
+	bool m_programListDirty; // programs built since the list was last saved
+	Uint32 m_programListSaved;
 	friend class OGL::Material;
 	friend class OGL::GasGiantSurfaceMaterial;
 	friend class OGL::GeoSphereSurfaceMaterial;
@@ -158,15 +195,20 @@ protected:
 	friend class OGL::FresnelColourMaterial;
 	friend class OGL::ShieldMaterial;
 	friend class OGL::BillboardMaterial;
-	std::vector<std::pair<MaterialDescriptor, OGL::Program*> > m_programs;
+	std::unordered_map<MaterialDescriptor, OGL::Program*, MaterialDescriptorHash> m_programs;
 	std::unordered_map<Uint32, OGL::RenderState*> m_renderStates;
 	float m_invLogZfarPlus1;
 	OGL::RenderTarget *m_activeRenderTarget;
 	RenderState *m_activeRenderState;
 
 	MatrixMode m_matrixMode;
-	std::stack<matrix4x4f> m_modelViewStack;
-	std::stack<matrix4x4f> m_projectionStack;
+	MatrixStack m_modelViewStack;
+	MatrixStack m_projectionStack;
+
+	// the derived matrices for the current stack tops, see SetMaterialShaderTransforms
+	OGL::TransformState m_transforms;
+	Uint32 m_transformsModelViewSerial;
+	Uint32 m_transformsProjectionSerial;
 
 	struct Viewport {
 		Viewport() : x(0), y(0), w(0), h(0) {}
@@ -177,10 +219,6 @@ protected:
 private:
 	static bool initted;
 
-	typedef std::map<std::pair<AttributeSet, size_t>, RefCountedPtr<VertexBuffer>> AttribBufferMap;
-	typedef AttribBufferMap::iterator AttribBufferIter;
-	static AttribBufferMap s_AttribBufferMap;
-
 	SDL_GLContext m_glContext;
 };
 #define CHECKERRORS() RendererOGL::CheckErrors(__FUNCTION__, __LINE__)
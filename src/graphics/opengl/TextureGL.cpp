@@ -76,8 +76,10 @@ inline bool IsCompressed(TextureFormat format) {
 	return (format == TEXTURE_DXT1 || format == TEXTURE_DXT5);
 }
 
+GLuint TextureGL::s_uploadBuffer = 0;
+
 TextureGL::TextureGL(const TextureDescriptor &descriptor, const bool useCompressed, const bool useAnisoFiltering) :
-	Texture(descriptor), m_useAnisoFiltering(useAnisoFiltering && descriptor.useAnisotropicFiltering)
+	Texture(descriptor), m_useCompressed(useCompressed), m_useAnisoFiltering(useAnisoFiltering && descriptor.useAnisotropicFiltering)
 {
 	PROFILE_SCOPED()
 	m_target = GLTextureType(descriptor.type);
@@ -346,6 +348,7 @@ void TextureGL::Update(const TextureCubeData &data, const vector2f &dataSize, Te
 
 void TextureGL::Bind()
 {
+	MarkUsed();
 	glBindTexture(m_target, m_texture);
 }
 
@@ -396,6 +399,92 @@ void TextureGL::SetSampleMode(TextureSampleMode mode)
 	CHECKERRORS();
 }
 
+void TextureGL::Reallocate(const TextureDescriptor &descriptor)
+{
+	PROFILE_SCOPED()
+	assert(m_target == GL_TEXTURE_2D && descriptor.type == TEXTURE_2D);
+	SetDescriptor(descriptor);
+
+	const bool compressTexture = m_useCompressed && descriptor.allowCompression;
+	const GLint internalFormat = (compressTexture && !IsCompressed(descriptor.format)) ?
+		GLCompressedInternalFormat(descriptor.format) : GLInternalFormat(descriptor.format);
+	const unsigned int numLevels = std::max(descriptor.numberOfMipMaps, 1U);
+
+	glBindTexture(m_target, m_texture);
+	size_t width = descriptor.dataSize.x;
+	size_t height = descriptor.dataSize.y;
+	for (unsigned int i = 0; i < numLevels; ++i) {
+		if (IsCompressed(descriptor.format)) {
+			const size_t bufSize = ((width + 3) / 4) * ((height + 3) / 4) * GetMinSize(descriptor.format);
+			glCompressedTexImage2D(m_target, i, internalFormat, width, height, 0, bufSize, 0);
+		} else {
+			glTexImage2D(m_target, i, internalFormat, width, height, 0,
+				GLImageFormat(descriptor.format), GLImageType(descriptor.format), 0);
+		}
+		width = std::max<size_t>(width / 2, 1);
+		height = std::max<size_t>(height / 2, 1);
+	}
+
+	// nothing to sample from until UpdateLevel fills the smallest level
+	glTexParameteri(m_target, GL_TEXTURE_BASE_LEVEL, numLevels - 1);
+	glTexParameteri(m_target, GL_TEXTURE_MAX_LEVEL, numLevels - 1);
+	glBindTexture(m_target, 0);
+	CHECKERRORS();
+
+	// the placeholder may not have had mipmaps to filter
+	SetSampleMode(descriptor.sampleMode);
+}
+
+void TextureGL::UpdateLevel(const void *data, size_t size, unsigned int level)
+{
+	PROFILE_SCOPED()
+	assert(m_target == GL_TEXTURE_2D);
+	const TextureDescriptor &descriptor = GetDescriptor();
+	const size_t width = std::max<size_t>(size_t(descriptor.dataSize.x) >> level, 1);
+	const size_t height = std::max<size_t>(size_t(descriptor.dataSize.y) >> level, 1);
+
+	// copy through a pixel buffer so the driver can transfer it without
+	// stalling, orphaning the previous contents each time
+	if (!s_uploadBuffer)
+		glGenBuffers(1, &s_uploadBuffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s_uploadBuffer);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	void *dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	const bool mapped = (dst != nullptr);
+	if (mapped) {
+		memcpy(dst, data, size);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	} else {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	const void *pixels = mapped ? nullptr : data;
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(m_target, m_texture);
+	// the small levels of RGB textures have rows that aren't 4 byte aligned
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	if (IsCompressed(descriptor.format)) {
+		glCompressedTexSubImage2D(m_target, level, 0, 0, width, height, GLImageFormat(descriptor.format), size, pixels);
+	} else {
+		glTexSubImage2D(m_target, level, 0, 0, width, height, GLImageFormat(descriptor.format), GLImageType(descriptor.format), pixels);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	// levels arrive smallest first, so this one and all below it are ready
+	glTexParameteri(m_target, GL_TEXTURE_BASE_LEVEL, level);
+	glBindTexture(m_target, 0);
+	CHECKERRORS();
+}
+
+void TextureGL::FreeUploadBuffer()
+{
+	if (s_uploadBuffer) {
+		glDeleteBuffers(1, &s_uploadBuffer);
+		s_uploadBuffer = 0;
+	}
+}
+
 void TextureGL::BuildMipmaps()
 {
 	const TextureDescriptor& descriptor = GetDescriptor();
@@ -26,10 +26,19 @@ namespace Graphics
 			virtual void BuildMipmaps() override final;
 			virtual uint32_t GetTextureID() const override final { assert(sizeof(uint32_t)==sizeof(GLuint)); return m_texture; }
 
+			virtual void Reallocate(const TextureDescriptor &descriptor) override final;
+			virtual void UpdateLevel(const void *data, size_t size, unsigned int level) override final;
+
+			// the pixel buffer UpdateLevel copies through, shared by all textures
+			static void FreeUploadBuffer();
+
 		private:
 			GLenum m_target;
 			GLuint m_texture;
+			const bool m_useCompressed;
 			const bool m_useAnisoFiltering;
+
+			static GLuint s_uploadBuffer;
 		};
 	}
 }
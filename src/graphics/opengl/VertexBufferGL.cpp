@@ -11,11 +11,15 @@ GLint get_num_components(VertexAttribFormat fmt)
 {
 	switch (fmt) {
 	case ATTRIB_FORMAT_FLOAT2:
+	case ATTRIB_FORMAT_HALF2:
+	case ATTRIB_FORMAT_SHORT2N:
 		return 2;
 	case ATTRIB_FORMAT_FLOAT3:
 		return 3;
 	case ATTRIB_FORMAT_FLOAT4:
 	case ATTRIB_FORMAT_UBYTE4:
+	case ATTRIB_FORMAT_HALF4:
+	case ATTRIB_FORMAT_USHORT4N:
 		return 4;
 	default:
 		assert(false);
@@ -28,6 +32,13 @@ GLenum get_component_type(VertexAttribFormat fmt)
 	switch (fmt) {
 	case ATTRIB_FORMAT_UBYTE4:
 		return GL_UNSIGNED_BYTE;
+	case ATTRIB_FORMAT_HALF2:
+	case ATTRIB_FORMAT_HALF4:
+		return GL_HALF_FLOAT;
+	case ATTRIB_FORMAT_SHORT2N:
+		return GL_SHORT;
+	case ATTRIB_FORMAT_USHORT4N:
+		return GL_UNSIGNED_SHORT;
 	case ATTRIB_FORMAT_FLOAT2:
 	case ATTRIB_FORMAT_FLOAT3:
 	case ATTRIB_FORMAT_FLOAT4:
@@ -36,48 +47,39 @@ GLenum get_component_type(VertexAttribFormat fmt)
 	}
 }
 
-VertexBuffer::VertexBuffer(const VertexBufferDesc &desc) :
-	Graphics::VertexBuffer(desc)
+// integer formats other than colours are read as -1..1 or 0..1
+GLboolean get_normalised(VertexAttribFormat fmt)
+{
+	return (fmt == ATTRIB_FORMAT_SHORT2N || fmt == ATTRIB_FORMAT_USHORT4N) ? GL_TRUE : GL_FALSE;
+}
+
+void CompleteVertexBufferDesc(VertexBufferDesc &desc)
 {
-	PROFILE_SCOPED()
 	//update offsets in desc
 	for (Uint32 i = 0; i < MAX_ATTRIBS; i++) {
-		if (m_desc.attrib[i].offset == 0)
-			m_desc.attrib[i].offset = VertexBufferDesc::CalculateOffset(m_desc, m_desc.attrib[i].semantic);
+		if (desc.attrib[i].offset == 0)
+			desc.attrib[i].offset = VertexBufferDesc::CalculateOffset(desc, desc.attrib[i].semantic);
 	}
 
 	//update stride in desc (respecting offsets)
-	if (m_desc.stride == 0)
+	if (desc.stride == 0)
 	{
 		Uint32 lastAttrib = 0;
 		while (lastAttrib < MAX_ATTRIBS) {
-			if (m_desc.attrib[lastAttrib].semantic == ATTRIB_NONE)
+			if (desc.attrib[lastAttrib].semantic == ATTRIB_NONE)
 				break;
 			lastAttrib++;
 		}
 
-		m_desc.stride = m_desc.attrib[lastAttrib].offset + VertexBufferDesc::GetAttribSize(m_desc.attrib[lastAttrib].format);
+		desc.stride = desc.attrib[lastAttrib].offset + VertexBufferDesc::GetAttribSize(desc.attrib[lastAttrib].format);
 	}
-	assert(m_desc.stride > 0);
-	assert(m_desc.numVertices > 0);
-
-	//SetVertexCount(m_desc.numVertices);
-
-	glGenVertexArrays(1, &m_vao);
-	glBindVertexArray(m_vao);
-
-	glGenBuffers(1, &m_buffer);
-
-	//Allocate GL buffer with undefined contents
-	//Critical optimisation for some architectures in cases where buffer is created and written in the same frame
-	glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
-	const Uint32 dataSize = m_desc.numVertices * m_desc.stride;
-	const GLenum usage = (m_desc.usage == BUFFER_USAGE_STATIC) ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW;
-	glBufferData(GL_ARRAY_BUFFER, dataSize, 0, usage);
+	assert(desc.stride > 0);
+}
 
-	//Setup the VAO pointers
+void SetVertexAttribPointers(const VertexBufferDesc &desc)
+{
 	for (Uint8 i = 0; i < MAX_ATTRIBS; i++) {
-		const auto& attr  = m_desc.attrib[i];
+		const auto& attr  = desc.attrib[i];
 		if (attr.semantic == ATTRIB_NONE)
 			break;
 
@@ -86,29 +88,86 @@ VertexBuffer::VertexBuffer(const VertexBufferDesc &desc) :
 		switch (attr.semantic) {
 		case ATTRIB_POSITION:
 			glEnableVertexAttribArray(0);	// Enable the attribute at that location
-			glVertexAttribPointer(0, get_num_components(attr.format), get_component_type(attr.format), GL_FALSE, m_desc.stride, offset);
+			glVertexAttribPointer(0, get_num_components(attr.format), get_component_type(attr.format), get_normalised(attr.format), desc.stride, offset);
 			break;
 		case ATTRIB_NORMAL:
 			glEnableVertexAttribArray(1);	// Enable the attribute at that location
-			glVertexAttribPointer(1, get_num_components(attr.format), get_component_type(attr.format), GL_FALSE, m_desc.stride, offset);
+			glVertexAttribPointer(1, get_num_components(attr.format), get_component_type(attr.format), get_normalised(attr.format), desc.stride, offset);
 			break;
 		case ATTRIB_DIFFUSE:
 			glEnableVertexAttribArray(2);	// Enable the attribute at that location
-			glVertexAttribPointer(2, get_num_components(attr.format), get_component_type(attr.format), GL_TRUE, m_desc.stride, offset);	// only normalise the colours
+			glVertexAttribPointer(2, get_num_components(attr.format), get_component_type(attr.format), GL_TRUE, desc.stride, offset);	// colours are always normalised
 			break;
 		case ATTRIB_UV0:
 			glEnableVertexAttribArray(3);	// Enable the attribute at that location
-			glVertexAttribPointer(3, get_num_components(attr.format), get_component_type(attr.format), GL_FALSE, m_desc.stride, offset);
+			glVertexAttribPointer(3, get_num_components(attr.format), get_component_type(attr.format), get_normalised(attr.format), desc.stride, offset);
 			break;
 		case ATTRIB_TANGENT:
 			glEnableVertexAttribArray(4);	// Enable the attribute at that location
-			glVertexAttribPointer(4, get_num_components(attr.format), get_component_type(attr.format), GL_FALSE, m_desc.stride, offset);
+			glVertexAttribPointer(4, get_num_components(attr.format), get_component_type(attr.format), get_normalised(attr.format), desc.stride, offset);
 			break;
 		case ATTRIB_NONE:
 		default:
 			break;
 		}
 	}
+}
+
+void CopyVertexArray(Uint8 *dest, const VertexBufferDesc &desc, const VertexArray &va)
+{
+	PROFILE_SCOPED()
+	const Uint32 numVerts = va.GetNumVerts();
+	for (Uint32 a = 0; a < MAX_ATTRIBS; a++) {
+		const VertexAttribDesc &attr = desc.attrib[a];
+		if (attr.semantic == ATTRIB_NONE)
+			break;
+
+		Uint8 *out = dest + attr.offset;
+		switch (attr.semantic) {
+		case ATTRIB_POSITION:
+			for (Uint32 i = 0; i < numVerts; i++, out += desc.stride) memcpy(out, &va.position[i], sizeof(vector3f));
+			break;
+		case ATTRIB_NORMAL:
+			for (Uint32 i = 0; i < numVerts; i++, out += desc.stride) memcpy(out, &va.normal[i], sizeof(vector3f));
+			break;
+		case ATTRIB_DIFFUSE:
+			for (Uint32 i = 0; i < numVerts; i++, out += desc.stride) memcpy(out, &va.diffuse[i], sizeof(Color4ub));
+			break;
+		case ATTRIB_UV0:
+			for (Uint32 i = 0; i < numVerts; i++, out += desc.stride) memcpy(out, &va.uv0[i], sizeof(vector2f));
+			break;
+		case ATTRIB_TANGENT:
+			for (Uint32 i = 0; i < numVerts; i++, out += desc.stride) memcpy(out, &va.tangent[i], sizeof(vector3f));
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+VertexBuffer::VertexBuffer(const VertexBufferDesc &desc) :
+	Graphics::VertexBuffer(desc)
+{
+	PROFILE_SCOPED()
+	CompleteVertexBufferDesc(m_desc);
+	assert(m_desc.numVertices > 0);
+
+	//SetVertexCount(m_desc.numVertices);
+
+	glGenVertexArrays(1, &m_vao);
+	glBindVertexArray(m_vao);
+
+	glGenBuffers(1, &m_buffer);
+
+	//Allocate GL buffer with undefined contents
+	//Critical optimisation for some architectures in cases where buffer is created and written in the same frame
+	glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	const Uint32 dataSize = m_desc.numVertices * m_desc.stride;
+	const GLenum usage = (m_desc.usage == BUFFER_USAGE_STATIC) ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW;
+	glBufferData(GL_ARRAY_BUFFER, dataSize, 0, usage);
+
+	//Setup the VAO pointers
+	SetVertexAttribPointers(m_desc);
 
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
@@ -326,6 +385,19 @@ void VertexBuffer::BufferData(const size_t size, void *data)
 	}
 }
 
+void VertexBuffer::BufferSubData(const size_t offset, const size_t size, const void *data)
+{
+	PROFILE_SCOPED()
+	assert(m_mapMode == BUFFER_MAP_NONE); //must not be currently mapped
+	assert(offset + size <= m_desc.numVertices * m_desc.stride);
+	if (m_data)
+		memcpy(m_data + offset, data, size);
+	glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	m_written = true;
+}
+
 void VertexBuffer::Bind() {
 	assert(m_written);
 	glBindVertexArray(m_vao);
@@ -436,6 +508,19 @@ void IndexBuffer::BufferData(const size_t size, void *data)
 	}
 }
 
+void IndexBuffer::BufferSubData(const size_t offset, const size_t size, const void *data)
+{
+	PROFILE_SCOPED()
+	assert(m_mapMode == BUFFER_MAP_NONE); //must not be currently mapped
+	assert(offset + size <= sizeof(Uint32) * m_size);
+	if (m_data)
+		memcpy(reinterpret_cast<Uint8*>(m_data) + offset, data, size);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_buffer);
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	m_written = true;
+}
+
 void IndexBuffer::Bind() {
 	assert(m_written);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_buffer);
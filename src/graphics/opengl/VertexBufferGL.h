@@ -8,6 +8,13 @@
 
 namespace Graphics { namespace OGL {
 
+// fills in the attribute offsets and the stride where the description left them at zero
+void CompleteVertexBufferDesc(VertexBufferDesc &);
+// points the bound vertex array object's attributes into the bound GL_ARRAY_BUFFER
+void SetVertexAttribPointers(const VertexBufferDesc &);
+// interleaves the VertexArray into memory laid out as described (completed descriptions only)
+void CopyVertexArray(Uint8 *dest, const VertexBufferDesc &, const VertexArray &);
+
 class GLBufferBase {
 public:
 	GLBufferBase() : m_written(false) {}
@@ -30,6 +37,7 @@ public:
 
 	// change the buffer data without mapping
 	virtual void BufferData(const size_t, void*) override final;
+	virtual void BufferSubData(const size_t offset, const size_t size, const void*) override final;
 
 	virtual void Bind() override final;
 	virtual void Release() override final;
@@ -52,6 +60,7 @@ public:
 
 	// change the buffer data without mapping
 	virtual void BufferData(const size_t, void*) override final;
+	virtual void BufferSubData(const size_t offset, const size_t size, const void*) override final;
 
 	virtual void Bind() override final;
 	virtual void Release() override final;
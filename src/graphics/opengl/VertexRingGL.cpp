@@ -0,0 +1,209 @@
+// Copyright © 2008-2018 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "graphics/opengl/VertexRingGL.h"
+#include "graphics/opengl/VertexBufferGL.h"
+#include "utils.h"
+
+namespace Graphics { namespace OGL {
+
+VertexRing::VertexRing(Uint32 frameSize) :
+	m_buffer(0),
+	m_mapped(nullptr),
+	m_frameSize(frameSize),
+	m_region(0),
+	m_offset(0),
+	m_allocated(false),
+	m_bytesThisFrame(0),
+	m_buffersCreated(0)
+{
+	m_persistent = GLEW_ARB_buffer_storage && (GLEW_VERSION_3_2 || GLEW_ARB_sync);
+	for (Uint32 i = 0; i < FRAMES; i++)
+		m_fences[i] = 0;
+	CreateBuffer();
+}
+
+VertexRing::~VertexRing()
+{
+	DestroyBuffer();
+}
+
+void VertexRing::CreateBuffer()
+{
+	PROFILE_SCOPED()
+	const GLsizeiptr size = GLsizeiptr(m_frameSize) * FRAMES;
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	if (m_persistent) {
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+		m_mapped = reinterpret_cast<Uint8*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+		if (!m_mapped) {
+			// the driver claims support but won't do it, fall back to orphaning
+			Output("VertexRing: persistent mapping failed, falling back to orphaning\n");
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			glDeleteBuffers(1, &m_buffer);
+			m_persistent = false;
+			CreateBuffer();
+			return;
+		}
+	} else {
+		glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	m_region = 0;
+	m_offset = 0;
+	m_buffersCreated++;
+}
+
+void VertexRing::DestroyBuffer()
+{
+	for (Uint32 i = 0; i < FRAMES; i++) {
+		if (m_fences[i]) {
+			glDeleteSync(m_fences[i]);
+			m_fences[i] = 0;
+		}
+	}
+
+	for (auto &it : m_vaos)
+		glDeleteVertexArrays(1, &it.second);
+	m_vaos.clear();
+
+	if (m_mapped) {
+		glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		m_mapped = nullptr;
+	}
+	// draws already submitted keep the storage alive until they are done
+	glDeleteBuffers(1, &m_buffer);
+	m_buffer = 0;
+}
+
+void VertexRing::Grow(Uint32 needed)
+{
+	PROFILE_SCOPED()
+	Uint32 size = m_frameSize * 2;
+	while (size < needed)
+		size *= 2;
+	Output("VertexRing: growing from %u to %u bytes per frame\n", m_frameSize, size);
+	m_frameSize = size;
+
+	if (m_persistent) {
+		// immutable storage, so start over with a new buffer
+		DestroyBuffer();
+		CreateBuffer();
+	} else {
+		// same buffer name, so the vertex array objects stay valid
+		glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+		glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(m_frameSize) * FRAMES, nullptr, GL_STREAM_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		m_offset = 0;
+		m_buffersCreated++;
+	}
+}
+
+Uint8 *VertexRing::Allocate(const VertexBufferDesc &desc, Uint32 count, Uint32 &first)
+{
+	PROFILE_SCOPED()
+	assert(!m_allocated);
+	assert(desc.stride > 0 && count > 0);
+	const Uint32 bytes = count * desc.stride;
+
+	// vertices are drawn by index from the start of the buffer, so they have to
+	// start at a multiple of their own stride
+	auto align = [&desc](Uint32 pos) { return ((pos + desc.stride - 1) / desc.stride) * desc.stride; };
+
+	Uint8 *ptr;
+	if (m_persistent) {
+		const Uint32 base = m_region * m_frameSize;
+		Uint32 start = align(base + m_offset);
+		if (start + bytes > base + m_frameSize) {
+			Grow(bytes + desc.stride);
+			start = align(m_region * m_frameSize + m_offset);
+		}
+		m_offset = start + bytes - m_region * m_frameSize;
+		first = start / desc.stride;
+		ptr = m_mapped + start;
+	} else {
+		const Uint32 capacity = m_frameSize * FRAMES;
+		if (bytes + desc.stride > capacity)
+			Grow((bytes + desc.stride + FRAMES - 1) / FRAMES);
+		Uint32 start = align(m_offset);
+		glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+		if (start + bytes > m_frameSize * FRAMES) {
+			// orphan the storage, the driver hands us a fresh one while the GPU
+			// finishes with the old
+			glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(m_frameSize) * FRAMES, nullptr, GL_STREAM_DRAW);
+			start = 0;
+		}
+		m_offset = start + bytes;
+		first = start / desc.stride;
+		ptr = reinterpret_cast<Uint8*>(glMapBufferRange(GL_ARRAY_BUFFER, start, bytes,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+	}
+
+	m_bytesThisFrame += bytes;
+	m_allocated = true;
+	return ptr;
+}
+
+void VertexRing::Commit()
+{
+	assert(m_allocated);
+	if (!m_persistent) {
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	m_allocated = false;
+}
+
+void VertexRing::Bind(const VertexBufferDesc &desc)
+{
+	AttributeSet attribs = 0;
+	for (Uint32 i = 0; i < MAX_ATTRIBS && desc.attrib[i].semantic != ATTRIB_NONE; i++)
+		attribs |= desc.attrib[i].semantic;
+
+	auto it = m_vaos.find(attribs);
+	if (it == m_vaos.end()) {
+		GLuint vao;
+		glGenVertexArrays(1, &vao);
+		glBindVertexArray(vao);
+		glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+		SetVertexAttribPointers(desc);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		m_vaos[attribs] = vao;
+	} else {
+		glBindVertexArray(it->second);
+	}
+}
+
+void VertexRing::Release()
+{
+	glBindVertexArray(0);
+}
+
+void VertexRing::NextFrame()
+{
+	PROFILE_SCOPED()
+	assert(!m_allocated);
+	if (m_persistent) {
+		m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_region = (m_region + 1) % FRAMES;
+		m_offset = 0;
+
+		// the GPU should be done with this region by now, FRAMES frames later
+		GLsync &fence = m_fences[m_region];
+		if (fence) {
+			GLenum result = glClientWaitSync(fence, 0, 0);
+			while (result == GL_TIMEOUT_EXPIRED)
+				result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1ms
+			glDeleteSync(fence);
+			fence = 0;
+		}
+	}
+	m_bytesThisFrame = 0;
+}
+
+} }
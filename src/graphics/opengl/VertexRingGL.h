@@ -0,0 +1,74 @@
+// Copyright © 2008-2018 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef OGL_VERTEXRING_H
+#define OGL_VERTEXRING_H
+#include "OpenGLLibs.h"
+#include "graphics/VertexBuffer.h"
+#include <map>
+
+namespace Graphics { namespace OGL {
+
+/**
+ * Streams the vertices of immediate mode draws (Renderer::DrawTriangles,
+ * DrawPointSprites) through one large buffer instead of a vertex buffer per
+ * vertex count. Each frame writes to its own part of the buffer:
+ *  - with ARB_buffer_storage the buffer is persistently mapped and split
+ *    into FRAMES regions, each protected by a fence until the GPU is done
+ *    with it
+ *  - otherwise it is written with unsynchronised maps and orphaned whenever
+ *    it fills up
+ * The buffer only grows (which is the only time one is created) when a
+ * frame needs more than it has, so in steady state no buffers are created.
+ */
+class VertexRing {
+public:
+	static const Uint32 FRAMES = 3;
+
+	explicit VertexRing(Uint32 frameSize);
+	~VertexRing();
+
+	// returns where to write count vertices laid out as described (the
+	// description must have been completed), and sets first to the index to
+	// draw them from. Commit must be called before the next Allocate
+	Uint8 *Allocate(const VertexBufferDesc &desc, Uint32 count, Uint32 &first);
+	void Commit();
+
+	// binds a vertex array object for the layout, pointing into the ring
+	void Bind(const VertexBufferDesc &desc);
+	void Release();
+
+	// the frame's draws have all been submitted
+	void NextFrame();
+
+	bool IsPersistent() const { return m_persistent; }
+	Uint32 GetFrameSize() const { return m_frameSize; }
+	// bytes written since NextFrame
+	Uint32 GetBytesThisFrame() const { return m_bytesThisFrame; }
+	// number of GL buffers (re)allocated since the last call
+	Uint32 TakeBuffersCreated() { const Uint32 n = m_buffersCreated; m_buffersCreated = 0; return n; }
+
+private:
+	void CreateBuffer();
+	void DestroyBuffer();
+	void Grow(Uint32 needed);
+
+	bool m_persistent;
+	GLuint m_buffer;
+	Uint8 *m_mapped;          // persistent mapping of the whole buffer
+	Uint32 m_frameSize;       // bytes available to each frame
+	Uint32 m_region;          // current frame's region (persistent only)
+	Uint32 m_offset;          // next free byte, within the region when persistent
+	GLsync m_fences[FRAMES];
+	bool m_allocated;         // between Allocate and Commit
+
+	Uint32 m_bytesThisFrame;
+	Uint32 m_buffersCreated;
+
+	// one vertex array object per layout, all pointing into m_buffer
+	std::map<AttributeSet, GLuint> m_vaos;
+};
+
+} }
+
+#endif // OGL_VERTEXRING_H
@@ -17,6 +17,7 @@ enum RunMode {
 	MODE_MODELVIEWER,
 	MODE_GALAXYDUMP,
 	MODE_SKIPMENU,
+	MODE_BENCH,
 	MODE_VERSION,
 	MODE_USAGE,
 	MODE_USAGE_ERROR
@@ -62,6 +63,11 @@ int main(int argc, char** argv)
 			goto start;
 		}
 
+		if (modeopt == "bench" || modeopt == "b") {
+			mode = MODE_BENCH;
+			goto start;
+		}
+
 		if (modeopt == "version" || modeopt == "v") {
 			mode = MODE_VERSION;
 			goto start;
@@ -81,7 +87,9 @@ start:
 	long int radius = 4;
 	long int sx = 0, sy = 0, sz = 0;
 	std::string filename;
+	std::string source;
 	int startPlanet = 0; // zero is off
+	long int frames = 1000;
 
 	switch (mode) {
 		case MODE_GALAXYDUMP: {
@@ -149,6 +157,33 @@ start:
 			}
 			// fallthrough
 		}
+		case MODE_BENCH: {
+			// fallthrough protect
+			if (mode == MODE_BENCH) {
+				if (argc < 3) {
+					Output("pioneer: bench requires a saved game or a body path\n");
+					return 1;
+				}
+				source = argv[pos];
+				++pos;
+				// anything that isn't an option is the frame count, then the output file
+				if (argc > pos && strchr(argv[pos], '=') == nullptr) {
+					char* end = nullptr;
+					frames = std::strtol(argv[pos], &end, 0);
+					if (end == nullptr || *end != 0 || frames <= 0) {
+						Output("pioneer: invalid frame count: %s\n", argv[pos]);
+						return 1;
+					}
+					++pos;
+				}
+				if (argc > pos && strchr(argv[pos], '=') == nullptr) {
+					filename = argv[pos];
+					++pos;
+				} else
+					filename = "-";
+			}
+			// fallthrough
+		}
 		case MODE_GAME: {
 			std::map<std::string,std::string> options;
 
@@ -172,7 +207,7 @@ start:
 				}
 			}
 
-			Pi::Init(options, mode == MODE_GALAXYDUMP);
+			Pi::Init(options, mode == MODE_GALAXYDUMP, mode == MODE_BENCH);
 
 			if (mode == MODE_GAME)
 				for (;;) {
@@ -185,13 +220,32 @@ start:
 					Output("pioneer: could not open \"%s\" for writing: %s\n", filename.c_str(), strerror(errno));
 					break;
 				}
+				// the output format follows the file name's extension, stdout gets text
+				Galaxy::DumpFormat format = Galaxy::DUMP_TEXT;
+				if (ends_with_ci(filename, ".csv"))
+					format = Galaxy::DUMP_CSV;
+				else if (ends_with_ci(filename, ".jsonl") || ends_with_ci(filename, ".json"))
+					format = Galaxy::DUMP_JSONL;
 				RefCountedPtr<Galaxy> galaxy = GalaxyGenerator::Create();
-				galaxy->Dump(file, sx, sy, sz, radius);
+				galaxy->Dump(file, sx, sy, sz, radius, format);
 				if (filename != "-" && fclose(file) != 0) {
 					Output("pioneer: writing to \"%s\" failed: %s\n", filename.c_str(), strerror(errno));
 				}
 				Pi::Quit();
 			}
+			else if (mode == MODE_BENCH) {
+				FILE* file = filename == "-" ? stdout : fopen(filename.c_str(), "w");
+				if (file == nullptr) {
+					Output("pioneer: could not open \"%s\" for writing: %s\n", filename.c_str(), strerror(errno));
+					Pi::Quit(1);
+				}
+				bool ok = Pi::Bench(source, Uint32(frames), file);
+				if (filename != "-" && fclose(file) != 0) {
+					Output("pioneer: writing to \"%s\" failed: %s\n", filename.c_str(), strerror(errno));
+					ok = false;
+				}
+				Pi::Quit(ok ? 0 : 1);
+			}
 			break;
 		}
 
@@ -221,9 +275,10 @@ start:
 				"available modes:\n"
 				"    -game        [-g]     game (default)\n"
 				"    -modelviewer [-mv]    model viewer\n"
-				"    -galaxydump  [-gd]    galaxy dumper\n"
+				"    -galaxydump  [-gd]    galaxy dumper: file[.csv|.jsonl] [radius] [x,y,z]\n"
 				"    -skipmenu    [-sm]    skip main menu\n"
 				"    -skipmenu=N  [-sm=N]  skip main menu and load planet 'N' where N: number\n"
+				"    -bench       [-b]     headless benchmark: savefile|x,y,z,system,body [frames] [file|-]\n"
 				"    -version     [-v]     show version\n"
 				"    -help        [-h,-?]  this help\n"
 			);
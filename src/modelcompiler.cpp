@@ -22,10 +22,15 @@
 #include "scenegraph/DumpVisitor.h"
 #include "scenegraph/FindNodeVisitor.h"
 #include "scenegraph/BinaryConverter.h"
+#include "scenegraph/CollisionGeometry.h"
+#include "scenegraph/LOD.h"
+#include "scenegraph/Parser.h"
+#include "jenkins/lookup3.h"
 #include "OS.h"
 #include "StringF.h"
 #include "ModManager.h"
 #include "GameSaveError.h"
+#include <set>
 #include <sstream>
 
 std::unique_ptr<GameConfig> s_config;
@@ -33,9 +38,12 @@ std::unique_ptr<Graphics::Renderer> s_renderer;
 std::unique_ptr<AsyncJobQueue> asyncJobQueue;
 
 static const std::string s_dummyPath("");
+// deflate the .sgm files written, set before any are
+static bool s_compressed = false;
 
 // fwd decl'
-void RunCompiler(const std::string &modelName, const std::string &filepath, const bool bInPlace);
+bool RunCompiler(Graphics::Renderer *renderer, const std::string &modelName, const std::string &filepath, const bool bInPlace);
+void WriteManifest(const std::string &filepath, const std::string &manifest, const bool bInPlace);
 
 // ********************************************************************************
 // Overloaded PureJob class to handle compiling each model
@@ -44,17 +52,28 @@ class CompileJob : public Job
 {
 public:
 	CompileJob() {};
-	CompileJob(const std::string &name, const std::string &path, const bool inPlace)
-		: m_name(name), m_path(path), m_inPlace(inPlace) {}
-
-	virtual void OnRun() override final { RunCompiler(m_name, m_path, m_inPlace); }    // RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
-	virtual void OnFinish() override final {}
+	CompileJob(const std::string &name, const std::string &path, const bool inPlace, const std::string &manifest)
+		: m_name(name), m_path(path), m_inPlace(inPlace), m_manifest(manifest), m_ok(false) {}
+
+	// RUNS IN ANOTHER THREAD!! MUST BE THREAD SAFE!
+	// so it loads with a renderer of its own, the texture cache and the rest
+	// being shared by nothing else
+	virtual void OnRun() override final {
+		Graphics::RendererDummy renderer;
+		m_ok = RunCompiler(&renderer, m_name, m_path, m_inPlace);
+	}
+	virtual void OnFinish() override final {
+		if (m_ok && !m_manifest.empty())
+			WriteManifest(m_path, m_manifest, m_inPlace);
+	}
 	virtual void OnCancel() override final {}
 
 protected:
 	std::string	m_name;
 	std::string	m_path;
 	bool		m_inPlace;
+	std::string	m_manifest;
+	bool		m_ok;
 };
 
 // ********************************************************************************
@@ -101,7 +120,7 @@ void SetupRenderer()
 	Output("started %d worker threads\n", numThreads);
 }
 
-void RunCompiler(const std::string &modelName, const std::string &filepath, const bool bInPlace)
+bool RunCompiler(Graphics::Renderer *renderer, const std::string &modelName, const std::string &filepath, const bool bInPlace)
 {
 	PROFILE_SCOPED()
 	Profiler::Timer timer;
@@ -112,7 +131,7 @@ void RunCompiler(const std::string &modelName, const std::string &filepath, cons
 	//and then save it into binary
 	std::unique_ptr<SceneGraph::Model> model;
 	try {
-		SceneGraph::Loader ld(s_renderer.get(), true, false);
+		SceneGraph::Loader ld(renderer, true, false);
 		model.reset(ld.LoadModel(modelName));
 		//dump warnings
 		for (std::vector<std::string>::const_iterator it = ld.GetLogMessages().begin();
@@ -120,21 +139,205 @@ void RunCompiler(const std::string &modelName, const std::string &filepath, cons
 		{
 			Output("%s\n", (*it).c_str());
 		}
+		const SceneGraph::Loader::OptimizationStats &stats = ld.GetOptimizationStats();
+		Output("Optimised %u meshes: %u -> %u vertices, %u -> %u triangles, ACMR %.3f -> %.3f, overfetch %.3f -> %.3f, %u detail levels generated\n",
+			stats.meshes, stats.before.vertices, stats.after.vertices, stats.before.triangles, stats.after.triangles,
+			stats.before.acmr, stats.after.acmr, stats.before.overfetch, stats.after.overfetch, stats.generatedLevels);
+		if (stats.compactBuffers > 0) {
+			Output("Compacted %u vertex buffers: %u -> %u bytes, max error position %.4f, normal %.3f degrees, uv %.5f, %u attributes left as floats\n",
+				stats.compactBuffers, stats.floatBytes, stats.compactBytes,
+				stats.maxPositionError, stats.maxNormalError, stats.maxUVError, stats.floatFallbacks);
+		}
 	} catch (...) {
 		//minimal error handling, this is not expected to happen since we got this far.
-		return;
+		return false;
 	}
 
 	try {
 		const std::string DataPath = FileSystem::NormalisePath(filepath.substr(0, filepath.size()-6));
-		SceneGraph::BinaryConverter bc(s_renderer.get());
+		SceneGraph::BinaryConverter bc(renderer);
+		bc.SetCompressed(s_compressed);
 		bc.Save(modelName, DataPath, model.get(), bInPlace);
 	} catch (const CouldNotOpenFileException&) {
+		return false;
 	} catch (const CouldNotWriteToFileException&) {
+		return false;
 	}
 
 	timer.Stop();
 	Output("Compiling \"%s\" took: %lf\n", modelName.c_str(), timer.millicycles());
+	return true;
+}
+
+// ********************************************************************************
+// instance benchmark
+// ********************************************************************************
+// Distinct nodes reachable from the models visited and roughly the memory they
+// hold, not counting the vertex buffers and textures behind them.
+class NodeMemoryVisitor : public SceneGraph::NodeVisitor {
+public:
+	NodeMemoryVisitor() : bytes(0) { }
+
+	virtual void ApplyNode(SceneGraph::Node &n) override { Count(n, sizeof(SceneGraph::Node)); }
+	virtual void ApplyGroup(SceneGraph::Group &g) override { CountGroup(g, sizeof(SceneGraph::Group)); }
+	virtual void ApplyMatrixTransform(SceneGraph::MatrixTransform &m) override { CountGroup(m, sizeof(SceneGraph::MatrixTransform)); }
+	virtual void ApplyLOD(SceneGraph::LOD &l) override { CountGroup(l, sizeof(SceneGraph::LOD) + l.GetNumLevels() * sizeof(float)); }
+	virtual void ApplyStaticGeometry(SceneGraph::StaticGeometry &g) override {
+		Count(g, sizeof(SceneGraph::StaticGeometry) + g.GetNumMeshes() * sizeof(SceneGraph::StaticGeometry::Mesh));
+	}
+	virtual void ApplyLabel(SceneGraph::Label3D &l) override { Count(l, sizeof(SceneGraph::Label3D)); }
+	virtual void ApplyBillboard(SceneGraph::Billboard &b) override { Count(b, sizeof(SceneGraph::Billboard)); }
+	virtual void ApplyThruster(SceneGraph::Thruster &t) override { Count(t, sizeof(SceneGraph::Thruster)); }
+	virtual void ApplyCollisionGeometry(SceneGraph::CollisionGeometry &cg) override {
+		Count(cg, sizeof(SceneGraph::CollisionGeometry) + cg.GetVertices().size() * sizeof(vector3f) + cg.GetIndices().size() * sizeof(Uint32));
+	}
+
+	std::set<const SceneGraph::Node*> nodes;
+	size_t bytes;
+
+private:
+	bool Count(SceneGraph::Node &n, size_t size) {
+		if (!nodes.insert(&n).second)
+			return false;
+		bytes += size;
+		return true;
+	}
+
+	void CountGroup(SceneGraph::Group &g, size_t size) {
+		if (Count(g, size + g.GetNumChildren() * sizeof(SceneGraph::Node*)))
+			g.Traverse(*this);
+	}
+};
+
+// makes instances of a model the way ships are spawned, and reports how long
+// that takes and how much of the node graph they don't share with the model
+void RunInstanceBenchmark(Graphics::Renderer *renderer, const std::string &modelName, const Uint32 count)
+{
+	PROFILE_SCOPED()
+	std::unique_ptr<SceneGraph::Model> model;
+	try {
+		SceneGraph::BinaryConverter bc(renderer);
+		model.reset(bc.Load(modelName));
+	} catch (const SceneGraph::LoadingError &) {
+		try {
+			SceneGraph::Loader ld(renderer, false, false);
+			model.reset(ld.LoadModel(modelName));
+		} catch (const SceneGraph::LoadingError &err) {
+			Output("instances: could not load %s: %s\n", modelName.c_str(), err.what());
+			return;
+		}
+	}
+
+	NodeMemoryVisitor original;
+	model->GetRoot()->Accept(original);
+
+	std::vector<std::unique_ptr<SceneGraph::Model>> instances;
+	instances.reserve(count);
+	const Uint64 start = SDL_GetPerformanceCounter();
+	for (Uint32 i = 0; i < count; i++)
+		instances.emplace_back(model->MakeInstance());
+	const double ms = double(SDL_GetPerformanceCounter() - start) * 1000.0 / double(SDL_GetPerformanceFrequency());
+
+	NodeMemoryVisitor all(original);
+	for (auto &inst : instances)
+		inst->GetRoot()->Accept(all);
+
+	const size_t ownNodes = all.nodes.size() - original.nodes.size();
+	const size_t ownBytes = all.bytes - original.bytes;
+	Output("%s: %u nodes, %u bytes\n", modelName.c_str(), Uint32(original.nodes.size()), Uint32(original.bytes));
+	Output("%u instances in %.3f ms (%.4f ms each)\n", count, ms, count ? ms / count : 0.0);
+	Output("nodes of their own: %u (%.1f each), %u bytes (%.1f each)\n",
+		Uint32(ownNodes), count ? double(ownNodes) / count : 0.0, Uint32(ownBytes), count ? double(ownBytes) / count : 0.0);
+	Output("as full copies: %u nodes, %u bytes\n", Uint32(original.nodes.size() * count), Uint32(original.bytes * count));
+}
+
+// ********************************************************************************
+// incremental builds
+// ********************************************************************************
+// Next to each .sgm is a manifest of what went into it: a hash standing for
+// the loader, then a hash of the contents of every file the loader reads for
+// the model. A model whose manifest comes out the same needn't be compiled.
+static const std::string s_manifestExtension(".manifest");
+
+static std::string GetManifestPath(const std::string &filepath, const bool bInPlace)
+{
+	const std::string DataPath = FileSystem::NormalisePath(filepath.substr(0, filepath.size()-6));
+	return SceneGraph::BinaryConverter::GetSavePath(DataPath, bInPlace) + s_manifestExtension;
+}
+
+static Uint64 HashData(const char *data, size_t size, Uint32 seed = 0)
+{
+	Uint32 hashA = seed, hashB = 0;
+	lookup3_hashlittle2(data, size, &hashA, &hashB);
+	return (Uint64(hashA) << 32) | hashB;
+}
+
+// empty if the .model doesn't parse, which leaves the compiler to complain
+std::string BuildManifest(const std::string &filepath)
+{
+	PROFILE_SCOPED()
+	const std::string dir = filepath.substr(0, filepath.rfind('/'));
+	SceneGraph::ModelDefinition def;
+	try {
+		SceneGraph::Parser p(FileSystem::gameDataFiles, filepath, dir);
+		p.Parse(&def);
+	} catch (SceneGraph::ParseError &) {
+		return "";
+	}
+
+	std::set<std::string> files;
+	files.insert(filepath);
+	for (const auto &lod : def.lodDefs)
+		files.insert(lod.meshNames.begin(), lod.meshNames.end());
+	files.insert(def.collisionDefs.begin(), def.collisionDefs.end());
+	for (const auto &mat : def.matDefs) {
+		for (const std::string *tex : { &mat.tex_diff, &mat.tex_spec, &mat.tex_glow, &mat.tex_ambi, &mat.tex_norm })
+			if (!tex->empty()) files.insert(*tex);
+	}
+	for (FileSystem::FileEnumerator pats(FileSystem::gameDataFiles, dir); !pats.Finished(); pats.Next()) {
+		const FileSystem::FileInfo &info = pats.Current();
+		if (info.IsFile() && starts_with(info.GetName(), "pattern"))
+			files.insert(info.GetPath());
+	}
+
+	const std::string version = stringf("%0 %1 %2 %3 %4", PIONEER_VERSION, PIONEER_EXTRAVERSION,
+		SceneGraph::BinaryConverter::GetVersion(), SceneGraph::Loader::GetRevision(), s_compressed ? "compressed" : "stored");
+	std::string manifest = stringf("loader %0{x}\n", HashData(version.data(), version.size()));
+	for (const std::string &path : files) {
+		RefCountedPtr<FileSystem::FileData> data = FileSystem::gameDataFiles.ReadFile(path);
+		const Uint64 hash = data ? HashData(data->GetData(), data->GetSize()) : 0;
+		manifest += stringf("%0{x} %1\n", hash, path);
+	}
+	return manifest;
+}
+
+static FileSystem::FileSourceFS &GetTargetFiles(const bool bInPlace)
+{
+	static FileSystem::FileSourceFS dataFiles(FileSystem::GetDataDir());
+	return bInPlace ? dataFiles : FileSystem::userFiles;
+}
+
+bool IsUpToDate(const std::string &filepath, const std::string &manifest, const bool bInPlace)
+{
+	if (manifest.empty())
+		return false;
+	FileSystem::FileSourceFS &fs = GetTargetFiles(bInPlace);
+	const std::string manifestPath = GetManifestPath(filepath, bInPlace);
+	if (!fs.Lookup(manifestPath.substr(0, manifestPath.size() - s_manifestExtension.size())).IsFile())
+		return false;
+	RefCountedPtr<FileSystem::FileData> old = fs.ReadFile(manifestPath);
+	return old && old->AsStringRange().ToString() == manifest;
+}
+
+void WriteManifest(const std::string &filepath, const std::string &manifest, const bool bInPlace)
+{
+	FILE *f = GetTargetFiles(bInPlace).OpenWriteStream(GetManifestPath(filepath, bInPlace), FileSystem::FileSourceFS::WRITE_TEXT);
+	if (!f) {
+		Output("could not write the manifest for %s\n", filepath.c_str());
+		return;
+	}
+	fwrite(manifest.data(), manifest.size(), 1, f);
+	fclose(f);
 }
 
 
@@ -144,6 +347,7 @@ void RunCompiler(const std::string &modelName, const std::string &filepath, cons
 enum RunMode {
 	MODE_MODELCOMPILER=0,
 	MODE_MODELBATCHEXPORT,
+	MODE_INSTANCES,
 	MODE_VERSION,
 	MODE_USAGE,
 	MODE_USAGE_ERROR
@@ -176,6 +380,11 @@ int main(int argc, char** argv)
 			goto start;
 		}
 
+		if (modeopt == "instances" || modeopt == "i") {
+			mode = MODE_INSTANCES;
+			goto start;
+		}
+
 		if (modeopt == "version" || modeopt == "v") {
 			mode = MODE_VERSION;
 			goto start;
@@ -232,17 +441,21 @@ start:
 					}
 				}
 				SetupRenderer();
-				RunCompiler(modelName, filePath, isInPlace);
+				RunCompiler(s_renderer.get(), modelName, filePath, isInPlace);
 			}
 			break;
 		}
 
 		case MODE_MODELBATCHEXPORT: {
-			// determine if we're meant to be writing these in the source directory
+			// determine if we're meant to be writing these in the source directory,
+			// and whether models that haven't changed are left alone
 			bool isInPlace = false;
-			if (argc > 2) {
-				std::string arg2 = argv[2];
-				isInPlace = (arg2 == "inplace" || arg2 == "true");
+			bool isIncremental = false;
+			for (int i = 2; i < argc; i++) {
+				const std::string arg = argv[i];
+				isInPlace |= (arg == "inplace" || arg == "true");
+				isIncremental |= (arg == "incremental" || arg == "changed");
+				s_compressed |= (arg == "compressed");
 			}
 
 			// find all of the models
@@ -262,14 +475,18 @@ start:
 			}
 
 			SetupRenderer();
-#if 1
-			for (auto &modelName : list_model) {
-				RunCompiler(modelName.first, modelName.second, isInPlace);
-			}
-#else
+
+			// each model is compiled by a job of its own; manifests are only
+			// written for models that compiled, back on this thread
+			Uint32 numSkipped = 0;
 			std::deque<Job::Handle> handles;
 			for (auto &modelName : list_model) {
-				handles.push_back( asyncJobQueue->Queue(new CompileJob(modelName.first, modelName.second, isInPlace)) );
+				const std::string manifest = BuildManifest(modelName.second);
+				if (isIncremental && IsUpToDate(modelName.second, manifest, isInPlace)) {
+					numSkipped++;
+					continue;
+				}
+				handles.push_back( asyncJobQueue->Queue(new CompileJob(modelName.first, modelName.second, isInPlace, manifest)) );
 			}
 
 			while(true) {
@@ -280,8 +497,18 @@ start:
 
 				if(!hasJobs)
 					break;
+				SDL_Delay(10);
+			}
+			Output("compiled %u models, %u unchanged\n", Uint32(handles.size()), numSkipped);
+			break;
+		}
+
+		case MODE_INSTANCES: {
+			if (argc > 2) {
+				const Uint32 count = argc > 3 ? Uint32(std::max(atoi(argv[3]), 0)) : 500;
+				SetupRenderer();
+				RunInstanceBenchmark(s_renderer.get(), argv[2], count);
 			}
-#endif
 			break;
 		}
 
@@ -304,6 +531,9 @@ start:
 				"    -compile inplace  [-c ... inplace]  model compiler\n"
 				"    -batch            [-b]              batch mode output into users home/Pioneer directory\n"
 				"    -batch inplace    [-b inplace]      batch mode output into the source folder\n"
+				"    -batch ... incremental              only compile models whose files changed since last time\n"
+				"    -batch ... compressed               deflate the output, smaller files that load slower\n"
+				"    -instances model  [-i model [n]]    time making n instances (500) and the memory they use\n"
 				"    -version          [-v]              show version\n"
 				"    -help             [-h,-?]           this help\n"
 			);
@@ -10,6 +10,8 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <unistd.h>
 
 // on unix this is set from configure
@@ -183,6 +185,39 @@ namespace FileSystem {
 		return RefCountedPtr<FileData>(0);
 	}
 
+	class FileDataMapped : public FileData {
+	public:
+		FileDataMapped(const FileInfo &info, size_t size, char *data):
+			FileData(info, size, data) {}
+		virtual ~FileDataMapped() { munmap(m_data, m_size); }
+	};
+
+	RefCountedPtr<FileData> FileSourceFS::MapFile(const std::string &path)
+	{
+		const std::string fullpath = JoinPathBelow(GetRoot(), path);
+		Time::DateTime mtime;
+
+		FileInfo::FileType ty = stat_path(fullpath.c_str(), mtime);
+		if (ty != FileInfo::FT_FILE)
+			return RefCountedPtr<FileData>(0);
+
+		const int fd = open(fullpath.c_str(), O_RDONLY);
+		if (fd < 0)
+			return RefCountedPtr<FileData>(0);
+
+		struct stat st;
+		void *data = MAP_FAILED;
+		// can't map an empty file
+		if (fstat(fd, &st) == 0 && st.st_size > 0)
+			data = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+
+		if (data == MAP_FAILED)
+			return ReadFile(path);
+
+		return RefCountedPtr<FileData>(new FileDataMapped(MakeFileInfo(path, ty, mtime), st.st_size, static_cast<char*>(data)));
+	}
+
 	bool FileSourceFS::ReadDirectory(const std::string &dirpath, std::vector<FileInfo> &output)
 	{
 		const std::string fulldirpath = JoinPathBelow(GetRoot(), dirpath);
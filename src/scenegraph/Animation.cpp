@@ -27,45 +27,47 @@ Animation::Animation(const Animation &anim)
 	}
 }
 
-void Animation::UpdateChannelTargets(Node *root)
+void Animation::UpdateChannelTargets(const TransformMap &copies)
 {
 	for(ChannelList::iterator chan = m_channels.begin(); chan != m_channels.end(); ++chan) {
 		//update channels to point to new node structure
-		MatrixTransform *trans = dynamic_cast<MatrixTransform*>(root->FindNode(chan->node->GetName()));
-		assert(trans);
-		chan->node = trans;
+		TransformMap::const_iterator it = copies.find(chan->node);
+		assert(it != copies.end());
+		chan->node = it->second;
 	}
 }
 
 void Animation::Interpolate()
+{
+	PROFILE_SCOPED()
+	std::vector<matrix4x4f> trans(m_channels.size());
+	if (trans.empty()) return;
+	Evaluate(&trans[0]);
+	Apply(&trans[0]);
+}
+
+void Animation::Evaluate(matrix4x4f *out)
 {
 	PROFILE_SCOPED()
 	const double mtime = m_time;
 
 	//go through channels and calculate transforms
-	for(ChannelIterator chan = m_channels.begin(); chan != m_channels.end(); ++chan) {
-		matrix4x4f trans = chan->node->GetTransform();
+	for(ChannelIterator chan = m_channels.begin(); chan != m_channels.end(); ++chan, ++out) {
+		matrix4x4f &trans = *out;
+		trans = chan->node->GetTransform();
 
 		if (!chan->rotationKeys.empty()) {
-			//find a frame. To optimize, should begin search from previous frame (when mTime > previous mTime)
-			unsigned int frame = 0;
-			while (frame + 1 < chan->rotationKeys.size()) {
-				if (mtime < chan->rotationKeys[frame+1].time)
-					break;
-				frame++;
-			}
-
-			const RotationKey &a = chan->rotationKeys[frame];
-			vector3f saved_position = trans.GetTranslate();
-			if (frame + 1 < chan->rotationKeys.size()) {
-				const RotationKey &b = chan->rotationKeys[frame + 1];
-				double diffTime = b.time - a.time;
-				assert(diffTime > 0.0);
-				const float factor = Clamp(float((mtime - a.time) / diffTime), 0.f, 1.f);
-				trans = Quaternionf::Slerp(a.rotation, b.rotation, factor).ToMatrix3x3<float>();
-			} else {
-				trans = a.rotation.ToMatrix3x3<float>();
-			}
+			const RotationKeys &keys = chan->rotationKeys;
+			const unsigned int frame = keys.Find(mtime, chan->rotationCursor);
+			const float factor = keys.Factor(frame, mtime);
+			const vector3f saved_position = trans.GetTranslate();
+			//no need to slerp at either end of a pair of keys
+			if (factor <= 0.f)
+				trans = keys.values[frame].ToMatrix3x3<float>();
+			else if (factor >= 1.f)
+				trans = keys.values[frame + 1].ToMatrix3x3<float>();
+			else
+				trans = Quaternionf::Slerp(keys.values[frame], keys.values[frame + 1], factor).ToMatrix3x3<float>();
 			trans.SetTranslate(saved_position);
 		}
 
@@ -73,55 +75,33 @@ void Animation::Interpolate()
 		//continously scale the transform (would have to add originalTransform or
 		//something to MT)
 		if (!chan->scaleKeys.empty() && !chan->rotationKeys.empty()) {
-			//find a frame. To optimize, should begin search from previous frame (when mTime > previous mTime)
-			unsigned int frame = 0;
-			while (frame + 1 < chan->scaleKeys.size()) {
-				if (mtime < chan->scaleKeys[frame+1].time)
-					break;
-				frame++;
-			}
-
-			const ScaleKey &a = chan->scaleKeys[frame];
-			vector3f out;
-			if (frame + 1 < chan->scaleKeys.size()) {
-				const ScaleKey &b = chan->scaleKeys[frame + 1];
-				double diffTime = b.time - a.time;
-				assert(diffTime > 0.0);
-				const float factor = Clamp(float((mtime - a.time) / diffTime), 0.f, 1.f);
-				out = a.scale + (b.scale - a.scale) * factor;
-			} else {
-				out = a.scale;
-			}
-			trans.Scale(out.x, out.y, out.z);
+			const ScaleKeys &keys = chan->scaleKeys;
+			const unsigned int frame = keys.Find(mtime, chan->scaleCursor);
+			const float factor = keys.Factor(frame, mtime);
+			vector3f scale = keys.values[frame];
+			if (factor > 0.f)
+				scale += (keys.values[frame + 1] - keys.values[frame]) * factor;
+			trans.Scale(scale.x, scale.y, scale.z);
 		}
 
 		if (!chan->positionKeys.empty()) {
-			//find a frame. To optimize, should begin search from previous frame (when mTime > previous mTime)
-			unsigned int frame = 0;
-			while (frame + 1 < chan->positionKeys.size()) {
-				if (mtime < chan->positionKeys[frame+1].time)
-					break;
-				frame++;
-			}
-
-			const PositionKey &a = chan->positionKeys[frame];
-			vector3f out;
-			if (frame + 1 < chan->positionKeys.size()) {
-				const PositionKey &b = chan->positionKeys[frame + 1];
-				double diffTime = b.time - a.time;
-				assert(diffTime > 0.0);
-				const float factor = Clamp(float((mtime - a.time) / diffTime), 0.f, 1.f);
-				out = a.position + (b.position - a.position) * factor;
-			} else {
-				out = a.position;
-			}
-			trans.SetTranslate(out);
+			const PositionKeys &keys = chan->positionKeys;
+			const unsigned int frame = keys.Find(mtime, chan->positionCursor);
+			const float factor = keys.Factor(frame, mtime);
+			vector3f position = keys.values[frame];
+			if (factor > 0.f)
+				position += (keys.values[frame + 1] - keys.values[frame]) * factor;
+			trans.SetTranslate(position);
 		}
-
-		chan->node->SetTransform(trans);
 	}
 }
 
+void Animation::Apply(const matrix4x4f *in)
+{
+	for(ChannelIterator chan = m_channels.begin(); chan != m_channels.end(); ++chan, ++in)
+		chan->node->SetTransform(*in);
+}
+
 double Animation::GetProgress()
 {
 	return m_time / m_duration;
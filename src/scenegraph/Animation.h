@@ -9,6 +9,7 @@
  * animate the position/rotation of a single MatrixTransform node
  */
 #include "AnimationChannel.h"
+#include <map>
 
 namespace SceneGraph {
 
@@ -16,17 +17,26 @@ class Loader;
 class BinaryConverter;
 class Node;
 
+//the nodes of one model and their copies in an instance of it
+typedef std::map<const MatrixTransform*, MatrixTransform*> TransformMap;
+
 class Animation {
 public:
 	Animation(const std::string &name, double duration);
 	Animation(const Animation&);
-	void UpdateChannelTargets(Node *root);
+	void UpdateChannelTargets(const TransformMap &copies);
 	double GetDuration() const { return m_duration; }
 	const std::string &GetName() const { return m_name; }
 	double GetProgress();
 	void SetProgress(double); //0.0 -- 1.0, overrides m_time
 	void Interpolate(); //update transforms according to m_time;
 	const std::vector<AnimationChannel>& GetChannels() const { return m_channels; }
+	unsigned int GetNumChannels() const { return static_cast<Uint32>(m_channels.size()); }
+
+	//Interpolate in two halves, so a model can sample all its animations into
+	//one array before touching the nodes. Each fills or reads one transform per channel
+	void Evaluate(matrix4x4f *out);
+	void Apply(const matrix4x4f *in);
 
 private:
 	friend class Loader;
@@ -12,11 +12,15 @@ namespace SceneGraph {
 
 class AnimationChannel {
 public:
-	AnimationChannel(MatrixTransform *t) : node(t) { }
-	std::vector<PositionKey> positionKeys;
-	std::vector<RotationKey> rotationKeys;
-	std::vector<ScaleKey> scaleKeys;
+	AnimationChannel(MatrixTransform *t) : node(t), positionCursor(0), rotationCursor(0), scaleCursor(0) { }
+	PositionKeys positionKeys;
+	RotationKeys rotationKeys;
+	ScaleKeys scaleKeys;
 	MatrixTransform *node;
+	//frames found last time, where the next search starts
+	unsigned int positionCursor;
+	unsigned int rotationCursor;
+	unsigned int scaleCursor;
 };
 
 }
@@ -4,40 +4,57 @@
 #ifndef _SCENEGRAPH_ANIMATIONKEY_H
 #define _SCENEGRAPH_ANIMATIONKEY_H
 
+#include "libs.h"
 #include "vector3.h"
 #include "Quaternion.h"
+#include <algorithm>
+#include <vector>
 
 namespace SceneGraph {
 
-struct AnimationKey {
-	double time;
-
-	AnimationKey(double t) : time(t) { }
+// Keyframes of one property, times ascending. Times and values are kept
+// apart so finding a frame only touches the times
+template <typename T>
+struct AnimationKeys {
+	std::vector<double> times;
+	std::vector<T> values;
+
+	void Add(double time, const T &value) {
+		times.push_back(time);
+		values.push_back(value);
+	}
+
+	bool empty() const { return times.empty(); }
+	size_t size() const { return times.size(); }
+
+	// the last key at or before time (or the first key), starting from the
+	// one found last: animations mostly move forwards a little at a time
+	unsigned int Find(double time, unsigned int &cursor) const {
+		const unsigned int count = static_cast<unsigned int>(times.size());
+		unsigned int frame = std::min(cursor, count - 1);
+		if (time < times[frame]) {
+			frame = static_cast<unsigned int>(std::upper_bound(times.begin(), times.begin() + frame, time) - times.begin());
+			frame = frame > 0 ? frame - 1 : 0;
+		} else if (frame + 1 < count && time >= times[frame + 1]) {
+			frame = static_cast<unsigned int>(std::upper_bound(times.begin() + frame + 1, times.end(), time) - times.begin()) - 1;
+		}
+		cursor = frame;
+		return frame;
+	}
+
+	// how far time is from key frame to the next, 0 at the last key
+	float Factor(unsigned int frame, double time) const {
+		if (frame + 1 >= times.size())
+			return 0.f;
+		const double diffTime = times[frame + 1] - times[frame];
+		assert(diffTime > 0.0);
+		return Clamp(float((time - times[frame]) / diffTime), 0.f, 1.f);
+	}
 };
 
-struct PositionKey : public AnimationKey {
-	vector3f position;
-
-	PositionKey(double t, const vector3f &pos)
-	: AnimationKey(t)
-	, position(pos) { }
-};
-
-struct RotationKey : public AnimationKey {
-	Quaternionf rotation;
-
-	RotationKey(double t, const Quaternionf &q)
-	: AnimationKey(t)
-	, rotation(q) { }
-};
-
-struct ScaleKey : public AnimationKey {
-	vector3f scale;
-
-	ScaleKey(double t, const vector3f &s)
-	: AnimationKey(t)
-	, scale(s) { }
-};
+typedef AnimationKeys<vector3f> PositionKeys;
+typedef AnimationKeys<Quaternionf> RotationKeys;
+typedef AnimationKeys<vector3f> ScaleKeys;
 
 }
 
@@ -54,19 +54,19 @@ void BaseLoader::ConvertMaterialDefinition(const MaterialDefinition &mdef)
 		mat->diffuse.a = (float(mdef.opacity) / 100.f) * 255;
 
 	if (!diffTex.empty())
-		mat->texture0 = Graphics::TextureBuilder::Model(diffTex).GetOrCreateTexture(m_renderer, "model");
+		mat->texture0 = Graphics::TextureBuilder::Model(diffTex).Streamed(Color::GRAY).GetOrCreateTexture(m_renderer, "model");
 	else
 		mat->texture0 = Graphics::TextureBuilder::GetWhiteTexture(m_renderer);
 	if (!specTex.empty())
-		mat->texture1 = Graphics::TextureBuilder::Model(specTex).GetOrCreateTexture(m_renderer, "model");
+		mat->texture1 = Graphics::TextureBuilder::Model(specTex).Streamed(Color::BLACK).GetOrCreateTexture(m_renderer, "model");
 	if (!glowTex.empty())
-		mat->texture2 = Graphics::TextureBuilder::Model(glowTex).GetOrCreateTexture(m_renderer, "model");
+		mat->texture2 = Graphics::TextureBuilder::Model(glowTex).Streamed(Color::BLACK).GetOrCreateTexture(m_renderer, "model");
 	if (!ambiTex.empty())
-		mat->texture3 = Graphics::TextureBuilder::Model(ambiTex).GetOrCreateTexture(m_renderer, "model");
+		mat->texture3 = Graphics::TextureBuilder::Model(ambiTex).Streamed(Color::WHITE).GetOrCreateTexture(m_renderer, "model");
 	//texture4 is reserved for pattern
 	//texture5 is reserved for color gradient
 	if (!normTex.empty())
-		mat->texture6 = Graphics::TextureBuilder::Normal(normTex).GetOrCreateTexture(m_renderer, "model");
+		mat->texture6 = Graphics::TextureBuilder::Normal(normTex).Streamed(Color(128, 128, 255, 255)).GetOrCreateTexture(m_renderer, "model");
 
 
 	m_model->m_materials.push_back(std::make_pair(mdef.name, mat));
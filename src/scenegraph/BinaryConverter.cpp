@@ -21,7 +21,11 @@ using namespace SceneGraph;
 // 4: compressed SGM files and instancing support
 // 5: normal mapping
 // 6: 32-bit indicies
-const Uint32 SGM_VERSION = 6;
+// 7: uncompressed header, optionally compressed body, vertices and indices in aligned blocks
+// 8: collision mesh ahead of the nodes
+// 9: vertex attribute formats, for compact vertices
+// 10: navlight transforms flagged as per instance nodes
+const Uint32 SGM_VERSION = 10;
 union SGM_STRING_VALUE{
 	char name[4];
 	Uint32 value;
@@ -30,6 +34,13 @@ const SGM_STRING_VALUE SGM_STRING_ID = { {'s', 'g', 'm', SGM_VERSION} };
 const std::string SGM_EXTENSION = ".sgm";
 const std::string SAVE_TARGET_DIR = "binarymodels";
 
+// the header is signature, version, flags and the size of the body, which
+// starts 16 bytes in. Stored bodies are used straight from the mapped file
+enum SGMFlags {
+	SGM_COMPRESSED = 1 << 0, // deflated, the body has to be inflated to memory first
+};
+const Uint32 SGM_HEADER_SIZE = 16;
+
 class SaveHelperVisitor : public NodeVisitor
 {
 public:
@@ -58,6 +69,7 @@ public:
 BinaryConverter::BinaryConverter(Graphics::Renderer *r)
 	: BaseLoader(r)
 	, m_patternsUsed(false)
+	, m_compressed(false)
 {
 	//register core loaders
 	RegisterLoader("Group", &Group::Load);
@@ -81,6 +93,18 @@ void BinaryConverter::Save(const std::string& filename, Model* m)
 	Save(filename, s_EmptyString, m, false);
 }
 
+std::string BinaryConverter::GetSavePath(const std::string &savepath, const bool bInPlace)
+{
+	if (bInPlace)
+		return savepath + SGM_EXTENSION;
+	return FileSystem::JoinPathBelow(SAVE_TARGET_DIR, savepath + SGM_EXTENSION);
+}
+
+Uint32 BinaryConverter::GetVersion()
+{
+	return SGM_VERSION;
+}
+
 void BinaryConverter::Save(const std::string& filename, const std::string& savepath, Model* m, const bool bInPlace)
 {
 	PROFILE_SCOPED()
@@ -101,31 +125,27 @@ void BinaryConverter::Save(const std::string& filename, const std::string& savep
 			printf("Made directory (%s)\n", FileSystem::JoinPathBelow(SAVE_TARGET_DIR,newpath).c_str());
 		}
 
-		f = FileSystem::userFiles.OpenWriteStream(
-			FileSystem::JoinPathBelow(SAVE_TARGET_DIR, savepath + SGM_EXTENSION));
-		printf("Save file (%s)\n", FileSystem::JoinPathBelow(SAVE_TARGET_DIR, savepath + SGM_EXTENSION).c_str());
+		f = FileSystem::userFiles.OpenWriteStream(GetSavePath(savepath, bInPlace));
+		printf("Save file (%s)\n", GetSavePath(savepath, bInPlace).c_str());
 		if (!f) throw CouldNotOpenFileException();
 	} else {
-		f = newFS.OpenWriteStream(savepath + SGM_EXTENSION);
+		f = newFS.OpenWriteStream(GetSavePath(savepath, bInPlace));
 		if (!f) throw CouldNotOpenFileException();
 	}
 
 	Serializer::Writer wr;
 
-	wr.Int32(SGM_STRING_ID.value);
-
-	wr.Int32(SGM_VERSION);
-
 	wr.String(m->GetName().c_str());
 
+	//first, so it can be loaded without the renderer
+	m->GetCollisionMesh()->Save(wr);
+	wr.Float(m->GetDrawClipRadius());
+
 	SaveMaterials(wr, m);
 
 	SaveHelperVisitor sv(&wr, m);
 	m->GetRoot()->Accept(sv);
 
-	m->GetCollisionMesh()->Save(wr);
-	wr.Float(m->GetDrawClipRadius());
-
 	SaveAnimations(wr, m);
 
 	//save tags
@@ -133,18 +153,28 @@ void BinaryConverter::Save(const std::string& filename, const std::string& savep
 	for (unsigned int i = 0; i < m->GetNumTags(); i++)
 		wr.String(m->GetTagByIndex(i)->GetName().c_str());
 
-	// compress in memory, write to open file
-	size_t outSize = 0;
-	size_t nwritten = 0;
 	const std::string& data = wr.GetData();
-	void *pCompressedData = tdefl_compress_mem_to_heap(data.data(), data.length(), &outSize, 128);
-	if (pCompressedData) {
-		nwritten = fwrite(pCompressedData, outSize, 1, f);
-		mz_free(pCompressedData);
-	}
+	Serializer::Writer header;
+	header.Int32(SGM_STRING_ID.value);
+	header.Int32(SGM_VERSION);
+	header.Int32(m_compressed ? SGM_COMPRESSED : 0);
+	header.Int32(data.length());
+	assert(header.GetData().length() == SGM_HEADER_SIZE);
+
+	size_t nwritten = fwrite(header.GetData().data(), SGM_HEADER_SIZE, 1, f);
+	if (m_compressed) {
+		// compress in memory, write to open file
+		size_t outSize = 0;
+		void *pCompressedData = tdefl_compress_mem_to_heap(data.data(), data.length(), &outSize, 128);
+		if (pCompressedData) {
+			nwritten += fwrite(pCompressedData, outSize, 1, f);
+			mz_free(pCompressedData);
+		}
+	} else
+		nwritten += fwrite(data.data(), data.length(), 1, f);
 	fclose(f);
 
-	if (nwritten != 1) throw CouldNotWriteToFileException();
+	if (nwritten != 2) throw CouldNotWriteToFileException();
 }
 
 Model *BinaryConverter::Load(const std::string &filename)
@@ -155,6 +185,15 @@ Model *BinaryConverter::Load(const std::string &filename)
 }
 
 Model *BinaryConverter::Load(const std::string &shortname, const std::string &basepath)
+{
+	PROFILE_SCOPED()
+	std::unique_ptr<PreparedModel> prepared(Prepare(shortname, basepath));
+	if (!prepared)
+		throw (LoadingError("File not found"));
+	return Load(*prepared);
+}
+
+PreparedModel *BinaryConverter::Prepare(const std::string &shortname, const std::string &basepath)
 {
 	PROFILE_SCOPED()
 	FileSystem::FileSource &fileSource = FileSystem::gameDataFiles;
@@ -168,55 +207,105 @@ Model *BinaryConverter::Load(const std::string &shortname, const std::string &ba
 			const std::string name = info.GetName();
 
 			if (shortname == name.substr(0, name.length() - SGM_EXTENSION.length())) {
-				//curPath is used to find textures, patterns,
+				RefCountedPtr<FileSystem::FileData> binfile = info.Map();
+				if (!binfile.Valid())
+					continue;
+
+				PreparedModel *prepared = new PreparedModel();
+				prepared->m_name = name;
+				//the dir is used to find textures, patterns,
 				//possibly other data files for this model.
 				//Strip trailing slash
-				m_curPath = info.GetDir();
-				if (m_curPath[m_curPath.length()-1] == '/')
-					m_curPath = m_curPath.substr(0, m_curPath.length()-1);
-
-				RefCountedPtr<FileSystem::FileData> binfile = info.Read();
-				if (binfile.Valid()) {
-					Model* model(nullptr);
-					size_t outSize(0);
-					// decompress the loaded ByteRange in memory
-					const ByteRange bin = binfile->AsByteRange();
-					void *pDecompressedData = tinfl_decompress_mem_to_heap(&bin[0], bin.Size(), &outSize, 0);
-					if (pDecompressedData) {
-						// now parse in-memory representation as new ByteRange.
-						Serializer::Reader rd(ByteRange(static_cast<char*>(pDecompressedData), outSize));
-						model = CreateModel(name, rd);
-						mz_free(pDecompressedData);
-					}
-					return model;
-				}
+				prepared->m_dir = info.GetDir();
+				if (prepared->m_dir[prepared->m_dir.length()-1] == '/')
+					prepared->m_dir = prepared->m_dir.substr(0, prepared->m_dir.length()-1);
+				prepared->m_file = binfile;
+				PrepareBody(*prepared);
+				return prepared;
 			}
 		}
 	}
 
-	throw (LoadingError("File not found"));
 	return nullptr;
 }
 
-Model *BinaryConverter::CreateModel(const std::string& filename, Serializer::Reader &rd)
+void BinaryConverter::PrepareBody(PreparedModel &prepared)
 {
 	PROFILE_SCOPED()
+	const ByteRange bin = prepared.m_file->AsByteRange();
+	if (bin.Size() < SGM_HEADER_SIZE) {
+		prepared.m_error = "SGM file is truncated";
+		return;
+	}
+
+	Serializer::Reader header(ByteRange(bin.begin, bin.begin + SGM_HEADER_SIZE));
 	//verify signature
-	const Uint32 sig = rd.Int32();
+	const Uint32 sig = header.Int32();
 	if (sig != SGM_STRING_ID.value) { //'SGM#'
-		Warning("Error whilst loading %s\nSGM versioning (%u) did not match the supported SGM STRING ID (%u)\nSGM file will be ignored\n", filename.c_str(), sig, SGM_STRING_ID.value);
-		return nullptr;
+		prepared.m_error = stringf("SGM versioning (%0) did not match the supported SGM STRING ID (%1)", sig, SGM_STRING_ID.value);
+		return;
 	}
 
-	const Uint32 version = rd.Int32();
+	const Uint32 version = header.Int32();
 	if (version != SGM_VERSION) {
-		Warning("Error whilst loading %s\nSGM versioning (%u) did not match the supported SGM_VERSION (%u)\nSGM file will be ignored\n", filename.c_str(), version, SGM_VERSION);
+		prepared.m_error = stringf("SGM versioning (%0) did not match the supported SGM_VERSION (%1)", version, SGM_VERSION);
+		return;
+	}
+
+	const Uint32 flags = header.Int32();
+	const Uint32 size = header.Int32();
+	const ByteRange body(bin.begin + SGM_HEADER_SIZE, bin.end);
+	if (!(flags & SGM_COMPRESSED)) {
+		if (body.Size() != size) {
+			prepared.m_error = "SGM file is truncated";
+			return;
+		}
+		prepared.m_reader = Serializer::Reader(body);
+	} else {
+		// the size is known, so inflate in one go into a buffer that is only as big as it has to be
+		prepared.m_inflated.reset(static_cast<char*>(std::malloc(size)));
+		if (tinfl_decompress_mem_to_mem(prepared.m_inflated.get(), size, body.begin, body.Size(), 0) != size) {
+			prepared.m_error = "SGM file could not be decompressed";
+			return;
+		}
+		prepared.m_reader = Serializer::Reader(ByteRange(prepared.m_inflated.get(), prepared.m_inflated.get() + size));
+		// nothing points into the file any more
+		prepared.m_file.Reset();
+	}
+
+	// this runs on job threads, so a bad file must not throw out of here
+	try {
+		Serializer::Reader &rd = prepared.m_reader;
+		prepared.m_modelName = rd.String();
+
+		RefCountedPtr<CollMesh> collMesh(new CollMesh());
+		collMesh->Load(rd);
+		prepared.m_drawClipRadius = rd.Float();
+		prepared.m_collMesh = collMesh;
+	} catch (const SavedGameCorruptException &) {
+		prepared.m_error = "SGM file is corrupt";
+	}
+}
+
+Model *BinaryConverter::Load(PreparedModel &prepared)
+{
+	PROFILE_SCOPED()
+	if (!prepared.m_error.empty()) {
+		Warning("Error whilst loading %s\n%s\nSGM file will be ignored\n", prepared.m_name.c_str(), prepared.m_error.c_str());
 		return nullptr;
 	}
 
-	const std::string modelName = rd.String();
+	m_curPath = prepared.m_dir;
 
-	m_model = new Model(m_renderer, modelName);
+	Serializer::Reader rd(prepared.m_reader);
+
+	m_model = new Model(m_renderer, prepared.m_modelName);
+	m_model->SetCollisionMesh(prepared.m_collMesh);
+#ifdef PIONEER_PROFILER
+	Output("Collision mesh for %s: %u triangles, %d edges, loaded in %.2f ms\n", prepared.m_modelName.c_str(),
+		prepared.m_collMesh->GetNumTriangles(), prepared.m_collMesh->GetGeomTree()->GetNumEdges(), prepared.m_collMesh->GetBuildTime());
+#endif
+	m_model->SetDrawClipRadius(prepared.m_drawClipRadius);
 
 	m_patternsUsed = false;
 	LoadMaterials(rd);
@@ -225,11 +314,6 @@ Model *BinaryConverter::CreateModel(const std::string& filename, Serializer::Rea
 	if (!root) throw LoadingError("Expected root");
 	m_model->m_root.Reset(root);
 
-	RefCountedPtr<CollMesh> collMesh(new CollMesh());
-	collMesh->Load(rd);
-	m_model->SetCollisionMesh(collMesh);
-	m_model->SetDrawClipRadius(rd.Float());
-
 	LoadAnimations(rd);
 
 	m_model->UpdateAnimations();
@@ -307,19 +391,19 @@ void BinaryConverter::SaveAnimations(Serializer::Writer &wr, Model *m)
 			wr.String(chan.node->GetName());
 			//write pos/rot/scale keys
 			wr.Int32(chan.positionKeys.size());
-			for (const auto &pkey : chan.positionKeys) {
-				wr.Double(pkey.time);
-				wr.Vector3f(pkey.position);
+			for (size_t k = 0; k < chan.positionKeys.size(); k++) {
+				wr.Double(chan.positionKeys.times[k]);
+				wr.Vector3f(chan.positionKeys.values[k]);
 			}
 			wr.Int32(chan.rotationKeys.size());
-			for (const auto &rkey : chan.rotationKeys) {
-				wr.Double(rkey.time);
-				wr.WrQuaternionf(rkey.rotation);
+			for (size_t k = 0; k < chan.rotationKeys.size(); k++) {
+				wr.Double(chan.rotationKeys.times[k]);
+				wr.WrQuaternionf(chan.rotationKeys.values[k]);
 			}
 			wr.Int32(chan.scaleKeys.size());
-			for (const auto &skey : chan.scaleKeys) {
-				wr.Double(skey.time);
-				wr.Vector3f(skey.scale);
+			for (size_t k = 0; k < chan.scaleKeys.size(); k++) {
+				wr.Double(chan.scaleKeys.times[k]);
+				wr.Vector3f(chan.scaleKeys.values[k]);
 			}
 		}
 	}
@@ -343,17 +427,17 @@ void BinaryConverter::LoadAnimations(Serializer::Reader &rd)
 			for (Uint32 numKeys = rd.Int32(); numKeys > 0; numKeys--) {
 				const double ktime = rd.Double();
 				const vector3f kpos = rd.Vector3f();
-				chan.positionKeys.push_back(PositionKey(ktime, kpos));
+				chan.positionKeys.Add(ktime, kpos);
 			}
 			for (Uint32 numKeys = rd.Int32(); numKeys > 0; numKeys--) {
 				const double ktime = rd.Double();
 				const Quaternionf krot = rd.RdQuaternionf();
-				chan.rotationKeys.push_back(RotationKey(ktime, krot));
+				chan.rotationKeys.Add(ktime, krot);
 			}
 			for (Uint32 numKeys = rd.Int32(); numKeys > 0; numKeys--) {
 				const double ktime = rd.Double();
 				const vector3f kscale = rd.Vector3f();
-				chan.scaleKeys.push_back(ScaleKey(ktime, kscale));
+				chan.scaleKeys.Add(ktime, kscale);
 			}
 		}
 		m_model->m_animations.push_back(anim);
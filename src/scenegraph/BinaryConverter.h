@@ -17,10 +17,33 @@
 #include "CollisionGeometry.h"
 #include "Thruster.h"
 #include "Billboard.h"
+#include "CollMesh.h"
+#include "FileSystem.h"
+#include "Serializer.h"
 #include <functional>
 
 namespace SceneGraph
 {
+//what BinaryConverter::Prepare does without a renderer, kept for Load to finish
+class PreparedModel
+{
+public:
+	PreparedModel() : m_drawClipRadius(0.f) {}
+	const std::string &GetError() const { return m_error; }
+
+private:
+	friend class BinaryConverter;
+	std::string m_name;   //file name
+	std::string m_dir;    //for textures and patterns, no trailing slash
+	std::string m_modelName;
+	std::string m_error;  //why the file can't be used, warned about by Load
+	RefCountedPtr<FileSystem::FileData> m_file;
+	std::unique_ptr<char, FreeDeleter> m_inflated; //the body, if it was compressed
+	Serializer::Reader m_reader; //at the materials
+	RefCountedPtr<CollMesh> m_collMesh;
+	float m_drawClipRadius;
+};
+
 class BinaryConverter : public BaseLoader
 {
 public:
@@ -30,12 +53,27 @@ public:
 	Model *Load(const std::string &filename);
 	Model *Load(const std::string &filename, const std::string &path);
 
+	//finds, maps and checks the file and loads the collision mesh, which
+	//needs no renderer so can run on a job thread. Null if there is no file
+	static PreparedModel *Prepare(const std::string &shortname, const std::string &basepath = "models");
+	//the rest, on the main thread
+	Model *Load(PreparedModel &prepared);
+
+	//where Save puts the .sgm for savepath: relative to the data directory
+	//when in place, to the user directory otherwise
+	static std::string GetSavePath(const std::string &savepath, const bool bInPlace);
+	static Uint32 GetVersion();
+
+	//deflate the body of saved files: smaller, but they can't be used in
+	//place when loading. Off by default
+	void SetCompressed(bool compressed) { m_compressed = compressed; }
+
 	//if you implement any new node types, you must also register a loader function
 	//before calling Load.
 	void RegisterLoader(const std::string &typeName, std::function<Node*(NodeDatabase&)>);
 
 private:
-	Model *CreateModel(const std::string& filename, Serializer::Reader&);
+	static void PrepareBody(PreparedModel &prepared);
 	void SaveMaterials(Serializer::Writer&, Model* m);
 	void LoadMaterials(Serializer::Reader&);
 	void SaveAnimations(Serializer::Writer&, Model* m);
@@ -48,6 +86,7 @@ private:
 	static Label3D *LoadLabel3D(NodeDatabase&);
 
 	bool m_patternsUsed;
+	bool m_compressed;
 	std::map<std::string, std::function<Node*(NodeDatabase&)> > m_loaders;
 };
 }
@@ -7,6 +7,7 @@
 #include "Group.h"
 #include "MatrixTransform.h"
 #include "StaticGeometry.h"
+#include "collider/BuildTasks.h"
 
 namespace SceneGraph {
 CollisionVisitor::CollisionVisitor()
@@ -76,35 +77,19 @@ void CollisionVisitor::ApplyCollisionGeometry(CollisionGeometry &cg)
 void CollisionVisitor::ApplyDynamicCollisionGeometry(CollisionGeometry &cg)
 {
 	PROFILE_SCOPED()
-	//don't transform geometry, one geomtree per cg, create tree right away
-
-	const int numVertices = cg.GetVertices().size();
-	const int numIndices = cg.GetIndices().size();
-	const int numTris = numIndices / 3;
-	std::vector<vector3f> vertices(numVertices);
-	Uint32 *indices = new Uint32[numIndices];
-	unsigned int *triFlags = new unsigned int[numTris];
-
-	for (int i = 0; i < numVertices; i++)
-		vertices[i] = cg.GetVertices()[i];
-
-	for (int i = 0; i < numIndices; i++)
-		indices[i] = cg.GetIndices()[i];
-
-	for (int i = 0; i < numTris; i++)
-		triFlags[i] = cg.GetTriFlag();
-
-	//create geomtree
-	//takes ownership of data
-	GeomTree *gt = new GeomTree(
-		numVertices, numTris,
-		vertices,
-		indices, triFlags);
-	cg.SetGeomTree(gt);
-
-	m_collMesh->AddDynGeomTree(gt);
+	//don't transform geometry, one geomtree per cg, built along with the static one
+	m_dynamicGeoms.push_back(&cg);
+	m_totalTris += cg.GetIndices().size() / 3;
+}
 
-	m_totalTris += numTris;
+static GeomTree *CreateDynamicGeomTree(const CollisionGeometry &cg)
+{
+	PROFILE_SCOPED()
+	const std::vector<Uint32> triFlags(cg.GetIndices().size() / 3, cg.GetTriFlag());
+	return new GeomTree(
+		cg.GetVertices().size(), triFlags.size(),
+		cg.GetVertices(),
+		cg.GetIndices().data(), triFlags.data());
 }
 
 void CollisionVisitor::AabbToMesh(const Aabb &bb)
@@ -172,8 +157,6 @@ void CollisionVisitor::AabbToMesh(const Aabb &bb)
 RefCountedPtr<CollMesh> CollisionVisitor::CreateCollisionMesh()
 {
 	PROFILE_SCOPED()
-	Profiler::Timer timer;
-	timer.Start();
 
 	//convert from model AABB if no collisiongeoms found
 	if (!m_properData)
@@ -182,41 +165,37 @@ RefCountedPtr<CollMesh> CollisionVisitor::CreateCollisionMesh()
 	assert(m_collMesh->GetGeomTree() == 0);
 	assert(!m_vertices.empty() && !m_indices.empty());
 
-	//duplicate data again for geomtree...
-	const size_t numVertices = m_vertices.size();
-	const size_t numIndices = m_indices.size();
-	const size_t numTris = numIndices / 3;
-	std::vector<vector3f> vertices(numVertices);
-	Uint32 *indices = new Uint32[numIndices];
-	Uint32 *triFlags = new Uint32[numTris];
-
-	m_totalTris += numTris;
-
-	for (size_t i = 0; i < numVertices; i++)
-		vertices[i] = m_vertices[i];
-
-	for (size_t i = 0; i < numIndices; i++)
-		indices[i] = m_indices[i];
-
-	for (size_t i = 0; i < numTris; i++)
-		triFlags[i] = m_flags[i];
+	//the dynamic geometry's trees are built on another thread while the
+	//static one is built here (each of them being parallel inside, if big)
+	std::vector<GeomTree*> dynTrees(m_dynamicGeoms.size());
+	BuildTasks tasks(!m_dynamicGeoms.empty());
+	tasks.Run([this, &dynTrees]() {
+		for (size_t i = 0; i < m_dynamicGeoms.size(); i++)
+			dynTrees[i] = CreateDynamicGeomTree(*m_dynamicGeoms[i]);
+	});
 
 	//create geomtree
-	//takes ownership of data
+	//it copies the data
+	const size_t numTris = m_indices.size() / 3;
+	m_totalTris += numTris;
 	GeomTree *gt = new GeomTree(
-		numVertices, numTris,
-		vertices,
-		indices, triFlags);
+		m_vertices.size(), numTris,
+		m_vertices,
+		m_indices.data(), m_flags.data());
+	tasks.Wait();
+
 	m_collMesh->SetGeomTree(gt);
+	for (size_t i = 0; i < m_dynamicGeoms.size(); i++) {
+		m_dynamicGeoms[i]->SetGeomTree(dynTrees[i]);
+		m_collMesh->AddDynGeomTree(dynTrees[i]);
+	}
 	m_collMesh->SetNumTriangles(m_totalTris);
 	m_boundingRadius = m_collMesh->GetAabb().GetRadius();
 
 	m_vertices.clear();
 	m_indices.clear();
 	m_flags.clear();
-
-	timer.Stop();
-	//Output(" - CreateCollisionMesh took: %lf milliseconds\n", timer.millicycles());
+	m_dynamicGeoms.clear();
 
 	return m_collMesh;
 }
@@ -42,6 +42,9 @@ private:
 	std::vector<Uint32> m_indices;
 	std::vector<Uint32> m_flags;
 
+	//dynamic geometry, each getting a geomtree of its own
+	std::vector<CollisionGeometry*> m_dynamicGeoms;
+
 	Uint32 m_totalTris;
 };
 }
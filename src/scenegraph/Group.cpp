@@ -11,6 +11,7 @@ namespace SceneGraph {
 
 Group::Group(Graphics::Renderer *r)
 : Node(r, NODE_SOLID | NODE_TRANSPARENT)
+, m_structureChanges(0)
 {
 }
 
@@ -24,6 +25,7 @@ Group::~Group()
 
 Group::Group(const Group &group, NodeCopyCache *cache)
 : Node(group, cache)
+, m_structureChanges(0)
 {
 	for(std::vector<Node*>::const_iterator itr = group.m_children.begin();
 		itr != group.m_children.end();
@@ -55,6 +57,7 @@ void Group::AddChild(Node *child)
 {
 	child->IncRefCount();
 	m_children.push_back(child);
+	m_structureChanges++;
 }
 
 bool Group::RemoveChild(Node *node)
@@ -67,6 +70,7 @@ bool Group::RemoveChild(Node *node)
 		if((*itr) == node) {
 			itr = m_children.erase(itr);
 			node->DecRefCount();
+			m_structureChanges++;
 			return true;
 		}
 	}
@@ -79,6 +83,7 @@ bool Group::RemoveChildAt(unsigned int idx)
 	Node *node = m_children.at(idx);
 	node->DecRefCount();
 	m_children.erase(m_children.begin() + idx);
+	m_structureChanges++;
 	return true;
 }
 
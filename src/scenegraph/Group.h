@@ -30,11 +30,18 @@ public:
 	virtual void Render(const std::vector<matrix4x4f> &trans, const RenderData *rd) override;
 	virtual Node* FindNode(const std::string &) override;
 
+	// bumped whenever a child is added to or removed from this group, so
+	// anything flattening a tree (Model's render list) knows to look again
+	Uint32 GetStructureChanges() const { return m_structureChanges; }
+
 protected:
 	virtual ~Group();
 	virtual void RenderChildren(const matrix4x4f &trans, const RenderData *rd);
 	virtual void RenderChildren(const std::vector<matrix4x4f> &trans, const RenderData *rd);
 	std::vector<Node *> m_children;
+
+private:
+	Uint32 m_structureChanges;
 };
 
 }
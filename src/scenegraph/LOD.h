@@ -20,6 +20,9 @@ public:
 	virtual void Render(const matrix4x4f &trans, const RenderData *rd) override;
 	virtual void Render(const std::vector<matrix4x4f> &trans, const RenderData *rd) override;
 	void AddLevel(float pixelRadius, Node *child);
+	unsigned int GetNumLevels() const { return static_cast<Uint32>(m_pixelSizes.size()); }
+	// the level to draw at a view space transform, there must be one
+	unsigned int SelectLevel(const matrix4x4f &trans, float boundingRadius) const;
 	virtual void Save(NodeDatabase&) override;
 	static LOD* Load(NodeDatabase&);
 
@@ -5,6 +5,7 @@
 #include "CollisionGeometry.h"
 #include "FileSystem.h"
 #include "LOD.h"
+#include "MeshOptimizer.h"
 #include "Parser.h"
 #include "SceneGraph.h"
 #include "BinaryConverter.h"
@@ -19,6 +20,7 @@
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 #include <assimp/material.h>
+#include <set>
 
 namespace {
 	class AssimpFileReadStream : public Assimp::IOStream
@@ -114,12 +116,26 @@ namespace {
 } // anonymous namespace
 
 namespace SceneGraph {
+// bump whenever the same source files load into a different model, so
+// incremental model compiles don't keep .sgm files made by older code
+// 1: the first revision with incremental compiles
+// 2: meshes optimised, detail levels generated for single level models
+static const Uint32 LOADER_REVISION = 2;
+
 Loader::Loader(Graphics::Renderer *r, bool logWarnings, bool loadSGMfiles)
 : BaseLoader(r)
 , m_doLog(logWarnings)
 , m_loadSGMs(loadSGMfiles)
 , m_mostDetailedLod(false)
+, m_generateLods(false)
+, m_curVertexFormat(MESH_VERTICES_FLOAT)
+, m_optimizationStats()
+{
+}
+
+Uint32 Loader::GetRevision()
 {
+	return LOADER_REVISION;
 }
 
 Model *Loader::LoadModel(const std::string &filename)
@@ -210,6 +226,8 @@ Model *Loader::CreateModel(ModelDefinition &def)
 	Model *model = new Model(m_renderer, def.name);
 	m_model = model;
 	bool patternsUsed = false;
+	m_optimizationStats = OptimizationStats();
+	m_generateLods = (def.lodDefs.size() == 1);
 
 	m_thrustersRoot.Reset(new Group(m_renderer));
 	m_billboardsRoot.Reset(new Group(m_renderer));
@@ -247,13 +265,14 @@ Model *Loader::CreateModel(ModelDefinition &def)
 			it != (*lod).meshNames.end(); ++it)
 		{
 			try {
-				//multiple lods might use the same mesh
+				//multiple lods might use the same mesh, in the format it was first loaded in
 				RefCountedPtr<Node> mesh;
 				std::map<std::string, RefCountedPtr<Node> >::iterator cacheIt = meshCache.find((*it));
 				if (cacheIt != meshCache.end())
 					mesh = (*cacheIt).second;
 				else {
 					try {
+						m_curVertexFormat = (*lod).meshFormats.at(it - (*lod).meshNames.begin());
 						mesh = LoadMesh(*it, def.animDefs);
 					} catch (LoadingError &err) {
 						//append filename - easiest to do here
@@ -303,7 +322,6 @@ Model *Loader::CreateModel(ModelDefinition &def)
 
 	// Run CollisionVisitor to create the initial CM and its GeomTree.
 	// If no collision mesh is defined, a simple bounding box will be generated
-	Output("CreateCollisionMesh for : (%s)\n", m_model->m_name.c_str());
 	m_model->CreateCollisionMesh();
 
 	// Do an initial animation update to get all the animation transforms correct
@@ -355,6 +373,7 @@ RefCountedPtr<Node> Loader::LoadMesh(const std::string &filename, const AnimList
 	//turn all scene aiMeshes into Surfaces
 	//Index matches assimp index.
 	std::vector<RefCountedPtr<StaticGeometry> > geoms;
+	m_generatedLods.clear();
 	ConvertAiMeshes(geoms, scene);
 
 	// Recursive structure conversion. Matrix needs to be accumulated for
@@ -440,6 +459,190 @@ struct ModelTangentVtx {
 };
 #pragma pack(pop)
 
+// detail levels made for the meshes of models that only have one: the share
+// of the triangles kept, and the size in pixels the model is drawn at below
+// which the level is used
+struct GeneratedLod {
+	float ratio;
+	float pixelSize;
+};
+static const GeneratedLod s_generatedLods[] = {
+	{ 0.15f, 30.f },
+	{ 0.4f, 100.f }
+};
+static const float FULL_DETAIL_PIXEL_SIZE = 1000.f;
+static const Uint32 MIN_TRIANGLES_FOR_LODS = 512; //anything smaller isn't worth it
+
+// how far compact vertices may be from the full precision ones before
+// the attribute is kept as floats
+static const float MAX_POSITION_ERROR = 0.005f; //model units
+static const float MAX_NORMAL_ERROR = 0.5f; //degrees
+static const float MAX_UV_ERROR = 1.0f / 4096.0f; //half a texel of a 2048 texture
+
+static RefCountedPtr<Graphics::IndexBuffer> CreateIndexBuffer(Graphics::Renderer *r, const MeshOptimizer::MeshData &data)
+{
+	RefCountedPtr<Graphics::IndexBuffer> ib(r->CreateIndexBuffer(data.indices.size(), Graphics::BUFFER_USAGE_STATIC));
+	Uint32 *idxPtr = ib->Map(Graphics::BUFFER_MAP_WRITE);
+	memcpy(idxPtr, &data.indices[0], data.indices.size() * sizeof(Uint32));
+	ib->Unmap();
+	return ib;
+}
+
+// the compact counterpart of a float layout, attributes in the same order
+static Graphics::VertexBufferDesc CompactLayout(const Graphics::VertexBufferDesc &layout, Graphics::VertexAttribFormat positions, bool octNormals, bool halfUVs)
+{
+	using namespace Graphics;
+	VertexBufferDesc desc = layout;
+	Uint32 offset = 0;
+	for (Uint32 i = 0; i < MAX_ATTRIBS && desc.attrib[i].semantic != ATTRIB_NONE; i++) {
+		VertexAttribDesc &attr = desc.attrib[i];
+		switch (attr.semantic) {
+		case ATTRIB_POSITION: attr.format = positions; break;
+		case ATTRIB_NORMAL:
+		case ATTRIB_TANGENT: attr.format = octNormals ? ATTRIB_FORMAT_SHORT2N : ATTRIB_FORMAT_FLOAT3; break;
+		case ATTRIB_UV0: attr.format = halfUVs ? ATTRIB_FORMAT_HALF2 : ATTRIB_FORMAT_FLOAT2; break;
+		default: break;
+		}
+		attr.offset = offset;
+		offset += VertexBufferDesc::GetAttribSize(attr.format);
+	}
+	desc.stride = offset;
+	return desc;
+}
+
+// largest difference of each attribute between two float layouts, angles
+// for normals and tangents
+static void MeasureErrors(const Graphics::VertexBufferDesc &layout, const Uint8 *a, const Uint8 *b, Uint32 numVertices, float &position, float &normal, float &uv)
+{
+	using namespace Graphics;
+	position = normal = uv = 0.0f;
+	for (Uint32 v = 0; v < numVertices; v++) {
+		const Uint8 *va = a + v * layout.stride, *vb = b + v * layout.stride;
+		for (Uint32 i = 0; i < MAX_ATTRIBS && layout.attrib[i].semantic != ATTRIB_NONE; i++) {
+			const VertexAttribDesc &attr = layout.attrib[i];
+			if (attr.semantic == ATTRIB_UV0) {
+				const vector2f &ua = *reinterpret_cast<const vector2f*>(va + attr.offset);
+				const vector2f &ub = *reinterpret_cast<const vector2f*>(vb + attr.offset);
+				uv = std::max(uv, std::max(fabs(ua.x - ub.x), fabs(ua.y - ub.y)));
+				continue;
+			}
+			const vector3f &pa = *reinterpret_cast<const vector3f*>(va + attr.offset);
+			const vector3f &pb = *reinterpret_cast<const vector3f*>(vb + attr.offset);
+			if (attr.semantic == ATTRIB_POSITION) {
+				position = std::max(position, (pa - pb).Length());
+			} else if (attr.semantic == ATTRIB_NORMAL || attr.semantic == ATTRIB_TANGENT) {
+				const float cosAngle = Clamp(pa.NormalizedSafe().Dot(pb), -1.0f, 1.0f);
+				normal = std::max(normal, RAD2DEG(acosf(cosAngle)));
+			}
+		}
+	}
+}
+
+RefCountedPtr<Graphics::VertexBuffer> Loader::CreateVertexBuffer(const MeshOptimizer::MeshData &data, const Graphics::VertexBufferDesc &layout, bool compact)
+{
+	PROFILE_SCOPED()
+	using namespace Graphics;
+	const Uint32 numVertices = data.GetNumVertices();
+	VertexBufferDesc desc = layout;
+	desc.numVertices = numVertices;
+	std::vector<Uint8> compactVertices;
+
+	if (compact) {
+		const bool halfPositions = (m_curVertexFormat == MESH_VERTICES_COMPACT_HALF);
+		Aabb aabb;
+		for (Uint32 v = 0; v < numVertices; v++)
+			aabb.Update(vector3d(data.GetPosition(v)));
+		const vector3f min(aabb.min), max(aabb.max);
+
+		VertexAttribFormat positions = halfPositions ? ATTRIB_FORMAT_HALF4 : ATTRIB_FORMAT_USHORT4N;
+		bool octNormals = true, halfUVs = true;
+		std::vector<Uint8> decoded(data.vertices.size());
+		float positionError, normalError, uvError;
+		//the second time around, with what went over the limits as floats
+		for (int attempt = 0; attempt < 2; attempt++) {
+			desc = CompactLayout(layout, positions, octNormals, halfUVs);
+			desc.numVertices = numVertices;
+			if (positions == ATTRIB_FORMAT_HALF4) {
+				desc.positionOffset = (min + max) * 0.5f;
+				desc.positionScale = (max - min) * 0.5f;
+			} else if (positions == ATTRIB_FORMAT_USHORT4N) {
+				desc.positionOffset = min;
+				desc.positionScale = max - min;
+			} else {
+				desc.positionOffset = vector3f(0.0f);
+				desc.positionScale = vector3f(1.0f);
+			}
+			compactVertices.resize(numVertices * desc.stride);
+			ConvertVertices(layout, &data.vertices[0], desc, &compactVertices[0], numVertices);
+			ConvertVertices(desc, &compactVertices[0], layout, &decoded[0], numVertices);
+			MeasureErrors(layout, &data.vertices[0], &decoded[0], numVertices, positionError, normalError, uvError);
+
+			const Uint32 fallbacks = m_optimizationStats.floatFallbacks;
+			if (positionError > MAX_POSITION_ERROR && positions != ATTRIB_FORMAT_FLOAT3) {
+				positions = ATTRIB_FORMAT_FLOAT3;
+				m_optimizationStats.floatFallbacks++;
+			}
+			if (normalError > MAX_NORMAL_ERROR && octNormals) {
+				octNormals = false;
+				m_optimizationStats.floatFallbacks++;
+			}
+			if (uvError > MAX_UV_ERROR && halfUVs) {
+				halfUVs = false;
+				m_optimizationStats.floatFallbacks++;
+			}
+			if (fallbacks == m_optimizationStats.floatFallbacks)
+				break;
+			AddLog(stringf("%0: vertices too far from full precision (%1{f.4}, %2{f.2} degrees, uv %3{f.5}), keeping some as floats",
+				m_curMeshDef, positionError, normalError, uvError));
+		}
+
+		if (desc.IsCompact()) {
+			OptimizationStats &stats = m_optimizationStats;
+			stats.compactBuffers++;
+			stats.compactBytes += numVertices * desc.stride;
+			stats.floatBytes += numVertices * layout.stride;
+			stats.maxPositionError = std::max(stats.maxPositionError, positionError);
+			stats.maxNormalError = std::max(stats.maxNormalError, normalError);
+			stats.maxUVError = std::max(stats.maxUVError, uvError);
+		} else {
+			desc = layout;
+			desc.numVertices = numVertices;
+			compactVertices.clear();
+		}
+	}
+
+	RefCountedPtr<VertexBuffer> vb(m_renderer->CreateVertexBuffer(desc));
+	const std::vector<Uint8> &vertices = compactVertices.empty() ? data.vertices : compactVertices;
+	Uint8 *vtxPtr = vb->Map<Uint8>(BUFFER_MAP_WRITE);
+	memcpy(vtxPtr, &vertices[0], vertices.size());
+	vb->Unmap();
+	return vb;
+}
+
+// triangle weighted cache misses, vertex weighted overfetch
+static void AddMeshStats(MeshOptimizer::MeshStats &total, const MeshOptimizer::MeshStats &mesh)
+{
+	const Uint32 triangles = total.triangles + mesh.triangles;
+	const Uint32 vertices = total.vertices + mesh.vertices;
+	if (triangles > 0)
+		total.acmr = (total.acmr * total.triangles + mesh.acmr * mesh.triangles) / triangles;
+	if (vertices > 0)
+		total.overfetch = (total.overfetch * total.vertices + mesh.overfetch * mesh.vertices) / vertices;
+	total.triangles = triangles;
+	total.vertices = vertices;
+}
+
+// meshes whose vertices are read back as floats: collision meshes, see
+// CreateCollisionGeometry, and shields, which also have their own shader
+static void FindFloatMeshes(const aiNode *node, std::set<unsigned int> &meshes)
+{
+	const std::string nodename(node->mName.C_Str());
+	if (starts_with(nodename, "collision_") || ends_with(nodename, "_shield"))
+		meshes.insert(node->mMeshes, node->mMeshes + node->mNumMeshes);
+	for (unsigned int i = 0; i < node->mNumChildren; i++)
+		FindFloatMeshes(node->mChildren[i], meshes);
+}
+
 void Loader::ConvertAiMeshes(std::vector<RefCountedPtr<StaticGeometry> > &geoms, const aiScene *scene)
 {
 	PROFILE_SCOPED()
@@ -448,6 +651,11 @@ void Loader::ConvertAiMeshes(std::vector<RefCountedPtr<StaticGeometry> > &geoms,
 	if (scene->mNumMaterials > scene->mNumMeshes)
 		matIdxOffs = 1;
 
+	std::set<unsigned int> floatMeshes;
+	const bool compactMeshes = m_curVertexFormat != MESH_VERTICES_FLOAT && m_renderer->SupportsCompactVertices();
+	if (compactMeshes)
+		FindFloatMeshes(scene->mRootNode, floatMeshes);
+
 	//turn meshes into static geometry nodes
 	for (unsigned int i=0; i<scene->mNumMeshes; i++) {
 		const aiMesh *mesh = scene->mMeshes[i];
@@ -507,13 +715,11 @@ void Loader::ConvertAiMeshes(std::vector<RefCountedPtr<StaticGeometry> > &geoms,
 			vbd.attrib[3].offset = offsetof(ModelTangentVtx, tangent);
 		}
 		vbd.stride = hasTangents ? sizeof(ModelTangentVtx) : sizeof(ModelVtx);
-		vbd.numVertices = mesh->mNumVertices;
 		vbd.usage = Graphics::BUFFER_USAGE_STATIC;
 
-		RefCountedPtr<Graphics::VertexBuffer> vb(m_renderer->CreateVertexBuffer(vbd));
-
 		// huge meshes are split by the importer so this should not exceed 65K indices
-		std::vector<Uint32> indices;
+		MeshOptimizer::MeshData data(vbd.stride);
+		std::vector<Uint32> &indices = data.indices;
 		if (mesh->mNumFaces > 0)
 		{
 			indices.reserve(mesh->mNumFaces * 3);
@@ -533,18 +739,12 @@ void Loader::ConvertAiMeshes(std::vector<RefCountedPtr<StaticGeometry> > &geoms,
 
 		assert(indices.size() > 0);
 
-		//create buffer & copy
-		RefCountedPtr<Graphics::IndexBuffer> ib(m_renderer->CreateIndexBuffer(indices.size(), Graphics::BUFFER_USAGE_STATIC));
-		Uint32* idxPtr = ib->Map(Graphics::BUFFER_MAP_WRITE);
-		for (Uint32 j = 0; j < indices.size(); j++)
-			idxPtr[j] = indices[j];
-		ib->Unmap();
-
 		//copy vertices, always assume normals
 		//replace nonexistent UVs with zeros
+		data.vertices.resize(mesh->mNumVertices * vbd.stride);
 		if (!hasTangents)
 		{
-			ModelVtx *vtxPtr = vb->Map<ModelVtx>(Graphics::BUFFER_MAP_WRITE);
+			ModelVtx *vtxPtr = reinterpret_cast<ModelVtx*>(&data.vertices[0]);
 			for (unsigned int v = 0; v < mesh->mNumVertices; v++) {
 				const aiVector3D &vtx = mesh->mVertices[v];
 				const aiVector3D &norm = mesh->mNormals[v];
@@ -557,11 +757,10 @@ void Loader::ConvertAiMeshes(std::vector<RefCountedPtr<StaticGeometry> > &geoms,
 				//untransformed points, collision visitor will transform
 				geom->m_boundingBox.Update(vtx.x, vtx.y, vtx.z);
 			}
-			vb->Unmap();
 		}
 		else
 		{
-			ModelTangentVtx *vtxPtr = vb->Map<ModelTangentVtx>(Graphics::BUFFER_MAP_WRITE);
+			ModelTangentVtx *vtxPtr = reinterpret_cast<ModelTangentVtx*>(&data.vertices[0]);
 			for (unsigned int v = 0; v < mesh->mNumVertices; v++) {
 				const aiVector3D &vtx = mesh->mVertices[v];
 				const aiVector3D &norm = mesh->mNormals[v];
@@ -576,15 +775,63 @@ void Loader::ConvertAiMeshes(std::vector<RefCountedPtr<StaticGeometry> > &geoms,
 				//untransformed points, collision visitor will transform
 				geom->m_boundingBox.Update(vtx.x, vtx.y, vtx.z);
 			}
-			vb->Unmap();
 		}
 
+		//merge and reorder for the GPU, keeping count of what that did
+		const MeshOptimizer::MeshStats before = MeshOptimizer::GetStats(data);
+		MeshOptimizer::Optimize(data);
+		AddMeshStats(m_optimizationStats.before, before);
+		AddMeshStats(m_optimizationStats.after, MeshOptimizer::GetStats(data));
+		m_optimizationStats.meshes++;
+
+		//create buffers & copy
+		const bool compact = compactMeshes && !floatMeshes.count(i);
+		RefCountedPtr<Graphics::VertexBuffer> vb = CreateVertexBuffer(data, vbd, compact);
+		RefCountedPtr<Graphics::IndexBuffer> ib = CreateIndexBuffer(m_renderer, data);
+
 		geom->AddMesh(vb, ib, mat);
 
 		geoms.push_back(geom);
+		m_generatedLods.push_back(m_generateLods ? GenerateLods(data, vbd, compact, geom.Get()) : RefCountedPtr<LOD>());
 	}
 }
 
+RefCountedPtr<LOD> Loader::GenerateLods(const MeshOptimizer::MeshData &mesh, const Graphics::VertexBufferDesc &layout, bool compact, StaticGeometry *geom)
+{
+	PROFILE_SCOPED()
+	if (mesh.GetNumTriangles() < MIN_TRIANGLES_FOR_LODS)
+		return RefCountedPtr<LOD>();
+
+	const StaticGeometry::Mesh &full = geom->GetMeshAt(0);
+	RefCountedPtr<LOD> lod(new LOD(m_renderer));
+	lod->SetName(geom->GetName() + "_lods");
+	lod->SetNodeMask(geom->GetNodeMask()); //LOD doesn't check the mask of the level it draws
+
+	for (const GeneratedLod &level : s_generatedLods) {
+		MeshOptimizer::MeshData simplified(mesh.stride);
+		if (!MeshOptimizer::Simplify(mesh, level.ratio, offsetof(ModelVtx, nrm), simplified))
+			continue;
+
+		RefCountedPtr<Graphics::VertexBuffer> vb = CreateVertexBuffer(simplified, layout, compact);
+		RefCountedPtr<Graphics::IndexBuffer> ib = CreateIndexBuffer(m_renderer, simplified);
+
+		RefCountedPtr<StaticGeometry> sg(new StaticGeometry(m_renderer));
+		sg->SetName(stringf("%0_lod%1{u}", geom->GetName(), lod->GetNumLevels()));
+		sg->SetNodeMask(geom->GetNodeMask());
+		sg->SetRenderState(geom->GetRenderState());
+		sg->m_blendMode = geom->m_blendMode;
+		sg->m_boundingBox = geom->m_boundingBox;
+		sg->AddMesh(vb, ib, full.material);
+		lod->AddLevel(level.pixelSize, sg.Get());
+		m_optimizationStats.generatedLevels++;
+	}
+
+	if (lod->GetNumLevels() == 0)
+		return RefCountedPtr<LOD>();
+	lod->AddLevel(FULL_DETAIL_PIXEL_SIZE, geom);
+	return lod;
+}
+
 void Loader::ConvertAnimations(const aiScene* scene, const AnimList &animDefs, Node *meshRoot)
 {
 	PROFILE_SCOPED()
@@ -649,7 +896,7 @@ void Loader::ConvertAnimations(const aiScene* scene, const AnimList &animDefs, N
 					const aiVector3D &aipos = aikey.mValue;
 					if (in_range(aikey.mTime, defStart, defEnd)) {
 						const double t = aikey.mTime * secondsPerTick;
-						chan.positionKeys.push_back(PositionKey(t, vector3f(aipos.x, aipos.y, aipos.z)));
+						chan.positionKeys.Add(t, vector3f(aipos.x, aipos.y, aipos.z));
 						start = std::min(start, t);
 						end = std::max(end, t);
 					}
@@ -664,7 +911,7 @@ void Loader::ConvertAnimations(const aiScene* scene, const AnimList &animDefs, N
 					const aiQuaternion &airot = aikey.mValue;
 					if (in_range(aikey.mTime, defStart, defEnd)) {
 						const double t = aikey.mTime * secondsPerTick;
-						chan.rotationKeys.push_back(RotationKey(t, Quaternionf(airot.w, airot.x, airot.y, airot.z)));
+						chan.rotationKeys.Add(t, Quaternionf(airot.w, airot.x, airot.y, airot.z));
 						start = std::min(start, t);
 						end = std::max(end, t);
 					}
@@ -675,7 +922,7 @@ void Loader::ConvertAnimations(const aiScene* scene, const AnimList &animDefs, N
 					const aiVector3D &aipos = aikey.mValue;
 					if (in_range(aikey.mTime, defStart, defEnd)) {
 						const double t = aikey.mTime * secondsPerTick;
-						chan.scaleKeys.push_back(ScaleKey(t, vector3f(aipos.x, aipos.y, aipos.z)));
+						chan.scaleKeys.Add(t, vector3f(aipos.x, aipos.y, aipos.z));
 						start = std::min(start, t);
 						end = std::max(end, t);
 					}
@@ -687,16 +934,16 @@ void Loader::ConvertAnimations(const aiScene* scene, const AnimList &animDefs, N
 		for (std::vector<AnimationChannel>::iterator chan = animation->m_channels.begin() + first_new_channel;
 				chan != animation->m_channels.end(); ++chan) {
 			for (unsigned int k = 0; k < chan->positionKeys.size(); ++k) {
-				chan->positionKeys[k].time -= start;
-				assert(chan->positionKeys[k].time >= 0.0);
+				chan->positionKeys.times[k] -= start;
+				assert(chan->positionKeys.times[k] >= 0.0);
 			}
 			for (unsigned int k = 0; k < chan->rotationKeys.size(); ++k) {
-				chan->rotationKeys[k].time -= start;
-				assert(chan->rotationKeys[k].time >= 0.0);
+				chan->rotationKeys.times[k] -= start;
+				assert(chan->rotationKeys.times[k] >= 0.0);
 			}
 			for (unsigned int k = 0; k < chan->scaleKeys.size(); ++k) {
-				chan->scaleKeys[k].time -= start;
-				assert(chan->scaleKeys[k].time >= 0.0);
+				chan->scaleKeys.times[k] -= start;
+				assert(chan->scaleKeys.times[k] >= 0.0);
 			}
 		}
 
@@ -792,6 +1039,7 @@ void Loader::CreateNavlight(const std::string &name, const matrix4x4f &m)
 	const matrix4x4f lightPos = matrix4x4f::Translation(m.GetTranslate());
 	MatrixTransform *lightPoint = new MatrixTransform(m_renderer, lightPos);
 	lightPoint->SetNodeMask(0x0); //don't render
+	lightPoint->SetNodeFlags(lightPoint->GetNodeFlags() | NODE_INSTANCE); //each ship's lights go on its own copy
 	lightPoint->SetName(name);
 
 	m_billboardsRoot->AddChild(lightPoint);
@@ -903,7 +1151,12 @@ void Loader::ConvertNodes(aiNode *node, Group *_parent, std::vector<RefCountedPt
 				geom->SetRenderState(m_renderer->CreateRenderState(rsd));
 			}
 
-			parent->AddChild(geom.Get());
+			//shield geometry is picked out as StaticGeometry, see Shields
+			LOD *lod = m_generatedLods.at(node->mMeshes[i]).Get();
+			if (lod && numDecal == 0 && !ends_with(nodename, "_shield"))
+				parent->AddChild(lod);
+			else
+				parent->AddChild(geom.Get());
 		}
 	}
 
@@ -8,6 +8,7 @@
  */
 #include "BaseLoader.h"
 #include "CollisionGeometry.h"
+#include "MeshOptimizer.h"
 #include "graphics/Material.h"
 #include <assimp/types.h>
 
@@ -18,8 +19,28 @@ struct aiNodeAnim;
 
 namespace SceneGraph {
 
+class LOD;
+
 class Loader : public BaseLoader {
 public:
+	// what the mesh optimisation did to the meshes of the last model loaded.
+	// Cache misses and overfetch are averaged over triangles and vertices
+	struct OptimizationStats {
+		Uint32 meshes;
+		MeshOptimizer::MeshStats before;
+		MeshOptimizer::MeshStats after;
+		Uint32 generatedLevels;  // simplified meshes made for models without detail levels
+		// vertex buffers in the compact formats, and what they would take as floats
+		Uint32 compactBuffers;
+		Uint32 compactBytes;
+		Uint32 floatBytes;
+		// the largest differences their vertices have from the full precision ones
+		float maxPositionError;  // model units
+		float maxNormalError;    // degrees, normals and tangents
+		float maxUVError;
+		Uint32 floatFallbacks;   // attributes kept as floats to stay within the limits
+	};
+
 	Loader(Graphics::Renderer *r, bool logWarnings = false, bool loadSGMfiles = true);
 
 	//find & attempt to load a model, based on filename (without path or .model suffix)
@@ -27,11 +48,19 @@ public:
 	Model *LoadModel(const std::string &name, const std::string &basepath);
 
 	const std::vector<std::string> &GetLogMessages() const { return m_logMessages; }
+	const OptimizationStats &GetOptimizationStats() const { return m_optimizationStats; }
+
+	// of the code turning source files into models, see LOADER_REVISION
+	static Uint32 GetRevision();
 
 protected:
 	bool m_doLog;
 	bool m_loadSGMs;
 	bool m_mostDetailedLod;
+	bool m_generateLods; //the model has one detail level, so meshes get simplified ones
+	MeshVertexFormat m_curVertexFormat; //of the mesh being loaded
+	OptimizationStats m_optimizationStats;
+	std::vector<RefCountedPtr<LOD> > m_generatedLods; //per mesh of the file being loaded, if any
 	std::vector<std::string> m_logMessages;
 	std::string m_curMeshDef; //for logging
 
@@ -45,6 +74,8 @@ protected:
 	void AddLog(const std::string&);
 	void CheckAnimationConflicts(const Animation*, const std::vector<Animation*>&); //detect animation overlap
 	void ConvertAiMeshes(std::vector<RefCountedPtr<StaticGeometry> >&, const aiScene*); //model is only for material lookup
+	RefCountedPtr<Graphics::VertexBuffer> CreateVertexBuffer(const MeshOptimizer::MeshData &mesh, const Graphics::VertexBufferDesc &layout, bool compact);
+	RefCountedPtr<LOD> GenerateLods(const MeshOptimizer::MeshData &mesh, const Graphics::VertexBufferDesc &layout, bool compact, StaticGeometry *geom);
 	void ConvertAnimations(const aiScene *, const AnimList &, Node *meshRoot);
 	void ConvertNodes(aiNode *node, Group *parent, std::vector<RefCountedPtr<StaticGeometry> >& meshes, const matrix4x4f&);
 	void CreateLabel(Group *parent, const matrix4x4f&);
@@ -44,11 +44,19 @@ struct MaterialDefinition {
 	bool use_pattern;
 };
 
+//how the vertices of a mesh are stored
+enum MeshVertexFormat {
+	MESH_VERTICES_FLOAT,
+	MESH_VERTICES_COMPACT,      //16 bit integer positions within the mesh bounds
+	MESH_VERTICES_COMPACT_HALF  //half float positions about the middle of the mesh
+};
+
 struct LodDefinition {
 	LodDefinition(float size) : pixelSize(size)
 	{ }
 	float pixelSize;
 	std::vector<std::string> meshNames;
+	std::vector<MeshVertexFormat> meshFormats; //one per mesh name
 };
 
 struct AnimDefinition {
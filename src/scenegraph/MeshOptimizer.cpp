@@ -0,0 +1,284 @@
+// Copyright © 2008-2018 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#include "MeshOptimizer.h"
+#include "Aabb.h"
+#include "vcacheopt/vcacheopt.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace SceneGraph {
+
+namespace MeshOptimizer {
+
+static const Uint32 CACHE_SIZE = 16;       // post-transform cache modelled
+static const Uint32 FETCH_LINE_SIZE = 64;
+static const Uint32 FETCH_CACHE_LINES = 64;
+static const Uint32 MIN_CLUSTER_SIZE = 8;  // triangles, for the overdraw sort
+
+// a FIFO cache: a vertex is in it if fewer than size misses came after it
+class FifoCache {
+public:
+	FifoCache(Uint32 numEntries, Uint32 size) : m_stamps(numEntries, 0), m_time(size + 1), m_size(size) { }
+
+	// true on a miss, which puts the entry in
+	bool Fetch(Uint32 entry) {
+		if (m_time - m_stamps[entry] <= m_size)
+			return false;
+		m_stamps[entry] = m_time++;
+		return true;
+	}
+
+private:
+	std::vector<Uint32> m_stamps;
+	Uint32 m_time;
+	Uint32 m_size;
+};
+
+static vector3f TriangleNormal(const MeshData &mesh, const Uint32 *tri)
+{
+	const vector3f &a = mesh.GetPosition(tri[0]);
+	return (mesh.GetPosition(tri[1]) - a).Cross(mesh.GetPosition(tri[2]) - a);
+}
+
+static vector3f TriangleCentre(const MeshData &mesh, const Uint32 *tri)
+{
+	return (mesh.GetPosition(tri[0]) + mesh.GetPosition(tri[1]) + mesh.GetPosition(tri[2])) * (1.0f / 3.0f);
+}
+
+MeshStats GetStats(const MeshData &mesh)
+{
+	MeshStats stats;
+	stats.vertices = mesh.GetNumVertices();
+	stats.triangles = mesh.GetNumTriangles();
+	stats.acmr = stats.overfetch = 0.0f;
+	if (stats.triangles == 0)
+		return stats;
+
+	FifoCache cache(stats.vertices, CACHE_SIZE);
+	const Uint32 numLines = (stats.vertices * mesh.stride + FETCH_LINE_SIZE - 1) / FETCH_LINE_SIZE;
+	FifoCache lines(numLines, FETCH_CACHE_LINES);
+	Uint32 misses = 0, lineFetches = 0;
+	for (Uint32 i : mesh.indices) {
+		if (!cache.Fetch(i))
+			continue;
+		misses++;
+		const Uint32 first = i * mesh.stride / FETCH_LINE_SIZE;
+		const Uint32 last = ((i + 1) * mesh.stride - 1) / FETCH_LINE_SIZE;
+		for (Uint32 l = first; l <= last; l++)
+			if (lines.Fetch(l)) lineFetches++;
+	}
+	stats.acmr = float(misses) / stats.triangles;
+	stats.overfetch = float(lineFetches * FETCH_LINE_SIZE) / float(std::max(stats.vertices * mesh.stride, 1U));
+	return stats;
+}
+
+void RemoveDuplicateVertices(MeshData &mesh)
+{
+	PROFILE_SCOPED()
+	const Uint32 numVertices = mesh.GetNumVertices();
+	std::unordered_map<std::string, Uint32> unique;
+	unique.reserve(numVertices);
+	std::vector<Uint32> remap(numVertices);
+	std::vector<Uint8> vertices;
+	vertices.reserve(mesh.vertices.size());
+	for (Uint32 v = 0; v < numVertices; v++) {
+		const Uint8 *vtx = &mesh.vertices[v * mesh.stride];
+		auto it = unique.insert(std::make_pair(std::string(reinterpret_cast<const char*>(vtx), mesh.stride), Uint32(unique.size())));
+		if (it.second)
+			vertices.insert(vertices.end(), vtx, vtx + mesh.stride);
+		remap[v] = it.first->second;
+	}
+	if (unique.size() == numVertices)
+		return;
+	for (Uint32 &i : mesh.indices)
+		i = remap[i];
+	mesh.vertices.swap(vertices);
+}
+
+void OptimizeVertexCache(MeshData &mesh)
+{
+	PROFILE_SCOPED()
+	if (mesh.indices.empty())
+		return;
+	std::vector<Uint32> indices(mesh.indices);
+	VertexCacheOptimizerUInt vco;
+	if (!VertexCacheOptimizerUInt::Failed(vco.Optimize(&indices[0], mesh.GetNumTriangles())))
+		mesh.indices.swap(indices);
+}
+
+void OptimizeOverdraw(MeshData &mesh)
+{
+	PROFILE_SCOPED()
+	const Uint32 numTris = mesh.GetNumTriangles();
+	if (numTris < 2 * MIN_CLUSTER_SIZE)
+		return;
+
+	// clusters start at triangles none of whose vertices are in the cache,
+	// where it's as good as empty anyway, so moving them about costs little
+	std::vector<Uint32> starts;
+	FifoCache cache(mesh.GetNumVertices(), CACHE_SIZE);
+	for (Uint32 t = 0; t < numTris; t++) {
+		Uint32 misses = 0;
+		for (Uint32 j = 0; j < 3; j++)
+			if (cache.Fetch(mesh.indices[t * 3 + j])) misses++;
+		if (misses == 3 && (starts.empty() || t - starts.back() >= MIN_CLUSTER_SIZE))
+			starts.push_back(t);
+	}
+	starts.push_back(numTris);
+	if (starts.size() < 3)
+		return;
+
+	// area weighted centre of the mesh
+	vector3f centre(0.0f);
+	float area = 0.0f;
+	for (Uint32 t = 0; t < numTris; t++) {
+		const float a = TriangleNormal(mesh, &mesh.indices[t * 3]).Length();
+		centre += TriangleCentre(mesh, &mesh.indices[t * 3]) * a;
+		area += a;
+	}
+	if (area > 0.0f)
+		centre *= 1.0f / area;
+
+	// clusters facing away from the centre are likely to be in front of the
+	// others whichever way the mesh is seen, so they go first
+	struct TriangleCluster { Uint32 start, end; float sortKey; };
+	std::vector<TriangleCluster> clusters;
+	for (size_t c = 0; c + 1 < starts.size(); c++) {
+		vector3f normal(0.0f), clusterCentre(0.0f);
+		float clusterArea = 0.0f;
+		for (Uint32 t = starts[c]; t < starts[c + 1]; t++) {
+			const vector3f n = TriangleNormal(mesh, &mesh.indices[t * 3]);
+			const float a = n.Length();
+			normal += n;
+			clusterCentre += TriangleCentre(mesh, &mesh.indices[t * 3]) * a;
+			clusterArea += a;
+		}
+		float key = 0.0f;
+		if (clusterArea > 0.0f && normal.Length() > 0.0f)
+			key = (clusterCentre * (1.0f / clusterArea) - centre).Dot(normal.Normalized());
+		clusters.push_back({ starts[c], starts[c + 1], key });
+	}
+	std::stable_sort(clusters.begin(), clusters.end(), [](const TriangleCluster &a, const TriangleCluster &b) { return a.sortKey > b.sortKey; });
+
+	std::vector<Uint32> indices;
+	indices.reserve(mesh.indices.size());
+	for (const TriangleCluster &c : clusters)
+		indices.insert(indices.end(), mesh.indices.begin() + c.start * 3, mesh.indices.begin() + c.end * 3);
+	mesh.indices.swap(indices);
+}
+
+void OptimizeVertexFetch(MeshData &mesh)
+{
+	PROFILE_SCOPED()
+	// in the order the triangles first use them, leaving out unused ones
+	const Uint32 numVertices = mesh.GetNumVertices();
+	std::vector<Uint32> remap(numVertices, ~0U);
+	std::vector<Uint8> vertices;
+	vertices.reserve(mesh.vertices.size());
+	Uint32 next = 0;
+	for (Uint32 &i : mesh.indices) {
+		if (remap[i] == ~0U) {
+			remap[i] = next++;
+			vertices.insert(vertices.end(), mesh.vertices.begin() + i * mesh.stride, mesh.vertices.begin() + (i + 1) * mesh.stride);
+		}
+		i = remap[i];
+	}
+	mesh.vertices.swap(vertices);
+}
+
+void Optimize(MeshData &mesh)
+{
+	PROFILE_SCOPED()
+	RemoveDuplicateVertices(mesh);
+	OptimizeVertexCache(mesh);
+	OptimizeOverdraw(mesh);
+	OptimizeVertexFetch(mesh);
+}
+
+// the triangles left when vertices are merged on a grid of the given number
+// of cells along the longest side of the mesh
+static void ClusterVertices(const MeshData &mesh, const Aabb &aabb, Uint32 resolution, Uint32 normalOffset, std::vector<Uint32> &indices)
+{
+	const vector3d size = aabb.max - aabb.min;
+	const double cellSize = std::max(std::max(size.x, size.y), size.z) / resolution;
+	const Uint32 numVertices = mesh.GetNumVertices();
+
+	// cell of each vertex, with the main axis of its normal
+	std::vector<Uint64> keys(numVertices);
+	std::unordered_map<Uint64, std::pair<vector3f, Uint32> > cells;
+	for (Uint32 v = 0; v < numVertices; v++) {
+		const vector3f &p = mesh.GetPosition(v);
+		const vector3f &n = *reinterpret_cast<const vector3f*>(&mesh.vertices[v * mesh.stride + normalOffset]);
+		const Uint64 x = Uint64(std::min((p.x - aabb.min.x) / cellSize, double(resolution - 1)));
+		const Uint64 y = Uint64(std::min((p.y - aabb.min.y) / cellSize, double(resolution - 1)));
+		const Uint64 z = Uint64(std::min((p.z - aabb.min.z) / cellSize, double(resolution - 1)));
+		const vector3f an(fabs(n.x), fabs(n.y), fabs(n.z));
+		const Uint64 axis = an.x >= an.y && an.x >= an.z ? (n.x < 0.0f ? 1 : 0) : an.y >= an.z ? (n.y < 0.0f ? 3 : 2) : (n.z < 0.0f ? 5 : 4);
+		keys[v] = (x << 43) | (y << 23) | (z << 3) | axis;
+		auto &cell = cells.insert(std::make_pair(keys[v], std::make_pair(vector3f(0.0f), 0U))).first->second;
+		cell.first += p;
+		cell.second++;
+	}
+
+	// each cell keeps the vertex nearest the middle of its vertices
+	std::unordered_map<Uint64, std::pair<float, Uint32> > kept;
+	for (Uint32 v = 0; v < numVertices; v++) {
+		const auto &cell = cells[keys[v]];
+		const float dist = (mesh.GetPosition(v) - cell.first * (1.0f / cell.second)).LengthSqr();
+		auto it = kept.insert(std::make_pair(keys[v], std::make_pair(dist, v)));
+		if (!it.second && dist < it.first->second.first)
+			it.first->second = std::make_pair(dist, v);
+	}
+
+	indices.clear();
+	for (size_t t = 0; t < mesh.indices.size(); t += 3) {
+		Uint32 tri[3];
+		for (Uint32 j = 0; j < 3; j++)
+			tri[j] = kept[keys[mesh.indices[t + j]]].second;
+		if (tri[0] != tri[1] && tri[1] != tri[2] && tri[0] != tri[2])
+			indices.insert(indices.end(), tri, tri + 3);
+	}
+}
+
+bool Simplify(const MeshData &mesh, float ratio, Uint32 normalOffset, MeshData &out)
+{
+	PROFILE_SCOPED()
+	const Uint32 target = Uint32(mesh.GetNumTriangles() * ratio);
+	if (target == 0)
+		return false;
+
+	Aabb aabb;
+	for (Uint32 v = 0; v < mesh.GetNumVertices(); v++)
+		aabb.Update(vector3d(mesh.GetPosition(v)));
+	const vector3d size = aabb.max - aabb.min;
+	if (std::max(std::max(size.x, size.y), size.z) <= 0.0)
+		return false;
+
+	// the finest grid that gets down to the target
+	std::vector<Uint32> indices, best;
+	Uint32 lo = 1, hi = 1024;
+	while (lo < hi) {
+		const Uint32 mid = (lo + hi + 1) / 2;
+		ClusterVertices(mesh, aabb, mid, normalOffset, indices);
+		if (indices.size() / 3 <= target) {
+			lo = mid;
+			best.swap(indices);
+		} else {
+			hi = mid - 1;
+		}
+	}
+	if (best.empty())
+		return false;
+
+	out.stride = mesh.stride;
+	out.vertices = mesh.vertices;
+	out.indices.swap(best);
+	OptimizeVertexCache(out);
+	OptimizeVertexFetch(out);
+	return true;
+}
+
+}
+
+}
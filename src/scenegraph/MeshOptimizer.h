@@ -0,0 +1,59 @@
+// Copyright © 2008-2018 Pioneer Developers. See AUTHORS.txt for details
+// Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
+
+#ifndef _SCENEGRAPH_MESHOPTIMIZER_H
+#define _SCENEGRAPH_MESHOPTIMIZER_H
+/*
+ * Offline optimisation of triangle meshes, run by the Loader before the
+ * meshes go into vertex buffers (and so into .sgm files):
+ *  - identical vertices are merged
+ *  - triangles are reordered for the post-transform vertex cache, then in
+ *    clusters so the outward-facing ones come first and cover what's behind
+ *  - vertices are reordered to the order they're first used in
+ * Also simplifies meshes by vertex clustering, for generating detail levels.
+ */
+#include "libs.h"
+
+namespace SceneGraph {
+
+namespace MeshOptimizer {
+
+	// vertices are blocks of stride bytes starting with a vector3f position
+	struct MeshData {
+		MeshData(Uint32 stride_) : stride(stride_) { }
+		Uint32 GetNumVertices() const { return static_cast<Uint32>(vertices.size() / stride); }
+		Uint32 GetNumTriangles() const { return static_cast<Uint32>(indices.size() / 3); }
+		const vector3f &GetPosition(Uint32 v) const { return *reinterpret_cast<const vector3f*>(&vertices[v * stride]); }
+
+		Uint32 stride;
+		std::vector<Uint8> vertices;
+		std::vector<Uint32> indices;
+	};
+
+	struct MeshStats {
+		Uint32 vertices;
+		Uint32 triangles;
+		float acmr;       // average vertex cache misses per triangle, 0.5-3
+		float overfetch;  // vertex fetches per vertex when read in 64 byte lines
+	};
+
+	MeshStats GetStats(const MeshData &mesh);
+
+	void RemoveDuplicateVertices(MeshData &mesh);
+	void OptimizeVertexCache(MeshData &mesh);
+	void OptimizeOverdraw(MeshData &mesh);
+	void OptimizeVertexFetch(MeshData &mesh);
+
+	// all of the above, in that order
+	void Optimize(MeshData &mesh);
+
+	// a mesh with at most about ratio of the triangles, itself optimised.
+	// Vertices in one cell of a grid over the mesh are merged into one unless
+	// their normals (a vector3f at normalOffset) point different ways, which
+	// keeps hard edges. False if nothing useful is left
+	bool Simplify(const MeshData &mesh, float ratio, Uint32 normalOffset, MeshData &out);
+}
+
+}
+
+#endif
@@ -2,6 +2,8 @@
 // Licensed under the terms of the GPL v3. See licenses/GPL-3.txt
 
 #include "Model.h"
+#include "Billboard.h"
+#include "CollisionGeometry.h"
 #include "CollisionVisitor.h"
 #include "NodeCopyCache.h"
 #include "graphics/Renderer.h"
@@ -10,6 +12,8 @@
 #include "StringF.h"
 #include "JsonUtils.h"
 #include "FindNodeVisitor.h"
+#include "LOD.h"
+#include "StaticGeometry.h"
 #include "Thruster.h"
 #include "utils.h"
 #include "GameSaveError.h"
@@ -25,6 +29,154 @@ public:
 	std::string label;
 };
 
+class TransformListVisitor : public NodeVisitor {
+public:
+	virtual void ApplyMatrixTransform(MatrixTransform &m) {
+		transforms.push_back(&m);
+		m.Traverse(*this);
+	}
+
+	std::vector<MatrixTransform*> transforms;
+};
+
+// finds the nodes an instance changes: animated transforms, tags (navlights
+// hang their billboards off them), labels, billboards and dynamic collision
+// geometry, along with the groups above them. The rest never changes once the
+// model is loaded, so instances can share it
+class InstanceNodeFinder : public NodeVisitor {
+public:
+	InstanceNodeFinder(const AnimationContainer &animations) {
+		for (const Animation *anim : animations)
+			for (const AnimationChannel &chan : anim->GetChannels())
+				m_animated.insert(chan.node);
+	}
+
+	virtual void ApplyGroup(Group &g) override {
+		m_path.push_back(&g);
+		g.Traverse(*this);
+		m_path.pop_back();
+	}
+
+	virtual void ApplyMatrixTransform(MatrixTransform &m) override {
+		if ((m.GetNodeFlags() & (NODE_TAG | NODE_INSTANCE)) || m_animated.count(&m))
+			Mark(m);
+		ApplyGroup(m);
+	}
+
+	virtual void ApplyStaticGeometry(StaticGeometry &g) override {
+		if (g.GetNodeFlags() & NODE_INSTANCE)
+			Mark(g);
+	}
+
+	virtual void ApplyLabel(Label3D &l) override { Mark(l); }
+	virtual void ApplyBillboard(Billboard &b) override { Mark(b); }
+
+	virtual void ApplyCollisionGeometry(CollisionGeometry &cg) override {
+		if (cg.IsDynamic())
+			Mark(cg);
+	}
+
+	std::set<const Node*> nodes;
+
+private:
+	void Mark(const Node &n) {
+		nodes.insert(&n);
+		nodes.insert(m_path.begin(), m_path.end());
+	}
+
+	std::set<const MatrixTransform*> m_animated;
+	std::vector<const Node*> m_path;
+};
+
+// flattens the nodes a Render would reach, see Model::RenderList
+class RenderListBuilder : public NodeVisitor {
+public:
+	RenderListBuilder(Model::RenderList &list, const matrix4x4f &trans, float boundingRadius)
+	: m_list(list)
+	, m_trans(trans)
+	, m_boundingRadius(boundingRadius)
+	, m_forced(false)
+	{
+		m_list.transforms.assign(1, matrix4x4f::Identity());
+		m_list.meshes.clear();
+		m_list.leaves.clear();
+		m_list.levels.clear();
+		m_list.branches.clear();
+		m_transform.push_back(0);
+		m_mask.push_back(NODE_SOLID | NODE_TRANSPARENT);
+	}
+
+	virtual void ApplyGroup(Group &g) override {
+		if (!Enter(g)) return;
+		g.Traverse(*this);
+		m_mask.pop_back();
+	}
+
+	virtual void ApplyMatrixTransform(MatrixTransform &m) override {
+		if (!Enter(m)) return;
+		const matrix4x4f t = m_list.transforms[m_transform.back()] * m.GetTransform();
+		m_transform.push_back(static_cast<Uint32>(m_list.transforms.size()));
+		m_list.transforms.push_back(t);
+		m.Traverse(*this);
+		m_transform.pop_back();
+		m_mask.pop_back();
+	}
+
+	virtual void ApplyLOD(LOD &l) override {
+		if (!Enter(l)) return;
+		if (l.GetNumLevels() > 0) {
+			const Uint32 t = m_transform.back();
+			const unsigned int level = l.SelectLevel(m_trans * m_list.transforms[t], m_boundingRadius);
+			m_list.levels.push_back({ &l, t, level });
+			// LOD::Render doesn't look at the mask of the level it picks
+			m_forced = true;
+			l.GetChildAt(level)->Accept(*this);
+			m_forced = false;
+		}
+		m_mask.pop_back();
+	}
+
+	virtual void ApplyStaticGeometry(StaticGeometry &g) override {
+		const Uint32 leaf = static_cast<Uint32>(m_list.leaves.size());
+		AddLeaf(g, true);
+		const vector3f centre = m_list.transforms[m_transform.back()] * vector3f(0.5 * (g.m_boundingBox.min + g.m_boundingBox.max));
+		for (Uint32 i = 0; i < g.GetNumMeshes(); i++)
+			m_list.meshes.push_back({ &g, g.GetMeshAt(i).material.Get(), i, leaf, centre });
+	}
+
+	virtual void ApplyCollisionGeometry(CollisionGeometry &) override {
+		m_forced = false; // doesn't draw
+	}
+
+	// billboards, thrusters, labels and submodels draw themselves
+	virtual void ApplyNode(Node &n) override {
+		AddLeaf(n, false);
+	}
+
+private:
+	bool Enter(Group &g) {
+		const unsigned int mask = m_forced ? m_mask.back() : m_mask.back() & g.GetNodeMask();
+		m_forced = false;
+		if (!(mask & (NODE_SOLID | NODE_TRANSPARENT)))
+			return false;
+		m_mask.push_back(mask);
+		m_list.branches.push_back({ &g, g.GetStructureChanges() });
+		return true;
+	}
+
+	void AddLeaf(Node &n, bool geometry) {
+		m_list.leaves.push_back({ &n, m_transform.back(), m_mask.back(), !m_forced, geometry });
+		m_forced = false;
+	}
+
+	Model::RenderList &m_list;
+	const matrix4x4f &m_trans;
+	float m_boundingRadius;
+	bool m_forced;
+	std::vector<Uint32> m_transform;
+	std::vector<unsigned int> m_mask;
+};
+
 Model::Model(Graphics::Renderer *r, const std::string &name)
 : m_boundingRadius(10.f)
 , m_renderer(r)
@@ -49,8 +201,13 @@ Model::Model(const Model &model)
 , m_curPattern(model.m_curPattern)
 , m_debugFlags(0)
 {
-	//selective copying of node structure
+	//selective copying of node structure: only the parts an instance
+	//changes are copied, the rest of the graph is shared with the original
+	InstanceNodeFinder instanceNodes(model.m_animations);
+	model.m_root->Accept(instanceNodes);
+	instanceNodes.nodes.insert(model.m_root.Get());
 	NodeCopyCache cache;
+	cache.SetInstanceNodes(instanceNodes.nodes);
 	m_root.Reset(dynamic_cast<Group*>(model.m_root->Clone(&cache)));
 
 	//materials are shared by meshes
@@ -69,18 +226,28 @@ Model::Model(const Model &model)
 		SetPattern(0);
 	}
 
+	//the copy has the same shape, so its transforms pair up with the
+	//original's in traversal order (shared ones with themselves)
+	TransformListVisitor original, copy;
+	model.m_root->Accept(original);
+	m_root->Accept(copy);
+	assert(original.transforms.size() == copy.transforms.size());
+	TransformMap copies;
+	for (size_t i = 0; i < original.transforms.size(); i++)
+		copies[original.transforms[i]] = copy.transforms[i];
+
 	//animations need to be copied and retargeted
 	for (AnimationContainer::const_iterator it = model.m_animations.begin(); it != model.m_animations.end(); ++it) {
 		const Animation *anim = *it;
 		m_animations.push_back(new Animation(*anim));
-		m_animations.back()->UpdateChannelTargets(m_root.Get());
+		m_animations.back()->UpdateChannelTargets(copies);
 	}
 
 	//m_tags needs to be updated
 	for (TagContainer::const_iterator it = model.m_tags.begin(); it != model.m_tags.end(); ++it) {
-		MatrixTransform *t = dynamic_cast<MatrixTransform*>(m_root->FindNode((*it)->GetName()));
-		assert(t != 0);
-		m_tags.push_back(t);
+		TransformMap::const_iterator t = copies.find(*it);
+		assert(t != copies.end());
+		m_tags.push_back(t->second);
 	}
 }
 
@@ -95,16 +262,110 @@ Model *Model::MakeInstance() const
 	return m;
 }
 
+bool Model::IsRenderListStale(const matrix4x4f &trans, float boundingRadius)
+{
+	const RenderList &list = m_renderList;
+	if (!list.valid)
+		return true;
+
+	// in tree order, so a group removed from its parent is never looked at
+	for (const RenderList::Branch &b : list.branches)
+		if (b.group->GetStructureChanges() != b.structureChanges)
+			return true;
+
+	// animations write their transforms straight into the tree
+	for (size_t i = 0; i < m_animations.size(); i++)
+		if (m_animations[i]->GetProgress() != list.animationProgress[i])
+			return true;
+
+	for (const RenderList::Level &l : list.levels)
+		if (l.lod->SelectLevel(trans * list.transforms[l.transform], boundingRadius) != l.level)
+			return true;
+
+	return false;
+}
+
+void Model::BuildRenderList(const matrix4x4f &trans, float boundingRadius)
+{
+	PROFILE_SCOPED()
+	RenderList &list = m_renderList;
+
+	RenderListBuilder builder(list, trans, boundingRadius);
+	list.branches.push_back({ m_root.Get(), m_root->GetStructureChanges() });
+	m_root->Traverse(builder);
+
+	std::stable_sort(list.meshes.begin(), list.meshes.end(), [](const RenderList::Mesh &a, const RenderList::Mesh &b) {
+		return std::less<Graphics::Material*>()(a.material, b.material);
+	});
+
+	list.animationProgress.resize(m_animations.size());
+	for (size_t i = 0; i < m_animations.size(); i++)
+		list.animationProgress[i] = m_animations[i]->GetProgress();
+
+	list.patternMaterials.clear();
+	for (MaterialContainer::const_iterator it = m_materials.begin(); it != m_materials.end(); ++it)
+		if ((*it).second->GetDescriptor().usePatterns)
+			list.patternMaterials.push_back((*it).second.Get());
+
+	list.valid = true;
+}
+
+unsigned int Model::GetLeafMask(const RenderList::Leaf &leaf)
+{
+	return leaf.ownMask ? leaf.mask & leaf.node->GetNodeMask() : leaf.mask;
+}
+
+void Model::RenderPass(const RenderData &params, unsigned int pass)
+{
+	PROFILE_SCOPED()
+	const RenderList &list = m_renderList;
+	RenderData rd = params;
+	rd.nodemask = pass | (params.nodemask & MASK_IGNORE);
+
+	// opaque geometry goes straight to the queue
+	if (pass & NODE_SOLID) {
+		Uint32 lastTransform = ~0u;
+		for (const RenderList::Mesh &m : list.meshes) {
+			const RenderList::Leaf &leaf = list.leaves[m.leaf];
+			if (!(GetLeafMask(leaf) & NODE_SOLID))
+				continue;
+			SDL_assert(m.geom->GetRenderState());
+			if (leaf.transform != lastTransform) {
+				m_renderer->SetTransform(m_viewTransforms[leaf.transform]);
+				lastTransform = leaf.transform;
+			}
+			const float depth = -(m_viewTransforms[0] * m.centre).z;
+			StaticGeometry::Mesh &mesh = m.geom->GetMeshAt(m.mesh);
+			m_renderer->QueueBufferIndexed(mesh.vertexBuffer.Get(), mesh.indexBuffer.Get(), m.geom->GetRenderState(), m.material, depth);
+		}
+	}
+
+	for (const RenderList::Leaf &leaf : list.leaves) {
+		const unsigned int mask = GetLeafMask(leaf) & pass;
+		if (!mask || (leaf.geometry && (mask & NODE_SOLID)))
+			continue;
+		leaf.node->Render(m_viewTransforms[leaf.transform], &rd);
+	}
+}
+
 void Model::Render(const matrix4x4f &trans, const RenderData *rd)
 {
 	PROFILE_SCOPED()
+	//Override renderdata if this model is called from ModelNode
+	RenderData params = (rd != 0) ? (*rd) : m_renderData;
+
+	//using the entire model bounding radius for all nodes at the moment.
+	//BR could also be a property of Node.
+	params.boundingRadius = GetDrawClipRadius();
+
+	if (IsRenderListStale(trans, params.boundingRadius))
+		BuildRenderList(trans, params.boundingRadius);
+
 	//update color parameters (materials are shared by model instances)
 	if (m_curPattern) {
-		for (MaterialContainer::const_iterator it = m_materials.begin(); it != m_materials.end(); ++it) {
-			if ((*it).second->GetDescriptor().usePatterns) {
-				(*it).second->texture5 = m_colorMap.GetTexture();
-				(*it).second->texture4 = m_curPattern;
-			}
+		for (Graphics::Material *mat : m_renderList.patternMaterials) {
+			mat->texture5 = m_colorMap.GetTexture();
+			mat->texture4 = m_curPattern;
 		}
 	}
 
@@ -113,26 +374,27 @@ void Model::Render(const matrix4x4f &trans, const RenderData *rd)
 		if (m_decalMaterials[i])
 			m_decalMaterials[i]->texture0 = m_curDecals[i];
 
-	//Override renderdata if this model is called from ModelNode
-	RenderData params = (rd != 0) ? (*rd) : m_renderData;
+	const std::vector<matrix4x4f> &transforms = m_renderList.transforms;
+	m_viewTransforms.resize(transforms.size());
+	m_viewTransforms[0] = trans;
+	for (size_t i = 1; i < transforms.size(); i++)
+		m_viewTransforms[i] = trans * transforms[i];
 
 	m_renderer->SetTransform(trans);
 
-	//using the entire model bounding radius for all nodes at the moment.
-	//BR could also be a property of Node.
-	params.boundingRadius = GetDrawClipRadius();
-
 	//render in two passes, if this is the top-level model
 	if (m_debugFlags & DEBUG_WIREFRAME)
 		m_renderer->SetWireFrameMode(true);
 
 	if (params.nodemask & MASK_IGNORE) {
-		m_root->Render(trans, &params);
+		RenderPass(params, params.nodemask & (NODE_SOLID | NODE_TRANSPARENT));
 	} else {
-		params.nodemask = NODE_SOLID;
-		m_root->Render(trans, &params);
-		params.nodemask = NODE_TRANSPARENT;
-		m_root->Render(trans, &params);
+		// opaque meshes are queued and drawn sorted by material, which has to
+		// happen before anything gets blended over them
+		m_renderer->BeginCommands();
+		RenderPass(params, NODE_SOLID);
+		m_renderer->EndCommands();
+		RenderPass(params, NODE_TRANSPARENT);
 	}
 
 	if (!m_debugFlags)
@@ -322,10 +584,17 @@ void Model::DrawAxisIndicators(std::vector<Graphics::Drawables::Line3D> &lines)
 
 RefCountedPtr<CollMesh> Model::CreateCollisionMesh()
 {
+	PROFILE_SCOPED()
+	const Uint64 start = SDL_GetPerformanceCounter();
 	CollisionVisitor cv;
 	m_root->Accept(cv);
 	m_collMesh = cv.CreateCollisionMesh();
 	m_boundingRadius = cv.GetBoundingRadius();
+	m_collMesh->SetBuildTime(double(SDL_GetPerformanceCounter() - start) * 1000.0 / double(SDL_GetPerformanceFrequency()));
+#ifdef PIONEER_PROFILER
+	Output("Collision mesh for %s: %u triangles, %d edges, built in %.2f ms\n", m_name.c_str(),
+		m_collMesh->GetNumTriangles(), m_collMesh->GetGeomTree()->GetNumEdges(), m_collMesh->GetBuildTime());
+#endif
 	return m_collMesh;
 }
 
@@ -460,9 +729,33 @@ Animation *Model::FindAnimation(const std::string &name) const
 
 void Model::UpdateAnimations()
 {
+	PROFILE_SCOPED()
 	// XXX WIP. Assuming animations are controlled manually by SetProgress.
-	for (AnimationContainer::iterator anim = m_animations.begin(); anim != m_animations.end(); ++anim)
-		(*anim)->Interpolate();
+	// Nothing moves until one of them does. Animations never share a node
+	// (the loader checks), so all of them can be sampled before any is applied
+	bool changed = m_animationProgress.size() != m_animations.size();
+	m_animationProgress.resize(m_animations.size());
+	Uint32 numChannels = 0;
+	for (size_t i = 0; i < m_animations.size(); i++) {
+		const double progress = m_animations[i]->GetProgress();
+		changed = changed || progress != m_animationProgress[i];
+		m_animationProgress[i] = progress;
+		numChannels += m_animations[i]->GetNumChannels();
+	}
+	if (!changed || numChannels == 0)
+		return;
+
+	m_animationTransforms.resize(numChannels);
+	matrix4x4f *trans = &m_animationTransforms[0];
+	for (Animation *anim : m_animations) {
+		anim->Evaluate(trans);
+		trans += anim->GetNumChannels();
+	}
+	trans = &m_animationTransforms[0];
+	for (Animation *anim : m_animations) {
+		anim->Apply(trans);
+		trans += anim->GetNumChannels();
+	}
 }
 
 void Model::SetThrust(const vector3f &lin, const vector3f &ang)
@@ -587,6 +880,7 @@ void Model::LoadFromJson(const Json::Value &jsonObj)
 	if (!visitorArray.isArray()) throw SavedGameCorruptException();
 	LoadVisitorJson lv(visitorArray);
 	m_root->Accept(lv);
+	m_renderList.valid = false;
 
 	Json::Value animationArray = modelObj["animations"];
 	if (!animationArray.isArray()) throw SavedGameCorruptException();
@@ -594,6 +888,7 @@ void Model::LoadFromJson(const Json::Value &jsonObj)
 	unsigned int arrayIndex = 0;
 	for (AnimationContainer::const_iterator i = m_animations.begin(); i != m_animations.end(); ++i)
 		(*i)->SetProgress(StrToDouble(animationArray[arrayIndex++].asString()));
+	m_animationProgress.clear();
 	UpdateAnimations();
 
 	SetPattern(modelObj["cur_pattern_index"].asUInt());
@@ -48,6 +48,13 @@
  * named hardpoints, known as "tags" (term from Q3).
  * Users can query tags by name or index and create a ModelNode to wrap the sub model
  *
+ * Instances (MakeInstance) share the node graph with the model they're made
+ * from, apart from the nodes they change: animated transforms, tags, labels,
+ * billboards and dynamic collision geometry, and the groups leading down to
+ * those. Anything else in the graph must not be changed after loading. Each
+ * instance has its own animation times, pattern and colour map, decals and
+ * thruster parameters.
+ *
  * Minor features:
  *  - pattern + customizable colour system (one pattern per model). Patterns can be
  *    dropped into the model directory.
@@ -58,6 +65,12 @@
  * Things to optimize:
  *  - model cache
  *  - removing unnecessary nodes from the scene graph: pre-translate unanimated meshes etc.
+ *
+ * Rendering a single instance doesn't walk the tree: it's flattened into a
+ * render list of the nodes that draw and their transforms relative to the
+ * model, which is kept until an animation moves, a different LOD level is
+ * needed or the tree is changed. Node masks of leaves are looked at every
+ * frame (nav lights blink), those of groups only when the list is built.
  */
 #include "libs.h"
 #include "Animation.h"
@@ -83,6 +96,8 @@ namespace SceneGraph
 class BaseLoader;
 class ModelBinarizer;
 class BinaryConverter;
+class LOD;
+class StaticGeometry;
 
 struct LoadingError : public std::runtime_error {
 	LoadingError(const std::string &str) : std::runtime_error(str.c_str()) { }
@@ -188,6 +203,8 @@ private:
 	std::string m_name;
 	std::vector<Animation *> m_animations;
 	TagContainer m_tags; //named attachment points
+	std::vector<double> m_animationProgress; //when the transforms were last updated
+	std::vector<matrix4x4f> m_animationTransforms;
 	RenderData m_renderData;
 
 	//per-instance flavour data
@@ -195,6 +212,54 @@ private:
 	Graphics::Texture *m_curPattern;
 	Graphics::Texture *m_curDecals[MAX_DECAL_MATERIALS];
 
+	// the tree flattened for Render
+	struct RenderList {
+		// opaque meshes of the geometry, sorted by material
+		struct Mesh {
+			StaticGeometry *geom;
+			Graphics::Material *material;
+			Uint32 mesh;
+			Uint32 leaf;
+			vector3f centre;        // of the geometry's bounding box, model space
+		};
+		// everything that draws, in tree order
+		struct Leaf {
+			Node *node;
+			Uint32 transform;
+			unsigned int mask;      // of the groups above it
+			bool ownMask;           // false straight under a LOD, which draws it regardless
+			bool geometry;
+		};
+		// a level chosen, which makes the list stale when it changes
+		struct Level {
+			LOD *lod;
+			Uint32 transform;
+			unsigned int level;
+		};
+		// a group entered, which makes the list stale when its children change
+		struct Branch {
+			const Group *group;
+			Uint32 structureChanges;
+		};
+
+		RenderList() : valid(false) { }
+		bool valid;
+		std::vector<double> animationProgress;
+		std::vector<matrix4x4f> transforms;  // relative to the model
+		std::vector<Mesh> meshes;
+		std::vector<Leaf> leaves;
+		std::vector<Level> levels;
+		std::vector<Branch> branches;  // parents ahead of their children
+		std::vector<Graphics::Material*> patternMaterials;
+	};
+	friend class RenderListBuilder;
+	bool IsRenderListStale(const matrix4x4f &trans, float boundingRadius);
+	void BuildRenderList(const matrix4x4f &trans, float boundingRadius);
+	void RenderPass(const RenderData &params, unsigned int pass);
+	static unsigned int GetLeafMask(const RenderList::Leaf &leaf);
+	RenderList m_renderList;
+	std::vector<matrix4x4f> m_viewTransforms; // m_renderList.transforms for this Render
+
 	// debug support
 	void CreateAabbVB();
 	void DrawAabb();
@@ -33,7 +33,8 @@ enum NodeMask {
 //misc flags to identify features
 enum NodeFlags {
 	NODE_TAG = 0x1,
-	NODE_DECAL = 0x2
+	NODE_DECAL = 0x2,
+	NODE_INSTANCE = 0x4 //changed by each model instance (navlights, shields), never shared
 };
 
 //Small structure used internally to pass rendering data
@@ -6,14 +6,28 @@
 
 #include "RefCounted.h"
 #include <map>
+#include <set>
 
 namespace SceneGraph {
 
 class Node;
 
+// Copies the nodes of a graph being cloned, once each, however many parents
+// they have. When the nodes an instance will change are given, everything
+// else is left shared between the original and the copy
 class NodeCopyCache {
 public:
+	NodeCopyCache() : m_shareUnchanged(false) { }
+
+	// the nodes that need copying, with everything above them
+	void SetInstanceNodes(const std::set<const Node*> &nodes) {
+		m_instanceNodes = nodes;
+		m_shareUnchanged = true;
+	}
+
 	template <typename T> T *Copy(const T *origNode) {
+		if (m_shareUnchanged && !m_instanceNodes.count(origNode))
+			return const_cast<T*>(origNode);
 		const bool doCache = origNode->GetRefCount() > 1;
 		if (doCache) {
 			std::map<const Node*,Node*>::const_iterator i = m_cache.find(origNode);
@@ -28,6 +42,8 @@ public:
 
 private:
 	std::map<const Node*,Node*> m_cache;
+	std::set<const Node*> m_instanceNodes;
+	bool m_shareUnchanged;
 };
 
 }
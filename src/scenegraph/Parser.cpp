@@ -148,6 +148,7 @@ bool Parser::parseLine(const std::string &line)
 				m_model->lodDefs.push_back(LodDefinition(100.f));
 			}
 			m_model->lodDefs.back().meshNames.push_back(meshname);
+			m_model->lodDefs.back().meshFormats.push_back(MESH_VERTICES_FLOAT);
 			return true;
 		} else if(match(token, "collision")) {
 			//collision mesh definitions contain also only a filename
@@ -176,6 +177,20 @@ bool Parser::parseLine(const std::string &line)
 				throw ParseError("Animation start/end frames seem wrong");
 			m_model->animDefs.push_back(AnimDefinition(animName, startFrame, endFrame, loopMode));
 			return true;
+		} else if(match(token, "compact_vertices")) {
+			//affects the previously defined mesh, positions optionally "int16" or "half"
+			if (m_isMaterial || m_model->lodDefs.empty() || m_model->lodDefs.back().meshNames.empty())
+				throw ParseError("Compact vertices must come after a mesh definition");
+			MeshVertexFormat format = MESH_VERTICES_COMPACT;
+			std::string positions;
+			if (ss >> positions) {
+				if (match(positions, "half"))
+					format = MESH_VERTICES_COMPACT_HALF;
+				else if (!match(positions, "int16"))
+					throw ParseError("Compact vertex positions must be int16 or half");
+			}
+			m_model->lodDefs.back().meshFormats.back() = format;
+			return true;
 		} else {
 			if (m_isMaterial) {
 				//material definition in progress, check known parameters
@@ -12,6 +12,9 @@
 
 namespace SceneGraph {
 
+// vertex and index data in .sgm files starts on this boundary
+static const Uint32 BLOCK_ALIGNMENT = 16;
+
 StaticGeometry::StaticGeometry(Graphics::Renderer *r)
 : Node(r, NODE_SOLID)
 , m_blendMode(Graphics::BLEND_SOLID)
@@ -48,8 +51,10 @@ void StaticGeometry::Render(const matrix4x4f &trans, const RenderData *rd)
 	SDL_assert(m_renderState);
 	Graphics::Renderer *r = GetRenderer();
 	r->SetTransform(trans);
+	// queued when the model is recording its opaque pass, see Model::Render
+	const float depth = -(trans * vector3f(0.5 * (m_boundingBox.min + m_boundingBox.max))).z;
 	for (auto& it : m_meshes)
-		r->DrawBufferIndexed(it.vertexBuffer.Get(), it.indexBuffer.Get(), m_renderState, it.material.Get());
+		r->QueueBufferIndexed(it.vertexBuffer.Get(), it.indexBuffer.Get(), m_renderState, it.material.Get(), depth);
 
 	//DrawBoundingBox(m_boundingBox);
 }
@@ -133,51 +138,35 @@ void StaticGeometry::Save(NodeDatabase &db)
 		const std::string &matname = db.model->GetNameForMaterial(mesh.material.Get());
 		db.wr->String(matname);
 
-		//save vertex attrib description
+		//save vertex attrib description: positions, normals, uvs and maybe
+		//tangents, each with its format and where it is in the vertex
 		const auto& vbDesc = mesh.vertexBuffer->GetDesc();
-		Uint32 attribCombo = 0;
-		for (Uint32 i = 0; i < Graphics::MAX_ATTRIBS; i++)
-			attribCombo |= vbDesc.attrib[i].semantic;
-
-		db.wr->Int32(attribCombo);
-
-		const bool hasTangents = (attribCombo & Graphics::ATTRIB_TANGENT);
+		Uint32 numAttribs = 0;
+		while (numAttribs < Graphics::MAX_ATTRIBS && vbDesc.attrib[numAttribs].semantic != Graphics::ATTRIB_NONE)
+			numAttribs++;
+
+		db.wr->Int32(numAttribs);
+		for (Uint32 i = 0; i < numAttribs; i++) {
+			db.wr->Int32(vbDesc.attrib[i].semantic);
+			db.wr->Int32(vbDesc.attrib[i].format);
+			db.wr->Int32(vbDesc.attrib[i].offset);
+		}
 
-		//save positions, normals and uvs interleaved (only known format now)
-		const Uint32 posOffset = vbDesc.GetOffset(Graphics::ATTRIB_POSITION);
-		const Uint32 nrmOffset = vbDesc.GetOffset(Graphics::ATTRIB_NORMAL);
-		const Uint32 uv0Offset = vbDesc.GetOffset(Graphics::ATTRIB_UV0);
-		const Uint32 tanOffset = hasTangents ? vbDesc.GetOffset(Graphics::ATTRIB_TANGENT) : 0;
-		const Uint32 stride    = vbDesc.stride;
+		//save the vertices as they are in the buffer, interleaved, so they
+		//can be uploaded straight from the file
+		db.wr->Int32(vbDesc.stride);
 		db.wr->Int32(vbDesc.numVertices);
-		Uint8 *vtxPtr = mesh.vertexBuffer->Map<Uint8>(Graphics::BUFFER_MAP_READ);
-		if (hasTangents)
-		{
-			for (Uint32 i = 0; i < vbDesc.numVertices; i++) {
-				db.wr->Vector3f(*reinterpret_cast<vector3f*>(vtxPtr + i * stride + posOffset));
-				db.wr->Vector3f(*reinterpret_cast<vector3f*>(vtxPtr + i * stride + nrmOffset));
-				db.wr->Float(reinterpret_cast<vector2f*>(vtxPtr + i * stride + uv0Offset)->x);
-				db.wr->Float(reinterpret_cast<vector2f*>(vtxPtr + i * stride + uv0Offset)->y);
-				db.wr->Vector3f(*reinterpret_cast<vector3f*>(vtxPtr + i * stride + tanOffset));
-			}
-		}
-		else
-		{
-			for (Uint32 i = 0; i < vbDesc.numVertices; i++) {
-				db.wr->Vector3f(*reinterpret_cast<vector3f*>(vtxPtr + i * stride + posOffset));
-				db.wr->Vector3f(*reinterpret_cast<vector3f*>(vtxPtr + i * stride + nrmOffset));
-				db.wr->Float(reinterpret_cast<vector2f*>(vtxPtr + i * stride + uv0Offset)->x);
-				db.wr->Float(reinterpret_cast<vector2f*>(vtxPtr + i * stride + uv0Offset)->y);
-			}
-		}
+		db.wr->Vector3f(vbDesc.positionScale);
+		db.wr->Vector3f(vbDesc.positionOffset);
+		const Uint8 *vtxPtr = mesh.vertexBuffer->Map<Uint8>(Graphics::BUFFER_MAP_READ);
+		db.wr->AlignedBlob(vtxPtr, vbDesc.numVertices * vbDesc.stride, BLOCK_ALIGNMENT);
 		mesh.vertexBuffer->Unmap();
 
 		//indices
 		const Uint32 *indexPtr = mesh.indexBuffer->Map(Graphics::BUFFER_MAP_READ);
 		const Uint32 numIndices = mesh.indexBuffer->GetSize();
 		db.wr->Int32(numIndices);
-		for (Uint32 i = 0; i < numIndices; i++)
-			db.wr->Int32(indexPtr[i]);
+		db.wr->AlignedBlob(indexPtr, numIndices * sizeof(Uint32), BLOCK_ALIGNMENT);
 		mesh.indexBuffer->Unmap();
     }
 }
@@ -209,67 +198,70 @@ StaticGeometry *StaticGeometry::Load(NodeDatabase &db)
 		} else
 			material = db.model->GetMaterialByName(matName);
 
-		//vertex format check
-		const Uint32 vtxFormat = db.rd->Int32();
+		//vertex buffer, in the layout it was saved with
+		Graphics::VertexBufferDesc vbDesc;
+		const Uint32 numAttribs = rd.Int32();
+		if (numAttribs > MAX_ATTRIBS)
+			throw LoadingError("Unsupported vertex format");
+		Uint32 vtxFormat = 0;
+		for (Uint32 i = 0; i < numAttribs; i++) {
+			VertexAttribDesc &attr = vbDesc.attrib[i];
+			attr.semantic = static_cast<VertexAttrib>(rd.Int32());
+			attr.format = static_cast<VertexAttribFormat>(rd.Int32());
+			attr.offset = rd.Int32();
+			if (attr.format <= ATTRIB_FORMAT_NONE || attr.format > ATTRIB_FORMAT_USHORT4N)
+				throw LoadingError("Unsupported vertex format");
+			vtxFormat |= attr.semantic;
+		}
 		if (vtxFormat != (ATTRIB_POSITION | ATTRIB_NORMAL | ATTRIB_UV0 | ATTRIB_TANGENT) &&	vtxFormat != (ATTRIB_POSITION | ATTRIB_NORMAL | ATTRIB_UV0))
 		{
 			throw LoadingError("Unsupported vertex format");
 		}
-
-		const bool hasTangents = (vtxFormat & Graphics::ATTRIB_TANGENT);
-
-		//vertex buffer
-		Graphics::VertexBufferDesc vbDesc;
-		vbDesc.attrib[0].semantic = Graphics::ATTRIB_POSITION;
-		vbDesc.attrib[0].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
-		vbDesc.attrib[1].semantic = Graphics::ATTRIB_NORMAL;
-		vbDesc.attrib[1].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
-		vbDesc.attrib[2].semantic = Graphics::ATTRIB_UV0;
-		vbDesc.attrib[2].format   = Graphics::ATTRIB_FORMAT_FLOAT2;
-		if (hasTangents) {
-			vbDesc.attrib[3].semantic = Graphics::ATTRIB_TANGENT;
-			vbDesc.attrib[3].format = Graphics::ATTRIB_FORMAT_FLOAT3;
-		}
+		vbDesc.stride = rd.Int32();
 		vbDesc.usage = Graphics::BUFFER_USAGE_STATIC;
-		vbDesc.numVertices = db.rd->Int32();
-
-		RefCountedPtr<Graphics::VertexBuffer> vtxBuffer(db.loader->GetRenderer()->CreateVertexBuffer(vbDesc));
-		const Uint32 posOffset = vtxBuffer->GetDesc().GetOffset(Graphics::ATTRIB_POSITION);
-		const Uint32 nrmOffset = vtxBuffer->GetDesc().GetOffset(Graphics::ATTRIB_NORMAL);
-		const Uint32 uv0Offset = vtxBuffer->GetDesc().GetOffset(Graphics::ATTRIB_UV0);
-		const Uint32 tanOffset = hasTangents ? vtxBuffer->GetDesc().GetOffset(Graphics::ATTRIB_TANGENT) : 0;
-		const Uint32 stride = vtxBuffer->GetDesc().stride;
-		Uint8 *vtxPtr = vtxBuffer->Map<Uint8>(BUFFER_MAP_WRITE);
-		if (hasTangents)
-		{
-			for (Uint32 i = 0; i < vbDesc.numVertices; i++) {
-				*reinterpret_cast<vector3f*>(vtxPtr + i * stride + posOffset) = db.rd->Vector3f();
-				*reinterpret_cast<vector3f*>(vtxPtr + i * stride + nrmOffset) = db.rd->Vector3f();
-				const float uvx = db.rd->Float();
-				const float uvy = db.rd->Float();
-				*reinterpret_cast<vector2f*>(vtxPtr + i * stride + uv0Offset) = vector2f(uvx, uvy);
-				*reinterpret_cast<vector3f*>(vtxPtr + i * stride + tanOffset) = db.rd->Vector3f();
-			}
+		vbDesc.numVertices = rd.Int32();
+		vbDesc.positionScale = rd.Vector3f();
+		vbDesc.positionOffset = rd.Vector3f();
+		for (Uint32 i = 0; i < numAttribs; i++) {
+			if (vbDesc.attrib[i].offset + VertexBufferDesc::GetAttribSize(vbDesc.attrib[i].format) > vbDesc.stride)
+				throw LoadingError("Vertex format doesn't fit its stride");
 		}
-		else
-		{
-			for (Uint32 i = 0; i < vbDesc.numVertices; i++) {
-				*reinterpret_cast<vector3f*>(vtxPtr + i * stride + posOffset) = db.rd->Vector3f();
-				*reinterpret_cast<vector3f*>(vtxPtr + i * stride + nrmOffset) = db.rd->Vector3f();
-				const float uvx = db.rd->Float();
-				const float uvy = db.rd->Float();
-				*reinterpret_cast<vector2f*>(vtxPtr + i * stride + uv0Offset) = vector2f(uvx, uvy);
+
+		//the vertices and indices are uploaded from where they lie in the
+		//file, which is usually mapped rather than read
+		const ByteRange vertices = rd.AlignedBlob(BLOCK_ALIGNMENT);
+		if (vertices.Size() != vbDesc.numVertices * vbDesc.stride)
+			throw LoadingError("Vertex data size mismatch");
+		RefCountedPtr<Graphics::VertexBuffer> vtxBuffer;
+		if (vbDesc.IsCompact() && !db.loader->GetRenderer()->SupportsCompactVertices()) {
+			//back to floats for renderers that can't draw compact vertices
+			VertexBufferDesc floatDesc = vbDesc;
+			floatDesc.positionScale = vector3f(1.0f);
+			floatDesc.positionOffset = vector3f(0.0f);
+			Uint32 offset = 0;
+			for (Uint32 i = 0; i < numAttribs; i++) {
+				VertexAttribDesc &attr = floatDesc.attrib[i];
+				attr.format = (attr.semantic == ATTRIB_UV0) ? ATTRIB_FORMAT_FLOAT2 : ATTRIB_FORMAT_FLOAT3;
+				attr.offset = offset;
+				offset += VertexBufferDesc::GetAttribSize(attr.format);
 			}
+			floatDesc.stride = offset;
+			std::vector<Uint8> floatVertices(floatDesc.numVertices * floatDesc.stride);
+			ConvertVertices(vbDesc, reinterpret_cast<const Uint8*>(vertices.begin), floatDesc, floatVertices.data(), vbDesc.numVertices);
+			vtxBuffer.Reset(db.loader->GetRenderer()->CreateVertexBuffer(floatDesc));
+			vtxBuffer->BufferSubData(0, floatVertices.size(), floatVertices.data());
+		} else {
+			vtxBuffer.Reset(db.loader->GetRenderer()->CreateVertexBuffer(vbDesc));
+			vtxBuffer->BufferSubData(0, vertices.Size(), vertices.begin);
 		}
-		vtxBuffer->Unmap();
 
 		//index buffer
-		const Uint32 numIndices = db.rd->Int32();
+		const Uint32 numIndices = rd.Int32();
+		const ByteRange indices = rd.AlignedBlob(BLOCK_ALIGNMENT);
+		if (indices.Size() != numIndices * sizeof(Uint32))
+			throw LoadingError("Index data size mismatch");
 		RefCountedPtr<Graphics::IndexBuffer> idxBuffer(db.loader->GetRenderer()->CreateIndexBuffer(numIndices, Graphics::BUFFER_USAGE_STATIC));
-		Uint32 *idxPtr = idxBuffer->Map(BUFFER_MAP_WRITE);
-		for (Uint32 i = 0; i < numIndices; i++)
-			idxPtr[i] = db.rd->Int32();
-		idxBuffer->Unmap();
+		idxBuffer->BufferSubData(0, indices.Size(), indices.begin);
 
 		sg->AddMesh(vtxBuffer, idxBuffer, material);
 	}
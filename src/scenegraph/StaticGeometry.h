@@ -42,6 +42,7 @@ public:
 	Mesh &GetMeshAt(unsigned int i);
 
 	void SetRenderState(Graphics::RenderState *s) { m_renderState = s; }
+	Graphics::RenderState *GetRenderState() const { return m_renderState; }
 
 	Aabb m_boundingBox;
 	Graphics::BlendMode m_blendMode;
@@ -17,6 +17,57 @@ static const std::string thrusterTextureFilename("textures/thruster.dds");
 static const std::string thrusterGlowTextureFilename("textures/halo.dds");
 static Color baseColor(178, 153, 255, 255);
 
+// the thrusters of all models drawn since BeginBatch
+struct ThrusterBatch {
+	ThrusterBatch()
+	: active(false)
+	, flameShape(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0)
+	, glowShape(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0)
+	, flames(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE | Graphics::ATTRIB_UV0)
+	, glows(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_DIFFUSE | Graphics::ATTRIB_UV0)
+	, renderState(nullptr)
+	{ }
+
+	bool active;
+	Graphics::VertexArray flameShape;  // of one thruster, in its own space
+	Graphics::VertexArray glowShape;
+	Graphics::VertexArray flames;      // of every thruster, in view space
+	Graphics::VertexArray glows;
+	RefCountedPtr<Graphics::VertexBuffer> flameVB;
+	RefCountedPtr<Graphics::VertexBuffer> glowVB;
+	RefCountedPtr<Graphics::Material> flameMat;
+	RefCountedPtr<Graphics::Material> glowMat;
+	Graphics::RenderState *renderState;
+};
+static ThrusterBatch s_batch;
+
+static void AddToBatch(Graphics::VertexArray &batch, const Graphics::VertexArray &shape, const matrix4x4f &trans, const Color &color)
+{
+	for (Uint32 i = 0; i < shape.GetNumVerts(); i++)
+		batch.Add(trans * shape.position[i], color, shape.uv0[i]);
+}
+
+static void DrawBatch(Graphics::Renderer *r, Graphics::VertexArray &batch, RefCountedPtr<Graphics::VertexBuffer> &vb, Graphics::Material *mat)
+{
+	if (batch.IsEmpty())
+		return;
+	if (!vb.Valid() || vb->GetCapacity() < batch.GetNumVerts()) {
+		Graphics::VertexBufferDesc vbd;
+		vbd.attrib[0].semantic = Graphics::ATTRIB_POSITION;
+		vbd.attrib[0].format   = Graphics::ATTRIB_FORMAT_FLOAT3;
+		vbd.attrib[1].semantic = Graphics::ATTRIB_DIFFUSE;
+		vbd.attrib[1].format   = Graphics::ATTRIB_FORMAT_UBYTE4;
+		vbd.attrib[2].semantic = Graphics::ATTRIB_UV0;
+		vbd.attrib[2].format   = Graphics::ATTRIB_FORMAT_FLOAT2;
+		vbd.numVertices = batch.GetNumVerts();
+		vbd.usage = Graphics::BUFFER_USAGE_DYNAMIC;
+		vb.Reset(r->CreateVertexBuffer(vbd));
+	}
+	vb->Populate(batch);
+	r->DrawBuffer(vb.Get(), s_batch.renderState, mat);
+	batch.Clear();
+}
+
 Thruster::Thruster(Graphics::Renderer *r, bool _linear, const vector3f &_pos, const vector3f &_dir)
 : Node(r, NODE_TRANSPARENT)
 , linearOnly(_linear)
@@ -89,14 +140,24 @@ void Thruster::Render(const matrix4x4f &trans, const RenderData *rd)
 	}
 	if (power < 0.001f) return;
 
-	m_tMat->diffuse = m_glowMat->diffuse = currentColor * power;
+	Color flameColor = currentColor * power;
+	Color glowColor = flameColor;
 
 	//directional fade
 	vector3f cdir = vector3f(trans * -dir).Normalized();
 	vector3f vdir = vector3f(trans[2], trans[6], -trans[10]).Normalized();
 	// XXX check this for transition to new colors.
-	m_glowMat->diffuse.a = Easing::Circ::EaseIn(Clamp(vdir.Dot(cdir), 0.f, 1.f), 0.f, 1.f, 1.f) * 255;
-	m_tMat->diffuse.a = 255 - m_glowMat->diffuse.a;
+	glowColor.a = Easing::Circ::EaseIn(Clamp(vdir.Dot(cdir), 0.f, 1.f), 0.f, 1.f, 1.f) * 255;
+	flameColor.a = 255 - glowColor.a;
+
+	if (s_batch.active) {
+		AddToBatch(s_batch.flames, s_batch.flameShape, trans, flameColor);
+		AddToBatch(s_batch.glows, s_batch.glowShape, trans, glowColor);
+		return;
+	}
+
+	m_tMat->diffuse = flameColor;
+	m_glowMat->diffuse = glowColor;
 
 	Graphics::Renderer *r = GetRenderer();
 	if( !m_tBuffer.Valid() ) {
@@ -126,10 +187,61 @@ Thruster *Thruster::Load(NodeDatabase &db)
 	return t;
 }
 
-Graphics::VertexBuffer *Thruster::CreateThrusterGeometry(Graphics::Renderer *r, Graphics::Material *mat)
+void Thruster::BeginBatch()
 {
-	Graphics::VertexArray verts(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0);
+	assert(!s_batch.active);
+	if (s_batch.flameShape.IsEmpty()) {
+		BuildThrusterGeometry(s_batch.flameShape);
+		BuildGlowGeometry(s_batch.glowShape);
+	}
+	s_batch.active = true;
+}
 
+void Thruster::EndBatch(Graphics::Renderer *r)
+{
+	PROFILE_SCOPED()
+	assert(s_batch.active);
+	s_batch.active = false;
+	if (s_batch.flames.IsEmpty())
+		return;
+
+	if (!s_batch.renderState) {
+		Graphics::MaterialDescriptor desc;
+		desc.textures = 1;
+		desc.vertexColors = true;
+
+		s_batch.flameMat.Reset(r->CreateMaterial(desc));
+		s_batch.flameMat->texture0 = Graphics::TextureBuilder::Billboard(thrusterTextureFilename).GetOrCreateTexture(r, "billboard");
+
+		s_batch.glowMat.Reset(r->CreateMaterial(desc));
+		s_batch.glowMat->texture0 = Graphics::TextureBuilder::Billboard(thrusterGlowTextureFilename).GetOrCreateTexture(r, "billboard");
+
+		Graphics::RenderStateDesc rsd;
+		rsd.blendMode = Graphics::BLEND_ALPHA_ONE;
+		rsd.depthWrite = false;
+		rsd.cullMode = Graphics::CULL_NONE;
+		s_batch.renderState = r->CreateRenderState(rsd);
+	}
+
+	r->SetTransform(matrix4x4f::Identity());
+	DrawBatch(r, s_batch.flames, s_batch.flameVB, s_batch.flameMat.Get());
+	DrawBatch(r, s_batch.glows, s_batch.glowVB, s_batch.glowMat.Get());
+}
+
+void Thruster::Uninit()
+{
+	assert(!s_batch.active);
+	s_batch.flames.Clear();
+	s_batch.glows.Clear();
+	s_batch.flameVB.Reset();
+	s_batch.glowVB.Reset();
+	s_batch.flameMat.Reset();
+	s_batch.glowMat.Reset();
+	s_batch.renderState = nullptr;
+}
+
+void Thruster::BuildThrusterGeometry(Graphics::VertexArray &verts)
+{
 	//zero at thruster center
 	//+x down
 	//+y right
@@ -162,6 +274,12 @@ Graphics::VertexBuffer *Thruster::CreateThrusterGeometry(Graphics::Renderer *r,
 		three.ArbRotate(vector3f(0.f, 0.f, 1.f), DEG2RAD(45.f));
 		four.ArbRotate(vector3f(0.f, 0.f, 1.f), DEG2RAD(45.f));
 	}
+}
+
+Graphics::VertexBuffer *Thruster::CreateThrusterGeometry(Graphics::Renderer *r, Graphics::Material *mat)
+{
+	Graphics::VertexArray verts(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0);
+	BuildThrusterGeometry(verts);
 
 	//create buffer and upload data
 	Graphics::VertexBufferDesc vbd;
@@ -177,10 +295,8 @@ Graphics::VertexBuffer *Thruster::CreateThrusterGeometry(Graphics::Renderer *r,
 	return vb;
 }
 
-Graphics::VertexBuffer *Thruster::CreateGlowGeometry(Graphics::Renderer *r, Graphics::Material *mat)
+void Thruster::BuildGlowGeometry(Graphics::VertexArray &verts)
 {
-	Graphics::VertexArray verts(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0);
-
 	//create glow billboard for linear thrusters
 	const float w = 0.2;
 
@@ -207,6 +323,12 @@ Graphics::VertexBuffer *Thruster::CreateGlowGeometry(Graphics::Renderer *r, Grap
 		one.z += .1f;
 		two.z = three.z = four.z = one.z;
 	}
+}
+
+Graphics::VertexBuffer *Thruster::CreateGlowGeometry(Graphics::Renderer *r, Graphics::Material *mat)
+{
+	Graphics::VertexArray verts(Graphics::ATTRIB_POSITION | Graphics::ATTRIB_UV0);
+	BuildGlowGeometry(verts);
 
 	//create buffer and upload data
 	Graphics::VertexBufferDesc vbd;
@@ -5,12 +5,17 @@
 #define _SCENEGRAPH_THRUSTER_H
 /*
  * Spaceship thruster
+ *
+ * Between BeginBatch and EndBatch thrusters don't draw: they add their flames
+ * and glows, already in view space and coloured, to one array for all models,
+ * drawn at EndBatch with one draw call for each of the two textures.
  */
 #include "libs.h"
 #include "Node.h"
 
 namespace Graphics {
 	class Renderer;
+	class VertexArray;
 	class VertexBuffer;
 	class Material;
 	class RenderState;
@@ -31,7 +36,13 @@ public:
 	void SetColor(const Color c) { currentColor = c; }
 	const vector3f &GetDirection() { return dir; }
 
+	static void BeginBatch();
+	static void EndBatch(Graphics::Renderer *r);
+	static void Uninit();
+
 private:
+	static void BuildThrusterGeometry(Graphics::VertexArray &verts);
+	static void BuildGlowGeometry(Graphics::VertexArray &verts);
 	static Graphics::VertexBuffer* CreateThrusterGeometry(Graphics::Renderer*, Graphics::Material*);
 	static Graphics::VertexBuffer* CreateGlowGeometry(Graphics::Renderer*, Graphics::Material*);
 	RefCountedPtr<Graphics::Material> m_tMat;
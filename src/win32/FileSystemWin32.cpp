@@ -193,6 +193,41 @@ namespace FileSystem {
 		}
 	}
 
+	class FileDataMapped : public FileData {
+	public:
+		FileDataMapped(const FileInfo &info, size_t size, char *data):
+			FileData(info, size, data) {}
+		virtual ~FileDataMapped() { UnmapViewOfFile(m_data); }
+	};
+
+	RefCountedPtr<FileData> FileSourceFS::MapFile(const std::string &path)
+	{
+		const std::string fullpath = JoinPathBelow(GetRoot(), path);
+		const std::wstring wfullpath = transcode_utf8_to_utf16(fullpath);
+		HANDLE filehandle = CreateFileW(wfullpath.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+		if (filehandle == INVALID_HANDLE_VALUE)
+			return RefCountedPtr<FileData>(0);
+
+		const Time::DateTime modtime = file_modtime_for_handle(filehandle);
+		LARGE_INTEGER large_size;
+		void *data = nullptr;
+		// can't map an empty file
+		if (GetFileSizeEx(filehandle, &large_size) && large_size.QuadPart > 0) {
+			HANDLE mapping = CreateFileMappingW(filehandle, 0, PAGE_READONLY, 0, 0, 0);
+			if (mapping) {
+				data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+				// the view keeps the mapping open
+				CloseHandle(mapping);
+			}
+		}
+		CloseHandle(filehandle);
+
+		if (!data)
+			return ReadFile(path);
+
+		return RefCountedPtr<FileData>(new FileDataMapped(MakeFileInfo(path, FileInfo::FT_FILE, modtime), size_t(large_size.QuadPart), static_cast<char*>(data)));
+	}
+
 	bool FileSourceFS::ReadDirectory(const std::string &dirpath, std::vector<FileInfo> &output)
 	{
 		size_t output_head_size = output.size();